@@ -33,6 +33,13 @@ LOCAL_SRC_FILES	:= 	CinemaApp.cpp \
 					SwipeHintComponent.cpp \
 					CinemaStrings.cpp \
 					Settings.cpp \
+					SettingsSchema.cpp \
+					SettingsSnapshot.cpp \
+					SettingsWriter.cpp \
+					StreamProfileTuner.cpp \
+					PosterLoader.cpp \
+					MouseMotion.cpp \
+					InputSampler.cpp \
 					UI/UITexture.cpp \
 					UI/UIMenu.cpp \
 					UI/UIWidget.cpp \
@@ -40,10 +47,11 @@ LOCAL_SRC_FILES	:= 	CinemaApp.cpp \
 					UI/UILabel.cpp \
 					UI/UIImage.cpp \
 					UI/UIButton.cpp \
-					UI/UITextButton.cpp
+					UI/UITextButton.cpp \
+					UI/UITextCache.cpp
 
 LOCAL_STATIC_LIBRARIES += vrappframework libovr
-LOCAL_SHARED_LIBRARIES += vrapi
+LOCAL_SHARED_LIBRARIES += vrapi nv_opus_dec
 
 include $(BUILD_SHARED_LIBRARY)			# start building based on everything since CLEAR_VARS
 
@@ -16,6 +16,10 @@ of patent rights can be found in the PATENTS file in the same directory.
 #include <sys/stat.h>
 #include <errno.h>
 #include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "Kernel/OVR_String_Utils.h"
 #include "Kernel/OVR_JSON.h"
@@ -33,12 +37,316 @@ const int AppManager::PosterHeight = 344;
 
 //=======================================================================================
 
+AppPosterBackend::AppPosterBackend() :
+	Thread(),
+	Running( false ),
+	Reads(),
+	NextSerial( 0 ),
+	Placeholder( 0 ),
+	List(),
+	Loaded(),
+	ChangedItems()
+{
+	pthread_mutex_init( &Lock, NULL );
+	pthread_cond_init( &Changed, NULL );
+}
+
+AppPosterBackend::~AppPosterBackend()
+{
+	Shutdown();
+	pthread_cond_destroy( &Changed );
+	pthread_mutex_destroy( &Lock );
+}
+
+void AppPosterBackend::Shutdown()
+{
+	pthread_mutex_lock( &Lock );
+	const bool wasRunning = Running;
+	Running = false;
+	pthread_cond_broadcast( &Changed );
+	pthread_mutex_unlock( &Lock );
+
+	if ( wasRunning )
+	{
+		pthread_join( Thread, NULL );
+	}
+
+	for ( int i = 0; i < Reads.GetSizeI(); i++ )
+	{
+		FreeRead( Reads[ i ] );
+	}
+	Reads.Clear();
+}
+
+void * AppPosterBackend::ThreadFunction( void * param )
+{
+	( (AppPosterBackend *)param )->Run();
+	return NULL;
+}
+
+void AppPosterBackend::Run()
+{
+	pthread_mutex_lock( &Lock );
+	while ( Running )
+	{
+		int index = -1;
+		for ( int i = 0; i < Reads.GetSizeI(); i++ )
+		{
+			if ( !Reads[ i ].Started )
+			{
+				index = i;
+				break;
+			}
+		}
+		if ( index < 0 )
+		{
+			pthread_cond_wait( &Changed, &Lock );
+			continue;
+		}
+
+		// the read may be cancelled while the file is read
+		Reads[ index ].Started = true;
+		const unsigned serial = Reads[ index ].Serial;
+		char fileName[ PATH_MAX ];
+		strncpy( fileName, Reads[ index ].FileName, sizeof( fileName ) - 1 );
+		fileName[ sizeof( fileName ) - 1 ] = 0;
+		pthread_mutex_unlock( &Lock );
+
+		void * data = NULL;
+		int length = 0;
+		FILE * file = fopen( fileName, "rb" );
+		if ( file != NULL )
+		{
+			fseek( file, 0, SEEK_END );
+			length = ( int )ftell( file );
+			fseek( file, 0, SEEK_SET );
+			data = ( length > 0 ) ? malloc( length ) : NULL;
+			if ( ( data != NULL ) && ( fread( data, 1, length, file ) != ( size_t )length ) )
+			{
+				free( data );
+				data = NULL;
+			}
+			fclose( file );
+		}
+
+		pthread_mutex_lock( &Lock );
+		index = -1;
+		for ( int i = 0; i < Reads.GetSizeI(); i++ )
+		{
+			if ( Reads[ i ].Serial == serial )
+			{
+				index = i;
+				break;
+			}
+		}
+		if ( index >= 0 )
+		{
+			Reads[ index ].Data = data;
+			Reads[ index ].Length = ( data != NULL ) ? length : 0;
+			Reads[ index ].Done = true;
+		}
+		else
+		{
+			free( data );
+		}
+	}
+	pthread_mutex_unlock( &Lock );
+}
+
+int AppPosterBackend::FindRead( const int item ) const
+{
+	for ( int i = 0; i < Reads.GetSizeI(); i++ )
+	{
+		if ( Reads[ i ].Item == item )
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+void AppPosterBackend::FreeRead( Read & read )
+{
+	free( read.FileName );
+	free( read.Data );
+	read.FileName = NULL;
+	read.Data = NULL;
+}
+
+void AppPosterBackend::SetList( const Array<const PcDef *> & list )
+{
+	// the apps are AppManager's, this just can't change them through the list
+	List.Resize( list.GetSize() );
+	for ( int i = 0; i < list.GetSizeI(); i++ )
+	{
+		List[ i ] = const_cast<PcDef *>( list[ i ] );
+	}
+	ChangedItems.Clear();
+
+	for ( int i = Loaded.GetSizeI() - 1; i >= 0; i-- )
+	{
+		bool listed = false;
+		for ( int j = 0; ( j < List.GetSizeI() ) && !listed; j++ )
+		{
+			listed = ( List[ j ] == Loaded[ i ] );
+		}
+		if ( !listed )
+		{
+			ReleasePoster( Loaded[ i ] );
+			Loaded.RemoveAt( i );
+		}
+	}
+}
+
+void AppPosterBackend::TakeChanged( Array<int> & items )
+{
+	items = ChangedItems;
+	ChangedItems.Clear();
+}
+
+void AppPosterBackend::Fetch( const int item )
+{
+	String posterFilename = List[ item ]->PosterFileName;
+	posterFilename.StripExtension();
+	posterFilename.AppendString( ".png" );
+
+	pthread_mutex_lock( &Lock );
+	if ( !Running )
+	{
+		if ( pthread_create( &Thread, NULL, ThreadFunction, this ) != 0 )
+		{
+			LOG( "AppPosterBackend: Unable to create thread" );
+		}
+		else
+		{
+			Running = true;
+		}
+	}
+
+	Read read;
+	read.Serial = NextSerial++;
+	read.Item = item;
+	read.FileName = strdup( posterFilename.ToCStr() );
+	read.Data = NULL;
+	read.Length = 0;
+	read.Started = false;
+	read.Done = false;
+	read.Taken = false;
+	Reads.PushBack( read );
+
+	pthread_cond_broadcast( &Changed );
+	pthread_mutex_unlock( &Lock );
+}
+
+int AppPosterBackend::TakeFetched()
+{
+	int item = -1;
+	pthread_mutex_lock( &Lock );
+	for ( int i = 0; i < Reads.GetSizeI(); i++ )
+	{
+		if ( Reads[ i ].Done && !Reads[ i ].Taken )
+		{
+			Reads[ i ].Taken = true;
+			item = Reads[ i ].Item;
+			break;
+		}
+	}
+	pthread_mutex_unlock( &Lock );
+	return item;
+}
+
+void AppPosterBackend::Cancel( const int item )
+{
+	pthread_mutex_lock( &Lock );
+	const int index = FindRead( item );
+	if ( index >= 0 )
+	{
+		FreeRead( Reads[ index ] );
+		Reads.RemoveAt( index );
+	}
+	pthread_mutex_unlock( &Lock );
+}
+
+bool AppPosterBackend::Upload( const int item )
+{
+	pthread_mutex_lock( &Lock );
+	const int index = FindRead( item );
+	if ( index < 0 )
+	{
+		pthread_mutex_unlock( &Lock );
+		return false;
+	}
+	Read read = Reads[ index ];
+	Reads.RemoveAt( index );
+	pthread_mutex_unlock( &Lock );
+
+	PcDef * app = List[ item ];
+	int width = 0;
+	int height = 0;
+	const GLuint poster = ( read.Data == NULL ) ? 0 : LoadTextureFromBuffer( read.FileName, MemBuffer( read.Data, read.Length ),
+			TextureFlags_t( TEXTUREFLAG_NO_DEFAULT ), width, height );
+	FreeRead( read );
+
+	// without one it keeps the default poster
+	if ( poster == 0 )
+	{
+		return false;
+	}
+
+	BuildTextureMipmaps( poster );
+	MakeTextureTrilinear( poster );
+	MakeTextureClamped( poster );
+
+	ReleasePoster( app );
+	app->Poster = poster;
+	app->PosterWidth = width;
+	app->PosterHeight = height;
+	Loaded.PushBack( app );
+	ChangedItems.PushBack( item );
+	return true;
+}
+
+void AppPosterBackend::Release( const int item )
+{
+	PcDef * app = List[ item ];
+	for ( int i = 0; i < Loaded.GetSizeI(); i++ )
+	{
+		if ( Loaded[ i ] == app )
+		{
+			Loaded.RemoveAt( i );
+			break;
+		}
+	}
+	ReleasePoster( app );
+	ChangedItems.PushBack( item );
+}
+
+bool AppPosterBackend::IsResident( const int item ) const
+{
+	return ( List[ item ]->Poster != 0 ) && ( List[ item ]->Poster != Placeholder );
+}
+
+void AppPosterBackend::ReleasePoster( PcDef * app )
+{
+	if ( ( app->Poster != 0 ) && ( app->Poster != Placeholder ) )
+	{
+		glDeleteTextures( 1, &app->Poster );
+	}
+	app->Poster = Placeholder;
+	app->PosterWidth = AppManager::PosterWidth;
+	app->PosterHeight = AppManager::PosterHeight;
+}
+
+//=======================================================================================
+
 AppManager::AppManager( CinemaApp &cinema ) :
 	PcManager( cinema ),
     Apps(),
     updated( false ),
     Cinema( cinema ),
-    DefaultPoster(0)
+    DefaultPoster(0),
+    PosterBackend(),
+    Posters( PosterBackend, POSTER_BUDGET_BYTES / ( PosterWidth * PosterHeight * 4 * 4 / 3 ) )
 {
 }
 
@@ -60,6 +368,7 @@ void AppManager::OneTimeInit( const char * launchIntent )
 	BuildTextureMipmaps( DefaultPoster );
 	MakeTextureTrilinear( DefaultPoster );
 	MakeTextureClamped( DefaultPoster );
+	PosterBackend.SetPlaceholder( DefaultPoster );
 
 	LoadApps();
 
@@ -69,6 +378,7 @@ void AppManager::OneTimeInit( const char * launchIntent )
 void AppManager::OneTimeShutdown()
 {
 	LOG( "AppManager::OneTimeShutdown" );
+	PosterBackend.Shutdown();
 }
 
 void AppManager::LoadApps()
@@ -119,6 +429,14 @@ void AppManager::AddApp(const String &name, const String &posterFileName, int id
 
 	if( isNew ) ReadMetaData( anApp );
 
+	// until the carousel gets to its poster
+	if ( anApp->Poster == 0 )
+	{
+		anApp->Poster = DefaultPoster;
+		anApp->PosterWidth = PosterWidth;
+		anApp->PosterHeight = PosterHeight;
+	}
+
 	updated = true;
 }
 
@@ -183,15 +501,16 @@ void AppManager::LoadPoster( PcDef *anApp )
 	}
 }
 
-void AppManager::LoadPosters()
+void AppManager::SetPosterList( const Array<const PcDef *> &list )
 {
-	for(UPInt i=0; i < Apps.GetSize(); i++)
-	{
-		if( Apps[i]->Poster == 0 || Apps[i]->Poster == DefaultPoster )
-		{
-			LoadPoster(Apps[i]);
-		}
-	}
+	PosterBackend.SetList( list );
+	Posters.SetItems( list.GetSizeI() );
+}
+
+void AppManager::UpdatePosters( const float position, const float velocity, const float stop, const int halfWidth, Array<int> & changed )
+{
+	Posters.Update( position, velocity, stop, halfWidth );
+	PosterBackend.TakeChanged( changed );
 }
 
 Array<const PcDef *> AppManager::GetAppList( PcCategory category ) const
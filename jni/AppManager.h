@@ -16,10 +16,13 @@ of patent rights can be found in the PATENTS file in the same directory.
 #if !defined( AppManager_h )
 #define AppManager_h
 
+#include <pthread.h>
+
 #include "Kernel/OVR_String.h"
 #include "Kernel/OVR_Array.h"
 #include "GlTexture.h"
 #include "PcManager.h"
+#include "PosterLoader.h"
 
 namespace VRMatterStreamTheater {
 
@@ -53,6 +56,64 @@ public:
 	AppDef() : PcDef() {}
 };
 
+// Reads the posters of the apps on the app carousel's list on its own
+// thread, and decodes and uploads them on the render thread, for PosterLoader.
+// Items are indexes into that list.
+class AppPosterBackend : public PosterLoaderBackend
+{
+public:
+							AppPosterBackend();
+	virtual					~AppPosterBackend();
+
+	void					SetPlaceholder( const GLuint placeholder ) { Placeholder = placeholder; }
+	// Releases the posters of apps that aren't on list
+	void					SetList( const Array<const PcDef *> & list );
+	// Items whose poster changed since the last call
+	void					TakeChanged( Array<int> & items );
+	void					Shutdown();
+
+	virtual void			Fetch( const int item );
+	virtual int				TakeFetched();
+	virtual void			Cancel( const int item );
+	virtual bool			Upload( const int item );
+	virtual void			Release( const int item );
+	virtual bool			IsResident( const int item ) const;
+
+private:
+	struct Read
+	{
+		unsigned			Serial;
+		int					Item;
+		char *				FileName;
+		void *				Data;			// malloc'd, NULL if there was nothing to read
+		int					Length;
+		bool				Started;
+		bool				Done;
+		bool				Taken;
+	};
+
+	pthread_t				Thread;
+	pthread_mutex_t			Lock;
+	pthread_cond_t			Changed;
+	bool					Running;
+
+	Array<Read>				Reads;			// in the order they were asked for
+	unsigned				NextSerial;
+
+	GLuint					Placeholder;
+	Array<PcDef *>			List;
+	Array<PcDef *>			Loaded;			// with a poster of their own
+	Array<int>				ChangedItems;
+
+private:
+	static void *			ThreadFunction( void * param );
+	void					Run();
+	// Lock must be held
+	int						FindRead( const int item ) const;
+	void					FreeRead( Read & read );
+	void					ReleasePoster( PcDef * app );
+};
+
 class AppManager : public PcManager
 {
 public:
@@ -62,7 +123,10 @@ public:
 	virtual void			OneTimeInit( const char * launchIntent );
 	virtual void			OneTimeShutdown();
 	void					LoadApps();
-	void					LoadPosters();
+	// The apps the app carousel shows, whose posters are loaded as it scrolls
+	void					SetPosterList( const Array<const PcDef *> & list );
+	// Once a frame, with where the carousel is. changed gets the items whose poster changed.
+	void					UpdatePosters( const float position, const float velocity, const float stop, const int halfWidth, Array<int> & changed );
 	void					AddApp(const String &name, const String &posterFileName, int id, bool isRunning);
 	void					RemoveApp( int id);
 
@@ -73,6 +137,7 @@ public:
 
     static const int 		PosterWidth;
     static const int 		PosterHeight;
+    static const int		POSTER_BUDGET_BYTES = 16 * 1024 * 1024;
 
     bool					updated;
 
@@ -81,6 +146,9 @@ private:
 
     GLuint					DefaultPoster;
 
+    AppPosterBackend		PosterBackend;
+    PosterLoader			Posters;
+
     virtual void 			ReadMetaData( PcDef *app );
     virtual void 			LoadPoster( PcDef *app );
 };
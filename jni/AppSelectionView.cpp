@@ -70,7 +70,7 @@ AppSelectionView::AppSelectionView( CinemaApp &cinema ) :
 	TitleRoot( NULL ),
 	MovieTitle( NULL ),
 	SelectionFrame( NULL ),
-	CenterPoster( NULL ),
+	PosterImages(),
 	CenterIndex( 0 ),
 	CenterPosition(),
 	LeftSwipes(),
@@ -89,6 +89,7 @@ AppSelectionView::AppSelectionView( CinemaApp &cinema ) :
 	MovieBrowser( NULL ),
 	MoviePanelPositions(),
 	MoviePosterComponents(),
+	ChangedPosters(),
 	Categories(),
 	CurrentCategory( CATEGORY_LIMELIGHT ),
 	AppList(),
@@ -118,8 +119,11 @@ AppSelectionView::AppSelectionView( CinemaApp &cinema ) :
 	settingsVersion(1.0f),
 	defaultSettingsPath(""),
 	appSettingsPath(""),
+	hostSettingsPath(""),
 	defaultSettings( NULL ),
-	appSettings( NULL )
+	appSettings( NULL ),
+	hostSettings( NULL ),
+	settingsBinding( GetStreamTheaterSchema() )
 {
 	// This is called at library load time, so the system is not initialized
 	// properly yet.
@@ -454,10 +458,7 @@ void AppSelectionView::CreateMenu( OvrGuiSys & guiSys )
 		posterImage->GetMenuObject()->AddFlags( VRMENUOBJECT_FLAG_NO_FOCUS_GAINED );
 		posterImage->GetMenuObject()->SetLocalBoundsExpand( selectionBoundsExpandMin, selectionBoundsExpandMax );
 
-		if ( i == CenterIndex )
-		{
-			CenterPoster = posterImage;
-		}
+		PosterImages.PushBack( posterImage );
 
 		//
 		// 3D icon
@@ -491,6 +492,7 @@ void AppSelectionView::CreateMenu( OvrGuiSys & guiSys )
 	}
 
 	MovieBrowser->SetMenuObjects( menuObjs, MoviePosterComponents );
+	MovieBrowser->SetRecyclePanels( true );
 
 	// ==============================================================================
 	//
@@ -805,26 +807,43 @@ void AppSelectionView::SettingsButtonPressed()
 			defaultSettingsPath = outPath + "settings.json";
 			defaultSettings = new Settings(defaultSettingsPath);
 
-			defaultSettings->Define("StreamTheaterSettingsVersion", &settingsVersion);
-			defaultSettings->Define("MouseMode", (int*)&mouseMode);
-			defaultSettings->Define("StreamWidth", &streamWidth);
-			defaultSettings->Define("StreamHeight", &streamHeight);
-			defaultSettings->Define("StreamFPS", &streamFPS);
-			defaultSettings->Define("EnableHostAudio", &streamHostAudio);
+			settingsBinding.Bind<StreamSetting::SettingsVersion>(&settingsVersion);
+			settingsBinding.Bind<StreamSetting::MouseMode>(&mouseMode);
+			settingsBinding.Bind<StreamSetting::StreamWidth>(&streamWidth);
+			settingsBinding.Bind<StreamSetting::StreamHeight>(&streamHeight);
+			settingsBinding.Bind<StreamSetting::StreamFPS>(&streamFPS);
+			settingsBinding.Bind<StreamSetting::EnableHostAudio>(&streamHostAudio);
 		}
 
+		if(hostSettings != NULL)
+		{
+			delete(hostSettings);
+			hostSettings = NULL;
+		}
 		if(appSettings != NULL)
 		{
 			delete(appSettings);
 			appSettings = NULL;
 		}
 
+		const PcDef* pc = Cinema.GetCurrentPc();
+		if(pc != NULL)
+		{
+			hostSettingsPath = outPath + "settings.host." + pc->Name + ".json";
+			hostSettings = new Settings(hostSettingsPath);
+		}
+
 		appSettingsPath = outPath + "settings." + app->Name + ".json";
 		appSettings = new Settings(appSettingsPath);
-		appSettings->CopyDefines(*defaultSettings);
 
-		defaultSettings->Load();
-		appSettings->Load();
+		// Each file overrides what the ones before it have
+		settingsBinding.ApplyDefaults();
+		defaultSettings->Load(settingsBinding);
+		if(hostSettings != NULL)
+		{
+			hostSettings->Load(settingsBinding);
+		}
+		appSettings->Load(settingsBinding);
 	}
 
 	ButtonGaze->UpdateButtonState();
@@ -882,11 +901,11 @@ void AppSelectionView::SettingsPressed( UITextButton *button)
 	}
 	else if( button->GetText() == CinemaStrings::ButtonText_ButtonSaveApp )
 	{
-		appSettings->SaveChanged();
+		appSettings->SaveChanged(settingsBinding);
 	}
 	else if( button->GetText() == CinemaStrings::ButtonText_ButtonSaveDefault )
 	{
-		defaultSettings->SaveAll();
+		defaultSettings->SaveAll(settingsBinding);
 	}
 
 	ButtonGaze->UpdateButtonState();
@@ -947,11 +966,11 @@ bool AppSelectionView::SettingsIsActive( UITextButton *button)
 {
 	if( button->GetText() == CinemaStrings::ButtonText_ButtonSaveApp )
 	{
-		return appSettings->IsChanged();
+		return appSettings->IsChanged(settingsBinding);
 	}
 	else if( button->GetText() == CinemaStrings::ButtonText_ButtonSaveDefault )
 	{
-		return defaultSettings->IsChanged();
+		return defaultSettings->IsChanged(settingsBinding);
 	}
 	return false;
 }
@@ -976,19 +995,19 @@ void AppSelectionView::UpdateMenuPosition()
 {
 	// scale down when in a theater
 	const float scale = Cinema.InLobby ? 1.0f : 0.55f;
-	CenterRoot->GetMenuObject()->SetLocalScale( Vector3f( scale ) );
+	CenterRoot->SetLocalScale( Vector3f( scale ) );
 
 	if ( !Cinema.InLobby && Cinema.SceneMgr.SceneInfo.UseFreeScreen )
 	{
 		Quatf orientation = Quatf( Cinema.SceneMgr.FreeScreenPose );
-		CenterRoot->GetMenuObject()->SetLocalRotation( orientation );
-		CenterRoot->GetMenuObject()->SetLocalPosition( Cinema.SceneMgr.FreeScreenPose.Transform( Vector3f( 0.0f, -1.76f * scale, 0.0f ) ) );
+		CenterRoot->SetLocalRotation( orientation );
+		CenterRoot->SetLocalPosition( Cinema.SceneMgr.FreeScreenPose.Transform( Vector3f( 0.0f, -1.76f * scale, 0.0f ) ) );
 	}
 	else
 	{
 		const float menuOffset = Cinema.InLobby ? 0.0f : 0.5f;
-		CenterRoot->GetMenuObject()->SetLocalRotation( Quatf() );
-		CenterRoot->GetMenuObject()->SetLocalPosition( ScalePosition( Vector3f::ZERO, scale, menuOffset ) );
+		CenterRoot->SetLocalRotation( Quatf() );
+		CenterRoot->SetLocalPosition( ScalePosition( Vector3f::ZERO, scale, menuOffset ) );
 	}
 }
 
@@ -1066,6 +1085,7 @@ void AppSelectionView::SetAppList( const Array<const PcDef *> &movies, const PcD
 		MovieBrowserItems.PushBack( item );
 	}
 	MovieBrowser->SetItems( MovieBrowserItems );
+	Cinema.AppMgr.SetPosterList( AppList );
 
 	MovieTitle->SetText( "" );
 	LastMovieDisplayed = NULL;
@@ -1160,11 +1180,20 @@ void AppSelectionView::SelectionHighlighted( bool isHighlighted )
 	if ( isHighlighted && !ShowTimer && !Cinema.InLobby && ( MoviesIndex == MovieBrowser->GetSelection() ) )
 	{
 		// dim the poster when the resume icon is up and the poster is highlighted
-		CenterPoster->SetColor( Vector4f( 0.55f, 0.55f, 0.55f, 1.0f ) );
+		SetSelectedPosterColor( Vector4f( 0.55f, 0.55f, 0.55f, 1.0f ) );
 	}
 	else if ( MovieBrowser->HasSelection() )
 	{
-		CenterPoster->SetColor( Vector4f( 1.0f ) );
+		SetSelectedPosterColor( Vector4f( 1.0f ) );
+	}
+}
+
+void AppSelectionView::SetSelectedPosterColor( const Vector4f & color )
+{
+	const int panel = MovieBrowser->GetSelectionPanel();
+	if ( panel >= 0 )
+	{
+		PosterImages[ panel ]->SetColor( color );
 	}
 }
 
@@ -1223,7 +1252,7 @@ void AppSelectionView::UpdateSelectionFrame( const VrFrame & vrFrame )
 			TimerIcon->SetText( text );
 		}
 		TimerIcon->SetVisible( true );
-		CenterPoster->SetColor( Vector4f( 0.55f, 0.55f, 0.55f, 1.0f ) );
+		SetSelectedPosterColor( Vector4f( 0.55f, 0.55f, 0.55f, 1.0f ) );
 	}
 	else
 	{
@@ -1396,8 +1425,8 @@ Matrix4f AppSelectionView::Frame( const VrFrame & vrFrame )
 		{
 			Cinema.SceneMgr.PutScreenInFront();
 			Quatf orientation = Quatf( Cinema.SceneMgr.FreeScreenPose );
-			CenterRoot->GetMenuObject()->SetLocalRotation( orientation );
-			CenterRoot->GetMenuObject()->SetLocalPosition( Cinema.SceneMgr.FreeScreenPose.Transform( Vector3f( 0.0f, -1.76f * 0.55f, 0.0f ) ) );
+			CenterRoot->SetLocalRotation( orientation );
+			CenterRoot->SetLocalPosition( Cinema.SceneMgr.FreeScreenPose.Transform( Vector3f( 0.0f, -1.76f * 0.55f, 0.0f ) ) );
 
 		}
 		else
@@ -1419,10 +1448,23 @@ Matrix4f AppSelectionView::Frame( const VrFrame & vrFrame )
 	if (Cinema.AppMgr.updated) {
 		LOG("Updating App list");
 		Cinema.AppMgr.updated = false;
-		Cinema.AppMgr.LoadPosters();
 		SetAppList(Cinema.AppMgr.GetAppList(CurrentCategory), NULL);
 	}
 
+	Cinema.AppMgr.UpdatePosters( MovieBrowser->GetScrollPosition(), MovieBrowser->GetVelocity(), MovieBrowser->GetStopPosition(),
+			MoviePanelPositions.GetSizeI() / 2, ChangedPosters );
+	for ( int i = 0; i < ChangedPosters.GetSizeI(); i++ )
+	{
+		const int item = ChangedPosters[ i ];
+		MovieBrowserItems[ item ]->texture = AppList[ item ]->Poster;
+		MovieBrowserItems[ item ]->textureWidth = AppList[ item ]->PosterWidth;
+		MovieBrowserItems[ item ]->textureHeight = AppList[ item ]->PosterHeight;
+	}
+	if ( ChangedPosters.GetSizeI() > 0 )
+	{
+		MovieBrowser->ItemsChanged();
+	}
+
 	return Cinema.SceneMgr.Frame( vrFrame );
 }
 
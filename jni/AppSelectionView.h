@@ -111,7 +111,7 @@ private:
 
 	UIImage *							SelectionFrame;
 
-	UIImage *							CenterPoster;
+	Array<UIImage *>					PosterImages;			// by the carousel's menu objects
 	UPInt								CenterIndex;
 	Vector3f							CenterPosition;
 
@@ -138,6 +138,7 @@ private:
 	Array<PanelPose>					MoviePanelPositions;
 
 	Array<CarouselItemComponent *>	 	MoviePosterComponents;
+	Array<int>							ChangedPosters;			// this frame's, by item
 
 	Array<AppCategoryButton>			Categories;
     PcCategory			 				CurrentCategory;
@@ -175,8 +176,11 @@ private:
 	float								settingsVersion;
 	String								defaultSettingsPath;
 	String								appSettingsPath;
+	String								hostSettingsPath;
 	Settings*							defaultSettings;
 	Settings*							appSettings;
+	Settings*							hostSettings;
+	SettingsBinding						settingsBinding;
 
 
 
@@ -192,6 +196,8 @@ private:
 
 	void								UpdateAppTitle();
 	void								UpdateSelectionFrame( const VrFrame & vrFrame );
+	// The poster showing the selected item, whichever of the panels it is on
+	void								SetSelectedPosterColor( const Vector4f & color );
 
 	friend void							AppCloseAppButtonCallback( UIButton *button, void *object );
 	void								CloseAppButtonPressed();
@@ -21,16 +21,116 @@ using namespace OVR;
 
 namespace VRMatterStreamTheater {
 
+//==============================================================
+// CarouselMotion
+const double CarouselMotion::STEP_SECONDS = 1.0 / 120.0;
+const float CarouselMotion::FRICTION = 10.0f;
+const float CarouselMotion::STOP_DISTANCE = 0.005f;
+const double CarouselMotion::MAX_FRAME_SECONDS = 0.25;
+
+// What's left of the velocity after a step
+static float StepDecay()
+{
+	return expf( -CarouselMotion::FRICTION * ( float )CarouselMotion::STEP_SECONDS );
+}
+
+CarouselMotion::CarouselMotion() :
+	StepPosition( 0.0f ), PrevStepPosition( 0.0f ), Velocity( 0.0f ), Target( 0.0f ), Accumulator( 0.0 ), Moving( false )
+{
+}
+
+void CarouselMotion::Reset( const float position )
+{
+	StepPosition = position;
+	PrevStepPosition = position;
+	Target = position;
+	Velocity = 0.0f;
+	Accumulator = 0.0;
+	Moving = false;
+}
+
+bool CarouselMotion::Fling( const float distance, const int lastItem )
+{
+	// keep going where it was going when flung the same way again
+	const bool sameWay = Moving && ( ( Target - StepPosition ) * distance > 0.0f );
+	const float from = sameWay ? Target : StepPosition;
+
+	float target = floorf( from + distance + 0.5f );
+	if ( distance > 0.0f )
+	{
+		target = Alg::Max( target, floorf( from ) + 1.0f );
+	}
+	else
+	{
+		target = Alg::Min( target, ceilf( from ) - 1.0f );
+	}
+	target = Alg::Max( Alg::Min( target, ( float )lastItem ), 0.0f );
+
+	if ( ( Moving && ( target == Target ) ) || ( !Moving && ( fabsf( target - StepPosition ) < STOP_DISTANCE ) ) )
+	{
+		return false;
+	}
+
+	// Each step moves Velocity * STEP_SECONDS after decaying, so from here it
+	// coasts Velocity * STEP_SECONDS * decay / ( 1 - decay ), which has to end on target
+	const float decay = StepDecay();
+	Target = target;
+	Velocity = ( Target - StepPosition ) * ( 1.0f - decay ) / ( ( float )STEP_SECONDS * decay );
+	Moving = true;
+	return true;
+}
+
+void CarouselMotion::Advance( const double seconds )
+{
+	if ( !Moving )
+	{
+		return;
+	}
+
+	const float decay = StepDecay();
+	Accumulator += Alg::Min( seconds, MAX_FRAME_SECONDS );
+	while ( Accumulator >= STEP_SECONDS )
+	{
+		Accumulator -= STEP_SECONDS;
+		PrevStepPosition = StepPosition;
+		Velocity *= decay;
+		StepPosition += Velocity * ( float )STEP_SECONDS;
+		if ( fabsf( Target - StepPosition ) < STOP_DISTANCE )
+		{
+			Reset( Target );
+			return;
+		}
+	}
+}
+
+float CarouselMotion::GetPosition() const
+{
+	if ( !Moving )
+	{
+		return StepPosition;
+	}
+
+	const float frac = ( float )( Accumulator / STEP_SECONDS );
+	return PrevStepPosition + ( StepPosition - PrevStepPosition ) * frac;
+}
+
 //==============================================================
 // CarouselBrowserComponent
+
+// How far a swipe flings, from its length in swipe fractions over how long the touch was down
+static const float ITEMS_PER_SWIPE_SPEED = 0.1f;
+static const float MAX_SWIPE_ITEMS = 12.0f;
+static const float MIN_SWIPE_SECONDS = 0.05f;
 CarouselBrowserComponent::CarouselBrowserComponent( const Array<CarouselItem *> &items, const Array<PanelPose> &panelPoses ) :
 	VRMenuComponent( VRMenuEventFlags_t( VRMENU_EVENT_FRAME_UPDATE ) | 	VRMENU_EVENT_TOUCH_DOWN | 
 		VRMENU_EVENT_SWIPE_FORWARD | VRMENU_EVENT_SWIPE_BACK | VRMENU_EVENT_TOUCH_UP | VRMENU_EVENT_OPENED | VRMENU_EVENT_CLOSED ),
 		SelectPressed( false ), PositionScale( 1.0f ), Position( 0.0f ), TouchDownTime( -1.0 ),
-		ItemWidth( 0 ), ItemHeight( 0 ), Items(), MenuObjs(), MenuComps(), PanelPoses( panelPoses ),
-		StartTime( 0.0 ), EndTime( 0.0 ), PrevPosition( 0.0f ), NextPosition( 0.0f ), Swiping( false ), PanelsNeedUpdate( false )
+		ItemWidth( 0 ), ItemHeight( 0 ), Items(), MenuObjs(), MenuComps(), PanelPoses( panelPoses ), PoseTable(), PanelItems(),
+		Motion(), LastFrameTime( 0.0 ), PrefetchCallback( NULL ), PrefetchObject( NULL ), Swiping( false ), PanelsNeedUpdate( false ),
+		RecyclePanels( false )
 
 {
+	BuildPoseTable();
 	SetItems( items );
 }
 
@@ -64,7 +164,12 @@ eMsgStatus CarouselBrowserComponent::OnEvent_Impl( OvrGuiSys & guiSys, VrFrame c
 void CarouselBrowserComponent::SetPanelPoses( OvrVRMenuMgr & menuMgr, VRMenuObject * self, const Array<PanelPose> &panelPoses )
 {
 	PanelPoses = panelPoses;
-	UpdatePanels( menuMgr, self );
+	BuildPoseTable();
+	for ( int i = 0; i < PanelItems.GetSizeI(); i++ )
+	{
+		PanelItems[ i ] = -2;
+	}
+	UpdatePanels();
 }
 
 void CarouselBrowserComponent::SetMenuObjects( const Array<VRMenuObject *> &menuObjs, const Array<CarouselItemComponent *> &menuComps )
@@ -72,7 +177,26 @@ void CarouselBrowserComponent::SetMenuObjects( const Array<VRMenuObject *> &menu
 	MenuObjs = menuObjs;
 	MenuComps = menuComps;
 
-	assert( MenuObjs.GetSizeI() == MenuObjs.GetSizeI() );
+	assert( MenuObjs.GetSizeI() == MenuComps.GetSizeI() );
+
+	PanelItems.Resize( MenuObjs.GetSize() );
+	for ( int i = 0; i < PanelItems.GetSizeI(); i++ )
+	{
+		PanelItems[ i ] = -2;
+	}
+	PanelsNeedUpdate = true;
+}
+
+void CarouselBrowserComponent::SetPrefetchCallback( void ( *callback )( int firstItem, int lastItem, void * object ), void * object )
+{
+	PrefetchCallback = callback;
+	PrefetchObject = object;
+}
+
+void CarouselBrowserComponent::SetRecyclePanels( const bool recycle )
+{
+	RecyclePanels = recycle;
+	PanelsNeedUpdate = true;
 }
 
 PanelPose CarouselBrowserComponent::GetPosition( const float t )
@@ -108,6 +232,49 @@ PanelPose CarouselBrowserComponent::GetPosition( const float t )
 	return pose;
 }
 
+void CarouselBrowserComponent::BuildPoseTable()
+{
+	PoseTable.Clear();
+	if ( PanelPoses.GetSizeI() == 0 )
+	{
+		return;
+	}
+
+	const int samples = ( PanelPoses.GetSizeI() - 1 ) * POSE_SAMPLES_PER_PANEL + 1;
+	PoseTable.Resize( samples );
+	for ( int i = 0; i < samples; i++ )
+	{
+		PoseTable[ i ] = GetPosition( ( float )i / POSE_SAMPLES_PER_PANEL );
+	}
+}
+
+// Position and color are linear between panel poses, so they come out of the
+// table as they went in. Orientation is the nearest sample's.
+PanelPose CarouselBrowserComponent::LookupPose( const float t ) const
+{
+	const float sample = t * POSE_SAMPLES_PER_PANEL;
+	const int last = PoseTable.GetSizeI() - 1;
+	if ( sample <= 0.0f )
+	{
+		return PoseTable[ 0 ];
+	}
+	if ( sample >= last )
+	{
+		return PoseTable[ last ];
+	}
+
+	const int index = ( int )sample;
+	const float frac = sample - ( float )index;
+	const PanelPose & a = PoseTable[ index ];
+	const PanelPose & b = PoseTable[ index + 1 ];
+
+	PanelPose pose;
+	pose.Orientation = ( frac < 0.5f ) ? a.Orientation : b.Orientation;
+	pose.Position = a.Position.Lerp( b.Position, frac );
+	pose.Color = a.Color * ( 1.0f - frac ) + b.Color * frac;
+	return pose;
+}
+
 void CarouselBrowserComponent::SetSelectionIndex( const int selectedIndex )
 {
 	if ( ( selectedIndex >= 0 ) && ( selectedIndex < Items.GetSizeI() ) )
@@ -119,7 +286,7 @@ void CarouselBrowserComponent::SetSelectionIndex( const int selectedIndex )
 		Position = 0.0f;
 	}
 
-	NextPosition = Position;
+	Motion.Reset( Position );
 	Swiping = false;
 	PanelsNeedUpdate = true;
 }
@@ -145,6 +312,23 @@ bool CarouselBrowserComponent::HasSelection() const
 	return !Swiping;
 }
 
+int CarouselBrowserComponent::GetSelectionPanel() const
+{
+	const int itemIndex = GetSelection();
+	if ( ( itemIndex < 0 ) || ( MenuObjs.GetSizeI() == 0 ) )
+	{
+		return -1;
+	}
+
+	if ( RecyclePanels )
+	{
+		return itemIndex % MenuObjs.GetSizeI();
+	}
+
+	const int panel = itemIndex - ( int )floor( Position ) + PanelPoses.GetSizeI() / 2;
+	return ( ( panel >= 0 ) && ( panel < MenuObjs.GetSizeI() ) ) ? panel : -1;
+}
+
 bool CarouselBrowserComponent::CanSwipeBack() const
 {
 	float nextPos = floor( Position ) - 1.0f;
@@ -157,24 +341,45 @@ bool CarouselBrowserComponent::CanSwipeForward() const
 	return ( nextPos < Items.GetSizeI() );
 }
 
-void CarouselBrowserComponent::UpdatePanels( OvrVRMenuMgr & menuMgr, VRMenuObject * self )
+void CarouselBrowserComponent::UpdatePanels()
 {
-	int centerIndex = floor( Position );
-	float offset = centerIndex - Position;
-	int leftIndex = centerIndex - PanelPoses.GetSizeI() / 2;
+	const int panelCount = MenuObjs.GetSizeI();
+	if ( ( panelCount == 0 ) || ( PoseTable.GetSizeI() == 0 ) )
+	{
+		PanelsNeedUpdate = false;
+		return;
+	}
+
+	// item i is at i - Position + center along the path, which is on screen from 0 to its last pose
+	const float center = ( float )( PanelPoses.GetSizeI() / 2 );
+	const int leftItem = ( int )floor( Position ) - PanelPoses.GetSizeI() / 2;
+	const float lastPose = ( float )( PanelPoses.GetSizeI() - 1 );
+	int firstItem = ( int )ceil( Position - center );
+	int lastItem = ( int )floor( Position - center + lastPose );
+	firstItem = Alg::Max( firstItem, 0 );
+	lastItem = Alg::Min( Alg::Min( lastItem, Items.GetSizeI() - 1 ), firstItem + panelCount - 1 );
 
-	int itemIndex = leftIndex;
-	for( int i = 0; i < MenuObjs.GetSizeI(); i++, itemIndex++ )
+	for ( int i = 0; i < panelCount; i++ )
 	{
-		PanelPose pose = GetPosition( ( float )i + offset );
-		if ( ( itemIndex < 0 ) || ( itemIndex >= Items.GetSizeI() ) || ( ( offset < 0.0f ) && ( i == 0 ) ) )
+		// the item on screen that goes to this object, if there is one
+		int itemIndex = RecyclePanels ? firstItem + ( ( ( i - firstItem ) % panelCount ) + panelCount ) % panelCount : leftItem + i;
+		if ( ( itemIndex < firstItem ) || ( itemIndex > lastItem ) )
 		{
-			MenuComps[ i ]->SetItem( MenuObjs[ i ], NULL, pose );
+			itemIndex = -1;
 		}
-		else
+
+		if ( itemIndex < 0 )
 		{
-			MenuComps[ i ]->SetItem( MenuObjs[ i ], Items[ itemIndex ], pose );
+			if ( PanelItems[ i ] != -1 )
+			{
+				MenuComps[ i ]->SetItem( MenuObjs[ i ], NULL, PoseTable[ 0 ] );
+				PanelItems[ i ] = -1;
+			}
+			continue;
 		}
+
+		MenuComps[ i ]->SetItem( MenuObjs[ i ], Items[ itemIndex ], LookupPose( ( float )itemIndex - Position + center ) );
+		PanelItems[ i ] = itemIndex;
 	}
 
 	PanelsNeedUpdate = false;
@@ -182,20 +387,21 @@ void CarouselBrowserComponent::UpdatePanels( OvrVRMenuMgr & menuMgr, VRMenuObjec
 
 void CarouselBrowserComponent::CheckGamepad( OvrGuiSys & guiSys, VrFrame const & vrFrame, VRMenuObject * self )
 {
-	if ( Swiping )
+	// held down, it steps on once it's most of the way to the last item
+	if ( Swiping && ( fabsf( Motion.GetStop() - Position ) > 0.2f ) )
 	{
 		return;
 	}
 
-	if ( CanSwipeBack() && ( ( vrFrame.Input.buttonState & BUTTON_DPAD_LEFT ) || ( vrFrame.Input.sticks[0][0] < -0.5f ) ) )
+	if ( ( vrFrame.Input.buttonState & BUTTON_DPAD_LEFT ) || ( vrFrame.Input.sticks[0][0] < -0.5f ) )
 	{
-		SwipeBack( guiSys, vrFrame, self );
+		Fling( guiSys, vrFrame, -1.0f );
 		return;
 	}
 
-	if ( CanSwipeForward() && ( ( vrFrame.Input.buttonState & BUTTON_DPAD_RIGHT ) || ( vrFrame.Input.sticks[0][0] > 0.5f ) ) )
+	if ( ( vrFrame.Input.buttonState & BUTTON_DPAD_RIGHT ) || ( vrFrame.Input.sticks[0][0] > 0.5f ) )
 	{
-		SwipeForward( guiSys, vrFrame, self );
+		Fling( guiSys, vrFrame, 1.0f );
 		return;
 	}
 }
@@ -204,63 +410,62 @@ eMsgStatus CarouselBrowserComponent::Frame( OvrGuiSys & guiSys, VrFrame const &
 {
 	if ( Swiping )
 	{
-		float frac = ( vrFrame.PredictedDisplayTimeInSeconds - StartTime ) / ( EndTime - StartTime );
-		if ( frac >= 1.0f )
-		{
-			frac = 1.0f;
-			Swiping = false;
-		}
-
-		float easeOutQuad = -1.0f * frac * ( frac - 2.0f );
-
-		Position = PrevPosition * ( 1.0f - easeOutQuad ) + NextPosition * easeOutQuad;
-
+		Motion.Advance( vrFrame.PredictedDisplayTimeInSeconds - LastFrameTime );
+		LastFrameTime = vrFrame.PredictedDisplayTimeInSeconds;
+		Position = Motion.GetPosition();
+		Swiping = Motion.IsMoving();
 		PanelsNeedUpdate = true;
 	}
 
 	if ( PanelsNeedUpdate )
 	{
-		UpdatePanels( guiSys.GetVRMenuMgr(), self );
+		UpdatePanels();
 	}
 
 	return MSG_STATUS_ALIVE;
 }
 
-eMsgStatus CarouselBrowserComponent::SwipeForward( OvrGuiSys & guiSys, VrFrame const & vrFrame, VRMenuObject * self )
+bool CarouselBrowserComponent::Fling( OvrGuiSys & guiSys, VrFrame const & vrFrame, const float distance )
 {
+	if ( !Motion.Fling( distance, Items.GetSizeI() - 1 ) )
+	{
+		return false;
+	}
+
+	guiSys.GetApp()->PlaySound( "carousel_move" );
 	if ( !Swiping )
 	{
-		float nextPos = floor( Position ) + 1.0f;
-		if ( nextPos < Items.GetSizeI() )
-		{
-			guiSys.GetApp()->PlaySound( "carousel_move" );
-			PrevPosition = Position;
-			StartTime = vrFrame.PredictedDisplayTimeInSeconds;
-			EndTime = StartTime + 0.25;
-			NextPosition = nextPos;
-			Swiping = true;
-		}
+		LastFrameTime = vrFrame.PredictedDisplayTimeInSeconds;
+		Swiping = true;
+	}
+
+	if ( PrefetchCallback != NULL )
+	{
+		const int stop = ( int )Motion.GetStop();
+		const int center = PanelPoses.GetSizeI() / 2;
+		PrefetchCallback( Alg::Max( stop - center, 0 ), Alg::Min( stop + center, Items.GetSizeI() - 1 ), PrefetchObject );
 	}
+	return true;
+}
+
+// How far a swipe flings, in items
+static float SwipeDistance( VrFrame const & vrFrame, const double touchDownTime )
+{
+	const float seconds = ( touchDownTime < 0.0 ) ? MIN_SWIPE_SECONDS :
+			Alg::Max( ( float )( vrapi_GetTimeInSeconds() - touchDownTime ), MIN_SWIPE_SECONDS );
+	const float items = vrFrame.Input.swipeFraction / seconds * ITEMS_PER_SWIPE_SPEED;
+	return Alg::Max( Alg::Min( items, MAX_SWIPE_ITEMS ), 1.0f );
+}
 
+eMsgStatus CarouselBrowserComponent::SwipeForward( OvrGuiSys & guiSys, VrFrame const & vrFrame, VRMenuObject * self )
+{
+	Fling( guiSys, vrFrame, SwipeDistance( vrFrame, TouchDownTime ) );
 	return MSG_STATUS_CONSUMED;
 }
 
 eMsgStatus CarouselBrowserComponent::SwipeBack( OvrGuiSys & guiSys, VrFrame const & vrFrame, VRMenuObject * self )
 {
-	if ( !Swiping )
-	{
-		float nextPos = floor( Position ) - 1.0f;
-		if ( nextPos >= 0.0f )
-		{
-			guiSys.GetApp()->PlaySound( "carousel_move" );
-			PrevPosition = Position;
-			StartTime = vrFrame.PredictedDisplayTimeInSeconds;
-			EndTime = StartTime + 0.25;
-			NextPosition = nextPos;
-			Swiping = true;
-		}
-	}
-
+	Fling( guiSys, vrFrame, -SwipeDistance( vrFrame, TouchDownTime ) );
 	return MSG_STATUS_CONSUMED;
 }
 
@@ -303,6 +508,7 @@ eMsgStatus CarouselBrowserComponent::Opened( OvrGuiSys & guiSys, VrFrame const &
 {
 	Swiping = false;
 	Position = floor( Position );
+	Motion.Reset( Position );
 	SelectPressed = false;
 	return MSG_STATUS_ALIVE;
 }
@@ -319,11 +525,300 @@ void CarouselBrowserComponent::SetItems( const Array<CarouselItem *> &items )
 	SelectPressed = false;
 	Position = 0.0f;
 	TouchDownTime = -1.0;
-	StartTime = 0.0;
-	EndTime = 0.0;
-	PrevPosition = 0.0f;
-	NextPosition = 0.0f;
+	Motion.Reset( 0.0f );
+	Swiping = false;
 	PanelsNeedUpdate = true;
 }
 
+#ifndef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+
+class BenchmarkItemComponent : public CarouselItemComponent
+{
+public:
+							BenchmarkItemComponent() :
+								CarouselItemComponent( VRMenuEventFlags_t() ),
+								CurrentItem( NULL ), Sets( 0 ), Changes( 0 )
+							{
+							}
+
+	virtual void			SetItem( VRMenuObject * self, const CarouselItem * item, const PanelPose &pose )
+	{
+		Sets++;
+		if ( item != CurrentItem )
+		{
+			Changes++;
+			CurrentItem = item;
+		}
+	}
+
+	const CarouselItem *	CurrentItem;
+	int						Sets;
+	int						Changes;
+
+private:
+	virtual eMsgStatus		OnEvent_Impl( OvrGuiSys & guiSys, VrFrame const & vrFrame, VRMenuObject * self, VRMenuEvent const & event )
+	{
+		return MSG_STATUS_ALIVE;
+	}
+};
+
+void CarouselBrowserBenchmark()
+{
+	static const int FRAMES_PER_ITEM = 16;	// a quarter second swipe at 60 fps
+	static const int ITEM_COUNTS[] = { 7, 50, 500, 5000 };
+
+	// the poster carousel's poses
+	const Quatf forward( Vector3f( 0.0f, 1.0f, 0.0f ), 0.0f );
+	Array<PanelPose> panelPoses;
+	panelPoses.PushBack( PanelPose( forward, Vector3f( -5.59f, 1.76f, -12.55f ), Vector4f( 0.0f, 0.0f, 0.0f, 0.0f ) ) );
+	panelPoses.PushBack( PanelPose( forward, Vector3f( -3.82f, 1.76f, -10.97f ), Vector4f( 0.1f, 0.1f, 0.1f, 1.0f ) ) );
+	panelPoses.PushBack( PanelPose( forward, Vector3f( -2.05f, 1.76f,  -9.39f ), Vector4f( 0.2f, 0.2f, 0.2f, 1.0f ) ) );
+	panelPoses.PushBack( PanelPose( forward, Vector3f(  0.00f, 1.76f,  -7.39f ), Vector4f( 1.0f, 1.0f, 1.0f, 1.0f ) ) );
+	panelPoses.PushBack( PanelPose( forward, Vector3f(  2.05f, 1.76f,  -9.39f ), Vector4f( 0.2f, 0.2f, 0.2f, 1.0f ) ) );
+	panelPoses.PushBack( PanelPose( forward, Vector3f(  3.82f, 1.76f, -10.97f ), Vector4f( 0.1f, 0.1f, 0.1f, 1.0f ) ) );
+	panelPoses.PushBack( PanelPose( forward, Vector3f(  5.59f, 1.76f, -12.55f ), Vector4f( 0.0f, 0.0f, 0.0f, 0.0f ) ) );
+	const int panelCount = panelPoses.GetSizeI();
+
+	for ( int c = 0; c < ( int )( sizeof( ITEM_COUNTS ) / sizeof( ITEM_COUNTS[0] ) ); c++ )
+	{
+		const int itemCount = ITEM_COUNTS[ c ];
+		Array<CarouselItem *> items;
+		for ( int i = 0; i < itemCount; i++ )
+		{
+			items.PushBack( new CarouselItem() );
+		}
+
+		CarouselBrowserComponent * carousel = new CarouselBrowserComponent( items, panelPoses );
+		Array<VRMenuObject *> menuObjs;
+		Array<CarouselItemComponent *> menuComps;
+		Array<BenchmarkItemComponent *> benchmarkComps;
+		for ( int i = 0; i < panelCount; i++ )
+		{
+			BenchmarkItemComponent * comp = new BenchmarkItemComponent();
+			menuObjs.PushBack( NULL );
+			menuComps.PushBack( comp );
+			benchmarkComps.PushBack( comp );
+		}
+		carousel->SetMenuObjects( menuObjs, menuComps );
+		carousel->SetRecyclePanels( true );
+
+		if ( c == 0 )
+		{
+			// the table poses panels where interpolating the panel poses would
+			float maxError = 0.0f;
+			for ( float t = -0.5f; t <= panelCount - 1; t += 0.01f )
+			{
+				const Vector3f a = carousel->GetPosition( t ).Position;
+				const Vector3f b = carousel->LookupPose( t ).Position;
+				maxError = Alg::Max( maxError, ( a - b ).Length() );
+			}
+			assert( maxError < 0.0001f );
+		}
+
+		const int frames = ( itemCount - 1 ) * FRAMES_PER_ITEM + 1;
+		double total = 0.0;
+		double max = 0.0;
+		int maxSets = 0;
+		for ( int frame = 0; frame < frames; frame++ )
+		{
+			int setsBefore = 0;
+			for ( int i = 0; i < panelCount; i++ )
+			{
+				setsBefore += benchmarkComps[ i ]->Sets;
+			}
+
+			carousel->Position = ( float )frame / FRAMES_PER_ITEM;
+			const double start = vrapi_GetTimeInSeconds();
+			carousel->UpdatePanels();
+			const double elapsed = vrapi_GetTimeInSeconds() - start;
+			total += elapsed;
+			max = Alg::Max( max, elapsed );
+
+			int sets = -setsBefore;
+			for ( int i = 0; i < panelCount; i++ )
+			{
+				sets += benchmarkComps[ i ]->Sets;
+			}
+			maxSets = Alg::Max( maxSets, sets );
+
+			// every item on screen is on a panel
+			const float center = ( float )( panelCount / 2 );
+			const int firstItem = Alg::Max( ( int )floor( carousel->Position - center ), 0 );
+			for ( int item = firstItem; ( item < itemCount ) && ( item <= firstItem + panelCount ); item++ )
+			{
+				const float t = ( float )item - carousel->Position + center;
+				if ( ( t >= 0.0f ) && ( t <= panelCount - 1 ) )
+				{
+					assert( benchmarkComps[ item % panelCount ]->CurrentItem == items[ item ] );
+				}
+			}
+		}
+
+		int changes = 0;
+		for ( int i = 0; i < panelCount; i++ )
+		{
+			changes += benchmarkComps[ i ]->Changes;
+		}
+
+		// each item comes on once, and goes off once
+		assert( maxSets <= panelCount );
+		assert( changes <= 2 * itemCount + panelCount );
+
+		LOG( "CarouselBrowserBenchmark: %i items, %i frames, %.2f us mean %.2f us max a frame, "
+				"at most %i panels set a frame, %i item changes (%.2f an item)",
+				itemCount, frames, total / frames * 1e6, max * 1e6, maxSets, changes, ( float )changes / itemCount );
+
+		delete carousel;
+		for ( int i = 0; i < panelCount; i++ )
+		{
+			delete benchmarkComps[ i ];
+		}
+		for ( int i = 0; i < itemCount; i++ )
+		{
+			delete items[ i ];
+		}
+	}
+}
+
+static const double SAMPLE_SECONDS = 1.0 / 30.0;
+static const int MAX_SAMPLES = 300;
+
+struct MotionRun
+{
+	float	Samples[ MAX_SAMPLES ];
+	int		SampleCount;
+	double	StopSeconds;
+	float	Stop;
+	bool	Monotonic;
+};
+
+// A fling from rest at position, then frames of frameSeconds, every
+// hitchEvery'th taking hitchSeconds, until it stops. Without hitches, where it
+// was every SAMPLE_SECONDS is kept.
+static void RunMotion( MotionRun & run, const float position, const float distance, const int lastItem,
+		const double frameSeconds, const int hitchEvery, const double hitchSeconds )
+{
+	CarouselMotion motion;
+	motion.Reset( position );
+	motion.Fling( distance, lastItem );
+	run.Stop = motion.GetStop();
+	run.SampleCount = 0;
+	run.Monotonic = true;
+
+	double now = 0.0;
+	float last = position;
+	for ( int frame = 1; motion.IsMoving() && ( now < 10.0 ); frame++ )
+	{
+		const double seconds = ( ( hitchEvery > 0 ) && ( frame % hitchEvery == 0 ) ) ? hitchSeconds : frameSeconds;
+		// the frame's sample times, got to by advancing a copy only as far as them
+		while ( ( hitchEvery == 0 ) && ( run.SampleCount < MAX_SAMPLES ) && ( run.SampleCount * SAMPLE_SECONDS <= now + seconds + 1e-9 ) )
+		{
+			CarouselMotion sampled = motion;
+			sampled.Advance( run.SampleCount * SAMPLE_SECONDS - now );
+			run.Samples[ run.SampleCount++ ] = sampled.GetPosition();
+		}
+		motion.Advance( seconds );
+		now += Alg::Min( seconds, CarouselMotion::MAX_FRAME_SECONDS );
+
+		// never back, never past the stop
+		const float p = motion.GetPosition();
+		if ( ( ( p - last ) * distance < -1e-5f ) || ( ( run.Stop - p ) * distance < -1e-5f ) )
+		{
+			run.Monotonic = false;
+		}
+		last = p;
+	}
+	run.StopSeconds = now;
+	assert( !motion.IsMoving() && ( motion.GetPosition() == run.Stop ) );
+}
+
+void CarouselMotionTest()
+{
+	static const int LAST_ITEM = 999;
+	static const double FRAME_SECONDS[] = { 1.0 / 30.0, 1.0 / 60.0, 1.0 / 72.0, 1.0 / 90.0, 1.0 / 120.0, 0.0123 };
+	static const float DISTANCES[] = { 1.0f, 2.6f, 12.0f, -1.0f, -7.3f };
+
+	for ( int d = 0; d < ( int )( sizeof( DISTANCES ) / sizeof( DISTANCES[0] ) ); d++ )
+	{
+		MotionRun reference;
+		RunMotion( reference, 500.0f, DISTANCES[ d ], LAST_ITEM, FRAME_SECONDS[ 0 ], 0, 0.0 );
+		assert( reference.Stop == floorf( 500.0f + DISTANCES[ d ] + 0.5f ) );
+		assert( reference.Monotonic );
+
+		for ( int f = 1; f < ( int )( sizeof( FRAME_SECONDS ) / sizeof( FRAME_SECONDS[0] ) ); f++ )
+		{
+			MotionRun run;
+			RunMotion( run, 500.0f, DISTANCES[ d ], LAST_ITEM, FRAME_SECONDS[ f ], 0, 0.0 );
+			assert( run.Monotonic && ( run.Stop == reference.Stop ) );
+			assert( fabs( run.StopSeconds - reference.StopSeconds ) <= FRAME_SECONDS[ 0 ] + 1e-9 );
+			const int samples = Alg::Min( run.SampleCount, reference.SampleCount );
+			for ( int i = 0; i < samples; i++ )
+			{
+				// the same but for where it snaps onto the stop, at most a step apart
+				assert( fabsf( run.Samples[ i ] - reference.Samples[ i ] ) <= CarouselMotion::STOP_DISTANCE + 0.001f );
+			}
+		}
+
+		// hitches lose time instead of jumping
+		MotionRun hitched;
+		RunMotion( hitched, 500.0f, DISTANCES[ d ], LAST_ITEM, FRAME_SECONDS[ 1 ], 10, 0.5 );
+		assert( hitched.Monotonic && ( hitched.Stop == reference.Stop ) );
+
+		char curve[ 512 ];
+		int length = 0;
+		for ( int i = 0; ( i < reference.SampleCount ) && ( i <= 12 ); i += 2 )
+		{
+			length += snprintf( curve + length, sizeof( curve ) - length, " %.3f", reference.Samples[ i ] - 500.0f );
+		}
+		LOG( "CarouselMotionTest: flung %.1f, stops on %.0f after %.3f s, every %.0f ms:%s",
+				DISTANCES[ d ], reference.Stop - 500.0f, reference.StopSeconds, 2 * SAMPLE_SECONDS * 1e3, curve );
+	}
+
+	// a single step is most of the way there as quickly as the old quarter second ease out
+	MotionRun step;
+	RunMotion( step, 0.0f, 1.0f, LAST_ITEM, 1.0 / 60.0, 0, 0.0 );
+	assert( ( step.SampleCount > 8 ) && ( step.Samples[ 8 ] > 0.9f ) && ( step.StopSeconds < 0.6 ) );
+
+	CarouselMotion motion;
+
+	// swipes in a row add up
+	motion.Reset( 0.0f );
+	double now = 0.0;
+	for ( int i = 0; i < 5; i++ )
+	{
+		assert( motion.Fling( 12.0f, LAST_ITEM ) );
+		motion.Advance( 0.1 );
+		now += 0.1;
+	}
+	assert( motion.GetStop() == 60.0f );
+	while ( motion.IsMoving() )
+	{
+		motion.Advance( 1.0 / 60.0 );
+		now += 1.0 / 60.0;
+	}
+	assert( motion.GetPosition() == 60.0f );
+	LOG( "CarouselMotionTest: 5 swipes 0.1 s apart went 60 items in %.2f s", now );
+
+	// swiping back while going forward turns it around, short of where it was
+	motion.Reset( 0.0f );
+	motion.Fling( 10.0f, LAST_ITEM );
+	motion.Advance( 0.1 );
+	const float turnedAt = motion.GetPosition();
+	assert( motion.Fling( -1.0f, LAST_ITEM ) );
+	assert( ( motion.GetStop() < turnedAt ) && ( motion.GetVelocity() < 0.0f ) );
+
+	// and it stays on the list
+	motion.Reset( ( float )LAST_ITEM - 2.0f );
+	assert( motion.Fling( 12.0f, LAST_ITEM ) && ( motion.GetStop() == ( float )LAST_ITEM ) );
+	assert( !motion.Fling( 1.0f, LAST_ITEM ) );
+	motion.Reset( 0.0f );
+	assert( !motion.Fling( -1.0f, LAST_ITEM ) );
+	assert( !motion.Fling( 1.0f, 0 ) );
+
+	LOG( "CarouselMotionTest passed" );
+}
+#endif
+
 } // namespace VRMatterStreamTheater
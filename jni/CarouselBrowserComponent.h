@@ -60,27 +60,89 @@ public:
 	virtual void 					SetItem( VRMenuObject * self, const CarouselItem * item, const PanelPose &pose ) = 0;
 };
 
+// Where a carousel is and where it's coasting to, in items. A fling sets the
+// item it stops on, from how far it would coast, and the carousel slows down
+// onto it under friction. It's advanced in fixed steps, whatever the frame
+// rate, and positions between steps are interpolated.
+class CarouselMotion
+{
+public:
+	static const double				STEP_SECONDS;
+	// Of the velocity lost a second
+	static const float				FRICTION;
+	// Close enough to the stop to be on it
+	static const float				STOP_DISTANCE;
+	// Frames longer than this, from a hitch, only advance this much
+	static const double				MAX_FRAME_SECONDS;
+
+									CarouselMotion();
+
+	void							Reset( const float position );
+	// Coasts distance items further, on top of a fling going the same way, to
+	// the nearest item at least one on from where it is and no further than
+	// lastItem. Returns false if that doesn't change where it stops.
+	bool							Fling( const float distance, const int lastItem );
+	void							Advance( const double seconds );
+
+	float							GetPosition() const;
+	float							GetVelocity() const { return Moving ? Velocity : 0.0f; }	// items a second
+	float							GetStop() const { return Target; }
+	bool							IsMoving() const { return Moving; }
+
+private:
+	float							StepPosition;
+	float							PrevStepPosition;
+	float							Velocity;
+	float							Target;
+	double							Accumulator;			// seconds since the last step
+	bool							Moving;
+};
+
+// Only the items on screen are given to menu objects, posed from a table the
+// path between panel poses is sampled into once. Menu objects stay with their
+// place on the carousel unless they're recycled: then each item goes to the
+// menu object at its index modulo how many there are, so as the carousel
+// scrolls an object keeps its item until it leaves the screen and only the
+// object coming on gets a new one.
+// Swipes fling it by how fast they were, so quick swipes in a row scroll
+// through a long list, and it lets whoever loads items' textures know which
+// will be on screen where a fling stops.
 class CarouselBrowserComponent : public VRMenuComponent
 {
 public:
+	static const int				POSE_SAMPLES_PER_PANEL = 32;
+
 									CarouselBrowserComponent( const Array<CarouselItem *> &items, const Array<PanelPose> &panelPoses );
 
 	void							SetPanelPoses( OvrVRMenuMgr & menuMgr, VRMenuObject * self, const Array<PanelPose> &panelPoses );
 	void 							SetMenuObjects( const Array<VRMenuObject *> &menuObjs, const Array<CarouselItemComponent *> &menuComps );
 	void							SetItems( const Array<CarouselItem *> &items );
+	void							SetRecyclePanels( const bool recycle );
+	// For items that changed in place, like a texture that finished loading
+	void							ItemsChanged() { PanelsNeedUpdate = true; }
+	// Called with the items that will be on screen when a fling stops, as soon as it's flung
+	void							SetPrefetchCallback( void ( *callback )( int firstItem, int lastItem, void * object ), void * object );
 	void							SetSelectionIndex( const int selectedIndex );
     int 							GetSelection() const;
 	bool							HasSelection() const;
+	// Which of the menu objects shows the selected item, -1 if none does
+	int								GetSelectionPanel() const;
 	bool							IsSwiping() const { return Swiping; }
 	bool							CanSwipeBack() const;
 	bool							CanSwipeForward() const;
+	float							GetScrollPosition() const { return Position; }
+	float							GetVelocity() const { return Motion.GetVelocity(); }
+	float							GetStopPosition() const { return Motion.GetStop(); }
 
 	void 							CheckGamepad( OvrGuiSys & guiSys, VrFrame const & vrFrame, VRMenuObject * self );
 
 private:
     virtual eMsgStatus 				OnEvent_Impl( OvrGuiSys & guiSys, VrFrame const & vrFrame, VRMenuObject * self, VRMenuEvent const & event );
     PanelPose 						GetPosition( const float t );
-    void 							UpdatePanels( OvrVRMenuMgr & menuMgr, VRMenuObject * self );
+	bool							Fling( OvrGuiSys & guiSys, VrFrame const & vrFrame, const float distance );
+	void							BuildPoseTable();
+	PanelPose						LookupPose( const float t ) const;
+    void 							UpdatePanels();
 
     eMsgStatus 						Frame( OvrGuiSys & guiSys, VrFrame const & vrFrame, VRMenuObject * self, VRMenuEvent const & event );
     eMsgStatus 						SwipeForward( OvrGuiSys & guiSys, VrFrame const & vrFrame, VRMenuObject * self );
@@ -105,16 +167,36 @@ private:
     Array<VRMenuObject *> 			MenuObjs;
     Array<CarouselItemComponent *> 	MenuComps;
 	Array<PanelPose>				PanelPoses;
+	Array<PanelPose>				PoseTable;				// POSE_SAMPLES_PER_PANEL between each of PanelPoses
+	Array<int>						PanelItems;				// the item each menu object shows, -1 for none, -2 not yet set
 
-	double 							StartTime;
-	double 							EndTime;
-	float							PrevPosition;
-	float							NextPosition;
+	CarouselMotion					Motion;
+	double							LastFrameTime;
+	void							( *PrefetchCallback )( int firstItem, int lastItem, void * object );
+	void *							PrefetchObject;
 
 	bool							Swiping;
 	bool							PanelsNeedUpdate;
+	bool							RecyclePanels;
+
+#ifndef NDEBUG
+	friend void						CarouselBrowserBenchmark();
+#endif
 };
 
+#ifndef NDEBUG
+// Flings a carousel the same way at frame rates from 30 to 120 fps and with
+// hitches, and checks the motion comes out the same, slows down without
+// going past or coming back, and stops on the item it said it would
+void CarouselMotionTest();
+#endif
+
+#ifndef NDEBUG
+// Scrolls carousels of a few items up to 5,000 across their whole list and
+// logs what updating the panels cost a frame, and how many items panels were given
+void CarouselBrowserBenchmark();
+#endif
+
 } // namespace VRMatterStreamTheater
 
 #endif // OVR_CarouselBrowser_h
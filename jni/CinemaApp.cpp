@@ -17,6 +17,7 @@ of patent rights can be found in the PATENTS file in the same directory.
 #include "CinemaApp.h"
 #include "Native.h"
 #include "CinemaStrings.h"
+#include "Settings.h"
 
 #include <unistd.h>
 
@@ -32,6 +33,7 @@ CinemaApp::CinemaApp() :
 	ModelMgr( *this ),
 	PcMgr( *this ),
 	AppMgr( *this ),
+	TextCache(),
 	InLobby( true ),
 	AllowDebugControls( false ),
 	ViewMgr(),
@@ -47,6 +49,9 @@ CinemaApp::CinemaApp() :
 	PlayList(),
 	ShouldResumeMovie( false ),
 	MovieFinishedPlaying( false ),
+	ProfileTuner(),
+	ProfileSampleTime( 0.0 ),
+	StreamHostAudio( true ),
 	DelayedError( NULL )
 
 {
@@ -128,6 +133,13 @@ void CinemaApp::OneTimeInit( const char * fromPackage, const char * launchIntent
 	ViewMgr.AddView( &TheaterSelectionMenu );
 	ResumeMovieMenu.OneTimeInit( launchIntentURI );
 
+	// What each host and app streamed well is remembered next to the settings
+	String	outPath;
+	if ( app->GetStoragePaths().GetPathIfValidPermission( EST_PRIMARY_EXTERNAL_STORAGE, EFT_FILES, "", W_OK | R_OK, outPath ) )
+	{
+		ProfileTuner.SetDirectory( outPath.ToCStr() );
+	}
+
 	PcSelection( true );
 
 	LOG( "CinemaApp::OneTimeInit: %3.1f seconds", vrapi_GetTimeInSeconds() - StartTime );
@@ -148,6 +160,20 @@ void CinemaApp::OneTimeShutdown()
 	AppSelectionMenu.OneTimeShutdown();
 	TheaterSelectionMenu.OneTimeShutdown();
 	ResumeMovieMenu.OneTimeShutdown();
+
+	// The views' settings saves are written behind, get them on disk before the process goes
+	Settings::FlushWrites();
+}
+
+void CinemaApp::EnteredVrMode()
+{
+	MoviePlayer.EnteredVrMode();
+}
+
+void CinemaApp::LeavingVrMode()
+{
+	// The input sampler reads the head pose from its own thread, it has to stop before vrapi is left
+	MoviePlayer.LeavingVrMode();
 }
 
 const char * CinemaApp::RetailDir( const char *dir ) const
@@ -278,17 +304,71 @@ const PcDef *CinemaApp::GetPreviousMovie() const
 	return previous;
 }
 
-void CinemaApp::StartMoviePlayback(int width, int height, int fps, bool hostAudio, int customBitrate)
+void CinemaApp::StartMoviePlayback(int width, int height, int fps, bool hostAudio, int customBitrate, StreamTuning tuning)
+{
+	BeginStream( width, height, fps, hostAudio, customBitrate, tuning, false );
+}
+
+void CinemaApp::ReconfigureMoviePlayback(int width, int height, int fps, bool hostAudio, int customBitrate, StreamTuning tuning)
+{
+	// Without a movie texture to keep there's nothing to reconfigure
+	BeginStream( width, height, fps, hostAudio, customBitrate, tuning, SceneMgr.MovieTexture != NULL );
+}
+
+void CinemaApp::BeginStream(int width, int height, int fps, bool hostAudio, int customBitrate, StreamTuning tuning, bool reconfigure)
 {
 	if ( CurrentMovie != NULL )
 	{
 		MovieFinishedPlaying = false;
 		bool remote = CurrentPc->isRemote;
-		Native::StartMovie( app, CurrentPc->UUID.ToCStr(), CurrentMovie->Name.ToCStr(), CurrentMovie->Id, CurrentPc->Binding.ToCStr(), width, height, fps, hostAudio, customBitrate, remote );
+		const StreamProfile target = { width, height, fps, customBitrate };
+		const StreamProfile profile = ProfileTuner.Begin( CurrentPc->Name.ToCStr(), CurrentMovie->Name.ToCStr(), remote, target, tuning );
+		StreamHostAudio = hostAudio;
+		ProfileSampleTime = vrapi_GetTimeInSeconds();
+		PlayStreamProfile( profile, reconfigure );
 		ShouldResumeMovie = false;
 	}
 }
 
+void CinemaApp::PlayStreamProfile( const StreamProfile & profile, bool reconfigure )
+{
+	SceneMgr.WaitForFirstFrame( reconfigure );
+	if ( reconfigure )
+	{
+		Native::ReconfigureMovie( app, CurrentPc->UUID.ToCStr(), CurrentMovie->Name.ToCStr(), CurrentMovie->Id, CurrentPc->Binding.ToCStr(),
+				profile.Width, profile.Height, profile.FPS, StreamHostAudio, profile.Bitrate, CurrentPc->isRemote );
+	}
+	else
+	{
+		Native::StartMovie( app, CurrentPc->UUID.ToCStr(), CurrentMovie->Name.ToCStr(), CurrentMovie->Id, CurrentPc->Binding.ToCStr(),
+				profile.Width, profile.Height, profile.FPS, StreamHostAudio, profile.Bitrate, CurrentPc->isRemote );
+	}
+}
+
+void CinemaApp::UpdateStreamProfile()
+{
+	const double now = vrapi_GetTimeInSeconds();
+	if ( !ProfileTuner.IsActive() || now - ProfileSampleTime < StreamProfileTuner::SAMPLE_SECONDS )
+	{
+		return;
+	}
+	ProfileSampleTime = now;
+
+	StreamStats stats;
+	StreamProfile profile;
+	if ( Native::GetStreamStats( app, stats ) && ProfileTuner.Update( stats, now, profile ) && CurrentMovie != NULL )
+	{
+		// Streams can't change profile as they go, so stepping down is
+		// reconnecting, with the last frame on screen until the new stream's
+		PlayStreamProfile( profile, SceneMgr.MovieTexture != NULL );
+	}
+}
+
+void CinemaApp::StreamStopped()
+{
+	ProfileTuner.End();
+}
+
 void CinemaApp::ResumeMovieFromSavedLocation()
 {
 	LOG( "ResumeMovie");
@@ -313,6 +393,7 @@ void CinemaApp::ResumeOrRestartMovie()
 
 void CinemaApp::MovieFinished()
 {
+	StreamStopped();
 	InLobby = false;
 	MovieFinishedPlaying = true;
 	AppSelectionMenu.SetAppList( PlayList, GetNextMovie() );
@@ -321,6 +402,7 @@ void CinemaApp::MovieFinished()
 
 void CinemaApp::UnableToPlayMovie()
 {
+	StreamStopped();
 	InLobby = false;
 	AppSelectionMenu.SetError( CinemaStrings::Error_UnableToPlayMovie.ToCStr(), false, true );
 	ViewMgr.OpenView( AppSelectionMenu );
@@ -419,6 +501,9 @@ Matrix4f CinemaApp::Frame( const VrFrame & vrFrame )
 	// update gui systems after the app frame, but before rendering anything
 	GuiSys->Frame( vrFrame, CenterViewMatrix );
 
+	TextCache.EndFrame();
+	UIWidget::EndFrame();
+
 	return CenterViewMatrix;
 }
 
@@ -26,6 +26,8 @@ of patent rights can be found in the PATENTS file in the same directory.
 #include "AppSelectionView.h"
 #include "TheaterSelectionView.h"
 #include "ResumeMovieView.h"
+#include "StreamProfileTuner.h"
+#include "UI/UITextCache.h"
 
 using namespace OVR;
 
@@ -40,6 +42,8 @@ public:
 	virtual void			Configure( ovrSettings & settings );
 	virtual void 			OneTimeInit( const char * fromPackage, const char * launchIntentJSON, const char * launchIntentURI );
 	virtual void			OneTimeShutdown();
+	virtual void			EnteredVrMode();
+	virtual void			LeavingVrMode();
 	virtual bool 			OnKeyEvent( const int keyCode, const int repeatCount, const KeyEventType eventType );
 	virtual Matrix4f 		Frame( const VrFrame & vrFrame );
 	virtual Matrix4f 		DrawEyeView( const int eye, const float fovDegrees );
@@ -59,7 +63,13 @@ public:
 
 	const SceneDef & 		GetCurrentTheater() const;
 
-	void 					StartMoviePlayback(int width, int height, int fps, bool hostAudio, int customBitrate);
+	// width, height, fps and customBitrate are what the user picked, tuning may stream less
+	void 					StartMoviePlayback(int width, int height, int fps, bool hostAudio, int customBitrate, StreamTuning tuning);
+	// Like StartMoviePlayback, but a stream that's playing keeps its screen while it reconnects
+	void 					ReconfigureMoviePlayback(int width, int height, int fps, bool hostAudio, int customBitrate, StreamTuning tuning);
+	// Samples the stream for the tuner, reconnecting it a step down when it can't keep up
+	void					UpdateStreamProfile();
+	void					StreamStopped();
 	void 					ResumeMovieFromSavedLocation();
 	void					PlayMovieFromBeginning();
 	void 					ResumeOrRestartMovie();
@@ -98,6 +108,7 @@ public:
 	ModelManager 			ModelMgr;
 	PcManager 				PcMgr;
 	AppManager				AppMgr;
+	UITextCache				TextCache;
 
 	bool					InLobby;
 	bool					AllowDebugControls;
@@ -122,12 +133,18 @@ private:
 	bool					ShouldResumeMovie;
 	bool					MovieFinishedPlaying;
 
+	StreamProfileTuner		ProfileTuner;
+	double					ProfileSampleTime;
+	bool					StreamHostAudio;
+
 	Matrix4f				CenterViewMatrix;
 
 	OVR::String*			DelayedError;
 
 private:
 	void 					Command( const char * msg );
+	void					BeginStream(int width, int height, int fps, bool hostAudio, int customBitrate, StreamTuning tuning, bool reconfigure);
+	void					PlayStreamProfile( const StreamProfile & profile, bool reconfigure );
 };
 
 } // namespace VRMatterStreamTheater
@@ -0,0 +1,424 @@
+/************************************************************************************
+
+Filename    :   InputSampler.cpp
+Content     :	Fixed rate input thread, independent of the render frame rate.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#include "InputSampler.h"
+
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include "Native.h"
+#include "Android/LogUtils.h"
+
+namespace VRMatterStreamTheater {
+
+// Same as ANDROID_PRIORITY_URGENT_DISPLAY, which isn't exposed in the NDK
+static const int INPUT_THREAD_PRIORITY = -8;
+
+InputSampler::InputSampler() :
+	app( NULL ),
+	Vm( NULL ),
+	ActivityObject( NULL ),
+	Thread(),
+	Running( 0 ),
+	RateHz( DEFAULT_RATE ),
+	QueueHead( 0 ),
+	QueueTail( 0 ),
+	HeadMouseEnabled( 0 ),
+	HeadYawScale( 0.0f ),
+	HeadPitchScale( 0.0f ),
+	PredictionHorizon( 0.0f ),
+	DisplayLead( 0.0f ),
+	HaveLastHead( false ),
+	LastYaw( 0.0f ),
+	LastPitch( 0.0f ),
+	HeadMotion(),
+	SampleCount( 0 ),
+	SampleCountStart( 0.0 ),
+	SampleRate( 0.0f ),
+	SentClicks( 0 ),
+	SentScrolls( 0 )
+{
+}
+
+InputSampler::~InputSampler()
+{
+	Stop();
+}
+
+void InputSampler::Start( App * app_, const int rateHz )
+{
+	if ( IsRunning() )
+	{
+		Stop();
+	}
+
+	app = app_;
+	RateHz = ( rateHz > 0 ) ? rateHz : DEFAULT_RATE;
+	Vm = ( app != NULL ) ? app->GetJava()->Vm : NULL;
+	ActivityObject = ( app != NULL ) ? app->GetJavaObject() : NULL;
+
+	QueueHead = 0;
+	QueueTail = 0;
+	HeadMouseEnabled = 0;
+	HaveLastHead = false;
+	HeadMotion.Reset();
+	SampleCount = 0;
+	SampleCountStart = 0.0;
+	SampleRate = 0.0f;
+	SentClicks = 0;
+	SentScrolls = 0;
+
+	__atomic_store_n( &Running, 1, __ATOMIC_RELEASE );
+	if ( pthread_create( &Thread, NULL, ThreadFunction, this ) != 0 )
+	{
+		LOG( "InputSampler: Unable to create thread" );
+		__atomic_store_n( &Running, 0, __ATOMIC_RELEASE );
+		return;
+	}
+	LOG( "InputSampler: Started at %i Hz", RateHz );
+}
+
+void InputSampler::Stop()
+{
+	if ( !IsRunning() )
+	{
+		return;
+	}
+
+	__atomic_store_n( &Running, 0, __ATOMIC_RELEASE );
+	pthread_join( Thread, NULL );
+	LOG( "InputSampler: Stopped" );
+}
+
+bool InputSampler::IsRunning() const
+{
+	return __atomic_load_n( &Running, __ATOMIC_ACQUIRE ) != 0;
+}
+
+void InputSampler::SetHeadMouse( const bool enable, const float yawScale, const float pitchScale )
+{
+	__atomic_store( &HeadYawScale, &yawScale, __ATOMIC_RELAXED );
+	__atomic_store( &HeadPitchScale, &pitchScale, __ATOMIC_RELAXED );
+	__atomic_store_n( &HeadMouseEnabled, enable ? 1 : 0, __ATOMIC_RELEASE );
+}
+
+void InputSampler::SetPredictionHorizon( const float seconds )
+{
+	__atomic_store( &PredictionHorizon, &seconds, __ATOMIC_RELAXED );
+}
+
+void InputSampler::SetPredictedDisplayTime( const double seconds )
+{
+	const float lead = OVR::Alg::Max( (float)( seconds - vrapi_GetTimeInSeconds() ), 0.0f );
+	__atomic_store( &DisplayLead, &lead, __ATOMIC_RELAXED );
+}
+
+bool InputSampler::PostMouseMove( const int deltaX, const int deltaY )
+{
+	return Post( MOUSE_EVENT_MOVE, deltaX, deltaY );
+}
+
+bool InputSampler::PostMouseClick( const int buttonId, const bool down )
+{
+	return Post( MOUSE_EVENT_CLICK, buttonId, down ? 1 : 0 );
+}
+
+bool InputSampler::PostMouseScroll( const signed char amount )
+{
+	return Post( MOUSE_EVENT_SCROLL, amount, 0 );
+}
+
+bool InputSampler::Post( const int type, const int x, const int y )
+{
+	if ( !IsRunning() )
+	{
+		return false;
+	}
+
+	const int head = QueueHead;
+	const int tail = __atomic_load_n( &QueueTail, __ATOMIC_ACQUIRE );
+	if ( head - tail >= QUEUE_SIZE )
+	{
+		return false;
+	}
+
+	MouseEvent & event = Queue[head & ( QUEUE_SIZE - 1 )];
+	event.type = type;
+	event.x = x;
+	event.y = y;
+	__atomic_store_n( &QueueHead, head + 1, __ATOMIC_RELEASE );
+	return true;
+}
+
+float InputSampler::GetSampleRate() const
+{
+	float rate;
+	__atomic_load( &SampleRate, &rate, __ATOMIC_RELAXED );
+	return rate;
+}
+
+int InputSampler::GetPendingCount() const
+{
+	return __atomic_load_n( &QueueHead, __ATOMIC_ACQUIRE ) - __atomic_load_n( &QueueTail, __ATOMIC_ACQUIRE );
+}
+
+void * InputSampler::ThreadFunction( void * param )
+{
+	( ( InputSampler * )param )->Run();
+	return NULL;
+}
+
+void InputSampler::SendQueue( JNIEnv * jni, int & deltaX, int & deltaY )
+{
+	const int head = __atomic_load_n( &QueueHead, __ATOMIC_ACQUIRE );
+	int tail = QueueTail;
+	while ( tail != head )
+	{
+		const MouseEvent & event = Queue[tail & ( QUEUE_SIZE - 1 )];
+		tail++;
+		if ( event.type == MOUSE_EVENT_MOVE )
+		{
+			deltaX += event.x;
+			deltaY += event.y;
+			continue;
+		}
+
+		// The cursor has to get where the moves before a click put it first
+		if ( jni != NULL && ( deltaX != 0 || deltaY != 0 ) )
+		{
+			Native::MouseMove( jni, ActivityObject, deltaX, deltaY );
+		}
+		deltaX = 0;
+		deltaY = 0;
+
+		if ( event.type == MOUSE_EVENT_CLICK )
+		{
+			if ( jni != NULL )
+			{
+				Native::MouseClick( jni, ActivityObject, event.x, event.y != 0 );
+			}
+			SentClicks++;
+		}
+		else
+		{
+			if ( jni != NULL )
+			{
+				Native::MouseScroll( jni, ActivityObject, (signed char)event.x );
+			}
+			SentScrolls++;
+		}
+	}
+	__atomic_store_n( &QueueTail, tail, __ATOMIC_RELEASE );
+}
+
+void InputSampler::SampleHead( const double now, Vector2f & delta )
+{
+	if ( app == NULL || !__atomic_load_n( &HeadMouseEnabled, __ATOMIC_ACQUIRE ) )
+	{
+		HaveLastHead = false;
+		return;
+	}
+
+	float yawScale, pitchScale, horizon;
+	__atomic_load( &HeadYawScale, &yawScale, __ATOMIC_RELAXED );
+	__atomic_load( &HeadPitchScale, &pitchScale, __ATOMIC_RELAXED );
+	__atomic_load( &PredictionHorizon, &horizon, __ATOMIC_RELAXED );
+
+	const ovrTracking tracking = vrapi_GetPredictedTracking( app->GetOvrMobile(), now );
+	const ovrQuatf & o = tracking.HeadPose.Pose.Orientation;
+	Quatf orientation( o.x, o.y, o.z, o.w );
+	if ( horizon > 0.0f )
+	{
+		const ovrVector3f & w = tracking.HeadPose.AngularVelocity;
+		orientation = PredictOrientation( orientation, Vector3f( w.x, w.y, w.z ), horizon );
+	}
+	const Matrix4f pose( orientation );
+
+	float y, p, r;
+	pose.ToEulerAngles<Axis_Y,Axis_X,Axis_Z,Rotate_CCW, Handed_R>(&y, &p, &r);
+
+	if ( HaveLastHead )
+	{
+		float yaw = y - LastYaw;
+		const float pitch = p - LastPitch;
+		if(yaw > M_PI) yaw -= 2 * M_PI;
+		if(yaw < -M_PI) yaw += 2 * M_PI;
+
+		delta.x = - yawScale * yaw;
+		delta.y = - pitchScale * pitch;
+	}
+
+	LastYaw = y;
+	LastPitch = p;
+	HaveLastHead = true;
+}
+
+Quatf PredictOrientation( const Quatf & orientation, const Vector3f & angularVelocity, const float seconds )
+{
+	const float speed = angularVelocity.Length();
+	if ( speed < 1e-6f )
+	{
+		return orientation;
+	}
+	return Quatf( angularVelocity / speed, speed * seconds ) * orientation;
+}
+
+void InputSampler::Run()
+{
+	setpriority( PRIO_PROCESS, syscall( __NR_gettid ), INPUT_THREAD_PRIORITY );
+
+	JNIEnv * jni = NULL;
+	if ( Vm != NULL && Vm->AttachCurrentThread( &jni, NULL ) != JNI_OK )
+	{
+		LOG( "InputSampler: Unable to attach thread to the VM" );
+		jni = NULL;
+	}
+
+	const long periodNs = 1000000000L / RateHz;
+	struct timespec next;
+	clock_gettime( CLOCK_MONOTONIC, &next );
+
+	while ( IsRunning() )
+	{
+		next.tv_nsec += periodNs;
+		while ( next.tv_nsec >= 1000000000L )
+		{
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL );
+
+		// If we fell more than a period behind, don't try to catch up with a burst of samples
+		struct timespec current;
+		clock_gettime( CLOCK_MONOTONIC, &current );
+		const long long lateNs = ( current.tv_sec - next.tv_sec ) * 1000000000LL + ( current.tv_nsec - next.tv_nsec );
+		if ( lateNs > periodNs )
+		{
+			next = current;
+		}
+
+		const double now = current.tv_sec + current.tv_nsec * 1e-9;
+
+		float lead;
+		__atomic_load( &DisplayLead, &lead, __ATOMIC_RELAXED );
+
+		Vector2f headDelta( 0.0f, 0.0f );
+		SampleHead( vrapi_GetTimeInSeconds() + lead, headDelta );
+
+		int deltaX = 0;
+		int deltaY = 0;
+		HeadMotion.Accumulate( headDelta, now, deltaX, deltaY );
+		SendQueue( jni, deltaX, deltaY );
+
+		if ( jni != NULL && ( deltaX != 0 || deltaY != 0 ) )
+		{
+			Native::MouseMove( jni, ActivityObject, deltaX, deltaY );
+		}
+
+		SampleCount++;
+		if ( SampleCountStart == 0.0 )
+		{
+			SampleCountStart = now;
+		}
+		else if ( now - SampleCountStart >= 1.0 )
+		{
+			const float rate = SampleCount / ( now - SampleCountStart );
+			__atomic_store( &SampleRate, &rate, __ATOMIC_RELAXED );
+			SampleCount = 0;
+			SampleCountStart = now;
+		}
+	}
+
+	if ( jni != NULL )
+	{
+		Vm->DetachCurrentThread();
+	}
+}
+
+#ifndef NDEBUG
+#include <assert.h>
+void InputSamplerTest()
+{
+	InputSampler sampler;
+	sampler.Start( NULL, InputSampler::DEFAULT_RATE );
+
+	// Pretend to be a render loop that dropped to 30Hz, then to 15Hz
+	const int frameRates[] = { 60, 30, 15 };
+	for ( int i = 0; i < 3; i++ )
+	{
+		for ( int frame = 0; frame < frameRates[i] * 2; frame++ )
+		{
+			bool posted = sampler.PostMouseMove( 1, -1 );
+			assert( posted );
+			usleep( 1000000 / frameRates[i] );
+		}
+		const float rate = sampler.GetSampleRate();
+		LOG( "InputSamplerTest: render %i Hz, input %3.1f Hz, %i pending", frameRates[i], rate, sampler.GetPendingCount() );
+		assert( rate > InputSampler::DEFAULT_RATE * 0.9f && rate < InputSampler::DEFAULT_RATE * 1.1f );
+	}
+
+	// Clicks and scrolls go out between the moves they were posted between
+	for ( int i = 0; i < 8; i++ )
+	{
+		bool posted = sampler.PostMouseMove( 1, -1 ) && sampler.PostMouseClick( 1, ( i & 1 ) == 0 ) && sampler.PostMouseScroll( 8 );
+		assert( posted );
+	}
+
+	usleep( 10000 );
+	assert( sampler.GetPendingCount() == 0 );
+	sampler.Stop();
+	assert( sampler.SentClicks == 8 && sampler.SentScrolls == 8 );
+}
+
+// Replays a head turning back and forth and compares where the host cursor is
+// when the frame shows up against where the head actually is by then
+void HeadPredictionTest()
+{
+	const float latency = 0.08f;		// seconds from sending the mouse to seeing the frame
+	const float amplitude = 0.5f;		// radians
+	const float frequency = 1.0f;		// Hz
+	const float sampleTime = 1.0f / InputSampler::DEFAULT_RATE;
+
+	double plainError = 0.0;
+	double predictedError = 0.0;
+	int samples = 0;
+	for ( float t = 0.0f; t < 4.0f; t += sampleTime )
+	{
+		const float phase = 2.0f * M_PI * frequency;
+		const float yaw = amplitude * sinf( phase * t );
+		const float yawRate = amplitude * phase * cosf( phase * t );
+		const float yawAtDisplay = amplitude * sinf( phase * ( t + latency ) );
+
+		const Quatf orientation( Vector3f( 0.0f, 1.0f, 0.0f ), yaw );
+		const Quatf predicted = PredictOrientation( orientation, Vector3f( 0.0f, yawRate, 0.0f ), latency );
+
+		float y, p, r;
+		Matrix4f( predicted ).ToEulerAngles<Axis_Y,Axis_X,Axis_Z,Rotate_CCW, Handed_R>(&y, &p, &r);
+
+		plainError += ( yaw - yawAtDisplay ) * ( yaw - yawAtDisplay );
+		predictedError += ( y - yawAtDisplay ) * ( y - yawAtDisplay );
+		samples++;
+	}
+	plainError = sqrt( plainError / samples );
+	predictedError = sqrt( predictedError / samples );
+
+	LOG( "HeadPredictionTest: RMS lag error %f rad without prediction, %f rad with prediction", plainError, predictedError );
+	assert( predictedError < plainError * 0.5 );
+}
+#endif
+
+} // namespace VRMatterStreamTheater
@@ -0,0 +1,135 @@
+/************************************************************************************
+
+Filename    :   InputSampler.h
+Content     :	Fixed rate input thread, independent of the render frame rate.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#if !defined( InputSampler_h )
+#define InputSampler_h
+
+#include <pthread.h>
+#include <jni.h>
+
+#include "App.h"
+#include "MouseMotion.h"
+
+using namespace OVR;
+
+namespace VRMatterStreamTheater {
+
+// Samples the predicted head pose at a fixed rate on its own thread and
+// sends the resulting mouse motion to the stream, so the head tracked
+// mouse doesn't slow down when the render loop drops to 30Hz.
+// Mouse moves, clicks and scrolls from the render thread go through a lock
+// free single producer/single consumer queue and are sent from the same
+// thread in the order they were posted, so a click lands where the moves
+// before it put the cursor and the render thread never waits on the Java side.
+// It has to be stopped before the app leaves VR mode, since it reads the
+// head pose through vrapi.
+class InputSampler
+{
+public:
+	static const int	DEFAULT_RATE = 250;
+	static const int	QUEUE_SIZE = 256;	// must be a power of two
+
+						InputSampler();
+						~InputSampler();
+
+	// app may be NULL to run without head tracking or JNI, for testing
+	void				Start( App * app, const int rateHz );
+	void				Stop();
+	bool				IsRunning() const;
+
+	// Render thread: scales are in host pixels per radian, disabled when enable is false
+	void				SetHeadMouse( const bool enable, const float yawScale, const float pitchScale );
+	// Render thread: send the mouse for where the head will be this many seconds from now
+	// 0 sends the current head pose
+	void				SetPredictionHorizon( const float seconds );
+	// Render thread, every frame: the frame's predicted display time. The head is
+	// sampled as far ahead of each sample as this is ahead of now, as the frame
+	// parameters would, rather than where it is now.
+	void				SetPredictedDisplayTime( const double seconds );
+	// Render thread: each returns false if the sampler isn't running or the queue is full
+	bool				PostMouseMove( const int deltaX, const int deltaY );
+	bool				PostMouseClick( const int buttonId, const bool down );
+	bool				PostMouseScroll( const signed char amount );
+
+	// Samples per second measured over the last second
+	float				GetSampleRate() const;
+	int					GetPendingCount() const;
+
+#ifndef NDEBUG
+	friend void			InputSamplerTest();
+#endif
+
+private:
+	enum MouseEventType
+	{
+		MOUSE_EVENT_MOVE,
+		MOUSE_EVENT_CLICK,
+		MOUSE_EVENT_SCROLL
+	};
+
+	struct MouseEvent
+	{
+		int	type;
+		int	x;		// delta, button or scroll amount
+		int	y;		// delta or button down
+	};
+
+	App *				app;
+	JavaVM *			Vm;
+	jobject				ActivityObject;
+	pthread_t			Thread;
+	int					Running;
+	int					RateHz;
+
+	MouseEvent			Queue[QUEUE_SIZE];
+	int					QueueHead;			// only written by the render thread
+	int					QueueTail;			// only written by the sampler thread
+
+	int					HeadMouseEnabled;
+	float				HeadYawScale;
+	float				HeadPitchScale;
+	float				PredictionHorizon;
+	float				DisplayLead;		// seconds from now to the predicted display time
+
+	// Sampler thread only
+	bool				HaveLastHead;
+	float				LastYaw;
+	float				LastPitch;
+	MouseMotion			HeadMotion;
+	int					SampleCount;
+	double				SampleCountStart;
+	float				SampleRate;
+	int					SentClicks;
+	int					SentScrolls;
+
+private:
+	static void *		ThreadFunction( void * param );
+	void				Run();
+	bool				Post( const int type, const int x, const int y );
+	void				SampleHead( const double now, Vector2f & delta );
+	// Sends the queued events, moves summed with deltaX/Y up to each click or scroll
+	void				SendQueue( JNIEnv * jni, int & deltaX, int & deltaY );
+};
+
+// Rotates orientation by a world space angular velocity (radians/second) over seconds
+Quatf PredictOrientation( const Quatf & orientation, const Vector3f & angularVelocity, const float seconds );
+
+#ifndef NDEBUG
+void InputSamplerTest();
+void HeadPredictionTest();
+#endif
+
+} // namespace VRMatterStreamTheater
+
+#endif // InputSampler_h
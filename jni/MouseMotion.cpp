@@ -0,0 +1,266 @@
+/************************************************************************************
+
+Filename    :   MouseMotion.cpp
+Content     :	Sub-pixel mouse motion accumulation, acceleration and smoothing.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#include "MouseMotion.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "Kernel/OVR_Alg.h"
+
+#include "Android/LogUtils.h"
+
+namespace VRMatterStreamTheater {
+
+// Keep the integrated positions small so float precision doesn't eat the fractions
+static const float REBASE_DISTANCE = 4096.0f;
+
+static float SmoothingFactor( float cutoff, float dt )
+{
+	const float tau = 1.0f / ( 2.0f * M_PI * cutoff );
+	return 1.0f / ( 1.0f + tau / dt );
+}
+
+/*
+ * OneEuroFilter
+ */
+OneEuroFilter::OneEuroFilter() :
+	minCutoff( 1.0f ),
+	beta( 0.0f ),
+	derivativeCutoff( 1.0f ),
+	initialized( false ),
+	lastTime( 0.0 ),
+	lastValue( 0.0f ),
+	lastDerivative( 0.0f )
+{
+}
+
+void OneEuroFilter::Set( float minCutoff_, float beta_, float derivativeCutoff_ )
+{
+	minCutoff = minCutoff_;
+	beta = beta_;
+	derivativeCutoff = derivativeCutoff_;
+}
+
+void OneEuroFilter::Reset()
+{
+	initialized = false;
+	lastDerivative = 0.0f;
+}
+
+void OneEuroFilter::Shift( float offset )
+{
+	lastValue += offset;
+}
+
+float OneEuroFilter::Filter( float value, double time )
+{
+	if ( !initialized )
+	{
+		initialized = true;
+		lastTime = time;
+		lastValue = value;
+		lastDerivative = 0.0f;
+		return value;
+	}
+
+	const float dt = (float)( time - lastTime );
+	if ( dt <= 0.0f )
+	{
+		return lastValue;
+	}
+	lastTime = time;
+
+	const float derivative = ( value - lastValue ) / dt;
+	const float derivativeAlpha = SmoothingFactor( derivativeCutoff, dt );
+	lastDerivative += derivativeAlpha * ( derivative - lastDerivative );
+
+	const float cutoff = minCutoff + beta * fabsf( lastDerivative );
+	const float alpha = SmoothingFactor( cutoff, dt );
+	lastValue += alpha * ( value - lastValue );
+
+	return lastValue;
+}
+
+/*
+ * MouseMotion
+ */
+MouseMotion::MouseMotion() :
+	AccelGain( 0.0f ),
+	AccelThreshold( 0.0f ),
+	AccelMax( 1.0f ),
+	Smoothing( false ),
+	FilterX(),
+	FilterY(),
+	LastTime( -1.0 ),
+	RawPosition( 0.0f, 0.0f ),
+	FilteredPosition( 0.0f, 0.0f ),
+	Remainder( 0.0f, 0.0f )
+{
+}
+
+void MouseMotion::SetAcceleration( float gain, float threshold, float maxGain )
+{
+	AccelGain = gain;
+	AccelThreshold = threshold;
+	AccelMax = OVR::Alg::Max( maxGain, 1.0f );
+}
+
+void MouseMotion::SetSmoothing( bool enable, float minCutoff, float beta )
+{
+	if ( enable != Smoothing )
+	{
+		Reset();
+	}
+	Smoothing = enable;
+	FilterX.Set( minCutoff, beta, 1.0f );
+	FilterY.Set( minCutoff, beta, 1.0f );
+}
+
+void MouseMotion::Reset()
+{
+	FilterX.Reset();
+	FilterY.Reset();
+	LastTime = -1.0;
+	RawPosition = Vector2f( 0.0f, 0.0f );
+	FilteredPosition = Vector2f( 0.0f, 0.0f );
+	Remainder = Vector2f( 0.0f, 0.0f );
+}
+
+bool MouseMotion::Accumulate( const Vector2f & delta, double time, int & outX, int & outY )
+{
+	const float dt = ( LastTime < 0.0 ) ? 0.0f : (float)( time - LastTime );
+	LastTime = time;
+
+	Vector2f move = delta;
+	if ( AccelGain > 0.0f && dt > 0.0f )
+	{
+		const float speed = delta.Length() / dt;
+		const float gain = 1.0f + AccelGain * OVR::Alg::Max( speed - AccelThreshold, 0.0f );
+		move *= OVR::Alg::Min( gain, AccelMax );
+	}
+
+	RawPosition += move;
+
+	Vector2f filtered = RawPosition;
+	if ( Smoothing )
+	{
+		filtered.x = FilterX.Filter( RawPosition.x, time );
+		filtered.y = FilterY.Filter( RawPosition.y, time );
+	}
+
+	Remainder += filtered - FilteredPosition;
+	FilteredPosition = filtered;
+
+	if ( fabsf( RawPosition.x ) > REBASE_DISTANCE || fabsf( RawPosition.y ) > REBASE_DISTANCE )
+	{
+		const Vector2f offset = -FilteredPosition;
+		RawPosition += offset;
+		FilteredPosition += offset;
+		FilterX.Shift( offset.x );
+		FilterY.Shift( offset.y );
+	}
+
+	// Truncate toward zero so the carried fraction always stays within (-1, 1)
+	outX = (int)Remainder.x;
+	outY = (int)Remainder.y;
+	Remainder.x -= outX;
+	Remainder.y -= outY;
+
+	return outX != 0 || outY != 0;
+}
+
+#ifndef NDEBUG
+#include <assert.h>
+void MouseMotionTest()
+{
+	const double frameTime = 1.0 / 60.0;
+
+	LOG("MouseMotionTest: sub-pixel drift");
+	{
+		MouseMotion motion;
+		int totalX = 0, totalY = 0;
+		for ( int i = 0; i < 6000; i++ )
+		{
+			int x, y;
+			motion.Accumulate( Vector2f( 0.3f, -0.05f ), i * frameTime, x, y );
+			totalX += x;
+			totalY += y;
+		}
+		LOG("MouseMotionTest: expected 1800,-300 got %i,%i", totalX, totalY );
+		assert( abs( totalX - 1800 ) <= 1 );
+		assert( abs( totalY + 300 ) <= 1 );
+	}
+
+	LOG("MouseMotionTest: purely horizontal motion");
+	{
+		MouseMotion motion;
+		int totalX = 0, totalY = 0;
+		for ( int i = 0; i < 100; i++ )
+		{
+			int x, y;
+			motion.Accumulate( Vector2f( 2.5f, 0.0f ), i * frameTime, x, y );
+			totalX += x;
+			totalY += y;
+		}
+		assert( totalX == 250 );
+		assert( totalY == 0 );
+	}
+
+	LOG("MouseMotionTest: smoothing drift and latency");
+	{
+		MouseMotion motion;
+		motion.SetSmoothing( true, 1.0f, 0.01f );
+		int totalX = 0;
+		int settleFrame = -1;
+		for ( int i = 0; i < 600; i++ )
+		{
+			int x, y;
+			// Hold still, a 100 pixel step on frame 10, then hold still again
+			motion.Accumulate( Vector2f( i == 10 ? 100.0f : 0.0f, 0.0f ), i * frameTime, x, y );
+			totalX += x;
+			if ( settleFrame < 0 && totalX >= 95 )
+			{
+				settleFrame = i - 10;
+			}
+		}
+		LOG("MouseMotionTest: step reached 95%% after %i frames, final %i", settleFrame, totalX );
+		assert( settleFrame >= 0 );
+		assert( abs( totalX - 100 ) <= 1 );
+	}
+
+	LOG("MouseMotionTest: rebase keeps precision");
+	{
+		MouseMotion motion;
+		motion.SetSmoothing( true, 5.0f, 0.1f );
+		int totalX = 0;
+		for ( int i = 0; i < 20000; i++ )
+		{
+			int x, y;
+			motion.Accumulate( Vector2f( 1.01f, 0.0f ), i * frameTime, x, y );
+			totalX += x;
+		}
+		for ( int i = 20000; i < 21000; i++ )
+		{
+			int x, y;
+			motion.Accumulate( Vector2f( 0.0f, 0.0f ), i * frameTime, x, y );
+			totalX += x;
+		}
+		LOG("MouseMotionTest: expected 20200 got %i", totalX );
+		assert( abs( totalX - 20200 ) <= 1 );
+	}
+}
+#endif
+
+} // namespace VRMatterStreamTheater
@@ -0,0 +1,94 @@
+/************************************************************************************
+
+Filename    :   MouseMotion.h
+Content     :	Sub-pixel mouse motion accumulation, acceleration and smoothing.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#if !defined( MouseMotion_h )
+#define MouseMotion_h
+
+#include "Kernel/OVR_Math.h"
+
+using namespace OVR;
+
+namespace VRMatterStreamTheater {
+
+// One Euro filter (Casiez, Roussel, Vogel 2012)
+// A low pass filter whose cutoff rises with speed, so slow motion is
+// steadied while fast motion passes through with little lag.
+class OneEuroFilter
+{
+public:
+			OneEuroFilter();
+
+	void	Set( float minCutoff_, float beta_, float derivativeCutoff_ );
+	void	Reset();
+	// Move the filter state along with a rebased input
+	void	Shift( float offset );
+	float	Filter( float value, double time );
+
+private:
+	float	minCutoff;
+	float	beta;
+	float	derivativeCutoff;
+
+	bool	initialized;
+	double	lastTime;
+	float	lastValue;
+	float	lastDerivative;
+};
+
+// Turns floating point motion into whole pixel mouse deltas.
+// Fractions are carried over to the next call instead of being truncated,
+// so slow motion still moves the cursor and nothing drifts over time.
+class MouseMotion
+{
+public:
+				MouseMotion();
+
+	// gain is added per pixel/second of speed above threshold, capped at maxGain
+	// gain of 0 disables acceleration
+	void		SetAcceleration( float gain, float threshold, float maxGain );
+
+	// minCutoff in Hz, beta scales the cutoff with speed
+	void		SetSmoothing( bool enable, float minCutoff, float beta );
+
+	// Forget carried fractions and filter history, e.g. when a touch begins
+	void		Reset();
+
+	// Add a delta in host pixels at the given time in seconds
+	// returns true if there are whole pixels to send in outX/outY
+	bool		Accumulate( const Vector2f & delta, double time, int & outX, int & outY );
+
+	Vector2f	GetRemainder() const { return Remainder; }
+
+private:
+	float			AccelGain;
+	float			AccelThreshold;
+	float			AccelMax;
+
+	bool			Smoothing;
+	OneEuroFilter	FilterX;
+	OneEuroFilter	FilterY;
+
+	double			LastTime;
+	Vector2f		RawPosition;
+	Vector2f		FilteredPosition;
+	Vector2f		Remainder;
+};
+
+#ifndef NDEBUG
+void MouseMotionTest();
+#endif
+
+} // namespace VRMatterStreamTheater
+
+#endif // MouseMotion_h
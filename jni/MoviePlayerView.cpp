@@ -24,6 +24,7 @@ of patent rights can be found in the PATENTS file in the same directory.
 #include "Kernel/OVR_String_Utils.h"
 
 #include "CinemaStrings.h"
+#include "nv_opus_dec/nv_audio_sink.h"
 
 namespace VRMatterStreamTheater
 {
@@ -164,11 +165,18 @@ MoviePlayerView::MoviePlayerView( CinemaApp &cinema ) :
 	settings2Path(""),
 	settings3Path(""),
 	appSettingsPath(""),
+	hostSettingsPath(""),
 	defaultSettings( NULL ),
 	settings1( NULL ),
 	settings2( NULL ),
 	settings3( NULL ),
 	appSettings( NULL ),
+	hostSettings( NULL ),
+	settings1Snapshot(),
+	settings2Snapshot(),
+	settings3Snapshot(),
+	settingsBinding( GetStreamTheaterSchema() ),
+	slotBinding( GetStreamTheaterSchema() ),
 	BackgroundClicked( false ),
 	UIOpened( false ),
 	s00(0.0f),s01(0.0f),s10(0.0f),s11(0.0f),s20(0.0f),s21(0.0f),
@@ -184,12 +192,29 @@ MoviePlayerView::MoviePlayerView( CinemaApp &cinema ) :
 	gazeScaleValue(1.05),
 	trackpadScaleValue(2.0),
 	gamepadScaleValue(20.0),
+	gazeMotion(),
+	trackpadMotion(),
+	gamepadMotion(),
+	vrMotion(),
+	gazeSmoothing(false),
+	trackpadSmoothing(false),
+	gamepadSmoothing(false),
+	gazeAcceleration(0.0),
+	trackpadAcceleration(0.0),
+	gamepadAcceleration(0.0),
+	mouseFilterMinCutoff(1.0),
+	mouseFilterBeta(0.007),
+	inputSampler(),
+	inputSampleRate(InputSampler::DEFAULT_RATE),
+	inputSamplerParked(false),
 	streamWidth(1280),
 	streamHeight(720),
 	streamFPS(60),
 	streamHostAudio(true),
+	spatialAudio(false),
 	customBitrate(0.0),
 	bitrate(0),
+	autoTuneStream(true),
 	videoSettingsUpdated(false),
 	BitrateMin(0.0),
 	BitrateMax(20000.0),
@@ -212,6 +237,9 @@ MoviePlayerView::MoviePlayerView( CinemaApp &cinema ) :
 	screenMotionPaused( false ),
 	vrXscale( 1.0f ),
 	vrYscale( 1.0f ),
+	vrPredictMouse( false ),
+	VRPredictionMax( 100 ),
+	vrDisplayDelay( 0.0f ),
 	VRLatencyMax( 60 ),
 	VRLatencyMin( 0 ),
 	VRXScaleMax( 6.0f ),
@@ -259,6 +287,8 @@ void MoviePlayerView::OneTimeShutdown()
 	settings2 = NULL;
 	delete(settings3);
 	settings3 = NULL;
+	delete(hostSettings);
+	hostSettings = NULL;
 }
 
 float PixelScale( const float x )
@@ -492,7 +522,7 @@ void MoviePlayerView::InitializeGamepadMouse()
 		{
 			Settings gamepadSettings(gamepadDefaultsFilename);
 			WriteGamepadSettings(&gamepadSettings);
-			gamepadSettings.SaveAll();
+			gamepadSettings.Save();
 		}
 
 		if(defaultSettingsExists)
@@ -542,48 +572,63 @@ void MoviePlayerView::InitializeSettings()
 			defaultSettingsPath = outPath + "settings.json";
 			defaultSettings = new Settings(defaultSettingsPath);
 
-			defaultSettings->Define("StreamTheaterSettingsVersion", &settingsVersion);
-			defaultSettings->Define("MouseMode", (int*)&mouseMode);
-			defaultSettings->Define("StreamWidth", &streamWidth);
-			defaultSettings->Define("StreamHeight", &streamHeight);
-			defaultSettings->Define("StreamFPS", &streamFPS);
-			defaultSettings->Define("EnableHostAudio", &streamHostAudio);
-			defaultSettings->Define("CustomBitrate", &customBitrate);
-			defaultSettings->Define("MinBitrate", &BitrateMin);
-			defaultSettings->Define("MaxBitrate", &BitrateMax);
-
-			defaultSettings->Define("GazeScale", &gazeScaleValue);
-			defaultSettings->Define("TrackpadScale", &trackpadScaleValue);
-			defaultSettings->Define("GamepadMouseScale", &gamepadScaleValue);
-
-			defaultSettings->Define("VoidScreenDistance", &Cinema.SceneMgr.FreeScreenDistance);
-			defaultSettings->Define("VoidScreenScale", &Cinema.SceneMgr.FreeScreenScale);
-
-			defaultSettings->Define("GazeScaleMax", &GazeMax);
-			defaultSettings->Define("GazeScaleMin", &GazeMin);
-			defaultSettings->Define("TrackpadScaleMax", &TrackpadMax);
-			defaultSettings->Define("TrackpadScaleMin", &TrackpadMin);
-			defaultSettings->Define("GamepadScaleMax", &GamepadMax);
-			defaultSettings->Define("GamepadScaleMin", &GamepadMin);
-			defaultSettings->Define("VoidScreenDistanceMax", &VoidScreenDistanceMax);
-			defaultSettings->Define("VoidScreenDistanceMin", &VoidScreenDistanceMin);
-			defaultSettings->Define("VoidScreenScaleMax", &VoidScreenScaleMax);
-			defaultSettings->Define("VoidScreenScaleMin", &VoidScreenScaleMin);
+			settingsBinding.Bind<StreamSetting::SettingsVersion>(&settingsVersion);
+			settingsBinding.Bind<StreamSetting::MouseMode>((int*)&mouseMode);
+			settingsBinding.Bind<StreamSetting::StreamWidth>(&streamWidth);
+			settingsBinding.Bind<StreamSetting::StreamHeight>(&streamHeight);
+			settingsBinding.Bind<StreamSetting::StreamFPS>(&streamFPS);
+			settingsBinding.Bind<StreamSetting::EnableHostAudio>(&streamHostAudio);
+			settingsBinding.Bind<StreamSetting::SpatialAudio>(&spatialAudio);
+			settingsBinding.Bind<StreamSetting::CustomBitrate>(&customBitrate);
+			settingsBinding.Bind<StreamSetting::MinBitrate>(&BitrateMin);
+			settingsBinding.Bind<StreamSetting::MaxBitrate>(&BitrateMax);
+
+			settingsBinding.Bind<StreamSetting::GazeScale>(&gazeScaleValue);
+			settingsBinding.Bind<StreamSetting::TrackpadScale>(&trackpadScaleValue);
+			settingsBinding.Bind<StreamSetting::GamepadMouseScale>(&gamepadScaleValue);
+
+			settingsBinding.Bind<StreamSetting::GazeSmoothing>(&gazeSmoothing);
+			settingsBinding.Bind<StreamSetting::TrackpadSmoothing>(&trackpadSmoothing);
+			settingsBinding.Bind<StreamSetting::GamepadMouseSmoothing>(&gamepadSmoothing);
+			settingsBinding.Bind<StreamSetting::GazeAcceleration>(&gazeAcceleration);
+			settingsBinding.Bind<StreamSetting::TrackpadAcceleration>(&trackpadAcceleration);
+			settingsBinding.Bind<StreamSetting::GamepadMouseAcceleration>(&gamepadAcceleration);
+			settingsBinding.Bind<StreamSetting::MouseFilterMinCutoff>(&mouseFilterMinCutoff);
+			settingsBinding.Bind<StreamSetting::MouseFilterBeta>(&mouseFilterBeta);
+			settingsBinding.Bind<StreamSetting::InputSampleRate>(&inputSampleRate);
+			settingsBinding.Bind<StreamSetting::AutoTuneStream>(&autoTuneStream);
+
+			settingsBinding.Bind<StreamSetting::VoidScreenDistance>(&Cinema.SceneMgr.FreeScreenDistance);
+			settingsBinding.Bind<StreamSetting::VoidScreenScale>(&Cinema.SceneMgr.FreeScreenScale);
+
+			settingsBinding.Bind<StreamSetting::GazeScaleMax>(&GazeMax);
+			settingsBinding.Bind<StreamSetting::GazeScaleMin>(&GazeMin);
+			settingsBinding.Bind<StreamSetting::TrackpadScaleMax>(&TrackpadMax);
+			settingsBinding.Bind<StreamSetting::TrackpadScaleMin>(&TrackpadMin);
+			settingsBinding.Bind<StreamSetting::GamepadScaleMax>(&GamepadMax);
+			settingsBinding.Bind<StreamSetting::GamepadScaleMin>(&GamepadMin);
+			settingsBinding.Bind<StreamSetting::VoidScreenDistanceMax>(&VoidScreenDistanceMax);
+			settingsBinding.Bind<StreamSetting::VoidScreenDistanceMin>(&VoidScreenDistanceMin);
+			settingsBinding.Bind<StreamSetting::VoidScreenScaleMax>(&VoidScreenScaleMax);
+			settingsBinding.Bind<StreamSetting::VoidScreenScaleMin>(&VoidScreenScaleMin);
 
 			if(Cinema.SceneMgr.SceneInfo.UseVRScreen)
 			{ // Don't save or load VR screen settings if we're not using it
-				defaultSettings->Define("VRScreenLatency", &latencyAddition);
-				defaultSettings->Define("VRScreenXScale", &vrXscale);
-				defaultSettings->Define("VRScreenYScale", &vrYscale);
-				defaultSettings->Define("VRScreenLatencyMax", &VRLatencyMax);
-				defaultSettings->Define("VRScreenLatencyMin", &VRLatencyMin);
-				defaultSettings->Define("VRScreenXScaleMax", &VRXScaleMax);
-				defaultSettings->Define("VRScreenXScaleMin", &VRXScaleMin);
-				defaultSettings->Define("VRScreenYScaleMax", &VRYScaleMax);
-				defaultSettings->Define("VRScreenYScaleMin", &VRYScaleMin);
+				settingsBinding.Bind<StreamSetting::VRScreenLatency>(&latencyAddition);
+				settingsBinding.Bind<StreamSetting::VRScreenXScale>(&vrXscale);
+				settingsBinding.Bind<StreamSetting::VRScreenYScale>(&vrYscale);
+				settingsBinding.Bind<StreamSetting::VRScreenPredictMouse>(&vrPredictMouse);
+				settingsBinding.Bind<StreamSetting::VRScreenPredictionMax>(&VRPredictionMax);
+				settingsBinding.Bind<StreamSetting::VRScreenLatencyMax>(&VRLatencyMax);
+				settingsBinding.Bind<StreamSetting::VRScreenLatencyMin>(&VRLatencyMin);
+				settingsBinding.Bind<StreamSetting::VRScreenXScaleMax>(&VRXScaleMax);
+				settingsBinding.Bind<StreamSetting::VRScreenXScaleMin>(&VRXScaleMin);
+				settingsBinding.Bind<StreamSetting::VRScreenYScaleMax>(&VRYScaleMax);
+				settingsBinding.Bind<StreamSetting::VRScreenYScaleMin>(&VRYScaleMin);
 			}
 
-			defaultSettings->Load();
+			slotBinding = settingsBinding;
+			slotBinding.Bind<StreamSetting::MovieFormat>((int*)&Cinema.SceneMgr.CurrentMovieFormat);
 		}
 
 		if(settings1 == NULL)
@@ -595,12 +640,9 @@ void MoviePlayerView::InitializeSettings()
 			settings1 = new Settings(settings1Path);
 			settings2 = new Settings(settings2Path);
 			settings3 = new Settings(settings3Path);
-
-			settings1->CopyDefines(*defaultSettings);
-			settings1->Define("3dMode", (int*)&Cinema.SceneMgr.CurrentMovieFormat);
-
-			settings2->CopyDefines(*settings1);
-			settings3->CopyDefines(*settings1);
+			settings1->GetSnapshot(settings1Snapshot);
+			settings2->GetSnapshot(settings2Snapshot);
+			settings3->GetSnapshot(settings3Snapshot);
 
 			String settingsText;
 			if(settings1->GetVal("DisplayName", &settingsText) == false)
@@ -620,16 +662,36 @@ void MoviePlayerView::InitializeSettings()
 			}
 		}
 
+		if(hostSettings != NULL)
+		{
+			delete(hostSettings);
+			hostSettings = NULL;
+		}
 		if(appSettings != NULL)
 		{
 			delete(appSettings);
 			appSettings = NULL;
 		}
 
+		// Per host settings have no buttons, they're for editing by hand
+		const PcDef* pc = Cinema.GetCurrentPc();
+		if(pc != NULL)
+		{
+			hostSettingsPath = outPath + "settings.host." + pc->Name + ".json";
+			hostSettings = new Settings(hostSettingsPath);
+		}
+
 		appSettingsPath = outPath + "settings." + Cinema.GetCurrentMovie()->Name + ".json";
 		appSettings = new Settings(appSettingsPath);
-		appSettings->CopyDefines(*defaultSettings);
-		appSettings->Load();
+
+		// Each file overrides what the ones before it have
+		settingsBinding.ApplyDefaults();
+		defaultSettings->Load(settingsBinding);
+		if(hostSettings != NULL)
+		{
+			hostSettings->Load(settingsBinding);
+		}
+		appSettings->Load(settingsBinding);
 
 		if( Cinema.SceneMgr.CurrentMovieFormat == VT_LEFT_RIGHT_3D )
 		{
@@ -644,7 +706,7 @@ void MoviePlayerView::InitializeSettings()
 			Native::controllerHandledByMoonlight(Cinema.app, true);
 		}
 
-
+		UpdateMouseMotion();
 		UpdateMenus();
 	}
 }
@@ -1179,7 +1241,13 @@ void MoviePlayerView::OnOpen()
 	HideUI();
 	Cinema.SceneMgr.LightsOff( 1.5f );
 
-	Cinema.StartMoviePlayback(streamWidth, streamHeight, streamFPS, streamHostAudio, bitrate);
+	StartStream(STREAM_TUNING_FROM_HISTORY);
+
+	// An input sample rate of 0 keeps all input on the render thread
+	if ( inputSampleRate > 0 )
+	{
+		inputSampler.Start( Cinema.app, inputSampleRate );
+	}
 
 	if ( Cinema.SceneMgr.SceneInfo.UseVRScreen )
 	{
@@ -1203,6 +1271,10 @@ void MoviePlayerView::OnClose()
 	HideUI();
 	Cinema.GetGuiSys().GetGazeCursor().ShowCursor();
 
+	inputSampler.Stop();
+	inputSamplerParked = false;
+	Cinema.StreamStopped();
+
 	if ( MoveScreenMenu->IsOpen() )
 	{
 		MoveScreenLabel.SetVisible( false );
@@ -1236,6 +1308,8 @@ bool MoviePlayerView::Command( const char * msg )
 	}
 	else if ( MatchesHead( "pause ", msg ) )
 	{
+		inputSampler.Stop();
+		Cinema.StreamStopped();
 		Native::StopMovie( Cinema.app );
 		return false;	// allow VrLib to handle it, too
 	}
@@ -1243,6 +1317,27 @@ bool MoviePlayerView::Command( const char * msg )
 	return false;
 }
 
+void MoviePlayerView::EnteredVrMode()
+{
+	if ( inputSamplerParked )
+	{
+		inputSamplerParked = false;
+		if ( CurViewState == VIEWSTATE_OPEN )
+		{
+			inputSampler.Start( Cinema.app, inputSampleRate );
+		}
+	}
+}
+
+void MoviePlayerView::LeavingVrMode()
+{
+	if ( inputSampler.IsRunning() )
+	{
+		inputSampler.Stop();
+		inputSamplerParked = true;
+	}
+}
+
 void MoviePlayerView::MovieLoaded( const int width, const int height, const int duration )
 {
 }
@@ -1538,6 +1633,13 @@ void MoviePlayerView::MovieScreenUpdated()
 		if(timestamp != 0)
 		{
 			pose = InterpolatePoseAtTime(timestamp - latencyAddition);
+
+			// The newest recorded pose is from this frame, so its time is close enough to now
+			if( !oldPoses.IsEmpty() )
+			{
+				const float delay = oldPoses.GetLast()->time - timestamp;
+				vrDisplayDelay = ( vrDisplayDelay == 0.0f ) ? delay : vrDisplayDelay * 0.95f + delay * 0.05f;
+			}
 		} else {
 			pose = lastPose;
 		}
@@ -1569,10 +1671,22 @@ void MoviePlayerView::CheckVRInput( const VrFrame & vrFrame )
 	Vector2f mouse;
 	mouse.x = - trackCalibrationYaw * yaw * vrXscale;
 	mouse.y = - trackCalibrationPitch * pitch * vrYscale;
+	lastPose = currentPose;
+
+	// The input sampler tracks the head on its own at a fixed rate while the screen follows it
+	inputSampler.SetHeadMouse( !uiActive && !screenMotionPaused,
+			trackCalibrationYaw * vrXscale, trackCalibrationPitch * vrYscale );
+	inputSampler.SetPredictedDisplayTime( vrFrame.PredictedDisplayTimeInSeconds );
 
-	if( mouse.x != 0 || mouse.y != 0)
+	// End to end latency is the calibrated host side latency plus our own display delay
+	if( vrPredictMouse )
 	{
-		lastPose = currentPose;
+		const float horizon = OVR::Alg::Min( latencyAddition + vrDisplayDelay, (float)VRPredictionMax );
+		inputSampler.SetPredictionHorizon( OVR::Alg::Max( horizon, 0.0f ) / 1000.0f );
+	}
+	else
+	{
+		inputSampler.SetPredictionHorizon( 0.0f );
 	}
 
 	if(calibrationStage) {
@@ -1601,9 +1715,9 @@ void MoviePlayerView::CheckVRInput( const VrFrame & vrFrame )
 		}
 		else
 		{
-			if(mouse.x != 0.0 && mouse.y != 0.0)
+			if( !inputSampler.IsRunning() )
 			{
-				Native::MouseMove(Cinema.app, mouse.x, mouse.y );
+				SendMouseMotion( vrMotion, mouse, vrFrame.PredictedDisplayTimeInSeconds );
 			}
 
 			// Touching the trackpad will freeze the screen and activate mouse controls until back is hit.
@@ -1621,15 +1735,60 @@ void MoviePlayerView::CheckVRInput( const VrFrame & vrFrame )
 	}
 }
 
+// Acceleration kicks in above this speed in host pixels per second
+#define MOUSE_ACCEL_THRESHOLD 200.0f
+#define MOUSE_ACCEL_MAX_GAIN 4.0f
+void MoviePlayerView::UpdateMouseMotion()
+{
+	gazeMotion.SetSmoothing( gazeSmoothing, mouseFilterMinCutoff, mouseFilterBeta );
+	gazeMotion.SetAcceleration( gazeAcceleration, MOUSE_ACCEL_THRESHOLD, MOUSE_ACCEL_MAX_GAIN );
+	trackpadMotion.SetSmoothing( trackpadSmoothing, mouseFilterMinCutoff, mouseFilterBeta );
+	trackpadMotion.SetAcceleration( trackpadAcceleration, MOUSE_ACCEL_THRESHOLD, MOUSE_ACCEL_MAX_GAIN );
+	gamepadMotion.SetSmoothing( gamepadSmoothing, mouseFilterMinCutoff, mouseFilterBeta );
+	gamepadMotion.SetAcceleration( gamepadAcceleration, MOUSE_ACCEL_THRESHOLD, MOUSE_ACCEL_MAX_GAIN );
+}
+
+void MoviePlayerView::SendMouseMotion( MouseMotion & motion, const Vector2f & delta, const double time )
+{
+	int x, y;
+	if( motion.Accumulate( delta, time, x, y ) )
+	{
+		SendMouseMove( x, y );
+	}
+}
+
+void MoviePlayerView::SendMouseMove( const int deltaX, const int deltaY )
+{
+	if( !inputSampler.PostMouseMove( deltaX, deltaY ) )
+	{
+		Native::MouseMove(Cinema.app, deltaX, deltaY );
+	}
+}
+
+void MoviePlayerView::SendMouseClick( const int buttonId, const bool down )
+{
+	if( !inputSampler.PostMouseClick( buttonId, down ) )
+	{
+		Native::MouseClick(Cinema.app, buttonId, down );
+	}
+}
+
+void MoviePlayerView::SendMouseScroll( const signed char amount )
+{
+	if( !inputSampler.PostMouseScroll( amount ) )
+	{
+		Native::MouseScroll(Cinema.app, amount );
+	}
+}
+
 #define SCROLL_CLICKS 8
 void MoviePlayerView::HandleGazeMouse( const VrFrame & vrFrame, bool onscreen, const Vector2f screenCursor )
 {
 	if(onscreen) {
 		Vector2f travel = screenCursor - lastMouse;
-		if(travel.x != 0.0 && travel.y != 0.0)
-		{
-			Native::MouseMove(Cinema.app, streamWidth / 2 * gazeScaleValue * travel.x, streamHeight / -2 * gazeScaleValue * travel.y );
-		}
+		travel.x *= streamWidth / 2 * gazeScaleValue;
+		travel.y *= streamHeight / -2 * gazeScaleValue;
+		SendMouseMotion( gazeMotion, travel, vrFrame.PredictedDisplayTimeInSeconds );
 		lastMouse = screenCursor;
 	}
 
@@ -1639,9 +1798,9 @@ void MoviePlayerView::HandleGazeMouse( const VrFrame & vrFrame, bool onscreen, c
 		if(onscreen) {
 			if(allowDrag && !mouseDownLeft)
 			{
-				Native::MouseClick(Cinema.app,1,true); // fast click!
+				SendMouseClick(1,true); // fast click!
 			}
-			Native::MouseClick(Cinema.app,1,false);
+			SendMouseClick(1,false);
 			Cinema.app->PlaySound( "touch_up" );
 			mouseDownLeft = false;
 		} else		// open ui if it's not visible
@@ -1664,7 +1823,7 @@ void MoviePlayerView::HandleGazeMouse( const VrFrame & vrFrame, bool onscreen, c
 	if ( onscreen && allowDrag && !mouseDownLeft && (clickStartTime + 0.5 < vrapi_GetTimeInSeconds()) &&
 			( vrFrame.Input.buttonState & BUTTON_TOUCH ) && !( vrFrame.Input.buttonState & BUTTON_TOUCH_WAS_SWIPE ) )
 	{
-		Native::MouseClick(Cinema.app,1,true);
+		SendMouseClick(1,true);
 		Cinema.app->PlaySound( "touch_down" );
 		mouseDownLeft = true;
 		allowDrag = false; // already dragging
@@ -1673,7 +1832,7 @@ void MoviePlayerView::HandleGazeMouse( const VrFrame & vrFrame, bool onscreen, c
 	// Right click
 	if ( onscreen && !mouseDownRight && ( vrFrame.Input.buttonPressed & BUTTON_SWIPE_BACK ) )
 	{
-		Native::MouseClick(Cinema.app,3,true);
+		SendMouseClick(3,true);
 		Cinema.app->PlaySound( "touch_down" );
 		mouseDownRight = true;
 	}
@@ -1681,7 +1840,7 @@ void MoviePlayerView::HandleGazeMouse( const VrFrame & vrFrame, bool onscreen, c
 	// Middle click
 	if ( onscreen && !mouseDownMiddle && ( vrFrame.Input.buttonPressed & BUTTON_SWIPE_FORWARD ) )
 	{
-		Native::MouseClick(Cinema.app,2,true);
+		SendMouseClick(2,true);
 		Cinema.app->PlaySound( "touch_down" );
 		mouseDownMiddle = true;
 	}
@@ -1696,7 +1855,7 @@ void MoviePlayerView::HandleGazeMouse( const VrFrame & vrFrame, bool onscreen, c
 		lastScroll = (signed char)(SCROLL_CLICKS * actualSwipeFraction);
 		if(diff)
 		{
-			Native::MouseScroll(Cinema.app, diff );
+			SendMouseScroll( diff );
 			Cinema.app->PlaySound( "touch_up" );
 		}
 	}
@@ -1707,7 +1866,7 @@ void MoviePlayerView::HandleGazeMouse( const VrFrame & vrFrame, bool onscreen, c
 		lastScroll = (signed char)(SCROLL_CLICKS * actualSwipeFraction);
 		if(diff)
 		{
-			Native::MouseScroll(Cinema.app, diff );
+			SendMouseScroll( diff );
 			Cinema.app->PlaySound( "touch_down" );
 		}
 	}
@@ -1716,19 +1875,19 @@ void MoviePlayerView::HandleGazeMouse( const VrFrame & vrFrame, bool onscreen, c
 	{
 		if(mouseDownRight)
 		{
-			Native::MouseClick(Cinema.app,3,false);
+			SendMouseClick(3,false);
 			mouseDownRight = false;
 			Cinema.app->PlaySound( "touch_up" );
 		}
 		if(mouseDownMiddle)
 		{
-			Native::MouseClick(Cinema.app,2,false);
+			SendMouseClick(2,false);
 			mouseDownMiddle = false;
 			Cinema.app->PlaySound( "touch_up" );
 		}
 		if(mouseDownLeft)
 		{
-			Native::MouseClick(Cinema.app,1,false);
+			SendMouseClick(1,false);
 			mouseDownLeft = false;
 			Cinema.app->PlaySound( "touch_up" );
 		}
@@ -1748,11 +1907,14 @@ void MoviePlayerView::HandleTrackpadMouse( const VrFrame & vrFrame )
 		{
 			Vector2f travel = vrFrame.Input.touchRelative - lastMouse;
 			lastMouse = vrFrame.Input.touchRelative;
-			Native::MouseMove(Cinema.app, travel.x * trackpadScaleValue, travel.y * abs(trackpadScaleValue) );
+			travel.x *= trackpadScaleValue;
+			travel.y *= fabsf(trackpadScaleValue);
+			SendMouseMotion( trackpadMotion, travel, vrFrame.PredictedDisplayTimeInSeconds );
 		}
 		else
 		{
 			lastMouse = vrFrame.Input.touchRelative;
+			trackpadMotion.Reset();
 			mouseMoving = true;
 		}
 	}
@@ -1760,7 +1922,7 @@ void MoviePlayerView::HandleTrackpadMouse( const VrFrame & vrFrame )
 	if ( !mouseMoving && (clickStartTime + 0.5 < vrapi_GetTimeInSeconds()) &&
 			( vrFrame.Input.buttonState & BUTTON_TOUCH ) && !( vrFrame.Input.buttonState & BUTTON_TOUCH_WAS_SWIPE ) )
 	{
-		Native::MouseClick(Cinema.app,3,true);
+		SendMouseClick(3,true);
 		Cinema.app->PlaySound( "touch_down" );
 		mouseDownRight = true;
 	}
@@ -1769,16 +1931,16 @@ void MoviePlayerView::HandleTrackpadMouse( const VrFrame & vrFrame )
 	{
 		if( !mouseDownLeft && !mouseDownRight && !( vrFrame.Input.buttonState & BUTTON_TOUCH_WAS_SWIPE ) )
 		{
-			Native::MouseClick(Cinema.app,1,true); // fast click!
-			Native::MouseClick(Cinema.app,1,false);
+			SendMouseClick(1,true); // fast click!
+			SendMouseClick(1,false);
 		}
 		if( mouseDownRight )
 		{
-			Native::MouseClick(Cinema.app,3,false);
+			SendMouseClick(3,false);
 		}
 		if(mouseDownLeft)
 		{
-			Native::MouseClick(Cinema.app,1,false);
+			SendMouseClick(1,false);
 		}
 		Cinema.app->PlaySound( "touch_up" );
 		mouseDownLeft = false;
@@ -1796,34 +1958,34 @@ void MoviePlayerView::DoGamepadEvent(int code, bool down)
 	else
 	{
 		if(code >= GPMOUSE_B1 && code <= GPMOUSE_B1 + GPMOUSE_NUM_BUTTONS) {
-			Native::MouseClick(Cinema.app, code - GPMOUSE_B1 + 1, down);
+			SendMouseClick(code - GPMOUSE_B1 + 1, down);
 		}
 		else if(code == GPMOUSE_SCROLL_UP)
 		{
 			if(down)
 			{
-				Native::MouseScroll(Cinema.app, 8);
+				SendMouseScroll(8);
 			}
 		}
 		else if(code == GPMOUSE_SCROLL_DOWN)
 		{
 			if(down)
 			{
-				Native::MouseScroll(Cinema.app, -8);
+				SendMouseScroll(-8);
 			}
 		}
 		else if(code == GPMOUSE_COMFORT_LEFT)
 		{
 			if(down)
 			{
-				Native::MouseMove(Cinema.app, -160, 0);
+				SendMouseMove( -160, 0 );
 			}
 		}
 		else if(code == GPMOUSE_COMFORT_RIGHT)
 		{
 			if(down)
 			{
-				Native::MouseMove(Cinema.app, 160, 0);
+				SendMouseMove( 160, 0 );
 			}
 		}
 		else if(code == GPMOUSE_TOGGLE_VR_SCREEN_LOCK)
@@ -1862,10 +2024,7 @@ void MoviePlayerView::HandleGamepadMouse( const VrFrame & vrFrame )
 		 - ( ( gamepadButtonSettings[BUTTON_INDEX_RSTICK_UP]   == GPMOUSE_AXIS_Y_INV) ? vrFrame.Input.sticks[1][0] : 0 )
 		 - ( ( gamepadButtonSettings[BUTTON_INDEX_RSTICK_LEFT] == GPMOUSE_AXIS_Y_INV) ? vrFrame.Input.sticks[1][1] : 0 );
 
-	if(mouseX != 0 || mouseY != 0)
-	{
-		Native::MouseMove(Cinema.app, mouseX * gamepadScaleValue, mouseY * gamepadScaleValue);
-	}
+	SendMouseMotion( gamepadMotion, Vector2f( mouseX, mouseY ) * gamepadScaleValue, vrFrame.PredictedDisplayTimeInSeconds );
 
 	static bool rightTriggerDown = false;
 	if(vrFrame.Input.sticks[2][1] != 0 && !rightTriggerDown)
@@ -2070,140 +2229,137 @@ void MoviePlayerView::SaveAppPressed()
 {
 	if(!appSettings) return;
 
-	appSettings->SaveChanged();
+	appSettings->SaveChanged(settingsBinding);
 	UpdateMenus();
 }
 void MoviePlayerView::SaveDefaultPressed()
 {
 	if(!defaultSettings) return;
-//	defaultSettings->SaveChanged();
-//	defaultSettings->SaveVarNames();
-
-	defaultSettings->SaveAll();
+	defaultSettings->SaveAll(settingsBinding);
 	UpdateMenus();
 }
 void MoviePlayerView::ResetDefaultPressed()
 {
+	// Deleted before their files are removed, so nothing they still had to write brings them back
 	LOG("Resetting default settings");
-	remove(defaultSettingsPath);
 	delete(defaultSettings);
 	defaultSettings = NULL;
+	Settings::RemoveFile(defaultSettingsPath);
 
 	LOG("Resetting settings 1");
-	remove(settings1Path);
 	delete(settings1);
 	settings1 = NULL;
+	Settings::RemoveFile(settings1Path);
 
 	LOG("Resetting settings 2");
-	remove(settings2Path);
 	delete(settings2);
 	settings2 = NULL;
+	Settings::RemoveFile(settings2Path);
 
 	LOG("Resetting settings 3");
-	remove(settings3Path);
 	delete(settings3);
 	settings3 = NULL;
+	Settings::RemoveFile(settings3Path);
 
 	LOG("Resetting app settings");
-	remove(appSettingsPath);
 	delete(appSettings);
 	appSettings = NULL;
+	Settings::RemoveFile(appSettingsPath);
 
-	//FIXME: Define all these defaults in a better place
-	gazeScaleValue = 1.05;
-	trackpadScaleValue = 2.0;
-	gamepadScaleValue = 20.0;
-	streamWidth = 1280;
-	streamHeight = 720;
-	streamFPS = 60;
-	streamHostAudio = true;
-	GazeMin = 0.7;
-	GazeMax = 1.58;
-	TrackpadMin = -4.0;
-	TrackpadMax = 4.0;
-	VoidScreenDistanceMin = 0.1;
-	VoidScreenDistanceMax = 3.0;
-	VoidScreenScaleMin = -3.0;
-	VoidScreenScaleMax = 4.0;
-	Cinema.SceneMgr.FreeScreenDistance = 1.5;
-	Cinema.SceneMgr.FreeScreenScale = 1.0;
-	latencyAddition = 24;
-	vrXscale = 1.0;
-	vrYscale = 1.0;
-	VRLatencyMax = 60;
-	VRLatencyMin = 0;
-	VRXScaleMax = 6.0f;
-	VRXScaleMin = 0.0f;
-	VRYScaleMax = 6.0f;
-	VRYScaleMin = 0.0f;
+	// The host file is edited by hand and may have more than the schema,
+	// so it's kept with only its schema settings back to the defaults
+	LOG("Resetting host settings");
+	if(hostSettings != NULL)
+	{
+		hostSettings->SetSnapshot(SettingsSnapshot(GetStreamTheaterSchema()));
+	}
 
+	// Nothing left over the schema defaults
 	InitializeSettings();
 
-	Cinema.SceneMgr.ClearMovie();
 	UpdateMenus();
-	Cinema.StartMoviePlayback(streamWidth, streamHeight, streamFPS, streamHostAudio, bitrate);
+	ReconfigureStream(STREAM_TUNING_FROM_HISTORY);
 
 }
 void MoviePlayerView::Save1Pressed()
 {
 	if(!settings1) return;
 
-	settings1->SaveAll();
+	settings1->SaveAll(slotBinding);
+	settings1->GetSnapshot(settings1Snapshot);
 	UpdateMenus();
 }
 void MoviePlayerView::Save2Pressed()
 {
 	if(!settings2) return;
 
-	settings2->SaveAll();
+	settings2->SaveAll(slotBinding);
+	settings2->GetSnapshot(settings2Snapshot);
 	UpdateMenus();
 }
 void MoviePlayerView::Save3Pressed()
 {
 	if(!settings3) return;
 
-	settings3->SaveAll();
+	settings3->SaveAll(slotBinding);
+	settings3->GetSnapshot(settings3Snapshot);
 	UpdateMenus();
 }
 void MoviePlayerView::Load1Pressed()
 {
-	LoadSettings(settings1);
+	LoadSettings(settings1, settings1Snapshot);
 }
 void MoviePlayerView::Load2Pressed()
 {
-	LoadSettings(settings2);
+	LoadSettings(settings2, settings2Snapshot);
 }
 void MoviePlayerView::Load3Pressed()
 {
-	LoadSettings(settings3);
+	LoadSettings(settings3, settings3Snapshot);
 }
-void MoviePlayerView::LoadSettings(Settings* set)
+void MoviePlayerView::LoadSettings(Settings* set, const SettingsSnapshot & snapshot)
 {
-	MovieFormat oldFormat = Cinema.SceneMgr.CurrentMovieFormat;
-	int oldWidth = 	streamWidth;
-	int oldHeight = streamHeight;
-	int oldFPS = streamFPS;
+	const MovieFormat oldFormat = Cinema.SceneMgr.CurrentMovieFormat;
 
-	set->Load();
+	// Only what the slot changes needs updating
+	SettingsMask changed(GetStreamTheaterSchema().GetCount());
+	snapshot.Apply(slotBinding, changed);
 
-	if( oldWidth != streamWidth || oldHeight != streamHeight || oldFPS != streamFPS )
+	if( changed.Test(STREAM_SETTING_StreamWidth) || changed.Test(STREAM_SETTING_StreamHeight) || changed.Test(STREAM_SETTING_StreamFPS) )
 	{
-		Cinema.SceneMgr.ClearMovie();
-		Cinema.StartMoviePlayback(streamWidth, streamHeight, streamFPS, streamHostAudio, bitrate);
+		ReconfigureStream(STREAM_TUNING_FROM_TARGET);
 	}
 
-	GazeSlider.SetExtents(GazeMax,GazeMin,2);
-	GazeSlider.SetValue(gazeScaleValue);
-	TrackpadSlider.SetExtents(TrackpadMax,TrackpadMin,2);
-	TrackpadSlider.SetValue(trackpadScaleValue);
-	GamepadSlider.SetExtents(GamepadMax,GamepadMin,2);
-	GamepadSlider.SetValue(gamepadScaleValue);
-	BitrateSlider.SetExtents(BitrateMax,BitrateMin,-1);
-	BitrateSlider.SetValue(customBitrate);
-	DistanceSlider.SetExtents(VoidScreenDistanceMax,VoidScreenDistanceMin,2);
-	DistanceSlider.SetValue(Cinema.SceneMgr.FreeScreenDistance);
-	SizeSlider.SetExtents(VoidScreenScaleMax,VoidScreenScaleMin,2);
-	SizeSlider.SetValue(Cinema.SceneMgr.FreeScreenScale);
+	if( changed.Test(STREAM_SETTING_GazeScale) || changed.Test(STREAM_SETTING_GazeScaleMax) || changed.Test(STREAM_SETTING_GazeScaleMin) )
+	{
+		GazeSlider.SetExtents(GazeMax,GazeMin,2);
+		GazeSlider.SetValue(gazeScaleValue);
+	}
+	if( changed.Test(STREAM_SETTING_TrackpadScale) || changed.Test(STREAM_SETTING_TrackpadScaleMax) || changed.Test(STREAM_SETTING_TrackpadScaleMin) )
+	{
+		TrackpadSlider.SetExtents(TrackpadMax,TrackpadMin,2);
+		TrackpadSlider.SetValue(trackpadScaleValue);
+	}
+	if( changed.Test(STREAM_SETTING_GamepadMouseScale) || changed.Test(STREAM_SETTING_GamepadScaleMax) || changed.Test(STREAM_SETTING_GamepadScaleMin) )
+	{
+		GamepadSlider.SetExtents(GamepadMax,GamepadMin,2);
+		GamepadSlider.SetValue(gamepadScaleValue);
+	}
+	if( changed.Test(STREAM_SETTING_CustomBitrate) || changed.Test(STREAM_SETTING_MaxBitrate) || changed.Test(STREAM_SETTING_MinBitrate) )
+	{
+		BitrateSlider.SetExtents(BitrateMax,BitrateMin,-1);
+		BitrateSlider.SetValue(customBitrate);
+	}
+	if( changed.Test(STREAM_SETTING_VoidScreenDistance) || changed.Test(STREAM_SETTING_VoidScreenDistanceMax) || changed.Test(STREAM_SETTING_VoidScreenDistanceMin) )
+	{
+		DistanceSlider.SetExtents(VoidScreenDistanceMax,VoidScreenDistanceMin,2);
+		DistanceSlider.SetValue(Cinema.SceneMgr.FreeScreenDistance);
+	}
+	if( changed.Test(STREAM_SETTING_VoidScreenScale) || changed.Test(STREAM_SETTING_VoidScreenScaleMax) || changed.Test(STREAM_SETTING_VoidScreenScaleMin) )
+	{
+		SizeSlider.SetExtents(VoidScreenScaleMax,VoidScreenScaleMin,2);
+		SizeSlider.SetValue(Cinema.SceneMgr.FreeScreenScale);
+	}
 
 	if( Cinema.SceneMgr.CurrentMovieFormat == VT_LEFT_RIGHT_3D && oldFormat != VT_LEFT_RIGHT_3D )
 	{
@@ -2215,16 +2371,20 @@ void MoviePlayerView::LoadSettings(Settings* set)
 		Cinema.SceneMgr.CurrentMovieWidth *= 2;
 	}
 
-	if( mouseMode == MOUSE_GAMEPAD)
+	if( changed.Test(STREAM_SETTING_MouseMode) )
 	{
-		Native::controllerHandledByMoonlight(Cinema.app, false);
-	}
-	else {
-		Native::controllerHandledByMoonlight(Cinema.app, true);
+		if( mouseMode == MOUSE_GAMEPAD)
+		{
+			Native::controllerHandledByMoonlight(Cinema.app, false);
+		}
+		else {
+			Native::controllerHandledByMoonlight(Cinema.app, true);
+		}
 	}
 
 	LoadGamepadSettings(set);
 
+	UpdateMouseMotion();
 	UpdateMenus();
 }
 
@@ -2344,9 +2504,20 @@ void MoviePlayerView::BitratePressed( const float value)
 void MoviePlayerView::ApplyVideoPressed()
 {
 	videoSettingsUpdated = false;
-	Cinema.SceneMgr.ClearMovie();
 	UpdateMenus();
-	Cinema.StartMoviePlayback(streamWidth, streamHeight, streamFPS, streamHostAudio, bitrate);
+	ReconfigureStream(STREAM_TUNING_FROM_TARGET);
+}
+void MoviePlayerView::StartStream(const StreamTuning tuning)
+{
+	// The audio sink picks this up when the stream starts it
+	nv_audio_sink_set_spatialize( spatialAudio );
+	// What's picked here is the most the tuner will stream
+	Cinema.StartMoviePlayback(streamWidth, streamHeight, streamFPS, streamHostAudio, bitrate, autoTuneStream ? tuning : STREAM_TUNING_OFF);
+}
+void MoviePlayerView::ReconfigureStream(const StreamTuning tuning)
+{
+	nv_audio_sink_set_spatialize( spatialAudio );
+	Cinema.ReconfigureMoviePlayback(streamWidth, streamHeight, streamFPS, streamHostAudio, bitrate, autoTuneStream ? tuning : STREAM_TUNING_OFF);
 }
 void MoviePlayerView::LatencyPressed(const float value)
 {
@@ -2596,6 +2767,10 @@ Matrix4f MoviePlayerView::Frame( const VrFrame & vrFrame )
 		LOG( "Playback finished" );
 		Cinema.MovieFinished();
 	}
+	else
+	{
+		Cinema.UpdateStreamProfile();
+	}
 
 	CheckInput( vrFrame );
 	CheckDebugControls( vrFrame );
@@ -2610,7 +2785,25 @@ Matrix4f MoviePlayerView::Frame( const VrFrame & vrFrame )
 		MoveScreenMenu->Close();
 	}
 
-	return Cinema.SceneMgr.Frame( vrFrame );
+	const Matrix4f viewMatrix = Cinema.SceneMgr.Frame( vrFrame );
+	UpdateAudioScreen( viewMatrix );
+	return viewMatrix;
+}
+
+/*
+ * UpdateAudioScreen()
+ *
+ * The host's audio plays from wherever the screen is relative to the head,
+ * the audio callback picks up the newest position every buffer. Set straight
+ * on the audio sink, it changes with every head movement.
+ */
+void MoviePlayerView::UpdateAudioScreen( const Matrix4f & viewMatrix )
+{
+	const Vector3f center = viewMatrix.Transform( Cinema.SceneMgr.GetScreenPose().Position );
+	const Vector3f up = viewMatrix.Transform( Vector3f( 0.0f, 1.0f, 0.0f ) ) - viewMatrix.Transform( Vector3f( 0.0f, 0.0f, 0.0f ) );
+	const float centerArray[3] = { center.x, center.y, center.z };
+	const float upArray[3] = { up.x, up.y, up.z };
+	nv_audio_sink_set_screen( centerArray, upArray, Cinema.SceneMgr.GetScreenSize().x );
 }
 
 /*************************************************************************************/
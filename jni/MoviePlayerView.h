@@ -27,6 +27,9 @@ of patent rights can be found in the PATENTS file in the same directory.
 #include "UI/UIButton.h"
 #include "UI/UITextButton.h"
 #include "Settings.h"
+#include "MouseMotion.h"
+#include "InputSampler.h"
+#include "StreamProfileTuner.h"
 
 #include "Kernel/OVR_List.h"
 
@@ -163,6 +166,10 @@ public:
 
 	void					MovieScreenUpdated();
 
+	// The input sampler reads the head pose through vrapi, so it's parked while out of VR mode
+	void					EnteredVrMode();
+	void					LeavingVrMode();
+
 private:
 	CinemaApp &				Cinema;
 
@@ -354,11 +361,18 @@ private:
 	String					settings2Path;
 	String					settings3Path;
 	String					appSettingsPath;
+	String					hostSettingsPath;
 	Settings*				defaultSettings;
 	Settings*				settings1;
 	Settings*				settings2;
 	Settings*				settings3;
 	Settings*				appSettings;
+	Settings*				hostSettings;
+	SettingsSnapshot		settings1Snapshot;		// The save slots, ready to switch to
+	SettingsSnapshot		settings2Snapshot;
+	SettingsSnapshot		settings3Snapshot;
+	SettingsBinding			settingsBinding;		// What's saved as defaults, per host and per app
+	SettingsBinding			slotBinding;			// and the save slots, which also have the 3D mode
 
 	bool					BackgroundClicked;
 	bool					UIOpened;							// Used to ignore button A or touchpad until release so we don't close the UI immediately after opening it
@@ -378,12 +392,31 @@ private:
 	float					trackpadScaleValue;
 	float					gamepadScaleValue;
 
+	MouseMotion				gazeMotion;
+	MouseMotion				trackpadMotion;
+	MouseMotion				gamepadMotion;
+	MouseMotion				vrMotion;
+	bool					gazeSmoothing;
+	bool					trackpadSmoothing;
+	bool					gamepadSmoothing;
+	float					gazeAcceleration;
+	float					trackpadAcceleration;
+	float					gamepadAcceleration;
+	float					mouseFilterMinCutoff;
+	float					mouseFilterBeta;
+
+	InputSampler			inputSampler;
+	int						inputSampleRate;
+	bool					inputSamplerParked;
+
 	int						streamWidth;
 	int 					streamHeight;
 	int						streamFPS;
 	bool					streamHostAudio;
+	bool					spatialAudio;		// host audio from the screen's position
 	float					customBitrate;
 	int						bitrate;
+	bool					autoTuneStream;
 	bool					videoSettingsUpdated;
 
 	float					BitrateMin;
@@ -412,6 +445,9 @@ private:
 	bool					screenMotionPaused;
 	float					vrXscale;
 	float					vrYscale;
+	bool					vrPredictMouse;
+	int						VRPredictionMax;
+	float					vrDisplayDelay;		// smoothed ms from a frame arriving to it being on screen
 	int						VRLatencyMax;
 	int						VRLatencyMin;
 	float					VRXScaleMax;
@@ -565,12 +601,22 @@ private:
 
 	Vector2f 				GazeCoordinatesOnScreen( const Matrix4f & viewMatrix, const Matrix4f panelMatrix ) const;
 
-	void					LoadSettings(Settings* set);
+	void					LoadSettings(Settings* set, const SettingsSnapshot & snapshot);
+	// Starts streaming the profile picked, with tuning unless it's turned off
+	void					StartStream(const StreamTuning tuning);
+	// Same, keeping the screen and its last frame while a playing stream reconnects
+	void					ReconfigureStream(const StreamTuning tuning);
 	void					InitializeSettings();
 	void					InitializeGamepadMouse();
 	void					WriteGamepadSettings(Settings* set);
 	void					LoadGamepadSettings(Settings* set);
 	void					UpdateMenus();
+	void					UpdateMouseMotion();
+	void					SendMouseMotion( MouseMotion & motion, const Vector2f & delta, const double time );
+	// Through the input sampler when it runs, so they stay in order with its moves
+	void					SendMouseMove( const int deltaX, const int deltaY );
+	void					SendMouseClick( const int buttonId, const bool down );
+	void					SendMouseScroll( const signed char amount );
 
 	void 					UpdateUI( const VrFrame & vrFrame );
 	void 					CheckInput( const VrFrame & vrFrame );
@@ -578,6 +624,7 @@ private:
 	void					HandleTrackpadMouse( const VrFrame & vrFrame );
 	void					HandleGamepadMouse( const VrFrame & vrFrame );
 	void 					CheckDebugControls( const VrFrame & vrFrame );
+	void					UpdateAudioScreen( const Matrix4f & viewMatrix );
 	void					DoGamepadEvent(int code, bool down);
 
 	void 					ShowUI();
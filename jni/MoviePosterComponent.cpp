@@ -27,6 +27,7 @@ bool MoviePosterComponent::ShowShadows = true;
 MoviePosterComponent::MoviePosterComponent() :
 	CarouselItemComponent( VRMenuEventFlags_t() ),
 	CurrentItem( NULL ),
+	CurrentTexture( 0 ),
     Poster( NULL ),
 	PosterImage( NULL ),
     Is3DIcon( NULL ),
@@ -68,11 +69,19 @@ void MoviePosterComponent::SetItem( VRMenuObject * self, const CarouselItem * it
 	Is3DIcon->SetColor( pose.Color );
 	Shadow->SetColor( pose.Color );
 
+	if ( ( item != NULL ) && ( item == CurrentItem ) && ( item->texture != CurrentTexture ) )
+	{
+		// its poster was loaded or released
+		PosterImage->SetImage( 0, SURFACE_TEXTURE_DIFFUSE, item->texture, Width, Height );
+		CurrentTexture = item->texture;
+	}
+
 	if ( item != CurrentItem )
 	{
 		if ( item != NULL )
 		{
 			PosterImage->SetImage( 0, SURFACE_TEXTURE_DIFFUSE, item->texture, Width, Height );
+			CurrentTexture = item->texture;
 
 			Is3DIcon->SetVisible( ( item->userFlags & 1 ) != 0 );
 			Shadow->SetVisible( ShowShadows );
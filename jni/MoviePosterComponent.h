@@ -43,6 +43,7 @@ private:
                                     VRMenuObject * self, VRMenuEvent const & event );
 
     const CarouselItem * 	CurrentItem;
+    GLuint					CurrentTexture;
 
     int						Width;
     int						Height;
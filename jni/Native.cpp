@@ -122,6 +122,7 @@ static jmethodID 	isPlaybackFinishedMethodId = NULL;
 static jmethodID 	hadPlaybackErrorMethodId = NULL;
 static jmethodID 	startMovieMethodId = NULL;
 static jmethodID 	stopMovieMethodId = NULL;
+static jmethodID 	reconfigureMovieMethodId = NULL;
 static jmethodID 	initPcSelectorMethodId = NULL;
 static jmethodID 	pairPcMethodId = NULL;
 static jmethodID 	getPcPairStateMethodId = NULL;
@@ -138,6 +139,7 @@ static jmethodID	stopAppUpdatesMethodId = NULL;
 static jmethodID	startAppUpdatesMethodId = NULL;
 static jmethodID	getLastFrameTimestampMethodId = NULL;
 static jmethodID	currentTimeStampMethodId = NULL;
+static jmethodID	getStreamStatsMethodId = NULL;
 static jmethodID	closeAppMethodId = NULL;
 static jmethodID	controllerHandledByMoonlightMethodId = NULL;
 static jmethodID	sendKeyboardMethodId = NULL;
@@ -167,6 +169,7 @@ void Native::OneTimeInit( App *app, jclass mainActivityClass )
 	hadPlaybackErrorMethodId			= GetMethodID( app, mainActivityClass, "hadPlaybackError", "()Z" );
 	startMovieMethodId 					= GetMethodID( app, mainActivityClass, "startMovie", "(Ljava/lang/String;Ljava/lang/String;ILjava/lang/String;IIIZIZ)V" );
 	stopMovieMethodId 					= GetMethodID( app, mainActivityClass, "stopMovie", "()V" );
+	reconfigureMovieMethodId			= GetMethodID( app, mainActivityClass, "reconfigureMovie", "(Ljava/lang/String;Ljava/lang/String;ILjava/lang/String;IIIZIZ)V" );
 	initPcSelectorMethodId 				= GetMethodID( app, mainActivityClass, "initPcSelector", "()V" );
 	pairPcMethodId 						= GetMethodID( app, mainActivityClass, "pairPc", "(Ljava/lang/String;)V" );
 	getPcPairStateMethodId 				= GetMethodID( app, mainActivityClass, "getPcPairState", "(Ljava/lang/String;)I" );
@@ -183,6 +186,7 @@ void Native::OneTimeInit( App *app, jclass mainActivityClass )
 	startAppUpdatesMethodId				= GetMethodID( app, mainActivityClass, "startAppUpdates", "()V" );
 	getLastFrameTimestampMethodId		= GetMethodID( app, mainActivityClass, "getLastFrameTimestamp", "()J" );
 	currentTimeStampMethodId			= GetMethodID( app, mainActivityClass, "currentTimeStamp", "()J" );
+	getStreamStatsMethodId				= GetMethodID( app, mainActivityClass, "getStreamStats", "([I)Z" );
 	closeAppMethodId					= GetMethodID( app, mainActivityClass, "closeApp", "(Ljava/lang/String;I)V" );
 	controllerHandledByMoonlightMethodId = GetMethodID( app, mainActivityClass, "controllerHandledByMoonlight", "(Z)V");
 	sendKeyboardMethodId				= GetMethodID( app, mainActivityClass, "sendKeyboard", "(IZ)V" );
@@ -261,6 +265,21 @@ void Native::StopMovie( App *app )
 	app->GetVrJni()->CallVoidMethod( app->GetJavaObject(), stopMovieMethodId );
 }
 
+void Native::ReconfigureMovie( App *app, const char * uuid, const char * appName, int id, const char * binder, int width, int height, int fps, bool hostAudio, int customBitrate, bool remote )
+{
+	LOG( "ReconfigureMovie( %s, %ix%i@%i %ikbps )", appName, width, height, fps, customBitrate );
+
+	jstring jstrUUID = app->GetVrJni()->NewStringUTF( uuid );
+	jstring jstrAppName = app->GetVrJni()->NewStringUTF( appName );
+	jstring jstrBinder = app->GetVrJni()->NewStringUTF( binder );
+
+	app->GetVrJni()->CallVoidMethod( app->GetJavaObject(), reconfigureMovieMethodId, jstrUUID, jstrAppName, id, jstrBinder, width, height, fps, hostAudio, customBitrate, remote );
+
+	app->GetVrJni()->DeleteLocalRef( jstrUUID );
+	app->GetVrJni()->DeleteLocalRef( jstrAppName );
+	app->GetVrJni()->DeleteLocalRef( jstrBinder );
+}
+
 void Native::InitPcSelector( App *app )
 {
 	LOG( "InitPcSelector()" );
@@ -301,16 +320,32 @@ void Native::MouseMove(App *app, int deltaX, int deltaY)
 	app->GetVrJni()->CallVoidMethod( app->GetJavaObject(), mouseMoveMethodId, deltaX, deltaY );
 }
 
+void Native::MouseMove(JNIEnv *jni, jobject activity, int deltaX, int deltaY)
+{
+	jni->CallVoidMethod( activity, mouseMoveMethodId, deltaX, deltaY );
+}
+
 void Native::MouseClick(App *app, int buttonId, bool down)
 {
 	app->GetVrJni()->CallVoidMethod( app->GetJavaObject(), mouseClickMethodId, buttonId, down );
 }
 
+void Native::MouseClick(JNIEnv *jni, jobject activity, int buttonId, bool down)
+{
+	jni->CallVoidMethod( activity, mouseClickMethodId, buttonId, down );
+}
+
 void Native::MouseScroll(App *app, signed char amount)
 {
 	app->GetVrJni()->CallVoidMethod( app->GetJavaObject(), mouseScrollMethodId, amount );
 }
 
+void Native::MouseScroll(JNIEnv *jni, jobject activity, signed char amount)
+{
+	jni->CallVoidMethod( activity, mouseScrollMethodId, amount );
+}
+
+
 void Native::stopPcUpdates(App *app)
 {
 	app->GetVrJni()->CallVoidMethod( app->GetJavaObject(), stopPcUpdatesMethodId );
@@ -343,6 +378,26 @@ long Native::currentTimeStamp(App *app)
 	return app->GetVrJni()->CallLongMethod( app->GetJavaObject(), currentTimeStampMethodId );
 }
 
+bool Native::GetStreamStats(App *app, StreamStats & stats)
+{
+	static const int STAT_COUNT = 5;
+	JNIEnv * jni = app->GetVrJni();
+	jintArray jstats = jni->NewIntArray( STAT_COUNT );
+	const bool counted = jni->CallBooleanMethod( app->GetJavaObject(), getStreamStatsMethodId, jstats ) != 0;
+	if ( counted )
+	{
+		jint values[STAT_COUNT];
+		jni->GetIntArrayRegion( jstats, 0, STAT_COUNT, values );
+		stats.SubmittedFrames	= values[0];
+		stats.DecodedFrames		= values[1];
+		stats.DecoderTimeMs		= values[2];
+		stats.CompleteFrames	= values[3];
+		stats.DroppedFrames		= values[4];
+	}
+	jni->DeleteLocalRef( jstats );
+	return counted;
+}
+
 int Native::addPCbyIP(App *app, const char* ip)
 {
 	jstring jstrIP = app->GetVrJni()->NewStringUTF( ip );
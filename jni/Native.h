@@ -21,6 +21,8 @@ using namespace OVR;
 
 namespace VRMatterStreamTheater {
 
+struct StreamStats;
+
 class Native {
 public:
 	static void			OneTimeInit( App *app, jclass mainActivityClass );
@@ -36,6 +38,8 @@ public:
 
 	static void 		StartMovie( App *app, const char * uuid, const char * appName, int id, const char * binder, int width, int height, int fps, bool hostAudio, int customBitrate, bool remote );
 	static void 		StopMovie( App *app );
+	// Reconnects the playing stream with new settings, on the surface it already has
+	static void 		ReconfigureMovie( App *app, const char * uuid, const char * appName, int id, const char * binder, int width, int height, int fps, bool hostAudio, int customBitrate, bool remote );
 
 	enum PairState {
 		NOT_PAIRED = 0,
@@ -63,8 +67,11 @@ public:
     static void			Pair( App *app, const char* uuid);
 
     static void			MouseMove(App *app, int deltaX, int deltaY);
+    static void			MouseMove(JNIEnv *jni, jobject activity, int deltaX, int deltaY);	// for threads other than the render thread
     static void			MouseClick(App *app, int buttonId, bool down);
+    static void			MouseClick(JNIEnv *jni, jobject activity, int buttonId, bool down);
     static void			MouseScroll(App *app, signed char amount);
+    static void			MouseScroll(JNIEnv *jni, jobject activity, signed char amount);
 
     static void			stopPcUpdates(App *app);
     static void			startPcUpdates(App *app);
@@ -74,6 +81,8 @@ public:
 
     static long			getLastFrameTimestamp(App *app);
     static long			currentTimeStamp(App *app);
+    // returns false if there's no stream to count
+    static bool			GetStreamStats(App *app, StreamStats & stats);
 
     static int			addPCbyIP(App *app, const char* ip);
 
@@ -67,7 +67,7 @@ PcSelectionView::PcSelectionView( CinemaApp &cinema ) :
 	TitleRoot( NULL ),
 	MovieTitle( NULL ),
 	SelectionFrame( NULL ),
-	CenterPoster( NULL ),
+	PosterImages(),
 	CenterIndex( 0 ),
 	CenterPosition(),
 	LeftSwipes(),
@@ -390,10 +390,7 @@ void PcSelectionView::CreateMenu( OvrGuiSys & guiSys )
 		posterImage->GetMenuObject()->AddFlags( VRMENUOBJECT_FLAG_NO_FOCUS_GAINED );
 		posterImage->GetMenuObject()->SetLocalBoundsExpand( selectionBoundsExpandMin, selectionBoundsExpandMax );
 
-		if ( i == CenterIndex )
-		{
-			CenterPoster = posterImage;
-		}
+		PosterImages.PushBack( posterImage );
 
 		//
 		// 3D icon
@@ -427,6 +424,7 @@ void PcSelectionView::CreateMenu( OvrGuiSys & guiSys )
 	}
 
 	MovieBrowser->SetMenuObjects( menuObjs, MoviePosterComponents );
+	MovieBrowser->SetRecyclePanels( true );
 
 	// ==============================================================================
 	//
@@ -720,19 +718,19 @@ void PcSelectionView::UpdateMenuPosition()
 {
 	// scale down when in a theater
 	const float scale = Cinema.InLobby ? 1.0f : 0.55f;
-	CenterRoot->GetMenuObject()->SetLocalScale( Vector3f( scale ) );
+	CenterRoot->SetLocalScale( Vector3f( scale ) );
 
 	if ( !Cinema.InLobby && Cinema.SceneMgr.SceneInfo.UseFreeScreen )
 	{
 		Quatf orientation = Quatf( Cinema.SceneMgr.FreeScreenPose );
-		CenterRoot->GetMenuObject()->SetLocalRotation( orientation );
-		CenterRoot->GetMenuObject()->SetLocalPosition( Cinema.SceneMgr.FreeScreenPose.Transform( Vector3f( 0.0f, -1.76f * scale, 0.0f ) ) );
+		CenterRoot->SetLocalRotation( orientation );
+		CenterRoot->SetLocalPosition( Cinema.SceneMgr.FreeScreenPose.Transform( Vector3f( 0.0f, -1.76f * scale, 0.0f ) ) );
 	}
 	else
 	{
 		const float menuOffset = Cinema.InLobby ? 0.0f : 0.5f;
-		CenterRoot->GetMenuObject()->SetLocalRotation( Quatf() );
-		CenterRoot->GetMenuObject()->SetLocalPosition( ScalePosition( Vector3f::ZERO, scale, menuOffset ) );
+		CenterRoot->SetLocalRotation( Quatf() );
+		CenterRoot->SetLocalPosition( ScalePosition( Vector3f::ZERO, scale, menuOffset ) );
 	}
 }
 
@@ -914,11 +912,20 @@ void PcSelectionView::SelectionHighlighted( bool isHighlighted )
 	if ( isHighlighted && !ShowTimer && !Cinema.InLobby && ( MoviesIndex == MovieBrowser->GetSelection() ) )
 	{
 		// dim the poster when the resume icon is up and the poster is highlighted
-		CenterPoster->SetColor( Vector4f( 0.55f, 0.55f, 0.55f, 1.0f ) );
+		SetSelectedPosterColor( Vector4f( 0.55f, 0.55f, 0.55f, 1.0f ) );
 	}
 	else if ( MovieBrowser->HasSelection() )
 	{
-		CenterPoster->SetColor( Vector4f( 1.0f ) );
+		SetSelectedPosterColor( Vector4f( 1.0f ) );
+	}
+}
+
+void PcSelectionView::SetSelectedPosterColor( const Vector4f & color )
+{
+	const int panel = MovieBrowser->GetSelectionPanel();
+	if ( panel >= 0 )
+	{
+		PosterImages[ panel ]->SetColor( color );
 	}
 }
 
@@ -976,7 +983,7 @@ void PcSelectionView::UpdateSelectionFrame( const VrFrame & vrFrame )
 			TimerIcon->SetText( text );
 		}
 		TimerIcon->SetVisible( true );
-		CenterPoster->SetColor( Vector4f( 0.55f, 0.55f, 0.55f, 1.0f ) );
+		SetSelectedPosterColor( Vector4f( 0.55f, 0.55f, 0.55f, 1.0f ) );
 	}
 	else
 	{
@@ -1150,8 +1157,8 @@ Matrix4f PcSelectionView::Frame( const VrFrame & vrFrame )
 		{
 			Cinema.SceneMgr.PutScreenInFront();
 			Quatf orientation = Quatf( Cinema.SceneMgr.FreeScreenPose );
-			CenterRoot->GetMenuObject()->SetLocalRotation( orientation );
-			CenterRoot->GetMenuObject()->SetLocalPosition( Cinema.SceneMgr.FreeScreenPose.Transform( Vector3f( 0.0f, -1.76f * 0.55f, 0.0f ) ) );
+			CenterRoot->SetLocalRotation( orientation );
+			CenterRoot->SetLocalPosition( Cinema.SceneMgr.FreeScreenPose.Transform( Vector3f( 0.0f, -1.76f * 0.55f, 0.0f ) ) );
 
 		}
 		else
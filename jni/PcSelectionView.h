@@ -108,7 +108,7 @@ private:
 
 	UIImage *							SelectionFrame;
 
-	UIImage *							CenterPoster;
+	Array<UIImage *>					PosterImages;			// by the carousel's menu objects
 	UPInt								CenterIndex;
 	Vector3f							CenterPosition;
 
@@ -170,6 +170,8 @@ private:
 
 	void								UpdatePcTitle();
 	void								UpdateSelectionFrame( const VrFrame & vrFrame );
+	// The poster showing the selected item, whichever of the panels it is on
+	void								SetSelectedPosterColor( const Vector4f & color );
 
 	bool								ErrorShown() const;
 
@@ -0,0 +1,523 @@
+/************************************************************************************
+
+Filename    :   PosterLoader.cpp
+Content     :	Loads the posters of a carousel's items in the order they'll be seen.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#include "PosterLoader.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "Android/LogUtils.h"
+
+#ifndef NDEBUG
+#include "CarouselBrowserComponent.h"	// for its motion
+#endif
+
+namespace VRMatterStreamTheater {
+
+PosterLoader::PosterLoader( PosterLoaderBackend & backend, const int maxResident ) :
+	Backend( backend ),
+	MaxResident( maxResident ),
+	ItemCount( 0 ),
+	States(),
+	WantedFrames(),
+	FrameCount( 0 ),
+	Wanted(),
+	Fetching(),
+	Resident(),
+	LastPosition( 0.0f )
+{
+	memset( &Stats, 0, sizeof( Stats ) );
+}
+
+void PosterLoader::SetItems( const int count )
+{
+	for ( int i = 0; i < Fetching.GetSizeI(); i++ )
+	{
+		Backend.Cancel( Fetching[ i ] );
+	}
+	Fetching.Clear();
+	Resident.Clear();
+
+	ItemCount = count;
+	States.Resize( count );
+	WantedFrames.Resize( count );
+	for ( int i = 0; i < count; i++ )
+	{
+		States[ i ] = Backend.IsResident( i ) ? POSTER_RESIDENT : POSTER_NONE;
+		WantedFrames[ i ] = 0;
+		if ( States[ i ] == POSTER_RESIDENT )
+		{
+			Resident.PushBack( i );
+		}
+	}
+}
+
+void PosterLoader::Want( const int item )
+{
+	if ( ( item < 0 ) || ( item >= ItemCount ) || ( Wanted.GetSizeI() >= MaxResident ) || ( WantedFrames[ item ] == FrameCount ) )
+	{
+		return;
+	}
+	WantedFrames[ item ] = FrameCount;
+	Wanted.PushBack( item );
+}
+
+// first to last, outwards from center, the side dir is on first
+void PosterLoader::WantAround( const int center, const int first, const int last, const int dir )
+{
+	const int side = ( dir < 0 ) ? -1 : 1;
+	for ( int i = 0; ( i <= last - first ) && ( Wanted.GetSizeI() < MaxResident ); i++ )
+	{
+		const int ahead = center + i * side;
+		const int behind = center - i * side;
+		if ( ( ahead >= first ) && ( ahead <= last ) )
+		{
+			Want( ahead );
+		}
+		if ( ( behind >= first ) && ( behind <= last ) )
+		{
+			Want( behind );
+		}
+	}
+}
+
+void PosterLoader::Rank( const float position, const float velocity, const float stop, const int halfWidth )
+{
+	FrameCount++;
+	Wanted.Clear();
+	if ( ItemCount == 0 )
+	{
+		return;
+	}
+
+	const int dir = ( velocity > 0.0f ) ? 1 : ( ( velocity < 0.0f ) ? -1 : 0 );
+
+	// on screen now
+	int first = ( int )ceilf( position - halfWidth );
+	int last = ( int )floorf( position + halfWidth );
+	WantAround( ( int )floorf( position + 0.5f ), first, last, dir );
+
+	if ( dir != 0 )
+	{
+		// on screen where it stops
+		const int stopFirst = ( int )ceilf( stop - halfWidth );
+		const int stopLast = ( int )floorf( stop + halfWidth );
+		WantAround( ( int )floorf( stop + 0.5f ), stopFirst, stopLast, -dir );
+
+		// and passed on the way there, in the order it gets to them
+		if ( dir > 0 )
+		{
+			for ( int i = last + 1; ( i < stopFirst ) && ( i < ItemCount ) && ( Wanted.GetSizeI() < MaxResident ); i++ )
+			{
+				Want( i );
+			}
+		}
+		else
+		{
+			for ( int i = first - 1; ( i > stopLast ) && ( i >= 0 ) && ( Wanted.GetSizeI() < MaxResident ); i-- )
+			{
+				Want( i );
+			}
+		}
+
+		first = ( stopFirst < first ) ? stopFirst : first;
+		last = ( stopLast > last ) ? stopLast : last;
+	}
+
+	// outwards from all of that
+	for ( int i = 1; ( Wanted.GetSizeI() < MaxResident ) && ( ( first - i >= 0 ) || ( last + i < ItemCount ) ); i++ )
+	{
+		if ( dir < 0 )
+		{
+			Want( first - i );
+			Want( last + i );
+		}
+		else
+		{
+			Want( last + i );
+			Want( first - i );
+		}
+	}
+}
+
+// Releases the resident poster that isn't wanted furthest from where the carousel is
+bool PosterLoader::Evict()
+{
+	int furthest = -1;
+	float furthestDistance = -1.0f;
+	for ( int i = 0; i < Resident.GetSizeI(); i++ )
+	{
+		const int item = Resident[ i ];
+		const float distance = fabsf( ( float )item - LastPosition );
+		if ( ( WantedFrames[ item ] != FrameCount ) && ( distance > furthestDistance ) )
+		{
+			furthest = i;
+			furthestDistance = distance;
+		}
+	}
+	if ( furthest < 0 )
+	{
+		return false;
+	}
+
+	const int item = Resident[ furthest ];
+	Backend.Release( item );
+	States[ item ] = POSTER_NONE;
+	Resident.RemoveAt( furthest );
+	Stats.Releases++;
+	return true;
+}
+
+void PosterLoader::Update( const float position, const float velocity, const float stop, const int halfWidth )
+{
+	LastPosition = position;
+	Rank( position, velocity, stop, halfWidth );
+
+	// fetches nobody wants any more
+	for ( int i = Fetching.GetSizeI() - 1; i >= 0; i-- )
+	{
+		const int item = Fetching[ i ];
+		if ( WantedFrames[ item ] != FrameCount )
+		{
+			Backend.Cancel( item );
+			States[ item ] = POSTER_NONE;
+			Fetching.RemoveAt( i );
+			Stats.Cancels++;
+		}
+	}
+
+	for ( int item = Backend.TakeFetched(); item >= 0; item = Backend.TakeFetched() )
+	{
+		if ( ( item < ItemCount ) && ( States[ item ] == POSTER_FETCHING ) )
+		{
+			States[ item ] = POSTER_FETCHED;
+		}
+	}
+
+	// uploads, best first
+	int uploads = 0;
+	for ( int i = 0; ( i < Wanted.GetSizeI() ) && ( uploads < UPLOADS_PER_FRAME ); i++ )
+	{
+		const int item = Wanted[ i ];
+		if ( States[ item ] != POSTER_FETCHED )
+		{
+			continue;
+		}
+
+		bool room = true;
+		while ( room && ( Resident.GetSizeI() >= MaxResident ) )
+		{
+			room = Evict();
+		}
+		if ( !room )
+		{
+			// it waits for something to stop being wanted
+			break;
+		}
+
+		for ( int j = 0; j < Fetching.GetSizeI(); j++ )
+		{
+			if ( Fetching[ j ] == item )
+			{
+				Fetching.RemoveAt( j );
+				break;
+			}
+		}
+		if ( Backend.Upload( item ) )
+		{
+			States[ item ] = POSTER_RESIDENT;
+			Resident.PushBack( item );
+			Stats.Uploads++;
+		}
+		else
+		{
+			States[ item ] = POSTER_FAILED;
+			Stats.Failures++;
+		}
+		uploads++;
+	}
+
+	// and fetches, best first
+	for ( int i = 0; ( i < Wanted.GetSizeI() ) && ( Fetching.GetSizeI() < MAX_FETCHES ); i++ )
+	{
+		const int item = Wanted[ i ];
+		if ( States[ item ] == POSTER_NONE )
+		{
+			Backend.Fetch( item );
+			States[ item ] = POSTER_FETCHING;
+			Fetching.PushBack( item );
+			Stats.Fetches++;
+		}
+	}
+}
+
+#ifndef NDEBUG
+#include <assert.h>
+
+// Reads posters one at a time, each taking READ_SECONDS, on a clock the
+// simulation moves. A cancelled read that has started still takes its time.
+class SimulatedPosterBackend : public PosterLoaderBackend
+{
+public:
+	static const double	READ_SECONDS;
+
+						SimulatedPosterBackend( const int itemCount, const int maxResident ) :
+							Now( 0.0 ), BusyUntil( 0.0 ), Current( -1 ), Pending(), Read(),
+							Resident(), ResidentCount( 0 ), MaxResident( maxResident ), Broken( -1 )
+						{
+							Resident.Resize( itemCount );
+							for ( int i = 0; i < itemCount; i++ )
+							{
+								Resident[ i ] = false;
+							}
+						}
+
+	void				Advance( const double now )
+	{
+		Now = now;
+		while ( ( Current >= 0 || Pending.GetSizeI() > 0 ) && ( BusyUntil <= Now ) )
+		{
+			if ( Current >= 0 )
+			{
+				Read.PushBack( Current );
+				Current = -1;
+			}
+			if ( Pending.GetSizeI() > 0 )
+			{
+				Current = Pending[ 0 ];
+				Pending.RemoveAt( 0 );
+				BusyUntil += READ_SECONDS;
+			}
+		}
+		if ( ( Current < 0 ) && ( BusyUntil < Now ) )
+		{
+			BusyUntil = Now;
+		}
+	}
+
+	virtual void		Fetch( const int item )
+	{
+		Pending.PushBack( item );
+		Advance( Now );
+	}
+
+	virtual int			TakeFetched()
+	{
+		if ( Read.GetSizeI() == 0 )
+		{
+			return -1;
+		}
+		const int item = Read[ 0 ];
+		Read.RemoveAt( 0 );
+		return item;
+	}
+
+	virtual void		Cancel( const int item )
+	{
+		Remove( Pending, item );
+		Remove( Read, item );
+		if ( Current == item )
+		{
+			Current = -1;	// the reader is still busy with it until BusyUntil
+		}
+	}
+
+	virtual bool		Upload( const int item )
+	{
+		assert( !Resident[ item ] );
+		if ( item == Broken )
+		{
+			return false;
+		}
+		Resident[ item ] = true;
+		ResidentCount++;
+		assert( ResidentCount <= MaxResident );
+		return true;
+	}
+
+	virtual void		Release( const int item )
+	{
+		assert( Resident[ item ] );
+		Resident[ item ] = false;
+		ResidentCount--;
+	}
+
+	virtual bool		IsResident( const int item ) const { return Resident[ item ]; }
+
+	int					GetResidentCount() const { return ResidentCount; }
+	// An item whose poster can't be decoded, -1 for none
+	void				SetBroken( const int item ) { Broken = item; }
+
+private:
+	double				Now;
+	double				BusyUntil;
+	int					Current;
+	Array<int>			Pending;
+	Array<int>			Read;
+	Array<unsigned char>	Resident;
+	int					ResidentCount;
+	int					MaxResident;
+	int					Broken;
+
+	static void			Remove( Array<int> & items, const int item )
+	{
+		for ( int i = items.GetSizeI() - 1; i >= 0; i-- )
+		{
+			if ( items[ i ] == item )
+			{
+				items.RemoveAt( i );
+			}
+		}
+	}
+};
+
+const double SimulatedPosterBackend::READ_SECONDS = 0.015;
+
+struct ScrollPattern
+{
+	const char *		Name;
+	float				SwipeItems;		// how far each swipe flings
+	double				SwipeSeconds;	// between swipes
+	double				Seconds;		// of swiping
+	bool				Typical;		// no placeholders allowed
+};
+
+void PosterLoaderSimulate()
+{
+	static const int ITEM_COUNT = 5000;
+	static const int HALF_WIDTH = 3;			// the poster carousel's 7 panels
+	static const int MAX_RESIDENT = 40;			// 16MB of 228x344 mipmapped posters
+	static const double FRAME_SECONDS = 1.0 / 60.0;
+	static const double WARM_UP_SECONDS = 1.0;
+	static const ScrollPattern PATTERNS[] =
+	{
+		{ "browsing",	1.0f,	0.6,	10.0,	true },
+		{ "skimming",	4.0f,	0.5,	10.0,	true },
+		{ "flicking",	8.0f,	0.7,	10.0,	true },
+		{ "paging back",-8.0f,	0.7,	10.0,	true },
+		{ "racing",		12.0f,	0.1,	3.0,	false }
+	};
+
+	for ( int p = 0; p < ( int )( sizeof( PATTERNS ) / sizeof( PATTERNS[0] ) ); p++ )
+	{
+		const ScrollPattern & pattern = PATTERNS[ p ];
+		SimulatedPosterBackend backend( ITEM_COUNT, MAX_RESIDENT );
+		PosterLoader loader( backend, MAX_RESIDENT );
+		loader.SetItems( ITEM_COUNT );
+
+		CarouselMotion motion;
+		motion.Reset( ITEM_COUNT / 2 );
+
+		double now = 0.0;
+		double nextSwipe = WARM_UP_SECONDS;
+		double firstShown = -1.0;
+		int frames = 0;
+		int placeholderFrames = 0;
+		int maxResident = 0;
+		int settled = -1;
+		for ( ; now < WARM_UP_SECONDS + pattern.Seconds + 2.0; now += FRAME_SECONDS )
+		{
+			if ( ( now >= nextSwipe ) && ( now < WARM_UP_SECONDS + pattern.Seconds ) )
+			{
+				motion.Fling( pattern.SwipeItems, ITEM_COUNT - 1 );
+				nextSwipe += pattern.SwipeSeconds;
+			}
+			motion.Advance( FRAME_SECONDS );
+			backend.Advance( now );
+
+			const float position = motion.GetPosition();
+			loader.Update( position, motion.GetVelocity(), motion.GetStop(), HALF_WIDTH );
+			maxResident = Alg::Max( maxResident, backend.GetResidentCount() );
+
+			// the posters that can be seen, all but the faded out ends
+			bool placeholder = false;
+			for ( int item = ( int )floorf( position ) - HALF_WIDTH; item <= ( int )ceilf( position ) + HALF_WIDTH; item++ )
+			{
+				if ( ( item >= 0 ) && ( item < ITEM_COUNT ) && ( fabsf( item - position ) < HALF_WIDTH ) && !backend.IsResident( item ) )
+				{
+					placeholder = true;
+				}
+			}
+
+			if ( firstShown < 0.0 )
+			{
+				if ( !placeholder )
+				{
+					firstShown = now;
+				}
+				continue;
+			}
+			frames++;
+			placeholderFrames += placeholder;
+			if ( ( now >= WARM_UP_SECONDS + pattern.Seconds ) && !motion.IsMoving() && placeholder )
+			{
+				settled = -1;
+			}
+			else if ( ( settled < 0 ) && !motion.IsMoving() && ( now >= WARM_UP_SECONDS + pattern.Seconds ) )
+			{
+				settled = frames;
+			}
+		}
+
+		const PosterLoaderStats & stats = loader.GetStats();
+		LOG( "PosterLoaderSimulate: %s, first posters up after %.0f ms, %i of %i frames with a placeholder on screen, "
+				"%i posters at most, %i fetched, %i cancelled, %i uploaded, %i failed, %i released",
+				pattern.Name, firstShown * 1e3, placeholderFrames, frames, maxResident,
+				stats.Fetches, stats.Cancels, stats.Uploads, stats.Failures, stats.Releases );
+
+		assert( firstShown >= 0.0 && firstShown < 0.25 );
+		assert( maxResident <= MAX_RESIDENT );
+		assert( ( placeholderFrames == 0 ) || !pattern.Typical );
+		// once it stops, everything on screen is up
+		assert( settled >= 0 );
+	}
+
+	// jumping across the list cancels what was being read for where it was
+	SimulatedPosterBackend backend( ITEM_COUNT, MAX_RESIDENT );
+	PosterLoader loader( backend, MAX_RESIDENT );
+	loader.SetItems( ITEM_COUNT );
+	loader.Update( 0.0f, 0.0f, 0.0f, HALF_WIDTH );
+	assert( loader.GetStats().Fetches == PosterLoader::MAX_FETCHES );
+	loader.Update( 2500.0f, 0.0f, 2500.0f, HALF_WIDTH );
+	assert( loader.GetStats().Cancels == PosterLoader::MAX_FETCHES );
+	for ( double now = 0.0; now < 1.0; now += FRAME_SECONDS )
+	{
+		backend.Advance( now );
+		loader.Update( 2500.0f, 0.0f, 2500.0f, HALF_WIDTH );
+	}
+	for ( int item = 0; item < 2500 - MAX_RESIDENT; item++ )
+	{
+		assert( !backend.IsResident( item ) );
+	}
+	assert( loader.IsResident( 2500 ) );
+
+	// a poster that can't be decoded isn't counted as loaded or read again
+	SimulatedPosterBackend brokenBackend( ITEM_COUNT, MAX_RESIDENT );
+	PosterLoader brokenLoader( brokenBackend, MAX_RESIDENT );
+	brokenBackend.SetBroken( 100 );
+	brokenLoader.SetItems( ITEM_COUNT );
+	for ( double now = 0.0; now < 2.0; now += FRAME_SECONDS )
+	{
+		brokenBackend.Advance( now );
+		brokenLoader.Update( 100.0f, 0.0f, 100.0f, HALF_WIDTH );
+	}
+	assert( !brokenLoader.IsResident( 100 ) );
+	assert( brokenLoader.GetStats().Failures == 1 );
+	assert( brokenLoader.GetResidentCount() == brokenBackend.GetResidentCount() );
+	assert( brokenLoader.GetResidentCount() == MAX_RESIDENT - 1 );
+	LOG( "PosterLoaderSimulate passed" );
+}
+#endif
+
+} // namespace VRMatterStreamTheater
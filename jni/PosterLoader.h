@@ -0,0 +1,131 @@
+/************************************************************************************
+
+Filename    :   PosterLoader.h
+Content     :	Loads the posters of a carousel's items in the order they'll be seen.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#if !defined( PosterLoader_h )
+#define PosterLoader_h
+
+#include "Kernel/OVR_Array.h"
+
+using namespace OVR;
+
+namespace VRMatterStreamTheater {
+
+// What PosterLoader has done with items' posters. All but Fetch and
+// TakeFetched's reading happen on the render thread.
+class PosterLoaderBackend
+{
+public:
+	virtual				~PosterLoaderBackend() {}
+
+	// Starts reading item's poster, off the render thread
+	virtual void		Fetch( const int item ) = 0;
+	// An item whose poster has been read since the last call, -1 if there's none
+	virtual int			TakeFetched() = 0;
+	// Forgets a fetch, whether or not it has been read
+	virtual void		Cancel( const int item ) = 0;
+	// Decodes and uploads a poster that has been read, and gives it to the item.
+	// returns false if there was nothing to decode or it couldn't be uploaded,
+	// the item keeps the placeholder.
+	virtual bool		Upload( const int item ) = 0;
+	// Frees the item's poster, the item goes back to the placeholder
+	virtual void		Release( const int item ) = 0;
+	virtual bool		IsResident( const int item ) const = 0;
+};
+
+struct PosterLoaderStats
+{
+	int					Fetches;
+	int					Cancels;	// of fetches that stopped being wanted before they were uploaded
+	int					Uploads;
+	int					Failures;	// uploads that failed, not tried again until SetItems
+	int					Releases;
+};
+
+// Decides which of a carousel's items have their poster loaded, from where
+// the carousel is and where it will stop. Items on screen come first,
+// nearest the middle first, then the ones on screen where it stops, then
+// the ones it passes on the way there in the order it gets to them, then
+// the rest nearest first, ahead of where it's going first. The best
+// maxResident are wanted. Fetches of items no longer wanted are cancelled.
+// Read posters are uploaded a few a frame, best first, making room by
+// releasing the resident poster furthest down the order. Work a frame is
+// bounded by maxResident, not the number of items.
+class PosterLoader
+{
+public:
+	// Posters being read or waiting to be uploaded
+	static const int	MAX_FETCHES = 3;
+	static const int	UPLOADS_PER_FRAME = 2;
+
+						PosterLoader( PosterLoaderBackend & backend, const int maxResident );
+
+	// For a new list of items, some of which the backend may already have loaded
+	void				SetItems( const int count );
+	// Once a frame. halfWidth is how many items either side of position are on screen.
+	void				Update( const float position, const float velocity, const float stop, const int halfWidth );
+
+	bool				IsResident( const int item ) const { return States[ item ] == POSTER_RESIDENT; }
+	int					GetResidentCount() const { return Resident.GetSizeI(); }
+	int					GetMaxResident() const { return MaxResident; }
+	const PosterLoaderStats &	GetStats() const { return Stats; }
+
+private:
+	enum
+	{
+		POSTER_NONE,
+		POSTER_FETCHING,
+		POSTER_FETCHED,
+		POSTER_RESIDENT,
+		POSTER_FAILED
+	};
+
+	PosterLoaderBackend &	Backend;
+	int					MaxResident;
+	int					ItemCount;
+
+	Array<unsigned char>	States;			// by item
+	Array<unsigned>		WantedFrames;		// by item, the last frame it was wanted on
+	unsigned			FrameCount;
+
+	Array<int>			Wanted;				// this frame's, best first
+	Array<int>			Fetching;			// being read or waiting to be uploaded
+	Array<int>			Resident;
+	float				LastPosition;
+
+	PosterLoaderStats	Stats;
+
+private:
+	void				Want( const int item );
+	void				WantAround( const int center, const int first, const int last, const int dir );
+	void				Rank( const float position, const float velocity, const float stop, const int halfWidth );
+	// returns false if every resident poster is wanted
+	bool				Evict();
+
+private:
+	// not copyable
+						PosterLoader( const PosterLoader & );
+	PosterLoader &		operator=( const PosterLoader & );
+};
+
+#ifndef NDEBUG
+// Scrolls a carousel of 5,000 items through browsing, skimming and flicking
+// at 60 fps over a backend that takes a while to read each poster, and checks
+// no poster on screen is ever the placeholder while no more than the budget
+// are loaded. Then races through the list to log how it copes past that.
+void PosterLoaderSimulate();
+#endif
+
+} // namespace VRMatterStreamTheater
+
+#endif // PosterLoader_h
@@ -62,10 +62,16 @@ SceneManager::SceneManager( CinemaApp &cinema ) :
 	SceneScreenBounds(),
 	AllowMove( false ),
 	VoidedScene( false ),
-	osLollipop( false )
+	osLollipop( false ),
+	FirstFrameWaitStart( 0.0 ),
+	FirstFrameWaitReconfigured( false ),
+	FirstFrameWaitSized( false ),
+	FirstFrameSeconds( 0.0 )
 
 {
 	MipMappedMovieTextures[0] = MipMappedMovieTextures[1] = MipMappedMovieTextures[2] = 0;
+	MipMappedMovieWidths[0] = MipMappedMovieWidths[1] = MipMappedMovieWidths[2] = 0;
+	MipMappedMovieHeights[0] = MipMappedMovieHeights[1] = MipMappedMovieHeights[2] = 0;
 }
 
 void SceneManager::OneTimeInit( const char * launchIntent )
@@ -446,6 +452,13 @@ void SceneManager::ClearMovie()
 	MovieTexture = NULL;
 }
 
+void SceneManager::WaitForFirstFrame( const bool reconfigured )
+{
+	FirstFrameWaitStart = vrapi_GetTimeInSeconds();
+	FirstFrameWaitReconfigured = reconfigured;
+	FirstFrameWaitSized = false;
+}
+
 void SceneManager::SetFreeScreenPose( const Matrix4f & headPose )
 {
 	const float yaw = YawForMatrix( headPose );
@@ -735,35 +748,17 @@ bool SceneManager::Command( const char * msg )
 
 		//Cinema.MovieLoaded( CurrentMovieWidth, CurrentMovieHeight, MovieDuration );
 
-		// Create the texture that we will mip map from the external image
+		// Size the textures that we will mip map from the external image.
+		// The one on screen keeps the last frame until the ring comes back
+		// around to it with a new one, so a reconfigured stream doesn't blank.
 		for ( int i = 0 ; i < 3 ; i++ )
 		{
-			if ( MipMappedMovieFBOs[i] )
+			if ( i != CurrentMipMappedMovieTexture || MipMappedMovieTextures[i] == 0 )
 			{
-				glDeleteFramebuffers( 1, &MipMappedMovieFBOs[i] );
+				SizeMipMappedMovieTexture( i );
 			}
-			if ( MipMappedMovieTextures[i] )
-			{
-				glDeleteTextures( 1, &MipMappedMovieTextures[i] );
-			}
-			glGenTextures( 1, &MipMappedMovieTextures[i] );
-			glBindTexture( GL_TEXTURE_2D, MipMappedMovieTextures[i] );
-
-			glTexImage2D( GL_TEXTURE_2D, 0, Cinema.app->GetFramebufferIsSrgb() ? GL_SRGB8_ALPHA8 :GL_RGBA,
-					MovieTextureWidth, MovieTextureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
-
-			glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-			glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-			glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-			glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-
-			glGenFramebuffers( 1, &MipMappedMovieFBOs[i] );
-			glBindFramebuffer( GL_FRAMEBUFFER, MipMappedMovieFBOs[i] );
-			glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-					MipMappedMovieTextures[i], 0 );
-			glBindFramebuffer( GL_FRAMEBUFFER, 0 );
 		}
-		glBindTexture( GL_TEXTURE_2D, 0 );
+		FirstFrameWaitSized = true;
 
 		return true;
 	}
@@ -771,6 +766,49 @@ bool SceneManager::Command( const char * msg )
 	return false;
 }
 
+/*
+ * SizeMipMappedMovieTexture
+ *
+ * Creates the mip mapped texture and its FBO, or resizes it in place
+ * when the movie size changed since.
+ */
+void SceneManager::SizeMipMappedMovieTexture( const int index )
+{
+	if ( MipMappedMovieTextures[index] != 0 && MipMappedMovieWidths[index] == MovieTextureWidth &&
+			MipMappedMovieHeights[index] == MovieTextureHeight )
+	{
+		return;
+	}
+
+	const bool created = ( MipMappedMovieTextures[index] == 0 );
+	if ( created )
+	{
+		glGenTextures( 1, &MipMappedMovieTextures[index] );
+	}
+	glBindTexture( GL_TEXTURE_2D, MipMappedMovieTextures[index] );
+
+	glTexImage2D( GL_TEXTURE_2D, 0, Cinema.app->GetFramebufferIsSrgb() ? GL_SRGB8_ALPHA8 :GL_RGBA,
+			MovieTextureWidth, MovieTextureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+	MipMappedMovieWidths[index] = MovieTextureWidth;
+	MipMappedMovieHeights[index] = MovieTextureHeight;
+
+	if ( created )
+	{
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+
+		// the attachment follows the texture through later resizes
+		glGenFramebuffers( 1, &MipMappedMovieFBOs[index] );
+		glBindFramebuffer( GL_FRAMEBUFFER, MipMappedMovieFBOs[index] );
+		glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+				MipMappedMovieTextures[index], 0 );
+		glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+	}
+	glBindTexture( GL_TEXTURE_2D, 0 );
+}
+
 /*
  * DrawEyeView
  */
@@ -1032,6 +1070,15 @@ Matrix4f SceneManager::Frame( const VrFrame & vrFrame )
 		{
 			MovieTextureTimestamp = MovieTexture->nanoTimeStamp;
 			FrameUpdateNeeded = true;
+
+			// Not timed where the timestamp isn't set, see below
+			if ( FirstFrameWaitStart > 0.0 && FirstFrameWaitSized )
+			{
+				FirstFrameSeconds = vrapi_GetTimeInSeconds() - FirstFrameWaitStart;
+				FirstFrameWaitStart = 0.0;
+				LOG( "%s: first frame after %.0f ms", FirstFrameWaitReconfigured ? "Stream reconfigured" : "Stream started",
+						FirstFrameSeconds * 1000.0 );
+			}
 		}
 
 		// Currently on lollipop the surface texture isn't getting the timestamp set, so always update the image
@@ -1047,6 +1094,7 @@ Matrix4f SceneManager::Frame( const VrFrame & vrFrame )
 	{
 		FrameUpdateNeeded = false;
 		CurrentMipMappedMovieTexture = (CurrentMipMappedMovieTexture+1)%3;
+		SizeMipMappedMovieTexture( CurrentMipMappedMovieTexture );
 		glActiveTexture( GL_TEXTURE1 );
 		if ( CurrentMovieFormat == VT_LEFT_RIGHT_3D || CurrentMovieFormat == VT_LEFT_RIGHT_3D_CROP || CurrentMovieFormat == VT_LEFT_RIGHT_3D_FULL )
 		{
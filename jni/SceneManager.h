@@ -47,6 +47,9 @@ public:
 	void				NextSeat();
 
 	void 				ClearMovie();
+	// Times the first frame of a stream that was just started, or that
+	// reconnected with a new profile on the movie texture it already had
+	void				WaitForFirstFrame( const bool reconfigured );
 	void 				PutScreenInFront();
 
 	void				ClearGazeCursorGhosts();  	// clear gaze cursor to avoid seeing it lerp
@@ -115,6 +118,8 @@ public:
 	int					CurrentMipMappedMovieTexture;	// 0 - 2
 	GLuint				MipMappedMovieTextures[3];
 	GLuint				MipMappedMovieFBOs[3];
+	int					MipMappedMovieWidths[3];	// as allocated, they're resized in place
+	int					MipMappedMovieHeights[3];
 
 	GLuint				ScreenVignetteTexture;
 	GLuint				ScreenVignetteSbsTexture;	// for side by side 3D
@@ -140,7 +145,13 @@ public:
 
 	bool				osLollipop;
 
+	double				FirstFrameWaitStart;	// 0 when not waiting
+	bool				FirstFrameWaitReconfigured;
+	bool				FirstFrameWaitSized;	// frames before the new size may be the old stream's
+	double				FirstFrameSeconds;		// how long the last stream took to show a frame
+
 private:
+	void				SizeMipMappedMovieTexture( const int index );
 	GLuint 				BuildScreenVignetteTexture( const int horizontalTile ) const;
 	int 				BottomMipLevel( const int width, const int height ) const;
 };
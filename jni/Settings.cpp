@@ -21,6 +21,7 @@ LICENSE file in the StreamTheater/ directory.
 #include "Kernel/OVR_String.h"
 
 #include "Android/LogUtils.h"
+#include "SettingsWriter.h"
 
 namespace VRMatterStreamTheater {
 
@@ -45,174 +46,15 @@ void PrintJson(JSON* json)
     LOG("END------------------------");
 }
 
-/*
- * Variable holder
- */
-class Settings::IVariable {
-public:
-	virtual ~IVariable() { free(name); name = NULL; if(json) json->Release(); }
-	virtual IVariable* Clone() = 0;
-	// The three basic types of JSON values, since we don't know what type we're storing in this instance
-	// Could have template<typename T> Load(T), but this way we don't really have to save type info to json
-	virtual void LoadNumber(double num) = 0;
-	virtual void LoadCStr(const char* str) = 0;
-	virtual void LoadBool(bool b) = 0;
-	virtual JSON* Serialize() = 0;
-	virtual bool IsChanged() = 0;
-	virtual void SaveValue() = 0;
-public:
-	char* name;
-	JSON* json;
-};
-
-
-template<typename T>
-class Settings::Variable: public Settings::IVariable
-{
-public:
-	Variable(): initialValue(0) { name = NULL; json = NULL;}
-	Variable(const char* varName, T* ptr)
-	{
-		name = strdup(varName);
-		json = NULL;
-		varPtr = ptr;
-		initialValue = *ptr;
-	}
-	virtual ~Variable(){ free(name); name = NULL; if(json) json->Release(); }
-	virtual IVariable* Clone()
-	{
-		Variable<T>* newVar = new Variable<T>();
-		newVar->name = strdup(name);
-		newVar->varPtr = varPtr;
-		newVar->initialValue = initialValue;
-		return newVar;
-	}
-	virtual void LoadNumber(double num) { initialValue = (T)num; *varPtr = (T)num; }
-	virtual void LoadCStr(const char* str) { LOG("Loaded the wrong type! %s is not text.", name);}
-	virtual void LoadBool(bool b) { initialValue = (T)b; *varPtr = (T)b;}
-	virtual JSON* Serialize()
-	{
-		JSON* newJSON = JSON::CreateNumber((double)(*varPtr));
-		newJSON->Name = name;
-		json = NULL; // can't be sure we'll be pointing to the right thing soon
-		return newJSON;
-	}
-	virtual bool IsChanged() { return ( *varPtr != initialValue ); }
-	virtual void SaveValue() { initialValue = *varPtr; }
-public:
-	T* varPtr;
-	T initialValue;
-	typedef T type;
-};
-
-// Specialization for copying value of a c-string
-template<>
-class Settings::Variable<char*>: public Settings::IVariable
-{
-public:
-	Variable(): initialValue(NULL) { name = NULL; json = NULL;}
-	Variable(const char* varName, char** ptr)
-	{
-		name = strdup(varName);
-		json = NULL;
-		varPtr = ptr;
-		initialValue = strdup(*ptr);
-	}
-	virtual ~Variable() { free(name); name = NULL; free(initialValue); if(json) json->Release(); }
-	virtual IVariable* Clone()
-	{
-		Variable<char*>* newVar = new Variable<char*>();
-		newVar->name = strdup(name);
-		newVar->varPtr = varPtr;
-		newVar->initialValue = strdup(initialValue);
-		return newVar;
-	}
-	virtual void LoadNumber(double num) {LOG("Loaded the wrong type! %s is text.", name);}
-	virtual void LoadCStr(const char* str)
-	{
-		if(initialValue)
-		{
-			free(initialValue);
-		}
-		initialValue = strdup(str);
-		if(*varPtr)
-		{
-			free(*varPtr);
-		}
-		*varPtr = strdup(str);
-	}
-	virtual void LoadBool(bool b) { LOG("Loaded the wrong type! %s is text.", name);}
-	virtual JSON* Serialize()
-	{
-		JSON* newJSON = JSON::CreateString(*varPtr);
-		newJSON->Name = name;
-		json = NULL; // can't be sure we'll be pointing to the right thing soon
-		return newJSON;
-	}
-	virtual bool IsChanged() { return 0 != strcmp(*varPtr, initialValue); }
-	virtual void SaveValue() {
-		if(initialValue)
-		{
-			free(initialValue);
-		}
-		initialValue = strdup(*varPtr);
-	}
-public:
-	char** varPtr;
-	char* initialValue;
-	typedef char* type;
-};
-
-// Specialization for OVR_Strings
-template<>
-class Settings::Variable<String>: public Settings::IVariable
-{
-public:
-	Variable(): initialValue("") { name = NULL; json = NULL;}
-	Variable(const char* varName, String* ptr)
-	{
-		name = strdup(varName);
-		json = NULL;
-		varPtr = ptr;
-		initialValue = *ptr;
-	}
-	virtual ~Variable(){ free(name); name = NULL; if(json) json->Release(); }
-	virtual IVariable* Clone()
-	{
-		Variable<String>* newVar = new Variable<String>();
-		newVar->name = strdup(name);
-		newVar->varPtr = varPtr;
-		newVar->initialValue = initialValue;
-		return newVar;
-	}
-	virtual void LoadNumber(double num) { LOG("Loaded the wrong type! %s is text.", name); }
-	virtual void LoadCStr(const char* str) {
-		initialValue.AssignString(str,strlen(str));
-		varPtr->AssignString(str,strlen(str));
-	}
-	virtual void LoadBool(bool b) { LOG("Loaded the wrong type! %s is text.", name); }
-	virtual JSON* Serialize()
-	{
-		JSON* newJSON = JSON::CreateString(varPtr->ToCStr());
-		newJSON->Name = name;
-		json = NULL; // can't be sure we'll be pointing to the right thing soon
-		return newJSON;
-	}
-	virtual bool IsChanged() { return ( *varPtr != initialValue ); }
-	virtual void SaveValue() { initialValue = *varPtr; }
-public:
-	String* varPtr;
-	String initialValue;
-	typedef String type;
-};
-
 /*
  * Template type helpers for GetVal
  * (Specializations for new types shouldn't have to go past this section)
  * ((unless you're adding arrays or objects))
  */
-template<typename T> void SetHelper(T* source, T* toSet) { *toSet = *source; }
-template<> 			 void SetHelper(char** source, char** toSet) { *toSet = strdup(*source); }
+template<typename T> bool NumberToTypeHelper(double value, T* toSet) { *toSet = (T) value; return true; }
+template<> 			 bool NumberToTypeHelper(double value, bool* toSet) { *toSet = ( value != 0.0 ); return true; }
+template<> 			 bool NumberToTypeHelper(double value, char** toSet) { return false; }
+template<> 			 bool NumberToTypeHelper(double value, String* toSet) { return false; }
 template<typename T> void JSONToTypeHelper(JSON* json, T* toSet)
 {
 	*toSet = (T) json->GetDoubleValue();
@@ -234,31 +76,35 @@ template<> void JSONToTypeHelper(JSON* json, String* toSet)
 /***************************
  * Settings                *
  ***************************/
-Settings::Settings() :
+Settings::Settings(const SettingsSchema& schema_) :
+		schema(schema_),
 		settingsFileName(NULL),
 		rootSettingsJSON(NULL),
 		settingsJSON(NULL),
-		variables()
+		snapshot(schema_),
+		baseline(new char[schema_.GetValuesSize()])
 {
-	;
+	pthread_mutex_init(&jsonLock, NULL);
+	schema.SetDefaults(baseline);
 }
 
-Settings::Settings(const char* filename) :
+Settings::Settings(const char* filename, const SettingsSchema& schema_) :
+		schema(schema_),
 		settingsFileName(NULL),
 		rootSettingsJSON(NULL),
 		settingsJSON(NULL),
-		variables()
+		snapshot(schema_),
+		baseline(new char[schema_.GetValuesSize()])
 {
+	pthread_mutex_init(&jsonLock, NULL);
+	schema.SetDefaults(baseline);
 	OpenOrCreate(filename);
 }
 
 Settings::~Settings()
 {
-	while(variables.GetSize() > 0)
-	{
-		IVariable* var = variables.Pop();
-		delete(var);
-	}
+	// A save that hasn't been written yet still will be
+	SettingsWriter::Get().Detach(this);
 
 	if(rootSettingsJSON)
 	{
@@ -267,10 +113,22 @@ Settings::~Settings()
 		rootSettingsJSON = NULL;
 		LOG("Done releasing!");
 	}
+	free(settingsFileName);
+	delete[] baseline;
+	pthread_mutex_destroy(&jsonLock);
 }
 
 void Settings::OpenOrCreate(const char* filename)
 {
+	// Anything not written yet goes to the old file
+	SettingsWriter::Get().Detach(this);
+
+	// The file on disk may be behind saves that are still to be written
+	// (not under jsonLock, the writer takes it while holding its own lock)
+	char* pendingText = NULL;
+	const bool pending = SettingsWriter::Get().GetPendingContents(filename, &pendingText);
+
+	pthread_mutex_lock(&jsonLock);
 	if(settingsFileName)
 	{
 		free(settingsFileName);
@@ -283,17 +141,27 @@ void Settings::OpenOrCreate(const char* filename)
 		rootSettingsJSON = NULL;
 		settingsJSON = NULL;
 	}
-	if(!(rootSettingsJSON = JSON::Load(filename)))
+	schema.SetDefaults(snapshot.Values);
+	snapshot.Present.ResetAll();
+
+	if(pending)
+	{
+		rootSettingsJSON = pendingText ? JSON::Parse(pendingText) : NULL;
+		free(pendingText);
+	}
+	else
+	{
+		rootSettingsJSON = JSON::Load(filename);
+	}
+
+	bool created = false;
+	if(!rootSettingsJSON)
 	{
 		LOG("Creating new settings file: %s", filename);
 		rootSettingsJSON = JSON::CreateObject();
 		rootSettingsJSON->AddNumberItem("SettingsVersion",SETTINGS_VERSION);
 		rootSettingsJSON->AddItem("Settings",JSON::CreateObject());
-		if(!rootSettingsJSON->Save(filename))
-		{
-			LOG("Error creating settings file: %s", filename);
-			return;
-		}
+		created = true;
 	}
 	else
 	{
@@ -308,391 +176,653 @@ void Settings::OpenOrCreate(const char* filename)
 	{
 		LOG("Error! Invalid settings file!");
 	}
-}
-
-void Settings::CopyDefines(const Settings& source)
-{
-	for(int i=0;i<source.variables.GetSizeI();i++)
+	else
 	{
-		variables.PushBack(source.variables[i]->Clone());
+		ReadSchemaValues();
 	}
-}
+	pthread_mutex_unlock(&jsonLock);
 
-template<typename T> void Settings::Define(const char* varName, T* ptr)
-{
-	Variable<T>* newVar = new Variable<T>(varName, ptr);
-	variables.PushBack(newVar);
+	if(created)
+	{
+		ScheduleSave();
+	}
 }
 
-template<typename T> bool Settings::GetVal(const char* varName, T* toSet)
+// jsonLock must be held
+void Settings::ReadSchemaValues()
 {
-	if(settingsJSON == NULL) return false;
-
-	// Check all the variables first
-	for(int i = 0; i < variables.GetSizeI(); i++)
+	JSON* next = NULL;
+	for(JSON* item = settingsJSON->GetFirstItem(); item != NULL; item = next)
 	{
-		if(strcmp(variables[i]->name, varName) == 0)
+		next = settingsJSON->GetNextItem(item);
+
+		const int index = schema.Find(item->Name.ToCStr());
+		if(index < 0)
 		{
-			Variable<T>* var = (Variable<T>*)(variables[i]);
-			if(var == NULL)
-			{
-				return false;
-			}
-			SetHelper(var->varPtr, toSet);
-			return true;
+			continue;
 		}
-	}
 
-	// Still here?  It wasn't in the defined objects.
-	JSON* valJSON = settingsJSON->GetItemByName(varName);
-	if(valJSON)
-	{
-		JSONToTypeHelper<T>(valJSON, toSet);
-		return true;
+		switch(item->Type)
+		{
+		case JSON_Bool:
+			schema.SetValue(snapshot.Values, index, item->GetBoolValue() ? 1.0 : 0.0);
+			snapshot.Present.Set(index);
+			break;
+		case JSON_Number:
+			schema.SetValue(snapshot.Values, index, item->GetDoubleValue());
+			snapshot.Present.Set(index);
+			break;
+		default:
+			// null is a setting named in the file without a value
+			LOG("Ignoring %s, it isn't a number", item->Name.ToCStr());
+			break;
+		}
+		item->RemoveNode();
+		item->Release();
 	}
-	return false;
 }
 
-template<typename T> void Settings::SetVal(const char* varName, T value)
+void Settings::ScheduleSave()
 {
-	if(settingsJSON == NULL) return;
-	JSON* newJSON = JSON::CreateNumber(value);
-	newJSON->Name = strdup(varName);
-	settingsJSON->AddItem(varName,newJSON);
-	PrintJson(settingsJSON);
+	SettingsWriter::Get().Schedule(this);
 }
 
-template<> void Settings::SetVal(const char* varName, char* value)
+/*
+ * Text output for SerializeText, since the schema's settings aren't kept as JSON
+ */
+struct SettingsText
 {
-	if(settingsJSON == NULL) return;
-	JSON* newJSON = JSON::CreateString(strdup(value));
-	newJSON->Name = strdup(varName);
-	settingsJSON->AddItem(varName,newJSON);
-}
+	char* text;
+	int length;
+	int capacity;
+};
 
-template<> void Settings::SetVal(const char* varName, String value)
+static void Append(SettingsText& out, const char* str, int length)
 {
-	if(settingsJSON == NULL) return;
-	JSON* newJSON = JSON::CreateString(strdup(value.ToCStr()));
-	newJSON->Name = strdup(varName);
-	settingsJSON->AddItem(varName,newJSON);
+	if(out.length + length + 1 > out.capacity)
+	{
+		while(out.length + length + 1 > out.capacity)
+		{
+			out.capacity *= 2;
+		}
+		out.text = (char*)realloc(out.text, out.capacity);
+	}
+	memcpy(out.text + out.length, str, length);
+	out.length += length;
+	out.text[out.length] = 0;
 }
 
+static void Append(SettingsText& out, const char* str)
+{
+	Append(out, str, strlen(str));
+}
 
-bool Settings::IsChanged()
+static void AppendQuoted(SettingsText& out, const char* str)
 {
-	if(settingsJSON == NULL) return false;
-	for(int i = 0; i < variables.GetSizeI(); i++)
+	Append(out, "\"", 1);
+	const char* run = str;
+	for(const char* c = str; *c != 0; c++)
 	{
-		IVariable* var = variables[i];
-		if(var->IsChanged())
+		if(*c != '"' && *c != '\\' && (unsigned char)*c >= 0x20)
 		{
-			return true;
+			continue;
+		}
+		Append(out, run, c - run);
+		run = c + 1;
+		if(*c == '"' || *c == '\\')
+		{
+			Append(out, "\\", 1);
+			Append(out, c, 1);
+		}
+		else
+		{
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+			Append(out, escaped);
 		}
 	}
-	return false;
+	Append(out, run, strlen(run));
+	Append(out, "\"", 1);
 }
 
-void Settings::DeleteVar(const char* varName)
+// The fewest digits that read back as the same float, so files stay easy to edit
+static void AppendFloat(SettingsText& out, float value)
 {
-	if(settingsJSON == NULL) return;
-
-	// Undefine the variable
-	for(int i = 0; i < variables.GetSizeI(); i++)
+	char number[32];
+	for(int precision = 6; precision <= 9; precision++)
 	{
-		if(strcmp(variables[i]->name, varName) == 0)
+		snprintf(number, sizeof(number), "%.*g", precision, value);
+		if(strtof(number, NULL) == value)
 		{
-			IVariable* toDel = variables[i];
-			variables.RemoveAtUnordered(i);
-			delete(toDel);
 			break;
 		}
 	}
+	Append(out, number);
+}
 
-	JSON* valJSON = settingsJSON->GetItemByName(varName);
-	if(valJSON)
-	{
-		valJSON->RemoveNode();
-		valJSON->Release();
-		rootSettingsJSON->Save(settingsFileName);
-	}
+static void AppendItem(SettingsText& out, JSON* item, const char* indent)
+{
+	Append(out, indent);
+	AppendQuoted(out, item->Name.ToCStr());
+	Append(out, ": ");
+	char* value = item->PrintValue(0, false);
+	Append(out, value ? value : "null");
+	free(value);
 }
 
-void Settings::Load()
+// Reads the schema's settings and the JSON, so the caller can't hold jsonLock
+char* Settings::SerializeText()
 {
-	if(settingsJSON == NULL) return;
+	pthread_mutex_lock(&jsonLock);
+	if(rootSettingsJSON == NULL)
+	{
+		pthread_mutex_unlock(&jsonLock);
+		return NULL;
+	}
 
-	for(int i = 0; i < variables.GetSizeI(); i++)
+	SettingsText out;
+	out.capacity = 4096;
+	out.length = 0;
+	out.text = (char*)malloc(out.capacity);
+	out.text[0] = 0;
+
+	Append(out, "{\n");
+	bool first = true;
+	for(JSON* rootItem = rootSettingsJSON->GetFirstItem(); rootItem != NULL; rootItem = rootSettingsJSON->GetNextItem(rootItem))
 	{
-		IVariable* var = variables[i];
-		JSON* varJSON = var->json;
-		if(varJSON == NULL)
+		if(!first)
+		{
+			Append(out, ",\n");
+		}
+		first = false;
+
+		if(rootItem != settingsJSON)
 		{
-			varJSON = settingsJSON->GetItemByName(var->name);
+			AppendItem(out, rootItem, "\t");
+			continue;
 		}
-		if(varJSON)
+
+		Append(out, "\t\"Settings\": {");
+		bool firstSetting = true;
+		for(int i = 0; i < schema.GetCount(); i++)
 		{
-			var->json = varJSON;
-			switch(varJSON->Type)
+			if(!snapshot.Present.Test(i))
 			{
-			case JSON_Bool:
-				var->LoadBool(varJSON->GetBoolValue());
-				break;
-			case JSON_Number:
-				var->LoadNumber(varJSON->GetDoubleValue());
+				continue;
+			}
+			Append(out, firstSetting ? "\n\t\t" : ",\n\t\t");
+			firstSetting = false;
+
+			const SettingDef& def = schema.GetDef(i);
+			AppendQuoted(out, def.Name);
+			Append(out, ": ");
+			const char* value = snapshot.Values + def.Offset;
+			switch(def.Type)
+			{
+			case SETTING_BOOL:
+				Append(out, *(const bool*)value ? "true" : "false");
 				break;
-			case JSON_String:
-				var->LoadCStr(varJSON->GetStringValue().ToCStr());
+			case SETTING_INT:
+			{
+				char number[16];
+				snprintf(number, sizeof(number), "%i", *(const int*)value);
+				Append(out, number);
 				break;
-			default:
+			}
+			case SETTING_FLOAT:
+				AppendFloat(out, *(const float*)value);
 				break;
 			}
 		}
+		for(JSON* item = settingsJSON->GetFirstItem(); item != NULL; item = settingsJSON->GetNextItem(item))
+		{
+			Append(out, firstSetting ? "\n" : ",\n");
+			firstSetting = false;
+			AppendItem(out, item, "\t\t");
+		}
+		Append(out, firstSetting ? "}" : "\n\t}");
 	}
+	Append(out, "\n}\n");
+	pthread_mutex_unlock(&jsonLock);
+	return out.text;
 }
 
-void Settings::SaveAll()
+void Settings::RemoveFile(const char* filename)
 {
-	if(settingsJSON == NULL) return;
+	SettingsWriter::Get().Remove(filename);
+}
+
+void Settings::FlushWrites()
+{
+	SettingsWriter::Get().Flush();
+}
+
+void Settings::Load(const SettingsBinding& binding)
+{
+	SettingsMask changed(schema.GetCount());
+	pthread_mutex_lock(&jsonLock);
+	snapshot.Apply(binding, changed);
+	pthread_mutex_unlock(&jsonLock);
+	binding.Store(baseline);
+}
+
+void Settings::GetSnapshot(SettingsSnapshot& out)
+{
+	pthread_mutex_lock(&jsonLock);
+	out = snapshot;
+	pthread_mutex_unlock(&jsonLock);
+}
+
+void Settings::SetSnapshot(const SettingsSnapshot& in)
+{
+	if(settingsJSON == NULL || &in.GetSchema() != &schema) return;
+
+	pthread_mutex_lock(&jsonLock);
+	snapshot = in;
+	pthread_mutex_unlock(&jsonLock);
+	ScheduleSave();
+}
+
+// Whether a bound variable differs from its value in a block of values
+static bool VariableChanged(const SettingsSchema& schema, const SettingsBinding& binding, const char* values, int index)
+{
+	const SettingDef& def = schema.GetDef(index);
+	return memcmp(binding.GetVariable(index), values + def.Offset, SettingsSchema::TypeSize(def.Type)) != 0;
+}
+
+bool Settings::IsChanged(const SettingsBinding& binding) const
+{
+	if(settingsJSON == NULL) return false;
 
-	for(int i = 0; i < variables.GetSizeI(); i++)
+	for(int i = 0; i < schema.GetCount(); i++)
 	{
-		IVariable* var = variables[i];
-		var->SaveValue();
-		JSON* varJSON = var->json;
-		if(varJSON == NULL)
+		if(binding.GetVariable(i) != NULL && VariableChanged(schema, binding, baseline, i))
 		{
-			varJSON = settingsJSON->GetItemByName(var->name);
-			var->json = varJSON;
-		}
-		if(varJSON == NULL)
-		{
-			settingsJSON->AddItem(var->name,var->Serialize());
-		}
-		else
-		{
-			varJSON->ReplaceNodeWith(var->Serialize());
+			return true;
 		}
 	}
-	rootSettingsJSON->Save(settingsFileName);
+	return false;
 }
 
-void Settings::SaveChanged()
+void Settings::StoreBound(const SettingsBinding& binding, bool onlyChanged)
 {
-	if(settingsJSON == NULL) return;
-
-	for(int i = 0; i < variables.GetSizeI(); i++)
+	pthread_mutex_lock(&jsonLock);
+	for(int i = 0; i < schema.GetCount(); i++)
 	{
-		IVariable* var = variables[i];
-		if(!var->IsChanged())
+		if(binding.GetVariable(i) == NULL || (onlyChanged && !VariableChanged(schema, binding, baseline, i)))
 		{
 			continue;
 		}
-		var->SaveValue();
-
-		JSON* varJSON = var->json;
-		if(varJSON == NULL)
-		{
-			varJSON = settingsJSON->GetItemByName(var->name);
-			var->json = varJSON;
-		}
-		if(varJSON == NULL)
-		{
-			settingsJSON->AddItem(var->name,var->Serialize());
-		}
-		else
-		{
-			varJSON->ReplaceNodeWith(var->Serialize());
-		}
+		// Through SetValue, so the file never gets a value it couldn't load
+		const SettingDef& def = schema.GetDef(i);
+		memcpy(snapshot.Values + def.Offset, binding.GetVariable(i), SettingsSchema::TypeSize(def.Type));
+		schema.SetValue(snapshot.Values, i, schema.GetValue(snapshot.Values, i));
+		snapshot.Present.Set(i);
 	}
-	rootSettingsJSON->Save(settingsFileName);
-	PrintFileToLog(settingsFileName);
+	pthread_mutex_unlock(&jsonLock);
+
+	binding.Store(baseline);
+}
+
+void Settings::SaveAll(const SettingsBinding& binding)
+{
+	if(settingsJSON == NULL) return;
+
+	StoreBound(binding, false);
+	ScheduleSave();
+}
+
+void Settings::SaveChanged(const SettingsBinding& binding)
+{
+	if(settingsJSON == NULL) return;
+
+	StoreBound(binding, true);
+	ScheduleSave();
 }
 
-void Settings::SaveOnly(const Array<const char*> &varNames)
+void Settings::Save()
 {
 	if(settingsJSON == NULL) return;
 
-	for(int i = 0; i < variables.GetSizeI(); i++)
+	ScheduleSave();
+}
+
+bool Settings::IsSet(int index) const
+{
+	return snapshot.Present.Test(index);
+}
+
+template<typename T> bool Settings::GetVal(const char* varName, T* toSet)
+{
+	if(settingsJSON == NULL) return false;
+
+	// Check the schema first
+	const int index = schema.Find(varName);
+	if(index >= 0)
 	{
-		IVariable* var = variables[i];
-		bool found = false;
-		for(int namesIndex = 0; namesIndex < varNames.GetSizeI(); namesIndex++)
-		{
-			if(strcmp(var->name, varNames[namesIndex]) == 0)
-			{
-				found = true;
-				break;
-			}
-		}
-		if(!found)
-		{
-			continue;
-		}
-		var->SaveValue();
+		return snapshot.Present.Test(index) && NumberToTypeHelper(schema.GetValue(snapshot.Values, index), toSet);
+	}
 
-		JSON* varJSON = var->json;
-		if(varJSON == NULL)
-		{
-			varJSON = settingsJSON->GetItemByName(var->name);
-			var->json = varJSON;
-		}
-		if(varJSON == NULL)
-		{
-			settingsJSON->AddItem(var->name,var->Serialize());
-		}
-		else
-		{
-			varJSON->ReplaceNodeWith(var->Serialize());
-		}
+	JSON* valJSON = settingsJSON->GetItemByName(varName);
+	if(valJSON)
+	{
+		JSONToTypeHelper<T>(valJSON, toSet);
+		return true;
 	}
-	rootSettingsJSON->Save(settingsFileName);
+	return false;
 }
 
-void	Settings::SaveVarNames()
+// Replaces the JSON of a variable outside the schema, jsonLock must be held
+static void SetJSONItem(JSON* settingsJSON, const char* varName, JSON* newJSON)
+{
+	JSON* oldJSON = settingsJSON->GetItemByName(varName);
+	if(oldJSON)
+	{
+		newJSON->Name = varName;
+		oldJSON->ReplaceNodeWith(newJSON);
+	}
+	else
+	{
+		settingsJSON->AddItem(varName,newJSON);
+	}
+}
+
+template<typename T> void Settings::SetVal(const char* varName, T value)
 {
 	if(settingsJSON == NULL) return;
+	pthread_mutex_lock(&jsonLock);
+	const int index = schema.Find(varName);
+	if(index >= 0)
+	{
+		schema.SetValue(snapshot.Values, index, (double)value);
+		snapshot.Present.Set(index);
+	}
+	else
+	{
+		SetJSONItem(settingsJSON, varName, JSON::CreateNumber(value));
+	}
+	pthread_mutex_unlock(&jsonLock);
+}
 
-	for(int i = 0; i < variables.GetSizeI(); i++)
+template<> void Settings::SetVal(const char* varName, char* value)
+{
+	if(settingsJSON == NULL || schema.Find(varName) >= 0) return;
+	pthread_mutex_lock(&jsonLock);
+	SetJSONItem(settingsJSON, varName, JSON::CreateString(value));
+	pthread_mutex_unlock(&jsonLock);
+}
+
+template<> void Settings::SetVal(const char* varName, String value)
+{
+	if(settingsJSON == NULL || schema.Find(varName) >= 0) return;
+	pthread_mutex_lock(&jsonLock);
+	SetJSONItem(settingsJSON, varName, JSON::CreateString(value.ToCStr()));
+	pthread_mutex_unlock(&jsonLock);
+}
+
+// Defined here, so these are all the types there are
+template bool Settings::GetVal(const char* varName, bool* toSet);
+template bool Settings::GetVal(const char* varName, int* toSet);
+template bool Settings::GetVal(const char* varName, float* toSet);
+template bool Settings::GetVal(const char* varName, double* toSet);
+template bool Settings::GetVal(const char* varName, char** toSet);
+template bool Settings::GetVal(const char* varName, String* toSet);
+template void Settings::SetVal(const char* varName, bool value);
+template void Settings::SetVal(const char* varName, int value);
+template void Settings::SetVal(const char* varName, float value);
+template void Settings::SetVal(const char* varName, double value);
+
+void Settings::DeleteVar(const char* varName)
+{
+	if(settingsJSON == NULL) return;
+
+	const int index = schema.Find(varName);
+	if(index >= 0)
 	{
-		IVariable* var = variables[i];
-		JSON* varJSON = var->json;
-		if(varJSON == NULL)
+		pthread_mutex_lock(&jsonLock);
+		const bool wasSet = snapshot.Present.Test(index);
+		snapshot.Present.Reset(index);
+		schema.SetValue(snapshot.Values, index, schema.GetDef(index).Default);
+		pthread_mutex_unlock(&jsonLock);
+		if(wasSet)
 		{
-			varJSON = settingsJSON->GetItemByName(var->name);
-			var->json = varJSON;
-		}
-		if(varJSON == NULL)
-		{
-			settingsJSON->AddItem(var->name,JSON::CreateNull());
+			ScheduleSave();
 		}
+		return;
+	}
+
+	JSON* valJSON = settingsJSON->GetItemByName(varName);
+	if(valJSON)
+	{
+		pthread_mutex_lock(&jsonLock);
+		valJSON->RemoveNode();
+		pthread_mutex_unlock(&jsonLock);
+		valJSON->Release();
+		ScheduleSave();
 	}
-	rootSettingsJSON->Save(settingsFileName);
 }
 
+#ifndef NDEBUG
 #include <assert.h>
+#include <limits.h>
+#include <time.h>
+
 void SettingsTest(String packageName)
 {
-	bool b = false;
-	int i = 1;
-	float f = 2.0f;
-	double d = 3.0;
-	char* cstr = strdup("cstring");
-	String str("string");
-
 	String appFileStoragePath = "/data/data/";
 	appFileStoragePath += packageName;
 	appFileStoragePath += "/files/";
 
-	String FilePath = appFileStoragePath + "settingstest.json";
-
-	LOG("Opening file");
-	Settings* s = new Settings(FilePath);
-
-	LOG("Deleting variables");
-	s->DeleteVar("testbool");
-	s->DeleteVar("testint");
-	s->DeleteVar("testfloat");
-	s->DeleteVar("testdouble");
-	s->DeleteVar("testcstr");
-	s->DeleteVar("teststr");
-
-	LOG("Defining variables");
-	s->Define("testbool",&b);
-	s->Define("testint",&i);
-	s->Define("testfloat",&f);
-	s->Define("testdouble",&d);
-	s->Define("testcstr",&cstr);
-	s->Define("teststr",&str);
-
-	LOG("Changing values");
-	b = true;
-	i = 5;
-	cstr = strdup("changed cstr");
-
-	LOG("Saving changes");
-	s->SaveChanged();
-
-	LOG("resetting values");
-	b = false;
-	i = 4;
-	f = 6.0f;
-	str.AssignString("changed String",strlen("changed String"));
-
-	Array<const char*> onlysave;
-	onlysave.PushBack("teststr");
-	LOG("Saving only string value");
-	s->SaveOnly(onlysave);
-
-	LOG("Changing string value");
-	cstr = strdup("changed cstr 2");
-	str.AssignString("changed String 2",strlen("changed String 2"));
-
-	LOG("Closing settings");
-	delete(s);
-
-	LOG("Opening file again");
-	s = new Settings(FilePath);
-
-	LOG("Defining stuff");
-	s->Define("testint",&i);
-	s->Define("testfloat",&f);
-	s->Define("testdouble",&d);
-	s->Define("testcstr",&cstr);
-	s->Define("teststr",&str);
-
-	LOG("Loading variables");
-	s->Load();
-
-	LOG("Checking values");
-
-	assert( b == false ); // didn't define it
-	assert( i == 5 ); // should revert
-	assert( f == 6.0f ); // shouldn't have been saved
-	assert( d == 3.0 ); // should stay same
-	assert( strcmp(cstr,"changed cstr") == 0 ); // C-Strings revert ok?
-	assert( str == "changed String" ); // Saved on its own?
-
-
-	LOG("Setting values, not variabls");
-	s->SetVal<bool>("testbool2", true);
-	s->SetVal<int>("testint2", 9);
-	s->SetVal<float>("testfloat2", 10.1);
-	s->SetVal<double>("testdouble2", 12.2);
-	char* tempChar = strdup("NotAVariable!");
-	s->SetVal<char*>("testcstr2", tempChar);
+	String defaultPath = appFileStoragePath + "settingstest.json";
+	String hostPath = appFileStoragePath + "settingstest.host.json";
+	String appPath = appFileStoragePath + "settingstest.app.json";
+	Settings::RemoveFile(defaultPath);
+	Settings::RemoveFile(hostPath);
+	Settings::RemoveFile(appPath);
+
+	float gazeScale = 0.0f;
+	int width = 0;
+	int fps = 0;
+	bool hostAudio = false;
+	SettingsBinding binding(GetStreamTheaterSchema());
+	binding.Bind<StreamSetting::GazeScale>(&gazeScale);
+	binding.Bind<StreamSetting::StreamWidth>(&width);
+	binding.Bind<StreamSetting::StreamFPS>(&fps);
+	binding.Bind<StreamSetting::EnableHostAudio>(&hostAudio);
+
+	LOG("Checking defaults");
+	binding.ApplyDefaults();
+	assert( gazeScale == 1.05f );
+	assert( width == 1280 );
+	assert( fps == 60 );
+	assert( hostAudio == true );
+
+	LOG("Saving a layer of each kind");
+	Settings* defaults = new Settings(defaultPath);
+	Settings* host = new Settings(hostPath);
+	Settings* app = new Settings(appPath);
+	defaults->Load(binding);
+	assert( !defaults->IsChanged(binding) );
+	width = 1920;
+	assert( defaults->IsChanged(binding) );
+	defaults->SaveAll(binding);
+	assert( !defaults->IsChanged(binding) );
+
+	host->SetVal("StreamFPS", 1000); // clamped
+	host->Save();
+
+	app->Load(binding);
+	hostAudio = false;
+	app->SaveChanged(binding);
+	assert( !app->IsSet(STREAM_SETTING_StreamWidth) );
+	assert( app->IsSet(STREAM_SETTING_EnableHostAudio) );
+
+	LOG("Setting values outside the schema");
+	app->SetVal<int>("testint", 9);
+	app->SetVal<float>("testfloat", 10.5f);
+	char* tempChar = strdup("Not \"in\" the schema!");
+	app->SetVal<char*>("testcstr", tempChar);
 	free(tempChar);
-	s->SetVal<String>("teststr2", "Nope!");
-
-	s->SaveAll();
-
-	LOG("Closing settings");
-	delete(s);
-
-	LOG("Opening file again");
-	s = new Settings(FilePath);
-
-	bool b2 = false;
-	int i2 = 0;
-	float f2 = 0.0f;
-	double d2 = 0.0;
-	char* cstr2 = strdup("null");
-	String str2("empty");
-
-	LOG("Getting values");
-	s->GetVal<bool>("testbool", &b2);
-	s->GetVal<int>("testint",&i2);
-	s->GetVal<float>("testfloat",&f2);
-	s->GetVal<double>("testdouble",&d2);
-	s->GetVal<char*>("testcstr",&cstr2);
-	s->GetVal<String>("teststr",&str2);
-
-	assert( b == true ); // good?
-	assert( i == 9 ); // should revert
-	assert( f == 10.1f ); // shouldn't have been saved
-	assert( d == 12.2 ); // should stay same
-	assert( strcmp(cstr,"NotAVariable!") == 0 ); // C-Strings revert ok?
-	assert( str == "Nope!" ); // Saved on its own?
+	app->SetVal<String>("DisplayName", "Nope!");
+	app->SetVal<String>("DisplayName", "Yep!");
+	app->Save();
+
+	LOG("Reopening before the writes are done");
+	delete(defaults);
+	delete(host);
+	delete(app);
+	defaults = new Settings(defaultPath);
+	host = new Settings(hostPath);
+	app = new Settings(appPath);
+
+	binding.ApplyDefaults();
+	defaults->Load(binding);
+	host->Load(binding);
+	app->Load(binding);
+	assert( gazeScale == 1.05f );
+	assert( width == 1920 ); // from defaults
+	assert( fps == 120 ); // from the host, clamped
+	assert( hostAudio == false ); // from the app
+	assert( !app->IsSet(STREAM_SETTING_StreamFPS) );
+
+	int i = 0;
+	float f = 0.0f;
+	char* cstr = NULL;
+	String str;
+	assert( app->GetVal("testint", &i) && i == 9 );
+	assert( app->GetVal("testfloat", &f) && f == 10.5f );
+	assert( app->GetVal("testcstr", &cstr) && strcmp(cstr, "Not \"in\" the schema!") == 0 );
+	free(cstr);
+	assert( app->GetVal("DisplayName", &str) && str == "Yep!" );
+	assert( app->GetVal("EnableHostAudio", &i) && i == 0 ); // schema values by name too
+	assert( !app->GetVal("StreamWidth", &i) ); // not in this layer
+
+	LOG("Deleting values");
+	app->DeleteVar("testint");
+	app->DeleteVar("EnableHostAudio");
+	assert( !app->GetVal("testint", &i) );
+	assert( !app->IsSet(STREAM_SETTING_EnableHostAudio) );
+
+	LOG("Resetting a layer to the defaults");
+	host->SetVal<int>("testhand", 7);
+	host->SetSnapshot(SettingsSnapshot(GetStreamTheaterSchema()));
+	assert( !host->IsSet(STREAM_SETTING_StreamFPS) );
+
+	LOG("Reopening from disk");
+	delete(defaults);
+	delete(host);
+	delete(app);
+	Settings::FlushWrites();
+	host = new Settings(hostPath);
+	assert( !host->IsSet(STREAM_SETTING_StreamFPS) );
+	assert( host->GetVal("testhand", &i) && i == 7 );
+	delete(host);
+	app = new Settings(appPath);
+	assert( !app->IsSet(STREAM_SETTING_EnableHostAudio) );
+	assert( !app->GetVal("testint", &i) );
+	assert( app->GetVal("testfloat", &f) && f == 10.5f );
+	assert( app->GetVal("DisplayName", &str) && str == "Yep!" );
+	delete(app);
+
+	Settings::RemoveFile(defaultPath);
+	Settings::RemoveFile(hostPath);
+	Settings::RemoveFile(appPath);
+	Settings::FlushWrites();
+	LOG("SettingsTest passed");
+}
+
+static double NowSeconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void SettingsSchemaBenchmark(const char* directory)
+{
+	static const int RUNS = 200;
+	const SettingsSchema& testSchema = GetTestSettingsSchema();
+	char fileName[PATH_MAX];
+	snprintf(fileName, sizeof(fileName), "%s/settingsschemabenchmark.json", directory);
+
+	float variables[TEST_SCHEMA_FIELDS];
+	SettingsBinding binding(testSchema);
+	for(int i = 0; i < TEST_SCHEMA_FIELDS; i++)
+	{
+		variables[i] = i * 0.5f;
+		binding.BindIndex(i, &variables[i]);
+	}
+
+	Settings* settings = new Settings(fileName, testSchema);
+	settings->SetVal<String>("DisplayName", "Benchmark");
+	settings->SaveAll(binding);
+	Settings::FlushWrites();
+
+	// Parsing the file and loading every setting
+	double loadTotal = 0.0;
+	for(int run = 0; run < RUNS; run++)
+	{
+		const double start = NowSeconds();
+		settings->OpenOrCreate(fileName);
+		settings->Load(binding);
+		loadTotal += NowSeconds() - start;
+	}
+
+	// Saving every setting, up to the text the writer thread puts on disk
+	double saveTotal = 0.0;
+	for(int run = 0; run < RUNS; run++)
+	{
+		variables[run % TEST_SCHEMA_FIELDS] += 1.0f;
+		const double start = NowSeconds();
+		settings->StoreBound(binding, false);
+		char* text = settings->SerializeText();
+		saveTotal += NowSeconds() - start;
+		free(text);
+	}
+
+	// Looking every name up, what Define and GetVal used to do with strcmp
+	volatile int found = 0;
+	const double lookupStart = NowSeconds();
+	for(int run = 0; run < RUNS; run++)
+	{
+		for(int i = 0; i < TEST_SCHEMA_FIELDS; i++)
+		{
+			found += testSchema.Find(testSchema.GetDef(i).Name);
+		}
+	}
+	const double lookup = NowSeconds() - lookupStart;
+
+	const double scanStart = NowSeconds();
+	for(int run = 0; run < RUNS; run++)
+	{
+		for(int i = 0; i < TEST_SCHEMA_FIELDS; i++)
+		{
+			for(int j = 0; j < TEST_SCHEMA_FIELDS; j++)
+			{
+				if(strcmp(testSchema.GetDef(j).Name, testSchema.GetDef(i).Name) == 0)
+				{
+					found += j;
+					break;
+				}
+			}
+		}
+	}
+	const double scan = NowSeconds() - scanStart;
+
+	for(int i = 0; i < TEST_SCHEMA_FIELDS; i++)
+	{
+		assert( variables[i] == i * 0.5f + ( i < RUNS % TEST_SCHEMA_FIELDS ? 1.0f : 0.0f ) + ( RUNS / TEST_SCHEMA_FIELDS ) );
+	}
+
+	LOG("SettingsSchemaBenchmark: %i settings, load %.1f us, save %.1f us",
+			TEST_SCHEMA_FIELDS, loadTotal / RUNS * 1e6, saveTotal / RUNS * 1e6);
+	LOG("SettingsSchemaBenchmark: name lookup %.1f ns hashed, %.1f ns scanned",
+			lookup / ( RUNS * TEST_SCHEMA_FIELDS ) * 1e9, scan / ( RUNS * TEST_SCHEMA_FIELDS ) * 1e9);
+
+	delete(settings);
+	Settings::RemoveFile(fileName);
+	Settings::FlushWrites();
 }
+#endif
 
 } // namespace VRMatterStreamTheater
@@ -15,8 +15,12 @@ LICENSE file in the StreamTheater/ directory.
 #if !defined( GenericSettings_h )
 #define GenericSettings_h
 
+#include <pthread.h>
+
 #include "Kernel/OVR_Array.h"
 #include "Kernel/OVR_JSON.h"
+#include "SettingsSchema.h"
+#include "SettingsSnapshot.h"
 
 namespace VRMatterStreamTheater {
 
@@ -26,24 +30,40 @@ class Settings
 {
 public:
 	static const double SETTINGS_VERSION = 1.0;
-	Settings();
-	Settings(const char* filename);
+	Settings(const SettingsSchema& schema = GetStreamTheaterSchema());
+	Settings(const char* filename, const SettingsSchema& schema = GetStreamTheaterSchema());
 	~Settings();
 
 	void OpenOrCreate(const char* filename);
 
-	// Copy the variable definitions from Settings that are already initialized
-	// Allows for multiple levels of saveable settings, e.g. defaults and theaters
-	void CopyDefines(const Settings& source);
+	// Set the bound variables to this file's values, for the settings it has.
+	// Files are layered by loading one after another over the schema defaults,
+	// e.g. settings.json, then per host, then per app
+	void Load(const SettingsBinding& binding);
 
-	// Associates a pointer to a variable with a name to save and load the value
-	// Please make sure all variables outlive the Settings object!
-	template<typename T>
-	void Define(const char* varName, T* ptr);
+	// Whether a bound variable changed since the last Load() or save
+	bool IsChanged(const SettingsBinding& binding) const;
+
+	// Save all bound values to settings
+	void SaveAll(const SettingsBinding& binding);
+
+	// Only save bound values that changed since the last Load() or save
+	void SaveChanged(const SettingsBinding& binding);
+
+	// Save the file as it is, e.g. after SetVal()
+	void Save();
+
+	// Whether the file has a value for a setting of the schema
+	bool IsSet(int index) const;
+
+	// Copies out the file's values for the schema, to switch to them later without the file
+	void GetSnapshot(SettingsSnapshot& out);
+
+	// Replaces the file's values for the schema, e.g. to write a snapshot out as JSON
+	void SetSnapshot(const SettingsSnapshot& in);
 
-	// Get a variable's value from the settings file
-	// Doesn't need to be defined, but call Load() first
-	// returns true if the variable exists, false if missing, wrong type, or unloaded
+	// Get a value from the settings file that isn't in the schema (or is, as a number)
+	// returns true if the variable exists, false if missing or the wrong type
 	// (slow, please avoid if possible, C-strings are duplicated so remember to clean up)
 	template<typename T>
 	bool GetVal(const char* varName, T* toSet);
@@ -51,42 +71,54 @@ public:
 	template<typename T>
 	void SetVal(const char* varName, T value);
 
-	bool IsChanged();
-
 	// Remove a variable from the saved settings file
 	// (automatically saved with no other changes)
 	void DeleteVar(const char* varName);
 
-	// Load any defined values into the specified variables
-	void Load();
-
-	// Save all values to settings
-	void SaveAll();
-
-	// Only add values if they're different from when they were defined or the last Load()
-	void SaveChanged();
-
-	// Update or create only the values of these variables
-	void SaveOnly(const Array<const char*> &varNames);
+	// Saves only update the settings in memory, the files are written on another thread
+	// a moment later. Delete a settings file through here so it isn't written again after.
+	static void RemoveFile(const char* filename);
 
-	// Save out any currently defined variable names if they don't exist but without data
-	// Allows users to edit variables that might not be changeable, without forcing a default value
-	void SaveVarNames();
+	// Wait for all saves so far to be written, before the app goes away
+	static void FlushWrites();
 
 private:
-	class IVariable;
-	template<typename T> class Variable;
+	friend class SettingsWriter;
+#ifndef NDEBUG
+	friend void SettingsSchemaBenchmark(const char* directory);
+#endif
+
+	void ScheduleSave();
+	// The whole file as text, for the writer thread (malloc'd)
+	char* SerializeText();
+	// Takes the schema's settings out of the JSON in one pass over it
+	void ReadSchemaValues();
+	// Copies the bound variables that differ from the baseline (or all) into values
+	void StoreBound(const SettingsBinding& binding, bool onlyChanged);
 
 private:
+	const SettingsSchema& schema;
 	char* settingsFileName;
+	// Everything in the file that isn't in the schema
 	JSON* rootSettingsJSON;
 	JSON* settingsJSON;
-	Array<IVariable*> variables;
+	// The schema's settings, and which of them the file has
+	SettingsSnapshot snapshot;
+	// The bound variables as of the last Load() or save
+	char* baseline;
+	// Held while the values or JSON change, since the writer thread serializes them
+	pthread_mutex_t jsonLock;
 
+private:
+	// not copyable
+	Settings(const Settings&);
+	Settings& operator=(const Settings&);
 };
 
 #ifndef NDEBUG
 void SettingsTest(String packageName);
+// Loads and saves a profile of TEST_SCHEMA_FIELDS settings
+void SettingsSchemaBenchmark(const char* directory);
 #endif
 
 } // namespace VRMatterStreamTheater
@@ -0,0 +1,261 @@
+/************************************************************************************
+
+Filename    :   SettingsSchema.cpp
+Content     :	Every saved setting's name, type, default and range, known at compile time.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#include "SettingsSchema.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "AppManager.h"
+#include "InputSampler.h"
+#include "MoviePlayerView.h"
+
+namespace VRMatterStreamTheater {
+
+static const SettingDef StreamTheaterSettingDefs[] =
+{
+#define STREAM_SETTING_DEF( member, name, type, def, min, max ) \
+	{ name, (SettingType)SettingTypeOf< type >::Value, offsetof( StreamTheaterSettings, member ), (double)( def ), (double)( min ), (double)( max ) },
+	STREAM_THEATER_SETTINGS( STREAM_SETTING_DEF )
+#undef STREAM_SETTING_DEF
+};
+
+const SettingsSchema & GetStreamTheaterSchema()
+{
+	static SettingsSchema schema( StreamTheaterSettingDefs, STREAM_SETTING_COUNT, sizeof( StreamTheaterSettings ) );
+	return schema;
+}
+
+SettingsSchema::SettingsSchema( const SettingDef * defs, const int count, const int valuesSize ) :
+	Defs( defs ),
+	Count( count ),
+	ValuesSize( valuesSize ),
+	Fingerprint( 0 ),
+	Slots( NULL ),
+	SlotMask( 0 )
+{
+	// At most half full, so probes stay short
+	int slotCount = 16;
+	while ( slotCount < count * 2 )
+	{
+		slotCount *= 2;
+	}
+	SlotMask = slotCount - 1;
+	Slots = new short[slotCount];
+	for ( int i = 0; i < slotCount; i++ )
+	{
+		Slots[i] = -1;
+	}
+
+	for ( int i = 0; i < count; i++ )
+	{
+		int slot = Hash( defs[i].Name ) & SlotMask;
+		while ( Slots[slot] >= 0 )
+		{
+			slot = ( slot + 1 ) & SlotMask;
+		}
+		Slots[slot] = (short)i;
+	}
+
+	char layout[16];
+	snprintf( layout, sizeof( layout ), "%i:%i", count, valuesSize );
+	Fingerprint = Hash( layout );
+	for ( int i = 0; i < count; i++ )
+	{
+		snprintf( layout, sizeof( layout ), "%i:%i", defs[i].Type, defs[i].Offset );
+		Fingerprint = ( Fingerprint * 31 ) ^ Hash( defs[i].Name ) ^ Hash( layout );
+	}
+}
+
+SettingsSchema::~SettingsSchema()
+{
+	delete[] Slots;
+}
+
+// FNV-1a
+unsigned SettingsSchema::Hash( const char * name )
+{
+	unsigned hash = 2166136261u;
+	for ( const unsigned char * c = (const unsigned char *)name; *c != 0; c++ )
+	{
+		hash = ( hash ^ *c ) * 16777619u;
+	}
+	return hash;
+}
+
+int SettingsSchema::Find( const char * name ) const
+{
+	for ( int slot = Hash( name ) & SlotMask; Slots[slot] >= 0; slot = ( slot + 1 ) & SlotMask )
+	{
+		if ( strcmp( Defs[Slots[slot]].Name, name ) == 0 )
+		{
+			return Slots[slot];
+		}
+	}
+	return -1;
+}
+
+int SettingsSchema::TypeSize( const SettingType type )
+{
+	switch ( type )
+	{
+		case SETTING_BOOL:	return sizeof( bool );
+		case SETTING_INT:	return sizeof( int );
+		case SETTING_FLOAT:	return sizeof( float );
+	}
+	return 0;
+}
+
+void SettingsSchema::SetDefaults( void * values ) const
+{
+	for ( int i = 0; i < Count; i++ )
+	{
+		SetValue( values, i, Defs[i].Default );
+	}
+}
+
+double SettingsSchema::GetValue( const void * values, const int index ) const
+{
+	const SettingDef & def = Defs[index];
+	const char * value = (const char *)values + def.Offset;
+	switch ( def.Type )
+	{
+		case SETTING_BOOL:	return *(const bool *)value ? 1.0 : 0.0;
+		case SETTING_INT:	return *(const int *)value;
+		case SETTING_FLOAT:	return *(const float *)value;
+	}
+	return 0.0;
+}
+
+void SettingsSchema::SetValue( void * values, const int index, const double value ) const
+{
+	const SettingDef & def = Defs[index];
+	double clamped = value;
+	if ( clamped != clamped )
+	{
+		clamped = def.Default;
+	}
+	clamped = ( clamped < def.Min ) ? def.Min : ( ( clamped > def.Max ) ? def.Max : clamped );
+
+	char * to = (char *)values + def.Offset;
+	switch ( def.Type )
+	{
+		case SETTING_BOOL:	*(bool *)to = ( clamped != 0.0 ); break;
+		case SETTING_INT:	*(int *)to = (int)clamped; break;
+		case SETTING_FLOAT:	*(float *)to = (float)clamped; break;
+	}
+}
+
+/***************************
+ * SettingsMask            *
+ ***************************/
+SettingsMask::SettingsMask( const int count ) :
+	Words()
+{
+	Words.Resize( ( count + 31 ) / 32 );
+	ResetAll();
+}
+
+void SettingsMask::ResetAll()
+{
+	for ( int i = 0; i < Words.GetSizeI(); i++ )
+	{
+		Words[i] = 0;
+	}
+}
+
+bool SettingsMask::Any() const
+{
+	for ( int i = 0; i < Words.GetSizeI(); i++ )
+	{
+		if ( Words[i] != 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/***************************
+ * SettingsBinding         *
+ ***************************/
+SettingsBinding::SettingsBinding( const SettingsSchema & schema ) :
+	Schema( &schema ),
+	Variables()
+{
+	Variables.Resize( schema.GetCount() );
+	for ( int i = 0; i < schema.GetCount(); i++ )
+	{
+		Variables[i] = NULL;
+	}
+}
+
+void SettingsBinding::Store( void * values ) const
+{
+	for ( int i = 0; i < Variables.GetSizeI(); i++ )
+	{
+		if ( Variables[i] != NULL )
+		{
+			const SettingDef & def = Schema->GetDef( i );
+			memcpy( (char *)values + def.Offset, Variables[i], SettingsSchema::TypeSize( def.Type ) );
+		}
+	}
+}
+
+void SettingsBinding::Apply( const void * values ) const
+{
+	for ( int i = 0; i < Variables.GetSizeI(); i++ )
+	{
+		if ( Variables[i] != NULL )
+		{
+			const SettingDef & def = Schema->GetDef( i );
+			memcpy( Variables[i], (const char *)values + def.Offset, SettingsSchema::TypeSize( def.Type ) );
+		}
+	}
+}
+
+void SettingsBinding::ApplyDefaults() const
+{
+	char * defaults = new char[Schema->GetValuesSize()];
+	Schema->SetDefaults( defaults );
+	Apply( defaults );
+	delete[] defaults;
+}
+
+#ifndef NDEBUG
+const SettingsSchema & GetTestSettingsSchema()
+{
+	static char names[TEST_SCHEMA_FIELDS][16];
+	static SettingDef defs[TEST_SCHEMA_FIELDS];
+	static bool initialized = false;
+	if ( !initialized )
+	{
+		for ( int i = 0; i < TEST_SCHEMA_FIELDS; i++ )
+		{
+			snprintf( names[i], sizeof( names[i] ), "TestField%03i", i );
+			defs[i].Name = names[i];
+			defs[i].Type = SETTING_FLOAT;
+			defs[i].Offset = i * sizeof( float );
+			defs[i].Default = 0.0;
+			defs[i].Min = -1e9;
+			defs[i].Max = 1e9;
+		}
+		initialized = true;
+	}
+	static SettingsSchema schema( defs, TEST_SCHEMA_FIELDS, TEST_SCHEMA_FIELDS * sizeof( float ) );
+	return schema;
+}
+#endif
+
+} // namespace VRMatterStreamTheater
@@ -0,0 +1,220 @@
+/************************************************************************************
+
+Filename    :   SettingsSchema.h
+Content     :	Every saved setting's name, type, default and range, known at compile time.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#if !defined( SettingsSchema_h )
+#define SettingsSchema_h
+
+#include <stddef.h>
+
+#include "Kernel/OVR_Array.h"
+
+using namespace OVR;
+
+namespace VRMatterStreamTheater {
+
+// The settings StreamTheater saves, each as
+// SETTING( member, name in the file, type, default, min, max )
+// Values loaded from a file are clamped to [min, max]. Enums are saved as int.
+// Defaults may use anything SettingsSchema.cpp includes.
+#define STREAM_THEATER_SETTINGS( SETTING ) \
+	SETTING( SettingsVersion,		"StreamTheaterSettingsVersion",	float,	1.0f,		0.0f,		1000.0f ) \
+	SETTING( MouseMode,				"MouseMode",					int,	MOUSE_GAZE,	MOUSE_OFF,	MOUSE_GAMEPAD ) \
+	SETTING( StreamWidth,			"StreamWidth",					int,	1280,		320,		4096 ) \
+	SETTING( StreamHeight,			"StreamHeight",					int,	720,		240,		2160 ) \
+	SETTING( StreamFPS,				"StreamFPS",					int,	60,			10,			120 ) \
+	SETTING( EnableHostAudio,		"EnableHostAudio",				bool,	true,		false,		true ) \
+	SETTING( SpatialAudio,			"SpatialAudio",					bool,	false,		false,		true ) \
+	SETTING( CustomBitrate,			"CustomBitrate",				float,	0.0f,		0.0f,		1000000.0f ) \
+	SETTING( MinBitrate,			"MinBitrate",					float,	0.0f,		0.0f,		1000000.0f ) \
+	SETTING( MaxBitrate,			"MaxBitrate",					float,	20000.0f,	0.0f,		1000000.0f ) \
+	SETTING( GazeScale,				"GazeScale",					float,	1.05f,		-1000.0f,	1000.0f ) \
+	SETTING( TrackpadScale,			"TrackpadScale",				float,	2.0f,		-1000.0f,	1000.0f ) \
+	SETTING( GamepadMouseScale,		"GamepadMouseScale",			float,	20.0f,		-1000.0f,	1000.0f ) \
+	SETTING( GazeSmoothing,			"GazeSmoothing",				bool,	false,		false,		true ) \
+	SETTING( TrackpadSmoothing,		"TrackpadSmoothing",			bool,	false,		false,		true ) \
+	SETTING( GamepadMouseSmoothing,	"GamepadMouseSmoothing",		bool,	false,		false,		true ) \
+	SETTING( GazeAcceleration,		"GazeAcceleration",				float,	0.0f,		-100.0f,	100.0f ) \
+	SETTING( TrackpadAcceleration,	"TrackpadAcceleration",			float,	0.0f,		-100.0f,	100.0f ) \
+	SETTING( GamepadMouseAcceleration,"GamepadMouseAcceleration",	float,	0.0f,		-100.0f,	100.0f ) \
+	SETTING( MouseFilterMinCutoff,	"MouseFilterMinCutoff",			float,	1.0f,		0.0f,		1000.0f ) \
+	SETTING( MouseFilterBeta,		"MouseFilterBeta",				float,	0.007f,		0.0f,		1000.0f ) \
+	SETTING( InputSampleRate,		"InputSampleRate",				int,	InputSampler::DEFAULT_RATE, 0, 1000 ) \
+	SETTING( AutoTuneStream,		"AutoTuneStream",				bool,	true,		false,		true ) \
+	SETTING( VoidScreenDistance,	"VoidScreenDistance",			float,	1.5f,		-100.0f,	100.0f ) \
+	SETTING( VoidScreenScale,		"VoidScreenScale",				float,	1.0f,		-100.0f,	100.0f ) \
+	SETTING( GazeScaleMax,			"GazeScaleMax",					float,	1.58f,		-1000.0f,	1000.0f ) \
+	SETTING( GazeScaleMin,			"GazeScaleMin",					float,	0.7f,		-1000.0f,	1000.0f ) \
+	SETTING( TrackpadScaleMax,		"TrackpadScaleMax",				float,	4.0f,		-1000.0f,	1000.0f ) \
+	SETTING( TrackpadScaleMin,		"TrackpadScaleMin",				float,	-4.0f,		-1000.0f,	1000.0f ) \
+	SETTING( GamepadScaleMax,		"GamepadScaleMax",				float,	50.0f,		-1000.0f,	1000.0f ) \
+	SETTING( GamepadScaleMin,		"GamepadScaleMin",				float,	1.0f,		-1000.0f,	1000.0f ) \
+	SETTING( VoidScreenDistanceMax,	"VoidScreenDistanceMax",		float,	3.0f,		-100.0f,	100.0f ) \
+	SETTING( VoidScreenDistanceMin,	"VoidScreenDistanceMin",		float,	0.1f,		-100.0f,	100.0f ) \
+	SETTING( VoidScreenScaleMax,	"VoidScreenScaleMax",			float,	4.0f,		-100.0f,	100.0f ) \
+	SETTING( VoidScreenScaleMin,	"VoidScreenScaleMin",			float,	-3.0f,		-100.0f,	100.0f ) \
+	SETTING( VRScreenLatency,		"VRScreenLatency",				int,	24,			-1000,		1000 ) \
+	SETTING( VRScreenXScale,		"VRScreenXScale",				float,	1.0f,		-100.0f,	100.0f ) \
+	SETTING( VRScreenYScale,		"VRScreenYScale",				float,	1.0f,		-100.0f,	100.0f ) \
+	SETTING( VRScreenPredictMouse,	"VRScreenPredictMouse",			bool,	false,		false,		true ) \
+	SETTING( VRScreenPredictionMax,	"VRScreenPredictionMax",		int,	100,		-1000,		1000 ) \
+	SETTING( VRScreenLatencyMax,	"VRScreenLatencyMax",			int,	60,			-1000,		1000 ) \
+	SETTING( VRScreenLatencyMin,	"VRScreenLatencyMin",			int,	0,			-1000,		1000 ) \
+	SETTING( VRScreenXScaleMax,		"VRScreenXScaleMax",			float,	6.0f,		-100.0f,	100.0f ) \
+	SETTING( VRScreenXScaleMin,		"VRScreenXScaleMin",			float,	0.0f,		-100.0f,	100.0f ) \
+	SETTING( VRScreenYScaleMax,		"VRScreenYScaleMax",			float,	6.0f,		-100.0f,	100.0f ) \
+	SETTING( VRScreenYScaleMin,		"VRScreenYScaleMin",			float,	0.0f,		-100.0f,	100.0f ) \
+	SETTING( MovieFormat,			"3dMode",						int,	VT_2D,		VT_UNKNOWN,	VT_TOP_BOTTOM_3D_FULL )
+
+enum SettingType
+{
+	SETTING_BOOL,
+	SETTING_INT,
+	SETTING_FLOAT
+};
+
+template< typename T > struct SettingTypeOf;
+template<> struct SettingTypeOf< bool >		{ enum { Value = SETTING_BOOL }; };
+template<> struct SettingTypeOf< int >		{ enum { Value = SETTING_INT }; };
+template<> struct SettingTypeOf< float >	{ enum { Value = SETTING_FLOAT }; };
+
+struct SettingDef
+{
+	const char *	Name;
+	SettingType		Type;
+	int				Offset;		// into a block of values, e.g. StreamTheaterSettings
+	double			Default;
+	double			Min;
+	double			Max;
+};
+
+// All of StreamTheater's settings by value, laid out by the schema
+struct StreamTheaterSettings
+{
+#define STREAM_SETTING_MEMBER( member, name, type, def, min, max ) type member;
+	STREAM_THEATER_SETTINGS( STREAM_SETTING_MEMBER )
+#undef STREAM_SETTING_MEMBER
+};
+
+enum StreamSettingIndex
+{
+#define STREAM_SETTING_INDEX( member, name, type, def, min, max ) STREAM_SETTING_##member,
+	STREAM_THEATER_SETTINGS( STREAM_SETTING_INDEX )
+#undef STREAM_SETTING_INDEX
+	STREAM_SETTING_COUNT
+};
+
+// One type per setting, so binding a variable of the wrong type doesn't compile
+// e.g. binding.Bind< StreamSetting::GazeScale >( &gazeScaleValue );
+namespace StreamSetting {
+#define STREAM_SETTING_TAG( member, name, type, def, min, max ) \
+	struct member { typedef type Type; enum { Index = STREAM_SETTING_##member }; };
+	STREAM_THEATER_SETTINGS( STREAM_SETTING_TAG )
+#undef STREAM_SETTING_TAG
+}
+
+// Fields of a block of values, found by index or by name in O(1)
+class SettingsSchema
+{
+public:
+						SettingsSchema( const SettingDef * defs, const int count, const int valuesSize );
+						~SettingsSchema();
+
+	int					GetCount() const { return Count; }
+	// Bytes in a block of values
+	int					GetValuesSize() const { return ValuesSize; }
+	const SettingDef &	GetDef( const int index ) const { return Defs[index]; }
+	// returns the index of the setting saved as name, or -1 if it isn't one
+	int					Find( const char * name ) const;
+
+	void				SetDefaults( void * values ) const;
+	double				GetValue( const void * values, const int index ) const;
+	// Clamps to the setting's range, anything not a number sets the default
+	void				SetValue( void * values, const int index, const double value ) const;
+
+	static int			TypeSize( const SettingType type );
+	// Differs between schemas with different settings or layouts
+	unsigned			GetFingerprint() const { return Fingerprint; }
+
+private:
+	const SettingDef *	Defs;
+	int					Count;
+	int					ValuesSize;
+	unsigned			Fingerprint;
+	short *				Slots;		// open addressed name hash of indices, -1 where empty
+	int					SlotMask;
+
+	static unsigned		Hash( const char * name );
+
+private:
+	// not copyable
+						SettingsSchema( const SettingsSchema & );
+	SettingsSchema &	operator=( const SettingsSchema & );
+};
+
+const SettingsSchema &	GetStreamTheaterSchema();
+
+// One bit per setting of a schema
+class SettingsMask
+{
+public:
+	explicit			SettingsMask( const int count );
+
+	bool				Test( const int index ) const { return ( Words[index >> 5] & ( 1u << ( index & 31 ) ) ) != 0; }
+	void				Set( const int index ) { Words[index >> 5] |= 1u << ( index & 31 ); }
+	void				Reset( const int index ) { Words[index >> 5] &= ~( 1u << ( index & 31 ) ); }
+	void				ResetAll();
+	bool				Any() const;
+
+	int					GetWordCount() const { return Words.GetSizeI(); }
+	unsigned *			GetWords() { return &Words[0]; }
+	const unsigned *	GetWords() const { return &Words[0]; }
+
+private:
+	Array< unsigned >	Words;
+};
+
+// Which variables a view keeps each setting in. Settings that aren't bound
+// are left alone by Load and Save.
+class SettingsBinding
+{
+public:
+	explicit			SettingsBinding( const SettingsSchema & schema );
+
+	template< typename Setting >
+	void				Bind( typename Setting::Type * variable ) { Variables[Setting::Index] = variable; }
+	// For schemas without tag types, variable must be of the setting's type
+	void				BindIndex( const int index, void * variable ) { Variables[index] = variable; }
+
+	const SettingsSchema &	GetSchema() const { return *Schema; }
+	void *				GetVariable( const int index ) const { return Variables[index]; }
+
+	// Copies the bound variables to a block of values and back
+	void				Store( void * values ) const;
+	void				Apply( const void * values ) const;
+	void				ApplyDefaults() const;
+
+private:
+	const SettingsSchema *	Schema;
+	Array< void * >		Variables;
+};
+
+#ifndef NDEBUG
+static const int TEST_SCHEMA_FIELDS = 200;
+// TEST_SCHEMA_FIELDS float settings named TestField000 and on, in a float[]
+const SettingsSchema &	GetTestSettingsSchema();
+#endif
+
+} // namespace VRMatterStreamTheater
+
+#endif // SettingsSchema_h
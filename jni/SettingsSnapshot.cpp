@@ -0,0 +1,278 @@
+/************************************************************************************
+
+Filename    :   SettingsSnapshot.cpp
+Content     :	A settings file's values for the schema, as a compact binary block.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#include "SettingsSnapshot.h"
+
+#include <string.h>
+
+#include "Settings.h"
+#include "Android/LogUtils.h"
+
+namespace VRMatterStreamTheater {
+
+SettingsSnapshot::SettingsSnapshot( const SettingsSchema & schema ) :
+	Schema( &schema ),
+	Values( new char[schema.GetValuesSize()] ),
+	Present( schema.GetCount() )
+{
+	// Padding too, so equal snapshots are equal bytes
+	memset( Values, 0, schema.GetValuesSize() );
+	schema.SetDefaults( Values );
+}
+
+SettingsSnapshot::SettingsSnapshot( const SettingsSnapshot & other ) :
+	Schema( other.Schema ),
+	Values( new char[other.Schema->GetValuesSize()] ),
+	Present( other.Present )
+{
+	memcpy( Values, other.Values, Schema->GetValuesSize() );
+}
+
+SettingsSnapshot::~SettingsSnapshot()
+{
+	delete[] Values;
+}
+
+SettingsSnapshot & SettingsSnapshot::operator=( const SettingsSnapshot & other )
+{
+	if ( this != &other )
+	{
+		if ( Schema->GetValuesSize() != other.Schema->GetValuesSize() )
+		{
+			delete[] Values;
+			Values = new char[other.Schema->GetValuesSize()];
+		}
+		Schema = other.Schema;
+		memcpy( Values, other.Values, Schema->GetValuesSize() );
+		Present = other.Present;
+	}
+	return *this;
+}
+
+int SettingsSnapshot::Apply( const SettingsBinding & binding, SettingsMask & changed ) const
+{
+	int count = 0;
+	for ( int i = 0; i < Schema->GetCount(); i++ )
+	{
+		void * variable = binding.GetVariable( i );
+		if ( variable == NULL || !Present.Test( i ) )
+		{
+			continue;
+		}
+		const SettingDef & def = Schema->GetDef( i );
+		const int size = SettingsSchema::TypeSize( def.Type );
+		if ( memcmp( variable, Values + def.Offset, size ) != 0 )
+		{
+			memcpy( variable, Values + def.Offset, size );
+			changed.Set( i );
+			count++;
+		}
+	}
+	return count;
+}
+
+int SettingsSnapshot::GetBinarySize() const
+{
+	return sizeof( BinaryHeader ) + Schema->GetValuesSize() + Present.GetWordCount() * sizeof( unsigned );
+}
+
+void SettingsSnapshot::WriteBinary( void * data ) const
+{
+	BinaryHeader header;
+	header.Magic = BINARY_MAGIC;
+	header.Fingerprint = Schema->GetFingerprint();
+	header.ValuesSize = Schema->GetValuesSize();
+	header.MaskWords = Present.GetWordCount();
+
+	char * out = (char *)data;
+	memcpy( out, &header, sizeof( header ) );
+	out += sizeof( header );
+	memcpy( out, Values, header.ValuesSize );
+	out += header.ValuesSize;
+	memcpy( out, Present.GetWords(), header.MaskWords * sizeof( unsigned ) );
+}
+
+bool SettingsSnapshot::ReadBinary( const void * data, const int size )
+{
+	BinaryHeader header;
+	if ( data == NULL || size != GetBinarySize() )
+	{
+		return false;
+	}
+	memcpy( &header, data, sizeof( header ) );
+	if ( header.Magic != BINARY_MAGIC || header.Fingerprint != Schema->GetFingerprint() ||
+			header.ValuesSize != Schema->GetValuesSize() || header.MaskWords != Present.GetWordCount() )
+	{
+		return false;
+	}
+
+	const char * in = (const char *)data + sizeof( header );
+	memcpy( Values, in, header.ValuesSize );
+	in += header.ValuesSize;
+	memcpy( Present.GetWords(), in, header.MaskWords * sizeof( unsigned ) );
+
+	// Whatever the bytes were, every value ends up one a file could have held
+	for ( int i = 0; i < Schema->GetCount(); i++ )
+	{
+		Schema->SetValue( Values, i, Schema->GetValue( Values, i ) );
+	}
+	return true;
+}
+
+#ifndef NDEBUG
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+
+// Binds every setting of the schema to the matching member of values
+static void BindAll( SettingsBinding & binding, StreamTheaterSettings & values )
+{
+	const SettingsSchema & schema = binding.GetSchema();
+	for ( int i = 0; i < schema.GetCount(); i++ )
+	{
+		binding.BindIndex( i, (char *)&values + schema.GetDef( i ).Offset );
+	}
+}
+
+static bool SameBinary( const SettingsSnapshot & a, const SettingsSnapshot & b )
+{
+	const int size = a.GetBinarySize();
+	if ( size != b.GetBinarySize() )
+	{
+		return false;
+	}
+	char * bytesA = new char[size];
+	char * bytesB = new char[size];
+	a.WriteBinary( bytesA );
+	b.WriteBinary( bytesB );
+	const bool same = memcmp( bytesA, bytesB, size ) == 0;
+	delete[] bytesA;
+	delete[] bytesB;
+	return same;
+}
+
+void SettingsSnapshotTest( const char * directory )
+{
+	const SettingsSchema & schema = GetStreamTheaterSchema();
+	char fileA[PATH_MAX];
+	char fileB[PATH_MAX];
+	snprintf( fileA, sizeof( fileA ), "%s/snapshottest.a.json", directory );
+	snprintf( fileB, sizeof( fileB ), "%s/snapshottest.b.json", directory );
+	Settings::RemoveFile( fileA );
+	Settings::RemoveFile( fileB );
+
+	// Every setting somewhere in its range, floats with digits that don't fit in binary
+	StreamTheaterSettings original;
+	memset( &original, 0, sizeof( original ) );
+	for ( int i = 0; i < schema.GetCount(); i++ )
+	{
+		const SettingDef & def = schema.GetDef( i );
+		schema.SetValue( &original, i, def.Min + ( def.Max - def.Min ) * ( ( i * 37 ) % 100 + 0.3 ) / 101.0 );
+	}
+	StreamTheaterSettings values = original;
+	SettingsBinding binding( schema );
+	BindAll( binding, values );
+
+	LOG( "SettingsSnapshotTest: from JSON to a snapshot" );
+	Settings * a = new Settings( fileA );
+	a->SetVal<String>( "DisplayName", "Snapshot" );
+	a->SaveAll( binding );
+	SettingsSnapshot snapshot;
+	a->GetSnapshot( snapshot );
+	for ( int i = 0; i < schema.GetCount(); i++ )
+	{
+		assert( snapshot.IsSet( i ) );
+	}
+
+	LOG( "SettingsSnapshotTest: through binary" );
+	const int size = snapshot.GetBinarySize();
+	char * bytes = new char[size];
+	snapshot.WriteBinary( bytes );
+	SettingsSnapshot fromBinary;
+	assert( fromBinary.ReadBinary( bytes, size ) );
+	assert( SameBinary( snapshot, fromBinary ) );
+
+	LOG( "SettingsSnapshotTest: applying it" );
+	StreamTheaterSettings defaults;
+	memset( &defaults, 0, sizeof( defaults ) );
+	schema.SetDefaults( &defaults );
+	values = defaults;
+	int differing = 0;
+	for ( int i = 0; i < schema.GetCount(); i++ )
+	{
+		differing += ( schema.GetValue( &original, i ) != schema.GetValue( &defaults, i ) );
+	}
+	SettingsMask changed( schema.GetCount() );
+	assert( fromBinary.Apply( binding, changed ) == differing );
+	assert( memcmp( &values, &original, sizeof( values ) ) == 0 );
+	for ( int i = 0; i < schema.GetCount(); i++ )
+	{
+		assert( changed.Test( i ) == ( schema.GetValue( &original, i ) != schema.GetValue( &defaults, i ) ) );
+	}
+	changed.ResetAll();
+	assert( fromBinary.Apply( binding, changed ) == 0 );
+	assert( !changed.Any() );
+
+	LOG( "SettingsSnapshotTest: back to JSON and in again" );
+	Settings * b = new Settings( fileB );
+	b->SetSnapshot( fromBinary );
+	delete b;
+	delete a;
+	Settings::FlushWrites();
+	b = new Settings( fileB );
+	SettingsSnapshot fromJSON;
+	b->GetSnapshot( fromJSON );
+	assert( SameBinary( snapshot, fromJSON ) );
+	String displayName;
+	assert( !b->GetVal( "DisplayName", &displayName ) ); // only the schema's settings travel
+	delete b;
+
+	LOG( "SettingsSnapshotTest: only what a snapshot has is applied" );
+	a = new Settings( fileA );
+	a->DeleteVar( "StreamWidth" );
+	SettingsSnapshot partial;
+	a->GetSnapshot( partial );
+	values = defaults;
+	values.StreamWidth = 1;
+	changed.ResetAll();
+	partial.Apply( binding, changed );
+	assert( values.StreamWidth == 1 && !changed.Test( STREAM_SETTING_StreamWidth ) );
+	assert( values.StreamHeight == original.StreamHeight );
+	delete a;
+
+	LOG( "SettingsSnapshotTest: binary that isn't a snapshot" );
+	SettingsSnapshot rejected;
+	assert( !rejected.ReadBinary( bytes, size - 1 ) );
+	assert( !rejected.ReadBinary( NULL, size ) );
+	bytes[0] ^= 1;
+	assert( !rejected.ReadBinary( bytes, size ) );
+	bytes[0] ^= 1;
+	SettingsSnapshot otherSchema( GetTestSettingsSchema() );
+	assert( !otherSchema.ReadBinary( bytes, size ) );
+	// out of range values are clamped like they would be from a file
+	const int valuesOffset = size - schema.GetValuesSize() - ( schema.GetCount() + 31 ) / 32 * sizeof( unsigned );
+	const int fps = 100000;
+	memcpy( bytes + valuesOffset + offsetof( StreamTheaterSettings, StreamFPS ), &fps, sizeof( fps ) );
+	assert( rejected.ReadBinary( bytes, size ) );
+	assert( ( (const StreamTheaterSettings *)rejected.GetValues() )->StreamFPS == 120 );
+	delete[] bytes;
+
+	Settings::RemoveFile( fileA );
+	Settings::RemoveFile( fileB );
+	Settings::FlushWrites();
+	LOG( "SettingsSnapshotTest passed" );
+}
+#endif
+
+} // namespace VRMatterStreamTheater
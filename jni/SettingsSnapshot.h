@@ -0,0 +1,74 @@
+/************************************************************************************
+
+Filename    :   SettingsSnapshot.h
+Content     :	A settings file's values for the schema, as a compact binary block.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#if !defined( SettingsSnapshot_h )
+#define SettingsSnapshot_h
+
+#include "SettingsSchema.h"
+
+namespace VRMatterStreamTheater {
+
+// The values a settings file has for each setting of a schema, and which
+// settings it has, in one block. Switching to a profile kept as a snapshot
+// is a compare and copy per bound variable, with no JSON involved.
+// JSON stays the format on disk; Settings converts between the two.
+class SettingsSnapshot
+{
+public:
+	explicit			SettingsSnapshot( const SettingsSchema & schema = GetStreamTheaterSchema() );
+						SettingsSnapshot( const SettingsSnapshot & other );
+						~SettingsSnapshot();
+
+	SettingsSnapshot &	operator=( const SettingsSnapshot & other );
+
+	const SettingsSchema &	GetSchema() const { return *Schema; }
+	bool				IsSet( const int index ) const { return Present.Test( index ); }
+	const void *		GetValues() const { return Values; }
+
+	// Sets the bound variables of settings the snapshot has that differ from it,
+	// marking them in changed. returns how many changed.
+	int					Apply( const SettingsBinding & binding, SettingsMask & changed ) const;
+
+	// The snapshot as bytes, for keeping profiles without their JSON:
+	// a header, the block of values, then a bit per setting it has
+	int					GetBinarySize() const;
+	void				WriteBinary( void * data ) const;
+	// returns false, leaving the snapshot as it was, if data isn't a snapshot of this schema
+	bool				ReadBinary( const void * data, const int size );
+
+private:
+	friend class Settings;
+
+	struct BinaryHeader
+	{
+		unsigned		Magic;
+		unsigned		Fingerprint;
+		int				ValuesSize;
+		int				MaskWords;
+	};
+	static const unsigned	BINARY_MAGIC = 0x53535453;	// "STSS"
+
+	const SettingsSchema *	Schema;
+	char *				Values;
+	SettingsMask		Present;
+};
+
+#ifndef NDEBUG
+// Round trips settings through snapshots, their binary form and JSON
+void SettingsSnapshotTest( const char * directory );
+#endif
+
+} // namespace VRMatterStreamTheater
+
+#endif // SettingsSnapshot_h
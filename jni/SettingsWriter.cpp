@@ -0,0 +1,529 @@
+/************************************************************************************
+
+Filename    :   SettingsWriter.cpp
+Content     :	Write-behind, atomic saving of settings files.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#include "SettingsWriter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Settings.h"
+#include "Android/LogUtils.h"
+
+namespace VRMatterStreamTheater {
+
+static long long NowMs()
+{
+	struct timespec now;
+	clock_gettime( CLOCK_REALTIME, &now );
+	return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+SettingsWriter & SettingsWriter::Get()
+{
+	static SettingsWriter writer;
+	return writer;
+}
+
+SettingsWriter::SettingsWriter() :
+	Thread(),
+	Running( false ),
+	Jobs(),
+	InFlight(),
+	Writing( false )
+{
+	pthread_mutex_init( &Lock, NULL );
+	pthread_cond_init( &Changed, NULL );
+}
+
+SettingsWriter::~SettingsWriter()
+{
+	Flush();
+
+	pthread_mutex_lock( &Lock );
+	const bool wasRunning = Running;
+	Running = false;
+	pthread_cond_broadcast( &Changed );
+	pthread_mutex_unlock( &Lock );
+
+	if ( wasRunning )
+	{
+		pthread_join( Thread, NULL );
+	}
+	pthread_cond_destroy( &Changed );
+	pthread_mutex_destroy( &Lock );
+}
+
+// Lock must be held
+void SettingsWriter::Start()
+{
+	if ( Running )
+	{
+		return;
+	}
+	if ( pthread_create( &Thread, NULL, ThreadFunction, this ) != 0 )
+	{
+		LOG( "SettingsWriter: Unable to create thread" );
+		return;
+	}
+	Running = true;
+}
+
+// Lock must be held
+int SettingsWriter::FindOwner( Settings * owner ) const
+{
+	for ( int i = 0; i < Jobs.GetSizeI(); i++ )
+	{
+		if ( Jobs[i].Owner == owner )
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+void SettingsWriter::FreeJob( Job & job )
+{
+	free( job.FileName );
+	free( job.Text );
+	job.FileName = NULL;
+	job.Text = NULL;
+	job.Owner = NULL;
+}
+
+void SettingsWriter::Schedule( Settings * owner )
+{
+	pthread_mutex_lock( &Lock );
+	Start();
+
+	const long long now = NowMs();
+	const int index = FindOwner( owner );
+	if ( index >= 0 )
+	{
+		const long long latest = Jobs[index].FirstMs + MAX_DELAY_MS;
+		Jobs[index].DueMs = ( now + DEBOUNCE_MS < latest ) ? now + DEBOUNCE_MS : latest;
+	}
+	else
+	{
+		Job job;
+		job.Owner = owner;
+		job.FileName = strdup( owner->settingsFileName );
+		job.Text = NULL;
+		job.FirstMs = now;
+		job.DueMs = now + DEBOUNCE_MS;
+		Jobs.PushBack( job );
+	}
+
+	pthread_cond_broadcast( &Changed );
+	pthread_mutex_unlock( &Lock );
+}
+
+void SettingsWriter::Detach( Settings * owner )
+{
+	pthread_mutex_lock( &Lock );
+	const int index = FindOwner( owner );
+	if ( index >= 0 )
+	{
+		Jobs[index].Text = owner->SerializeText();
+		Jobs[index].Owner = NULL;
+		Jobs[index].DueMs = NowMs();
+		pthread_cond_broadcast( &Changed );
+	}
+	pthread_mutex_unlock( &Lock );
+}
+
+void SettingsWriter::Remove( const char * fileName )
+{
+	pthread_mutex_lock( &Lock );
+	Start();
+
+	for ( int i = Jobs.GetSizeI() - 1; i >= 0; i-- )
+	{
+		if ( strcmp( Jobs[i].FileName, fileName ) == 0 )
+		{
+			FreeJob( Jobs[i] );
+			Jobs.RemoveAt( i );
+		}
+	}
+
+	Job job;
+	job.Owner = NULL;
+	job.FileName = strdup( fileName );
+	job.Text = NULL;
+	job.FirstMs = NowMs();
+	job.DueMs = job.FirstMs;
+	Jobs.PushBack( job );
+
+	pthread_cond_broadcast( &Changed );
+	pthread_mutex_unlock( &Lock );
+}
+
+bool SettingsWriter::GetPendingContents( const char * fileName, char ** contents )
+{
+	bool pending = false;
+	*contents = NULL;
+
+	pthread_mutex_lock( &Lock );
+	// The last write wins
+	for ( int i = Jobs.GetSizeI() - 1; i >= 0 && !pending; i-- )
+	{
+		if ( strcmp( Jobs[i].FileName, fileName ) == 0 )
+		{
+			pending = true;
+			if ( Jobs[i].Owner != NULL )
+			{
+				*contents = Jobs[i].Owner->SerializeText();
+			}
+			else if ( Jobs[i].Text != NULL )
+			{
+				*contents = strdup( Jobs[i].Text );
+			}
+		}
+	}
+	if ( !pending && Writing && strcmp( InFlight.FileName, fileName ) == 0 )
+	{
+		pending = true;
+		*contents = ( InFlight.Text != NULL ) ? strdup( InFlight.Text ) : NULL;
+	}
+	pthread_mutex_unlock( &Lock );
+
+	return pending;
+}
+
+void SettingsWriter::Flush()
+{
+	pthread_mutex_lock( &Lock );
+	// Nothing's debounced any more
+	for ( int i = 0; i < Jobs.GetSizeI(); i++ )
+	{
+		Jobs[i].DueMs = 0;
+	}
+	pthread_cond_broadcast( &Changed );
+	while ( Running && ( Jobs.GetSizeI() > 0 || Writing ) )
+	{
+		pthread_cond_wait( &Changed, &Lock );
+	}
+	pthread_mutex_unlock( &Lock );
+}
+
+void * SettingsWriter::ThreadFunction( void * param )
+{
+	( (SettingsWriter *)param )->Run();
+	return NULL;
+}
+
+void SettingsWriter::Run()
+{
+	pthread_mutex_lock( &Lock );
+	while ( Running )
+	{
+		if ( Jobs.GetSizeI() == 0 )
+		{
+			pthread_cond_wait( &Changed, &Lock );
+			continue;
+		}
+
+		// Strictly in order, so a write never lands on top of a later one
+		const long long dueMs = Jobs[0].DueMs;
+		if ( dueMs > NowMs() )
+		{
+			struct timespec until;
+			until.tv_sec = dueMs / 1000;
+			until.tv_nsec = ( dueMs % 1000 ) * 1000000;
+			pthread_cond_timedwait( &Changed, &Lock, &until );
+			continue;
+		}
+
+		InFlight = Jobs[0];
+		Jobs.RemoveAt( 0 );
+		if ( InFlight.Owner != NULL )
+		{
+			InFlight.Text = InFlight.Owner->SerializeText();
+			InFlight.Owner = NULL;
+		}
+		Writing = true;
+		pthread_mutex_unlock( &Lock );
+
+		if ( InFlight.Text == NULL )
+		{
+			if ( unlink( InFlight.FileName ) != 0 && errno != ENOENT )
+			{
+				LOG( "SettingsWriter: Unable to remove %s: %s", InFlight.FileName, strerror( errno ) );
+			}
+		}
+		else if ( !WriteAtomically( InFlight.FileName, InFlight.Text ) )
+		{
+			LOG( "SettingsWriter: Unable to save %s", InFlight.FileName );
+		}
+
+		pthread_mutex_lock( &Lock );
+		FreeJob( InFlight );
+		Writing = false;
+		pthread_cond_broadcast( &Changed );
+	}
+	pthread_mutex_unlock( &Lock );
+}
+
+bool SettingsWriter::WriteAtomically( const char * fileName, const char * text )
+{
+	char tempName[PATH_MAX];
+	if ( snprintf( tempName, sizeof( tempName ), "%s.tmp", fileName ) >= (int)sizeof( tempName ) )
+	{
+		return false;
+	}
+
+	const int fd = open( tempName, O_WRONLY | O_CREAT | O_TRUNC, 0660 );
+	if ( fd < 0 )
+	{
+		LOG( "SettingsWriter: Unable to open %s: %s", tempName, strerror( errno ) );
+		return false;
+	}
+
+	const size_t length = strlen( text );
+	size_t written = 0;
+	while ( written < length )
+	{
+		const ssize_t result = write( fd, text + written, length - written );
+		if ( result < 0 )
+		{
+			if ( errno == EINTR )
+			{
+				continue;
+			}
+			LOG( "SettingsWriter: Unable to write %s: %s", tempName, strerror( errno ) );
+			close( fd );
+			unlink( tempName );
+			return false;
+		}
+		written += result;
+	}
+
+	// The data has to be on disk before the rename is, or a power cut could leave an empty file
+	const bool synced = ( fsync( fd ) == 0 );
+	if ( close( fd ) != 0 || !synced )
+	{
+		LOG( "SettingsWriter: Unable to sync %s: %s", tempName, strerror( errno ) );
+		unlink( tempName );
+		return false;
+	}
+	if ( rename( tempName, fileName ) != 0 )
+	{
+		LOG( "SettingsWriter: Unable to rename %s: %s", tempName, strerror( errno ) );
+		unlink( tempName );
+		return false;
+	}
+
+	// And the rename itself lives in the directory
+	const char * slash = strrchr( fileName, '/' );
+	if ( slash != NULL )
+	{
+		char directory[PATH_MAX];
+		const int directoryLength = ( slash == fileName ) ? 1 : (int)( slash - fileName );
+		memcpy( directory, fileName, directoryLength );
+		directory[directoryLength] = '\0';
+
+		const int dirFd = open( directory, O_RDONLY | O_DIRECTORY );
+		if ( dirFd >= 0 )
+		{
+			fsync( dirFd );
+			close( dirFd );
+		}
+	}
+	return true;
+}
+
+#ifndef NDEBUG
+#include <assert.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+static double NowSeconds()
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// A settings file with every field set to generation, big enough to span a few disk blocks
+static char * TestSettingsText( const int generation )
+{
+	JSON * root = JSON::CreateObject();
+	root->AddNumberItem( "SettingsVersion", Settings::SETTINGS_VERSION );
+	JSON * settings = JSON::CreateObject();
+	for ( int i = 0; i < TEST_SCHEMA_FIELDS; i++ )
+	{
+		char name[32];
+		snprintf( name, sizeof( name ), "TestField%03i", i );
+		settings->AddNumberItem( name, generation );
+	}
+	root->AddItem( "Settings", settings );
+	char * text = root->PrintValue( 0, true );
+	root->Release();
+	return text;
+}
+
+// returns the generation every field in the file has, 0 if the file is missing, or -1 if it's torn
+static int TestSettingsGeneration( const char * fileName )
+{
+	if ( access( fileName, F_OK ) != 0 )
+	{
+		return 0;
+	}
+
+	JSON * root = JSON::Load( fileName );
+	JSON * settings = ( root != NULL ) ? root->GetItemByName( "Settings" ) : NULL;
+	int generation = -1;
+	if ( settings != NULL )
+	{
+		for ( int i = 0; i < TEST_SCHEMA_FIELDS; i++ )
+		{
+			char name[32];
+			snprintf( name, sizeof( name ), "TestField%03i", i );
+			JSON * field = settings->GetItemByName( name );
+			const int value = ( field != NULL ) ? (int)field->GetDoubleValue() : -1;
+			if ( value < 1 || ( generation > 0 && value != generation ) )
+			{
+				generation = -1;
+				break;
+			}
+			generation = value;
+		}
+	}
+	if ( root != NULL )
+	{
+		root->Release();
+	}
+	return generation;
+}
+
+void SettingsWriterCrashTest( const char * directory )
+{
+	char fileName[PATH_MAX];
+	snprintf( fileName, sizeof( fileName ), "%s/settingscrashtest.json", directory );
+	unlink( fileName );
+
+	// Made up front, the child shouldn't allocate after forking a threaded process
+	char * texts[2] = { TestSettingsText( 1 ), TestSettingsText( 2 ) };
+	int torn = 0;
+	int kills = 0;
+	int seen[3] = { 0, 0, 0 };
+	srand( 1 );
+
+	for ( int run = 0; run < 100; run++ )
+	{
+		const pid_t child = fork();
+		if ( child < 0 )
+		{
+			LOG( "SettingsWriterCrashTest: Unable to fork" );
+			break;
+		}
+		if ( child == 0 )
+		{
+			for ( int generation = 0; ; generation ^= 1 )
+			{
+				SettingsWriter::WriteAtomically( fileName, texts[generation] );
+			}
+		}
+
+		usleep( rand() % 20000 );
+		kill( child, SIGKILL );
+		waitpid( child, NULL, 0 );
+		kills++;
+
+		const int generation = TestSettingsGeneration( fileName );
+		if ( generation < 0 )
+		{
+			torn++;
+		}
+		else
+		{
+			seen[generation]++;
+		}
+	}
+
+	LOG( "SettingsWriterCrashTest: %i kills, %i torn files, %i missing, %i old, %i new",
+			kills, torn, seen[0], seen[1], seen[2] );
+	assert( torn == 0 );
+
+	free( texts[0] );
+	free( texts[1] );
+	unlink( fileName );
+}
+
+void SettingsSaveBenchmark( const char * directory )
+{
+	static const int SAVES = 200;
+	char fileName[PATH_MAX];
+	snprintf( fileName, sizeof( fileName ), "%s/settingsbenchmark.json", directory );
+
+	float values[TEST_SCHEMA_FIELDS];
+	SettingsBinding binding( GetTestSettingsSchema() );
+	for ( int i = 0; i < TEST_SCHEMA_FIELDS; i++ )
+	{
+		values[i] = 0.0f;
+		binding.BindIndex( i, &values[i] );
+	}
+	Settings * settings = new Settings( fileName, GetTestSettingsSchema() );
+	settings->Load( binding );
+
+	// What every save used to cost the render thread
+	char * text = TestSettingsText( 1 );
+	JSON * root = JSON::Parse( text );
+	double syncTotal = 0.0;
+	double syncMax = 0.0;
+	for ( int i = 0; i < SAVES; i++ )
+	{
+		const double start = NowSeconds();
+		root->Save( fileName );
+		const double elapsed = NowSeconds() - start;
+		syncTotal += elapsed;
+		syncMax = ( elapsed > syncMax ) ? elapsed : syncMax;
+	}
+	root->Release();
+	free( text );
+
+	// And what it costs now, a slider dragged across a few hundred frames
+	double total = 0.0;
+	double max = 0.0;
+	for ( int i = 0; i < SAVES; i++ )
+	{
+		values[i % TEST_SCHEMA_FIELDS] = i;
+		const double start = NowSeconds();
+		settings->SaveChanged( binding );
+		const double elapsed = NowSeconds() - start;
+		total += elapsed;
+		max = ( elapsed > max ) ? elapsed : max;
+	}
+
+	const double flushStart = NowSeconds();
+	SettingsWriter::Get().Flush();
+	const double flush = NowSeconds() - flushStart;
+
+	LOG( "SettingsSaveBenchmark: %i fields, synchronous save %.1f us mean %.1f us max",
+			TEST_SCHEMA_FIELDS, syncTotal / SAVES * 1e6, syncMax * 1e6 );
+	LOG( "SettingsSaveBenchmark: write-behind save %.1f us mean %.1f us max, flushed in %.1f ms",
+			total / SAVES * 1e6, max * 1e6, flush * 1e3 );
+
+	delete settings;
+	Settings::RemoveFile( fileName );
+	SettingsWriter::Get().Flush();
+}
+#endif
+
+} // namespace VRMatterStreamTheater
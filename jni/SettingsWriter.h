@@ -0,0 +1,99 @@
+/************************************************************************************
+
+Filename    :   SettingsWriter.h
+Content     :	Write-behind, atomic saving of settings files.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#if !defined( SettingsWriter_h )
+#define SettingsWriter_h
+
+#include <pthread.h>
+
+#include "Kernel/OVR_Array.h"
+
+using namespace OVR;
+
+namespace VRMatterStreamTheater {
+
+class Settings;
+
+// Writes settings files on its own thread, so a save from a button press
+// only touches the settings in memory. Saves of the same Settings within
+// DEBOUNCE_MS of each other are written once, serialized on this thread
+// when they're due, but none waits longer than MAX_DELAY_MS.
+// Files are written to a temporary next to them, synced and renamed over
+// the old file, so a crash leaves the old or the new file but never half
+// of one. Writes happen in the order they were asked for.
+class SettingsWriter
+{
+public:
+	static const int	DEBOUNCE_MS = 250;
+	// A slider that never stops moving is still written this often
+	static const int	MAX_DELAY_MS = 1000;
+
+	static SettingsWriter &	Get();
+
+						SettingsWriter();
+						~SettingsWriter();
+
+	// Writes owner's file once owner hasn't been saved again for DEBOUNCE_MS
+	void				Schedule( Settings * owner );
+	// For an owner that is going away or opening another file: a pending
+	// save is snapshotted now and written without it
+	void				Detach( Settings * owner );
+	// Drops pending writes of fileName and deletes it once earlier writes are done
+	void				Remove( const char * fileName );
+	// returns true if fileName has writes pending, in which case contents is what it
+	// will hold once they're done, to be free()d, or NULL if it's being removed
+	bool				GetPendingContents( const char * fileName, char ** contents );
+	// Blocks until everything asked for so far is on disk
+	void				Flush();
+
+	// Writes text to fileName through a synced temporary, returns false if it couldn't
+	static bool			WriteAtomically( const char * fileName, const char * text );
+
+private:
+	struct Job
+	{
+		Settings *		Owner;		// serialized when due, NULL once it has been
+		char *			FileName;
+		char *			Text;		// NULL with no owner to delete the file
+		long long		FirstMs;
+		long long		DueMs;
+	};
+
+	pthread_t			Thread;
+	pthread_mutex_t		Lock;
+	pthread_cond_t		Changed;
+	bool				Running;
+
+	Array<Job>			Jobs;
+	Job					InFlight;	// taken off Jobs, being written
+	bool				Writing;
+
+private:
+	static void *		ThreadFunction( void * param );
+	void				Run();
+	void				Start();
+	int					FindOwner( Settings * owner ) const;
+	void				FreeJob( Job & job );
+};
+
+#ifndef NDEBUG
+// Kills a process mid write many times over and checks what's left on disk
+void SettingsWriterCrashTest( const char * directory );
+// Time spent on the calling thread saving settings, write-behind and not
+void SettingsSaveBenchmark( const char * directory );
+#endif
+
+} // namespace VRMatterStreamTheater
+
+#endif // SettingsWriter_h
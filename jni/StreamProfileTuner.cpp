@@ -0,0 +1,732 @@
+/************************************************************************************
+
+Filename    :   StreamProfileTuner.cpp
+Content     :	Picks the stream's resolution, frame rate and bitrate per host and app.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#include "StreamProfileTuner.h"
+
+#include "Settings.h"
+#include "Android/LogUtils.h"
+
+namespace VRMatterStreamTheater {
+
+const double StreamProfileTuner::SAMPLE_SECONDS = 1.0;
+const double StreamProfileTuner::GRACE_SECONDS = 5.0;
+const double StreamProfileTuner::SUSTAIN_SECONDS = 60.0;
+const double StreamProfileTuner::LOSS_LIMIT = 0.02;
+
+// Steps down from any target, best first. The bitrates are the ones
+// the stream picks for each resolution and frame rate by itself.
+static const StreamProfile LadderSteps[] =
+{
+	{ 1920, 1080, 60, 20000 },
+	{ 1920, 1080, 60, 15000 },
+	{ 1920, 1080, 30, 10000 },
+	{ 1280, 720, 60, 10000 },
+	{ 1280, 720, 60, 7500 },
+	{ 1280, 720, 30, 5000 },
+	{ 854, 480, 60, 4000 },
+	{ 854, 480, 30, 2000 }
+};
+
+#define PROFILE_FORMAT			"%ix%i@%i %ikbps"
+#define PROFILE_ARGS( p )		(p).Width, (p).Height, (p).FPS, (p).Bitrate
+
+bool StreamProfile::operator==( const StreamProfile & other ) const
+{
+	return Width == other.Width && Height == other.Height && FPS == other.FPS && Bitrate == other.Bitrate;
+}
+
+bool StreamProfile::Within( const StreamProfile & other ) const
+{
+	return Width <= other.Width && Height <= other.Height && FPS <= other.FPS && Bitrate <= other.Bitrate;
+}
+
+StreamProfileTuner::StreamProfileTuner() :
+	Directory(),
+	HostHistory( NULL ),
+	HostName(),
+	AppName(),
+	Active( false ),
+	Ladder(),
+	Rung( 0 ),
+	Downshifts( 0 ),
+	Last(),
+	HaveLast( false ),
+	LastSeconds( 0.0 ),
+	RungStartSeconds( -1.0 ),
+	JudgedSeconds( 0.0 ),
+	BacklogSeconds( 0.0 ),
+	JudgedFrames( 0 ),
+	JudgedDropped( 0 ),
+	WindowNext( 0 ),
+	WindowCount( 0 ),
+	SessionFrames( 0 ),
+	SessionDropped( 0 ),
+	Trace( NULL )
+{
+	const StreamProfile none = { 0, 0, 0, 0 };
+	Ladder.PushBack( none );
+}
+
+StreamProfileTuner::~StreamProfileTuner()
+{
+	End();
+	if ( Trace != NULL )
+	{
+		fclose( Trace );
+	}
+}
+
+void StreamProfileTuner::SetDirectory( const char * directory )
+{
+	Directory = directory;
+}
+
+// The same as StreamInterface's table
+int StreamProfileTuner::DefaultBitrate( const int height, const int fps )
+{
+	if ( height == 1080 && fps == 60 )
+	{
+		return 20000;
+	}
+	if ( height == 720 && fps == 30 )
+	{
+		return 5000;
+	}
+	if ( height == 480 && fps == 60 )
+	{
+		return 4000;
+	}
+	if ( height == 480 && fps == 30 )
+	{
+		return 2000;
+	}
+	return 10000;
+}
+
+void StreamProfileTuner::BuildLadder( const StreamProfile & target )
+{
+	StreamProfile top = target;
+	if ( top.Bitrate <= 0 )
+	{
+		top.Bitrate = DefaultBitrate( top.Height, top.FPS );
+	}
+
+	Ladder.Clear();
+	Ladder.PushBack( top );
+	for ( int i = 0; i < (int)( sizeof( LadderSteps ) / sizeof( LadderSteps[0] ) ); i++ )
+	{
+		if ( LadderSteps[i].Within( top ) && LadderSteps[i] != top )
+		{
+			Ladder.PushBack( LadderSteps[i] );
+		}
+	}
+}
+
+int StreamProfileTuner::FindRung( const StreamProfile & profile ) const
+{
+	for ( int i = 0; i < Ladder.GetSizeI(); i++ )
+	{
+		if ( Ladder[i].Within( profile ) )
+		{
+			return i;
+		}
+	}
+	return Ladder.GetSizeI() - 1;
+}
+
+int StreamProfileTuner::FindLower( const bool lessPixels ) const
+{
+	const StreamProfile & current = Ladder[Rung];
+	for ( int i = Rung + 1; i < Ladder.GetSizeI(); i++ )
+	{
+		if ( lessPixels ? ( Ladder[i].PixelRate() < current.PixelRate() ) : ( Ladder[i].Bitrate < current.Bitrate ) )
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+void StreamProfileTuner::StartRung( const int rung )
+{
+	Rung = rung;
+	HaveLast = false;
+	RungStartSeconds = -1.0;
+	JudgedSeconds = 0.0;
+	BacklogSeconds = 0.0;
+	JudgedFrames = 0;
+	JudgedDropped = 0;
+	WindowNext = 0;
+	WindowCount = 0;
+}
+
+bool StreamProfileTuner::ReadHistory( const char * prefix, History & history ) const
+{
+	if ( HostHistory == NULL )
+	{
+		return false;
+	}
+	const String p( prefix );
+	return HostHistory->GetVal( ( p + "Width" ).ToCStr(), &history.Profile.Width ) &&
+			HostHistory->GetVal( ( p + "Height" ).ToCStr(), &history.Profile.Height ) &&
+			HostHistory->GetVal( ( p + "FPS" ).ToCStr(), &history.Profile.FPS ) &&
+			HostHistory->GetVal( ( p + "Bitrate" ).ToCStr(), &history.Profile.Bitrate ) &&
+			HostHistory->GetVal( ( p + "CleanSessions" ).ToCStr(), &history.CleanSessions );
+}
+
+void StreamProfileTuner::WriteHistory( const char * prefix, const History & history )
+{
+	if ( HostHistory == NULL )
+	{
+		return;
+	}
+	const String p( prefix );
+	HostHistory->SetVal( ( p + "Width" ).ToCStr(), history.Profile.Width );
+	HostHistory->SetVal( ( p + "Height" ).ToCStr(), history.Profile.Height );
+	HostHistory->SetVal( ( p + "FPS" ).ToCStr(), history.Profile.FPS );
+	HostHistory->SetVal( ( p + "Bitrate" ).ToCStr(), history.Profile.Bitrate );
+	HostHistory->SetVal( ( p + "CleanSessions" ).ToCStr(), history.CleanSessions );
+}
+
+StreamProfile StreamProfileTuner::Begin( const char * host, const char * app, const bool remote, const StreamProfile & target, const StreamTuning tuning )
+{
+	End();
+
+	HostName = host;
+	AppName = app;
+	Downshifts = 0;
+	SessionFrames = 0;
+	SessionDropped = 0;
+	BuildLadder( target );
+
+	if ( tuning == STREAM_TUNING_OFF )
+	{
+		StartRung( 0 );
+		LOG( "StreamProfileTuner: %s on %s as asked, " PROFILE_FORMAT, app, host, PROFILE_ARGS( Ladder[0] ) );
+		return target;
+	}
+
+	if ( Directory.GetLength() > 0 )
+	{
+		HostHistory = new Settings( ( Directory + "streamprofile.host." + HostName + ".json" ).ToCStr() );
+	}
+
+	int rung = 0;
+	if ( tuning == STREAM_TUNING_FROM_HISTORY )
+	{
+		const String appPrefix = String( "App." ) + AppName + ".";
+		History history;
+		double hostLoss = 0.0;
+		if ( ReadHistory( appPrefix.ToCStr(), history ) )
+		{
+			rung = FindRung( history.Profile );
+			if ( history.CleanSessions >= PROBE_SESSIONS && rung > 0 )
+			{
+				rung--;
+				LOG( "StreamProfileTuner: %s sustained " PROFILE_FORMAT " %i times, trying a step up",
+						app, PROFILE_ARGS( history.Profile ), history.CleanSessions );
+			}
+			else
+			{
+				LOG( "StreamProfileTuner: %s sustained " PROFILE_FORMAT " last time", app, PROFILE_ARGS( history.Profile ) );
+			}
+		}
+		else if ( ReadHistory( "Host.", history ) )
+		{
+			rung = FindRung( history.Profile );
+			LOG( "StreamProfileTuner: %s is new, %s last sustained " PROFILE_FORMAT, app, host, PROFILE_ARGS( history.Profile ) );
+		}
+		else if ( HostHistory != NULL && HostHistory->GetVal( "Host.LossPercent", &hostLoss ) && hostLoss > LOSS_LIMIT * 100.0 )
+		{
+			Rung = 0;
+			rung = FindLower( false );
+			rung = ( rung < 0 ) ? 0 : rung;
+			LOG( "StreamProfileTuner: %s loses %.1f%% of frames, starting with less bitrate", host, hostLoss );
+		}
+		else if ( remote )
+		{
+			while ( rung < Ladder.GetSizeI() - 1 && Ladder[rung].Bitrate > REMOTE_START_BITRATE )
+			{
+				rung++;
+			}
+			LOG( "StreamProfileTuner: %s is remote with no history, starting at %ikbps or less", host, REMOTE_START_BITRATE );
+		}
+	}
+
+	Active = true;
+	StartRung( rung );
+	LOG( "StreamProfileTuner: %s on %s as " PROFILE_FORMAT ", asked for " PROFILE_FORMAT,
+			app, host, PROFILE_ARGS( Ladder[Rung] ), PROFILE_ARGS( Ladder[0] ) );
+	return Ladder[Rung];
+}
+
+bool StreamProfileTuner::Update( const StreamStats & stats, const double nowSeconds, StreamProfile & profile )
+{
+	if ( !Active )
+	{
+		return false;
+	}
+
+	// A restarted stream counts from zero again
+	if ( !HaveLast || stats.SubmittedFrames < Last.SubmittedFrames || stats.DecodedFrames < Last.DecodedFrames ||
+			stats.CompleteFrames < Last.CompleteFrames || stats.DroppedFrames < Last.DroppedFrames )
+	{
+		Last = stats;
+		HaveLast = true;
+		LastSeconds = nowSeconds;
+		if ( RungStartSeconds < 0.0 )
+		{
+			RungStartSeconds = nowSeconds;
+		}
+		return false;
+	}
+
+	const double seconds = nowSeconds - LastSeconds;
+	if ( seconds < SAMPLE_SECONDS * 0.5 )
+	{
+		return false;
+	}
+
+	const int submitted = stats.SubmittedFrames - Last.SubmittedFrames;
+	const int decoded = stats.DecodedFrames - Last.DecodedFrames;
+	const int complete = stats.CompleteFrames - Last.CompleteFrames;
+	const int dropped = stats.DroppedFrames - Last.DroppedFrames;
+	Last = stats;
+	LastSeconds = nowSeconds;
+
+	// Nothing coming in is a paused or starting stream, not a bad one
+	if ( nowSeconds - RungStartSeconds < GRACE_SECONDS || ( submitted == 0 && decoded == 0 && dropped == 0 ) )
+	{
+		return false;
+	}
+
+	const StreamProfile & current = Ladder[Rung];
+	const double loss = ( complete + dropped > 0 ) ? (double)dropped / ( complete + dropped ) : 0.0;
+	int bad = 0;
+	bad |= ( loss > LOSS_LIMIT ) ? BAD_LOSS : 0;
+	bad |= ( submitted > decoded ) ? BAD_BACKLOG : 0;
+
+	JudgedSeconds += seconds;
+	JudgedFrames += complete + dropped;
+	JudgedDropped += dropped;
+	SessionFrames += complete + dropped;
+	SessionDropped += dropped;
+
+#ifndef NDEBUG
+	if ( Trace != NULL )
+	{
+		// What limited the stream, as far as a second's counters tell
+		const int capacity = ( bad & BAD_LOSS ) ? (int)( current.Bitrate * ( 1.0 - loss ) ) : 0;
+		const double decodeRate = ( bad & BAD_BACKLOG ) ? decoded / seconds * current.Width * current.Height / 1000000.0 : 0.0;
+		fprintf( Trace, "%i %.2f %.1f\n", capacity, ( bad & BAD_LOSS ) ? 0.0 : loss * 100.0, decodeRate );
+	}
+#endif
+
+	Window[WindowNext] = bad;
+	WindowFrames[WindowNext] = complete + dropped;
+	WindowDropped[WindowNext] = dropped;
+	WindowQueued[WindowNext] = submitted - decoded;
+	WindowNext = ( WindowNext + 1 ) % WINDOW_SAMPLES;
+	WindowCount = ( WindowCount < WINDOW_SAMPLES ) ? WindowCount + 1 : WINDOW_SAMPLES;
+
+	int lossSamples = 0;
+	int backlogSamples = 0;
+	int windowFrames = 0;
+	int windowDropped = 0;
+	int windowQueued = 0;
+	for ( int i = 0; i < WindowCount; i++ )
+	{
+		lossSamples += ( Window[i] & BAD_LOSS ) ? 1 : 0;
+		backlogSamples += ( Window[i] & BAD_BACKLOG ) ? 1 : 0;
+		windowFrames += WindowFrames[i];
+		windowDropped += WindowDropped[i];
+		windowQueued += WindowQueued[i];
+	}
+	// At a low frame rate one lost frame is a bad second, so loss also has to add up
+	const double windowLoss = ( windowFrames > 0 ) ? (double)windowDropped / windowFrames : 0.0;
+	if ( windowLoss <= LOSS_LIMIT )
+	{
+		lossSamples = 0;
+	}
+	// A second's queue wobbles with when frames come in, so it has to keep growing
+	if ( windowQueued <= BACKLOG_LIMIT )
+	{
+		backlogSamples = 0;
+	}
+	BacklogSeconds += ( backlogSamples > 0 && ( bad & BAD_BACKLOG ) ) ? seconds : 0.0;
+	int badSamples = 0;
+	for ( int i = 0; i < WindowCount; i++ )
+	{
+		badSamples += ( ( backlogSamples > 0 && ( Window[i] & BAD_BACKLOG ) ) || ( lossSamples > 0 && ( Window[i] & BAD_LOSS ) ) ) ? 1 : 0;
+	}
+	if ( badSamples < BAD_SAMPLES )
+	{
+		return false;
+	}
+
+	// A decoder that can't keep up needs fewer pixels, a link that can't needs fewer bits
+	const bool decoderBound = backlogSamples >= lossSamples;
+	int lower = FindLower( decoderBound );
+	if ( lower < 0 )
+	{
+		lower = FindLower( !decoderBound );
+	}
+	if ( lower < 0 )
+	{
+		LOG( "StreamProfileTuner: " PROFILE_FORMAT " is losing %.1f%% of frames with %i more queued, but is as low as it goes",
+				PROFILE_ARGS( current ), windowLoss * 100.0, windowQueued );
+		WindowCount = 0;
+		return false;
+	}
+
+	LOG( "StreamProfileTuner: " PROFILE_FORMAT " lost %.1f%% of frames with %i more queued in %i of %i seconds (%s), stepping down to " PROFILE_FORMAT,
+			PROFILE_ARGS( current ), windowLoss * 100.0, windowQueued, badSamples, WindowCount,
+			decoderBound ? "decoder backlog" : "frame loss", PROFILE_ARGS( Ladder[lower] ) );
+	Downshifts++;
+	StartRung( lower );
+	profile = Ladder[Rung];
+	return true;
+}
+
+void StreamProfileTuner::End()
+{
+	if ( !Active )
+	{
+		return;
+	}
+	Active = false;
+
+	const StreamProfile & current = Ladder[Rung];
+	const double loss = ( JudgedFrames > 0 ) ? (double)JudgedDropped / JudgedFrames : 0.0;
+	const bool sustained = JudgedSeconds >= SUSTAIN_SECONDS && loss <= LOSS_LIMIT && BacklogSeconds < JudgedSeconds * 0.1;
+	const String appPrefix = String( "App." ) + AppName + ".";
+
+	History history;
+	history.Profile = current;
+	history.CleanSessions = sustained ? 1 : 0;
+	if ( Downshifts > 0 )
+	{
+		LOG( "StreamProfileTuner: remembering " PROFILE_FORMAT " for %s on %s after %i steps down",
+				PROFILE_ARGS( current ), AppName.ToCStr(), HostName.ToCStr(), Downshifts );
+	}
+	else if ( sustained )
+	{
+		History previous;
+		if ( ReadHistory( appPrefix.ToCStr(), previous ) && previous.Profile == current )
+		{
+			history.CleanSessions = previous.CleanSessions + 1;
+		}
+		LOG( "StreamProfileTuner: %s on %s sustained " PROFILE_FORMAT " for %.0f seconds, %i sessions in a row",
+				AppName.ToCStr(), HostName.ToCStr(), PROFILE_ARGS( current ), JudgedSeconds, history.CleanSessions );
+	}
+	else if ( JudgedSeconds < SUSTAIN_SECONDS )
+	{
+		LOG( "StreamProfileTuner: %.0f seconds of " PROFILE_FORMAT " is too little to go by",
+				JudgedSeconds, PROFILE_ARGS( current ) );
+	}
+	else
+	{
+		LOG( "StreamProfileTuner: " PROFILE_FORMAT " lost %.1f%% of frames and was backlogged for %.0f of %.0f seconds, not remembering it",
+				PROFILE_ARGS( current ), loss * 100.0, BacklogSeconds, JudgedSeconds );
+	}
+
+	if ( HostHistory != NULL )
+	{
+		if ( Downshifts > 0 || sustained )
+		{
+			WriteHistory( appPrefix.ToCStr(), history );
+			WriteHistory( "Host.", history );
+		}
+		if ( SessionFrames > 0 )
+		{
+			double hostLoss = 0.0;
+			const double sessionLoss = 100.0 * SessionDropped / SessionFrames;
+			hostLoss = HostHistory->GetVal( "Host.LossPercent", &hostLoss ) ? hostLoss * 0.7 + sessionLoss * 0.3 : sessionLoss;
+			HostHistory->SetVal( "Host.LossPercent", hostLoss );
+		}
+		HostHistory->Save();
+		delete HostHistory;
+		HostHistory = NULL;
+	}
+}
+
+#ifndef NDEBUG
+void StreamProfileTuner::RecordTrace( const char * path )
+{
+	if ( Trace != NULL )
+	{
+		fclose( Trace );
+		Trace = NULL;
+	}
+	if ( path != NULL )
+	{
+		Trace = fopen( path, "a" );
+		if ( Trace == NULL )
+		{
+			LOG( "StreamProfileTuner: can't record a trace to %s", path );
+		}
+	}
+}
+
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+struct LinkSecond
+{
+	int					Capacity;		// kbps, 0 for no limit
+	double				LossPercent;	// random packet loss
+	double				DecodeRate;		// megapixels per second, 0 for no limit
+};
+
+struct SimulatedLink
+{
+	const char *		Host;
+	const char *		Name;		// of the app
+	bool				Remote;
+	Array< LinkSecond >	Seconds;
+};
+
+struct SimulatedSession
+{
+	StreamProfile		Launch;
+	StreamProfile		Final;
+	int					Downshifts;
+	int					LostFrames;
+	int					BacklogSeconds;
+	double				Megapixels;
+};
+
+static void AddSeconds( SimulatedLink & link, const int count, const int capacity, const double lossPercent, const double decodeRate )
+{
+	const LinkSecond second = { capacity, lossPercent, decodeRate };
+	for ( int i = 0; i < count; i++ )
+	{
+		link.Seconds.PushBack( second );
+	}
+}
+
+static bool ReadTrace( const char * path, SimulatedLink & link )
+{
+	FILE * f = fopen( path, "r" );
+	if ( f == NULL )
+	{
+		return false;
+	}
+	char line[256];
+	while ( fgets( line, sizeof( line ), f ) != NULL )
+	{
+		LinkSecond second;
+		if ( line[0] != '#' && sscanf( line, "%i %lf %lf", &second.Capacity, &second.LossPercent, &second.DecodeRate ) == 3 )
+		{
+			link.Seconds.PushBack( second );
+		}
+	}
+	fclose( f );
+	return link.Seconds.GetSizeI() > 0;
+}
+
+// The stream over the link a second at a time: bitrate over capacity loses that share
+// of frames, FEC hides about half the random loss, and frames the decoder can't get
+// through wait in its queue. The decoder always holds on to DECODER_HELD frames, more
+// than a backlog, so only a queue that grows counts. A step down costs RESTART_SECONDS
+// of nothing.
+static SimulatedSession SimulateSession( StreamProfileTuner & tuner, const SimulatedLink & link, const StreamProfile & target )
+{
+	static const int RESTART_SECONDS = 2;
+	static const int DECODER_HELD = StreamProfileTuner::BACKLOG_LIMIT + 2;
+
+	SimulatedSession session;
+	memset( &session, 0, sizeof( session ) );
+	StreamProfile profile = tuner.Begin( link.Host, link.Name, link.Remote, target, STREAM_TUNING_FROM_HISTORY );
+	session.Launch = profile;
+
+	StreamStats stats;
+	memset( &stats, 0, sizeof( stats ) );
+	double lossCarry = 0.0;
+	double decodeCarry = 0.0;
+	int restarting = 0;
+	for ( int t = 0; t < link.Seconds.GetSizeI(); t++ )
+	{
+		const LinkSecond & second = link.Seconds[t];
+		if ( restarting > 0 )
+		{
+			restarting--;
+		}
+		else
+		{
+			const double congestion = ( second.Capacity > 0 && profile.Bitrate > second.Capacity ) ?
+					(double)( profile.Bitrate - second.Capacity ) / profile.Bitrate : 0.0;
+			const double frameLoss = ( congestion + second.LossPercent / 200.0 < 1.0 ) ? congestion + second.LossPercent / 200.0 : 1.0;
+			lossCarry += profile.FPS * frameLoss;
+			const int dropped = (int)lossCarry;
+			lossCarry -= dropped;
+			const int complete = profile.FPS - dropped;
+
+			const double pixels = (double)profile.Width * profile.Height;
+			decodeCarry += ( second.DecodeRate > 0.0 ) ? second.DecodeRate * 1000000.0 / pixels : 1000000.0;
+			const int queued = stats.SubmittedFrames - stats.DecodedFrames + complete - DECODER_HELD;
+			const int decoded = ( decodeCarry < queued ) ? (int)decodeCarry : ( queued > 0 ? queued : 0 );
+			decodeCarry = ( second.DecodeRate > 0.0 ) ? decodeCarry - decoded : 0.0;
+
+			stats.CompleteFrames += complete;
+			stats.DroppedFrames += dropped;
+			stats.SubmittedFrames += complete;
+			stats.DecodedFrames += decoded;
+			stats.DecoderTimeMs += decoded * 8;
+
+			session.LostFrames += dropped;
+			session.BacklogSeconds += ( stats.SubmittedFrames - stats.DecodedFrames - DECODER_HELD > StreamProfileTuner::BACKLOG_LIMIT ) ? 1 : 0;
+			session.Megapixels += decoded * pixels / 1000000.0;
+		}
+
+		if ( tuner.Update( stats, t + 1.0, profile ) )
+		{
+			session.Downshifts++;
+			memset( &stats, 0, sizeof( stats ) );
+			lossCarry = 0.0;
+			decodeCarry = 0.0;
+			restarting = RESTART_SECONDS;
+		}
+	}
+	session.Final = profile;
+	tuner.End();
+
+	LOG( "StreamProfileTunerSimulate: %s launched " PROFILE_FORMAT ", ended " PROFILE_FORMAT ", %i steps down, "
+			"%i frames lost, %i seconds backlogged, %.1f megapixels/s shown",
+			link.Name, PROFILE_ARGS( session.Launch ), PROFILE_ARGS( session.Final ), session.Downshifts,
+			session.LostFrames, session.BacklogSeconds, session.Megapixels / link.Seconds.GetSizeI() );
+	return session;
+}
+
+static void RemoveHistory( const char * directory, const char * host )
+{
+	char path[PATH_MAX];
+	snprintf( path, sizeof( path ), "%sstreamprofile.host.%s.json", directory, host );
+	Settings::RemoveFile( path );
+}
+
+void StreamProfileTunerSimulate( const char * directory, const char * tracePath )
+{
+	static const int LAUNCHES = 3;
+	static const StreamProfile target = { 1920, 1080, 60, 0 };
+
+	StreamProfileTuner tuner;
+	tuner.SetDirectory( directory );
+
+	if ( tracePath != NULL )
+	{
+		SimulatedLink link;
+		link.Host = "SimulatedTrace";
+		link.Name = tracePath;
+		link.Remote = false;
+		if ( !ReadTrace( tracePath, link ) )
+		{
+			LOG( "StreamProfileTunerSimulate: no trace in %s", tracePath );
+			return;
+		}
+		RemoveHistory( directory, link.Host );
+		for ( int i = 0; i < LAUNCHES; i++ )
+		{
+			SimulateSession( tuner, link, target );
+		}
+		RemoveHistory( directory, link.Host );
+	}
+	else
+	{
+		// Each on a host of its own, so one's history doesn't start the next
+		SimulatedLink clean;
+		clean.Host = "SimulatedLAN";
+		clean.Name = "CleanLAN";
+		clean.Remote = false;
+		AddSeconds( clean, 120, 0, 0.1, 0.0 );
+
+		SimulatedLink congested;
+		congested.Host = "SimulatedWiFi";
+		congested.Name = "CongestedWiFi";
+		congested.Remote = false;
+		AddSeconds( congested, 30, 0, 0.2, 0.0 );
+		AddSeconds( congested, 90, 8000, 0.2, 0.0 );
+
+		SimulatedLink recovered = clean;
+		recovered.Host = congested.Host;
+		recovered.Name = congested.Name;
+
+		SimulatedLink slowDecoder;
+		slowDecoder.Host = "SimulatedDecoder";
+		slowDecoder.Name = "SlowDecoder";
+		slowDecoder.Remote = false;
+		AddSeconds( slowDecoder, 120, 0, 0.1, 80.0 );
+
+		SimulatedLink remote;
+		remote.Host = "SimulatedRemote";
+		remote.Name = "LossyRemote";
+		remote.Remote = true;
+		AddSeconds( remote, 120, 12000, 3.0, 0.0 );
+
+		const char * hosts[] = { clean.Host, congested.Host, slowDecoder.Host, remote.Host };
+		for ( int i = 0; i < 4; i++ )
+		{
+			RemoveHistory( directory, hosts[i] );
+		}
+
+		LOG( "StreamProfileTunerSimulate: a clean link keeps what was asked for" );
+		for ( int i = 0; i < LAUNCHES; i++ )
+		{
+			const SimulatedSession session = SimulateSession( tuner, clean, target );
+			assert( session.Downshifts == 0 && session.Final.Height == 1080 && session.Final.FPS == 60 );
+		}
+
+		LOG( "StreamProfileTunerSimulate: congestion steps bitrate down, and the next launch starts there" );
+		SimulatedSession session = SimulateSession( tuner, congested, target );
+		assert( session.Downshifts > 0 && session.Final.Bitrate <= 8000 );
+		const StreamProfile learned = session.Final;
+		session = SimulateSession( tuner, congested, target );
+		assert( session.Launch == learned && session.Downshifts == 0 );
+
+		LOG( "StreamProfileTunerSimulate: once the link is clean again, it tries a step up" );
+		bool probed = false;
+		for ( int i = 0; i <= StreamProfileTuner::PROBE_SESSIONS && !probed; i++ )
+		{
+			session = SimulateSession( tuner, recovered, target );
+			probed = ( session.Launch != learned );
+		}
+		assert( probed && learned.Within( session.Launch ) && session.Downshifts == 0 );
+
+		LOG( "StreamProfileTunerSimulate: a slow decoder steps down pixels, not just bits" );
+		session = SimulateSession( tuner, slowDecoder, target );
+		assert( session.Downshifts > 0 && session.Final.PixelRate() <= 80000000.0 );
+		for ( int i = 1; i < LAUNCHES; i++ )
+		{
+			session = SimulateSession( tuner, slowDecoder, target );
+			assert( session.Downshifts == 0 && session.BacklogSeconds == 0 );
+		}
+
+		LOG( "StreamProfileTunerSimulate: a remote host starts low and stays under its capacity" );
+		session = SimulateSession( tuner, remote, target );
+		assert( session.Launch.Bitrate <= StreamProfileTuner::REMOTE_START_BITRATE );
+		assert( session.Final.Bitrate <= 12000 );
+
+		for ( int i = 0; i < 4; i++ )
+		{
+			RemoveHistory( directory, hosts[i] );
+		}
+	}
+
+	Settings::FlushWrites();
+	LOG( "StreamProfileTunerSimulate done" );
+}
+#endif
+
+} // namespace VRMatterStreamTheater
@@ -0,0 +1,193 @@
+/************************************************************************************
+
+Filename    :   StreamProfileTuner.h
+Content     :	Picks the stream's resolution, frame rate and bitrate per host and app.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#if !defined( StreamProfileTuner_h )
+#define StreamProfileTuner_h
+
+#include <stdio.h>
+
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_String.h"
+
+using namespace OVR;
+
+namespace VRMatterStreamTheater {
+
+class Settings;
+
+struct StreamProfile
+{
+	int					Width;
+	int					Height;
+	int					FPS;
+	int					Bitrate;	// kbps
+
+	bool				operator==( const StreamProfile & other ) const;
+	bool				operator!=( const StreamProfile & other ) const { return !( *this == other ); }
+	// No more of anything than other
+	bool				Within( const StreamProfile & other ) const;
+	double				PixelRate() const { return (double)Width * Height * FPS; }
+};
+
+// What the stream has done since it started, as counted by the decoder.
+// Counters start over when the stream is restarted.
+struct StreamStats
+{
+	int					SubmittedFrames;	// pictures handed to the decoder, not parameter sets
+	int					DecodedFrames;
+	int					DecoderTimeMs;		// from submitting frames to their output, summed
+	int					CompleteFrames;
+	int					DroppedFrames;		// never completed, lost to the network
+};
+
+enum StreamTuning
+{
+	STREAM_TUNING_OFF,			// stream exactly what was asked for
+	STREAM_TUNING_FROM_TARGET,	// start with what was asked for, step down if it can't keep up
+	STREAM_TUNING_FROM_HISTORY	// start with what kept up last time, step down if it can't keep up
+};
+
+// Chooses what to stream for the profile the user picked, which it never
+// goes over. It remembers per host, and per app on that host, the best
+// profile a session sustained the frame rate of without sustained frame loss
+// or decoder backlog, and launches with that. Once a profile has held up for
+// a few sessions in a row the next one tries a step up. During a session the
+// stream's counters are sampled every second; when enough of the last few
+// seconds had lost frames or a backlog, it steps down: to less bitrate for
+// loss, to fewer pixels per second for a decoder that can't keep up.
+// Every decision is logged with why it was made.
+class StreamProfileTuner
+{
+public:
+	static const double	SAMPLE_SECONDS;
+	// Startup after a (re)start isn't judged
+	static const double	GRACE_SECONDS;
+	// A session this long that didn't step down sustained its profile
+	static const double	SUSTAIN_SECONDS;
+	// Bad seconds out of the last WINDOW_SAMPLES that make a step down,
+	// for loss only if those seconds together lost more than LOSS_LIMIT
+	static const int	WINDOW_SAMPLES = 6;
+	static const int	BAD_SAMPLES = 4;
+	// Frame loss a second may have and still be good, and how many frames
+	// the decoder's queue may grow by over the window before it's backlogged
+	static const double	LOSS_LIMIT;
+	static const int	BACKLOG_LIMIT = 4;
+	// Clean sessions in a row before launching a step up
+	static const int	PROBE_SESSIONS = 3;
+	// Remote hosts without history start at no more than this
+	static const int	REMOTE_START_BITRATE = 10000;
+
+						StreamProfileTuner();
+						~StreamProfileTuner();
+
+	// Where the per host history files go, with a trailing slash
+	void				SetDirectory( const char * directory );
+
+	// Ends any session going on and starts one for target, returns the profile to stream
+	StreamProfile		Begin( const char * host, const char * app, const bool remote, const StreamProfile & target, const StreamTuning tuning );
+	// Takes the stream's counters at nowSeconds, every SAMPLE_SECONDS or so.
+	// returns true when the stream should reconnect as profile, a step down.
+	bool				Update( const StreamStats & stats, const double nowSeconds, StreamProfile & profile );
+	// Remembers how the session went
+	void				End();
+
+	bool				IsActive() const { return Active; }
+	const StreamProfile &	GetProfile() const { return Ladder[Rung]; }
+
+	// The bitrate the stream uses for a height and frame rate when none is given
+	static int			DefaultBitrate( const int height, const int fps );
+
+#ifndef NDEBUG
+	// Appends every judged second to path from now on, as a trace
+	// StreamProfileTunerSimulate can read. NULL stops recording.
+	void				RecordTrace( const char * path );
+#endif
+
+private:
+	struct History
+	{
+		StreamProfile	Profile;
+		int				CleanSessions;
+	};
+
+	enum
+	{
+		BAD_LOSS	= 1,
+		BAD_BACKLOG	= 2
+	};
+
+	String				Directory;
+	Settings *			HostHistory;
+	String				HostName;
+	String				AppName;
+	bool				Active;
+
+	// The target, then each step down from it, best first
+	Array< StreamProfile >	Ladder;
+	int					Rung;
+	int					Downshifts;
+
+	StreamStats			Last;
+	bool				HaveLast;
+	double				LastSeconds;
+	double				RungStartSeconds;
+	// At the current rung
+	double				JudgedSeconds;
+	double				BacklogSeconds;
+	int					JudgedFrames;		// complete and dropped
+	int					JudgedDropped;
+	// The last few seconds, what was wrong with each and its frames
+	int					Window[WINDOW_SAMPLES];
+	int					WindowFrames[WINDOW_SAMPLES];
+	int					WindowDropped[WINDOW_SAMPLES];
+	int					WindowQueued[WINDOW_SAMPLES];	// submitted less decoded
+	int					WindowNext;
+	int					WindowCount;
+	// Over the whole session, for the host's history
+	int					SessionFrames;
+	int					SessionDropped;
+
+	FILE *				Trace;
+
+private:
+	void				BuildLadder( const StreamProfile & target );
+	// The best rung within profile, or the last rung if none is
+	int					FindRung( const StreamProfile & profile ) const;
+	// The next rung down that lowers bitrate, or pixel rate, -1 if none does
+	int					FindLower( const bool lessPixels ) const;
+	// For a (re)started stream, judged from its first sample on
+	void				StartRung( const int rung );
+
+	bool				ReadHistory( const char * prefix, History & history ) const;
+	void				WriteHistory( const char * prefix, const History & history );
+
+private:
+	// not copyable
+						StreamProfileTuner( const StreamProfileTuner & );
+	StreamProfileTuner &	operator=( const StreamProfileTuner & );
+};
+
+#ifndef NDEBUG
+// Streams each second of a trace through the tuner, launching the same app
+// a few times so its history comes into play, and logs what it picked and
+// how the stream would have done. A trace is a line per second of
+// "capacityKbps lossPercent decodeMegapixelsPerSecond", 0 for no limit, with
+// # comments. A NULL tracePath runs a set of made up links instead.
+// History files go in directory, and are removed after.
+void StreamProfileTunerSimulate( const char * directory, const char * tracePath );
+#endif
+
+} // namespace VRMatterStreamTheater
+
+#endif // StreamProfileTuner_h
@@ -48,21 +48,21 @@ void UILabel::SetText( const char *text )
 {
 	VRMenuObject * object = GetMenuObject();
 	assert( object );
-	object->SetText( text );
+	Cinema.TextCache.SetText( object, text );
 }
 
 void UILabel::SetText( const String &text )
 {
 	VRMenuObject * object = GetMenuObject();
 	assert( object );
-	object->SetText( text.ToCStr() );
+	Cinema.TextCache.SetText( object, text.ToCStr() );
 }
 
 void UILabel::SetTextWordWrapped( char const * text, class BitmapFont const & font, float const widthInMeters )
 {
 	VRMenuObject * object = GetMenuObject();
 	assert( object );
-	object->SetTextWordWrapped( text, font, widthInMeters );
+	Cinema.TextCache.SetTextWordWrapped( object, text, font, widthInMeters );
 }
 
 const String & UILabel::GetText() const
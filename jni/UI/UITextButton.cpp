@@ -131,21 +131,21 @@ void UITextButton::SetText( const char *text )
 {
 	VRMenuObject * object = GetMenuObject();
 	assert( object );
-	object->SetText( text );
+	Cinema.TextCache.SetText( object, text );
 }
 
 void UITextButton::SetText( const String &text )
 {
 	VRMenuObject * object = GetMenuObject();
 	assert( object );
-	object->SetText( text.ToCStr() );
+	Cinema.TextCache.SetText( object, text.ToCStr() );
 }
 
 void UITextButton::SetTextWordWrapped( char const * text, class BitmapFont const & font, float const widthInMeters )
 {
 	VRMenuObject * object = GetMenuObject();
 	assert( object );
-	object->SetTextWordWrapped( text, font, widthInMeters );
+	Cinema.TextCache.SetTextWordWrapped( object, text, font, widthInMeters );
 }
 
 const String & UITextButton::GetText() const
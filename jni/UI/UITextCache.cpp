@@ -0,0 +1,176 @@
+/************************************************************************************
+
+Filename    :   UITextCache.cpp
+Content     :	Keeps menu text from being laid out and rebuilt when it didn't change.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#include "UI/UITextCache.h"
+
+#include <string.h>
+
+#include "VRMenu/VRMenuObject.h"
+
+namespace VRMatterStreamTheater {
+
+static void ResetStats( UITextCacheStats & stats )
+{
+	memset( &stats, 0, sizeof( stats ) );
+}
+
+UITextCache::UITextCache( const int budgetBytes ) :
+	BudgetBytes( budgetBytes ),
+	UsedBytes( 0 ),
+	UseCount( 0 ),
+	Layouts()
+
+{
+	ResetStats( Frame );
+	ResetStats( LastFrame );
+	ResetStats( Total );
+}
+
+// FNV-1a over the text, then the rest of the key
+unsigned UITextCache::HashOf( const char * text, const void * font, const float scale, const float width )
+{
+	unsigned hash = 2166136261u;
+	for ( const unsigned char * c = (const unsigned char *)text; *c != 0; c++ )
+	{
+		hash = ( hash ^ *c ) * 16777619u;
+	}
+	const float parms[2] = { scale, width };
+	const unsigned char * bytes = (const unsigned char *)parms;
+	for ( int i = 0; i < (int)sizeof( parms ); i++ )
+	{
+		hash = ( hash ^ bytes[i] ) * 16777619u;
+	}
+	return hash ^ (unsigned)( (size_t)font >> 4 );
+}
+
+int UITextCache::SizeOf( const Layout & layout )
+{
+	return sizeof( Layout ) + (int)layout.Text.GetSize() + (int)layout.Wrapped.GetSize() + 2;
+}
+
+int UITextCache::GlyphVertices( const char * text )
+{
+	int glyphs = 0;
+	for ( const char * c = text; *c != 0; c++ )
+	{
+		// UTF-8 continuation bytes are part of the glyph before them
+		if ( *c != ' ' && *c != '\n' && *c != '\t' && ( *c & 0xC0 ) != 0x80 )
+		{
+			glyphs++;
+		}
+	}
+	return glyphs * 4;
+}
+
+int UITextCache::Find( const unsigned hash, const char * text, const void * font, const float scale, const float width ) const
+{
+	for ( int i = 0; i < Layouts.GetSizeI(); i++ )
+	{
+		const Layout & layout = Layouts[i];
+		if ( layout.Hash == hash && layout.Font == font && layout.Scale == scale && layout.Width == width &&
+				strcmp( layout.Text.ToCStr(), text ) == 0 )
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+void UITextCache::Store( const unsigned hash, const char * text, const void * font, const float scale, const float width, const String & wrapped )
+{
+	Layout layout;
+	layout.Hash = hash;
+	layout.Text = text;
+	layout.Font = font;
+	layout.Scale = scale;
+	layout.Width = width;
+	layout.Wrapped = wrapped;
+	layout.LastUse = ++UseCount;
+
+	const int size = SizeOf( layout );
+	if ( size > BudgetBytes )
+	{
+		return;
+	}
+	while ( UsedBytes + size > BudgetBytes && Layouts.GetSizeI() > 0 )
+	{
+		int oldest = 0;
+		for ( int i = 1; i < Layouts.GetSizeI(); i++ )
+		{
+			if ( Layouts[i].LastUse < Layouts[oldest].LastUse )
+			{
+				oldest = i;
+			}
+		}
+		UsedBytes -= SizeOf( Layouts[oldest] );
+		Layouts.RemoveAt( oldest );
+		Frame.Evictions++;
+	}
+	Layouts.PushBack( layout );
+	UsedBytes += size;
+}
+
+void UITextCache::Apply( VRMenuObject * object, const char * text )
+{
+	if ( strcmp( object->GetText().ToCStr(), text ) == 0 )
+	{
+		Frame.Unchanged++;
+		return;
+	}
+	object->SetText( text );
+	Frame.GlyphVertices += GlyphVertices( text );
+}
+
+void UITextCache::SetText( VRMenuObject * object, const char * text )
+{
+	Apply( object, text );
+}
+
+void UITextCache::SetTextWordWrapped( VRMenuObject * object, const char * text, BitmapFont const & font, const float widthInMeters )
+{
+	const float scale = object->GetFontParms().Scale;
+	const unsigned hash = HashOf( text, &font, scale, widthInMeters );
+	const int index = Find( hash, text, &font, scale, widthInMeters );
+	if ( index >= 0 )
+	{
+		Frame.Hits++;
+		Layouts[index].LastUse = ++UseCount;
+		Apply( object, Layouts[index].Wrapped.ToCStr() );
+		return;
+	}
+
+	Frame.Misses++;
+	object->SetTextWordWrapped( text, font, widthInMeters );
+	Frame.GlyphVertices += GlyphVertices( object->GetText().ToCStr() );
+	Store( hash, text, &font, scale, widthInMeters, object->GetText() );
+}
+
+void UITextCache::EndFrame()
+{
+	LastFrame = Frame;
+	Total.Hits += Frame.Hits;
+	Total.Misses += Frame.Misses;
+	Total.Unchanged += Frame.Unchanged;
+	Total.GlyphVertices += Frame.GlyphVertices;
+	Total.Evictions += Frame.Evictions;
+	ResetStats( Frame );
+}
+
+void UITextCache::Clear()
+{
+	Layouts.Clear();
+	UsedBytes = 0;
+}
+
+} // namespace VRMatterStreamTheater
@@ -0,0 +1,92 @@
+/************************************************************************************
+
+Filename    :   UITextCache.h
+Content     :	Keeps menu text from being laid out and rebuilt when it didn't change.
+Created     :	10/19/2026
+Authors     :   Michael Grosse Huelsewiesche
+
+Copyright   :   Copyright 2026 VRMatter All Rights reserved.
+
+This source code is licensed under the GPL license found in the
+LICENSE file in the StreamTheater/ directory.
+
+*************************************************************************************/
+
+#if !defined( UITextCache_h )
+#define UITextCache_h
+
+#include "VRMenu/VRMenu.h"
+
+using namespace OVR;
+
+namespace VRMatterStreamTheater {
+
+struct UITextCacheStats
+{
+	int					Hits;			// word wrapped layouts reused
+	int					Misses;			// word wrapped layouts made
+	int					Unchanged;		// sets of the text an object already had
+	int					GlyphVertices;	// of text objects were given to rebuild, 4 a glyph
+	int					Evictions;
+};
+
+// Text labels and buttons set through here only hand a menu object text it
+// doesn't already have, since the font surface rebuilds the glyphs of any
+// text it's given. Word wrapping is remembered by text, font, font scale and
+// wrap width, so wrapped text that comes back, like a help page or error
+// opened again, is set already laid out. Layouts past the budget are dropped,
+// least recently used first.
+class UITextCache
+{
+public:
+	static const int	DEFAULT_BUDGET_BYTES = 64 * 1024;
+
+	explicit			UITextCache( const int budgetBytes = DEFAULT_BUDGET_BYTES );
+
+	void				SetText( VRMenuObject * object, const char * text );
+	void				SetTextWordWrapped( VRMenuObject * object, const char * text, BitmapFont const & font, const float widthInMeters );
+
+	// Starts counting the next frame
+	void				EndFrame();
+	// What the last whole frame did, and every frame before it together
+	const UITextCacheStats &	GetFrameStats() const { return LastFrame; }
+	const UITextCacheStats &	GetTotalStats() const { return Total; }
+	int					GetUsedBytes() const { return UsedBytes; }
+
+	void				Clear();
+
+private:
+	struct Layout
+	{
+		unsigned		Hash;
+		String			Text;
+		const void *	Font;
+		float			Scale;
+		float			Width;
+		String			Wrapped;
+		unsigned		LastUse;
+	};
+
+	int					BudgetBytes;
+	int					UsedBytes;
+	unsigned			UseCount;
+	Array< Layout >		Layouts;
+
+	UITextCacheStats	Frame;
+	UITextCacheStats	LastFrame;
+	UITextCacheStats	Total;
+
+private:
+	static unsigned		HashOf( const char * text, const void * font, const float scale, const float width );
+	static int			SizeOf( const Layout & layout );
+	static int			GlyphVertices( const char * text );
+
+	int					Find( const unsigned hash, const char * text, const void * font, const float scale, const float width ) const;
+	void				Store( const unsigned hash, const char * text, const void * font, const float scale, const float width, const String & wrapped );
+	// Hands object text it doesn't already have
+	void				Apply( VRMenuObject * object, const char * text );
+};
+
+} // namespace VRMatterStreamTheater
+
+#endif // UITextCache_h
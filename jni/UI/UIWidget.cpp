@@ -19,14 +19,28 @@ of patent rights can be found in the PATENTS file in the same directory.
 #include "VRMenu/GuiSys.h"
 #include "CinemaApp.h"
 
+#ifndef NDEBUG
+#include <assert.h>
+#include "UI/UIContainer.h"
+#endif
+
 namespace VRMatterStreamTheater {
 
+UIWidgetUpdateStats UIWidget::FrameUpdates = { 0, 0, 0, 0 };
+UIWidgetUpdateStats UIWidget::LastFrameUpdates = { 0, 0, 0, 0 };
+
 UIWidget::UIWidget( CinemaApp &cinema ) :
 	Cinema( cinema ),
 	Parent( NULL ),
 	Id(),
 	Handle(),
-	Object( NULL )
+	Object( NULL ),
+	Children(),
+	WorldDirty( true ),
+	WorldPose(),
+	WorldScale( 1.0f ),
+	WorldFromPose(),
+	WorldFromScale( 1.0f )
 
 {
 }
@@ -34,6 +48,21 @@ UIWidget::UIWidget( CinemaApp &cinema ) :
 UIWidget::~UIWidget()
 {
 	//DeletePointerArray( MovieBrowserItems );
+	if ( Parent != NULL )
+	{
+		for ( int i = 0; i < Parent->Children.GetSizeI(); i++ )
+		{
+			if ( Parent->Children[ i ] == this )
+			{
+				Parent->Children.RemoveAt( i );
+				break;
+			}
+		}
+	}
+	for ( int i = 0; i < Children.GetSizeI(); i++ )
+	{
+		Children[ i ]->Parent = NULL;
+	}
 }
 
 VRMenuObject * UIWidget::GetMenuObject() const
@@ -45,6 +74,11 @@ void UIWidget::AddToMenuWithParms( OvrGuiSys & guiSys, UIMenu *menu, UIWidget *p
 {
 	Menu = menu;
 	Parent = parent;
+	if ( parent != NULL )
+	{
+		parent->Children.PushBack( this );
+	}
+	MarkWorldDirty();
 
 	Id = parms.Id;
 
@@ -97,7 +131,7 @@ void UIWidget::SetLocalPose( const Posef &pose )
 {
 	VRMenuObject * object = GetMenuObject();
 	OVR_ASSERT( object );
-	if ( object != NULL )
+	if ( object != NULL && Propagate( !SamePose( object->GetLocalPose(), pose ), true ) )
 	{
 		object->SetLocalPose( pose );
 	}
@@ -107,7 +141,7 @@ void UIWidget::SetLocalPose( const Quatf &orientation, const Vector3f &position
 {
 	VRMenuObject * object = GetMenuObject();
 	OVR_ASSERT( object );
-	if ( object != NULL )
+	if ( object != NULL && Propagate( !SamePose( object->GetLocalPose(), Posef( orientation, position ) ), true ) )
 	{
 		object->SetLocalPose( Posef( orientation, position ) );
 	}
@@ -124,7 +158,7 @@ void UIWidget::SetLocalPosition( Vector3f const & pos )
 {
 	VRMenuObject * object = GetMenuObject();
 	OVR_ASSERT( object );
-	if ( object != NULL )
+	if ( object != NULL && Propagate( object->GetLocalPosition() != pos, true ) )
 	{
 		object->SetLocalPosition( pos );
 	}
@@ -141,7 +175,7 @@ void UIWidget::SetLocalRotation( Quatf const & rot )
 {
 	VRMenuObject * object = GetMenuObject();
 	OVR_ASSERT( object );
-	if ( object != NULL )
+	if ( object != NULL && Propagate( object->GetLocalRotation() != rot, true ) )
 	{
 		object->SetLocalRotation( rot );
 	}
@@ -158,7 +192,7 @@ void UIWidget::SetLocalScale( Vector3f const & scale )
 {
 	VRMenuObject * object = GetMenuObject();
 	OVR_ASSERT( object );
-	if ( object != NULL )
+	if ( object != NULL && Propagate( object->GetLocalScale() != scale, true ) )
 	{
 		object->SetLocalScale( scale );
 	}
@@ -168,7 +202,7 @@ void UIWidget::SetLocalScale( float const & scale )
 {
 	VRMenuObject * object = GetMenuObject();
 	OVR_ASSERT( object );
-	if ( object != NULL )
+	if ( object != NULL && Propagate( object->GetLocalScale() != Vector3f( scale ), true ) )
 	{
 		object->SetLocalScale( Vector3f( scale ) );
 	}
@@ -181,74 +215,124 @@ Vector3f UIWidget::GetLocalScale() const
 	return object->GetLocalScale();
 }
 
-Posef UIWidget::GetWorldPose() const
+bool UIWidget::SamePose( const Posef & a, const Posef & b )
 {
-	VRMenuObject * object = GetMenuObject();
-	OVR_ASSERT( object );
-
-	Posef const & localPose = object->GetLocalPose();
+	return a.Position == b.Position && a.Orientation == b.Orientation;
+}
 
-	if ( Parent == NULL )
+bool UIWidget::Propagate( const bool changed, const bool transform )
+{
+	if ( changed )
 	{
-		return localPose;
+		FrameUpdates.Propagated++;
+		if ( transform )
+		{
+			MarkWorldDirty();
+		}
 	}
+	else
+	{
+		FrameUpdates.Skipped++;
+	}
+	return changed;
+}
 
-	Posef parentModelPose = Parent->GetWorldPose();
-	Vector3f parentScale = Parent->GetWorldScale();
-
-	Posef curModelPose;
-	curModelPose.Position = parentModelPose.Position + ( parentModelPose.Orientation * parentScale.EntrywiseMultiply( localPose.Position ) );
-	curModelPose.Orientation = localPose.Orientation * parentModelPose.Orientation;
+void UIWidget::EndFrame()
+{
+	LastFrameUpdates = FrameUpdates;
+	FrameUpdates.Propagated = 0;
+	FrameUpdates.Skipped = 0;
+	FrameUpdates.WorldComputed = 0;
+	FrameUpdates.WorldReused = 0;
+}
 
-	return curModelPose;
+// Stops at widgets already dirty, everything under them is too
+void UIWidget::MarkWorldDirty() const
+{
+	if ( WorldDirty )
+	{
+		return;
+	}
+	WorldDirty = true;
+	for ( int i = 0; i < Children.GetSizeI(); i++ )
+	{
+		Children[ i ]->MarkWorldDirty();
+	}
 }
 
-Vector3f UIWidget::GetWorldPosition() const
+// A clean widget answers from its cache without looking at its parents.
+// A dirty one works out its parent first, which is then clean for the
+// rest of the subtree.
+void UIWidget::GetWorldTransform( Posef & pose, Vector3f & scale ) const
 {
 	VRMenuObject * object = GetMenuObject();
 	OVR_ASSERT( object );
 
 	Posef const & localPose = object->GetLocalPose();
+	const Vector3f localScale = object->GetLocalScale();
 
-	if ( Parent == NULL )
+	if ( !WorldDirty && !( SamePose( localPose, WorldFromPose ) && localScale == WorldFromScale ) )
 	{
-		return localPose.Position;
+		MarkWorldDirty();
 	}
 
-	Posef parentModelPose = Parent->GetWorldPose();
-	Vector3f parentScale = Parent->GetWorldScale();
-
-	return parentModelPose.Position + ( parentModelPose.Orientation * parentScale.EntrywiseMultiply( localPose.Position ) );
-}
-
-Quatf UIWidget::GetWorldRotation() const
-{
-	VRMenuObject * object = GetMenuObject();
-	OVR_ASSERT( object );
+	if ( !WorldDirty )
+	{
+		FrameUpdates.WorldReused++;
+		pose = WorldPose;
+		scale = WorldScale;
+		return;
+	}
 
-	Quatf const & rotation = object->GetLocalRotation();
 	if ( Parent == NULL )
 	{
-		return rotation;
+		WorldPose = localPose;
+		WorldScale = localScale;
+	}
+	else
+	{
+		Posef parentModelPose;
+		Vector3f parentScale;
+		Parent->GetWorldTransform( parentModelPose, parentScale );
+
+		WorldPose.Position = parentModelPose.Position + ( parentModelPose.Orientation * parentScale.EntrywiseMultiply( localPose.Position ) );
+		WorldPose.Orientation = localPose.Orientation * parentModelPose.Orientation;
+		WorldScale = parentScale.EntrywiseMultiply( localScale );
 	}
 
-	return rotation * Parent->GetWorldRotation();
+	WorldDirty = false;
+	WorldFromPose = localPose;
+	WorldFromScale = localScale;
+	FrameUpdates.WorldComputed++;
+
+	pose = WorldPose;
+	scale = WorldScale;
 }
 
-Vector3f UIWidget::GetWorldScale() const
+Posef UIWidget::GetWorldPose() const
 {
-	VRMenuObject * object = GetMenuObject();
-	OVR_ASSERT( object );
+	Posef pose;
+	Vector3f scale;
+	GetWorldTransform( pose, scale );
+	return pose;
+}
 
-	Vector3f scale = object->GetLocalScale();
+Vector3f UIWidget::GetWorldPosition() const
+{
+	return GetWorldPose().Position;
+}
 
-	if ( Parent == NULL )
-	{
-		return scale;
-	}
+Quatf UIWidget::GetWorldRotation() const
+{
+	return GetWorldPose().Orientation;
+}
 
-	Vector3f parentScale = Parent->GetWorldScale();
-	return parentScale.EntrywiseMultiply( scale );
+Vector3f UIWidget::GetWorldScale() const
+{
+	Posef pose;
+	Vector3f scale;
+	GetWorldTransform( pose, scale );
+	return scale;
 }
 
 bool UIWidget::GetVisible() const
@@ -262,6 +346,10 @@ void UIWidget::SetVisible( const bool visible )
 {
 	VRMenuObject * object = GetMenuObject();
 	OVR_ASSERT( object );
+	if ( !Propagate( visible != ( ( object->GetFlags() & VRMENUOBJECT_DONT_RENDER ) == 0 ), false ) )
+	{
+		return;
+	}
 	if ( visible )
 	{
 		object->RemoveFlags( VRMENUOBJECT_DONT_RENDER );
@@ -421,7 +509,10 @@ void UIWidget::SetColor( Vector4f const & c )
 {
 	VRMenuObject * object = GetMenuObject();
 	assert( object );
-	object->SetColor( c );
+	if ( Propagate( object->GetColor() != c, false ) )
+	{
+		object->SetColor( c );
+	}
 }
 
 Vector4f const & UIWidget::GetColor() const
@@ -487,4 +578,51 @@ void UIWidget::SetLocalBoundsExpand( Vector3f const mins, Vector3f const & maxs
 	object->SetLocalBoundsExpand( mins, maxs );
 }
 
+#ifndef NDEBUG
+void UIWidgetUpdateTest( CinemaApp & cinema )
+{
+	OvrGuiSys & guiSys = cinema.GetGuiSys();
+	UIMenu menu( cinema );
+	menu.Create( "UIWidgetUpdateTest" );
+
+	UIContainer parent( cinema );
+	UIContainer child( cinema );
+	UIContainer sibling( cinema );
+	UIContainer siblingChild( cinema );
+	parent.AddToMenu( guiSys, &menu );
+	child.AddToMenu( guiSys, &menu, &parent );
+	sibling.AddToMenu( guiSys, &menu );
+	siblingChild.AddToMenu( guiSys, &menu, &sibling );
+
+	child.SetLocalPosition( Vector3f( 0.0f, 1.0f, 0.0f ) );
+	child.GetWorldPosition();
+	siblingChild.GetWorldPosition();
+	UIWidget::EndFrame();
+
+	LOG( "UIWidgetUpdateTest: moved parent" );
+	parent.SetLocalPosition( Vector3f( 2.0f, 0.0f, 0.0f ) );
+	const Vector3f moved = child.GetWorldPosition();
+	siblingChild.GetWorldPosition();
+	UIWidget::EndFrame();
+	UIWidgetUpdateStats updates = UIWidget::GetFrameUpdates();
+	LOG( "UIWidgetUpdateTest: %i propagated, %i skipped, %i computed, %i reused",
+			updates.Propagated, updates.Skipped, updates.WorldComputed, updates.WorldReused );
+	assert( updates.Propagated == 1 && updates.Skipped == 0 );
+	// The parent and child once each, the sibling's child from its cache
+	assert( updates.WorldComputed == 2 && updates.WorldReused == 1 );
+	assert( moved == Vector3f( 2.0f, 1.0f, 0.0f ) );
+
+	LOG( "UIWidgetUpdateTest: sibling set to what it has" );
+	sibling.SetLocalPosition( sibling.GetLocalPosition() );
+	child.GetWorldPosition();
+	siblingChild.GetWorldPosition();
+	UIWidget::EndFrame();
+	updates = UIWidget::GetFrameUpdates();
+	assert( updates.Propagated == 0 && updates.Skipped == 1 );
+	assert( updates.WorldComputed == 0 && updates.WorldReused == 2 );
+
+	LOG( "UIWidgetUpdateTest passed" );
+}
+#endif
+
 } // namespace VRMatterStreamTheater
@@ -26,6 +26,20 @@ class CinemaApp;
 class UIMenu;
 class UITexture;
 
+// Counted a frame at a time across all widgets
+struct UIWidgetUpdateStats
+{
+	int									Propagated;		// pose, scale, color and visibility changes handed to menu objects
+	int									Skipped;		// sets that changed nothing
+	int									WorldComputed;	// world transforms worked out again
+	int									WorldReused;
+};
+
+// Setters only hand their menu object a value it doesn't already have, so
+// views can set their state every frame without the menu system redoing
+// anything for it. Each widget keeps its world transform, and moving a
+// widget marks it and everything under it dirty, so asking for world
+// transforms only works out the moved subtrees again, once each.
 class UIWidget
 {
 public:
@@ -85,6 +99,10 @@ public:
 
 	void								SetLocalBoundsExpand( Vector3f const mins, Vector3f const & maxs );
 
+	// Starts counting the next frame's updates
+	static void							EndFrame();
+	static const UIWidgetUpdateStats &	GetFrameUpdates() { return LastFrameUpdates; }
+
 	void								AddComponent( VRMenuComponent * component );
 	void								RemoveComponent( VRMenuComponent * component ) ;
 	Array< VRMenuComponent* > const & 	GetComponentList() const;
@@ -101,8 +119,36 @@ protected:
 	VRMenuId_t 							Id;
 	menuHandle_t						Handle;
 	VRMenuObject *						Object;
+
+private:
+	Array< UIWidget * >					Children;
+
+	// The world transform as last worked out, and the local transform it was
+	// worked out from, which catches moves made on this widget's menu object
+	// directly. A dirty parent always has dirty children.
+	mutable bool						WorldDirty;
+	mutable Posef						WorldPose;
+	mutable Vector3f					WorldScale;
+	mutable Posef						WorldFromPose;
+	mutable Vector3f					WorldFromScale;
+
+	static UIWidgetUpdateStats			FrameUpdates;
+	static UIWidgetUpdateStats			LastFrameUpdates;
+
+private:
+	void								GetWorldTransform( Posef & pose, Vector3f & scale ) const;
+	void								MarkWorldDirty() const;
+	// Counts a set, returns changed. A changed transform dirties the subtree.
+	bool								Propagate( const bool changed, const bool transform );
+	static bool							SamePose( const Posef & a, const Posef & b );
 };
 
+#ifndef NDEBUG
+// Moves a parent and leaves its sibling be in a menu of its own that's never
+// opened, and checks the frame counts. Ends frames, so call it between them.
+void UIWidgetUpdateTest( CinemaApp & cinema );
+#endif
+
 } // namespace VRMatterStreamTheater
 
 #endif // UIMenu_h
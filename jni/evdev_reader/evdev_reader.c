@@ -5,44 +5,103 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/un.h>
 #include <fcntl.h>
 #include <linux/input.h>
 #include <unistd.h>
-#include <poll.h>
 #include <errno.h>
 #include <dirent.h>
-#include <pthread.h>
-#include <netinet/in.h>
-#include <netinet/tcp.h>
+#include <stddef.h>
 
 #include <android/log.h>
 
-#define EVDEV_MAX_EVENT_SIZE 24
-
 #define REL_X 0x00
 #define REL_Y 0x01
 #define KEY_Q 16
 #define BTN_LEFT 0x110
 #define BTN_GAMEPAD 0x130
 
+// Events pulled out of a device with a single read()
+#define EVENTS_PER_READ 64
+
+#define MAX_EPOLL_EVENTS 16
+
+// Wire protocol, in native byte order since both ends run on this device.
+// The stream starts with a hello, followed by frames. A frame carries
+// one device's events up to and including its SYN_REPORT, so the client
+// gets a whole report in one read.
+//
+//   hello: uint32 magic, uint16 version, uint16 flags
+//   frame: uint16 count, uint16 flags, count * { uint16 type, uint16 code, int32 value }
+#define EVDEV_PROTOCOL_MAGIC 0x46445645 // "EVDF"
+#define EVDEV_PROTOCOL_VERSION 1
+
+// Frame flags
+#define EVDEV_FRAME_MERGED 0x01 // REL_X/REL_Y of several reports were added together
+
+// A frame that grows past this without a SYN_REPORT is sent as it is
+#define MAX_FRAME_EVENTS 64
+
+#define OUT_BUFFER_SIZE 16384
+
+struct EvdevHello {
+    unsigned int magic;
+    unsigned short version;
+    unsigned short flags;
+};
+
+struct EvdevFrameHeader {
+    unsigned short count;
+    unsigned short flags;
+};
+
+struct EvdevFrameEvent {
+    unsigned short type;
+    unsigned short code;
+    int value;
+};
+
 struct DeviceEntry {
     struct DeviceEntry *next;
-    pthread_t thread;
     int fd;
     char devName[128];
+
+    // The report being collected until its SYN_REPORT
+    struct EvdevFrameEvent frame[MAX_FRAME_EVENTS];
+    int frameCount;
+    int frameIsMotion;
 };
 
+// Everything below is only touched by the main thread
 static struct DeviceEntry *DeviceListHead;
 static int grabbing = 1;
-static pthread_mutex_t DeviceListLock = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t SocketSendLock = PTHREAD_MUTEX_INITIALIZER;
 static int sock;
+static int epollFd;
+static int inotifyFd = -1;
+
+static int mergeMotion;
+
+// Frames waiting to be written to the client
+static unsigned char outBuffer[OUT_BUFFER_SIZE];
+static int outLength;
+
+// The last frame in outBuffer if it is pure motion that later motion
+// from the same device may still be added to, otherwise -1
+static int lastMotionOffset = -1;
+static struct DeviceEntry *lastMotionDevice;
 
 // This is a small executable that runs in a root shell. It reads input
 // devices and writes the evdev output packets to a socket. This allows
 // Moonlight to read input devices without having to muck with changing
 // device permissions or modifying SELinux policy (which is prevented in
 // Marshmallow anyway).
+//
+// All devices, the client socket and hotplug notifications for /dev/input
+// are waited on by a single epoll loop, so there are no per-device threads
+// and nothing to lock. Events that arrive together are read in bulk and
+// written to the socket with one send().
 
 #define test_bit(bit, array)    (array[bit/8] & (1<<(bit%8)))
 
@@ -62,114 +121,217 @@ static int hasKey(int fd, short key) {
     return test_bit(key, keyBitmask);
 }
 
-static void outputEvdevData(char *data, int dataSize) {
-    char packetBuffer[EVDEV_MAX_EVENT_SIZE + sizeof(dataSize)];
+static int sendAll(const void *data, int length) {
+    const unsigned char *ptr = data;
+    int ret;
+
+    // A partial send must be finished or the client would lose
+    // track of the frame boundaries
+    while (length > 0) {
+        ret = send(sock, ptr, length, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "send() failed: %d", errno);
+            return -1;
+        }
+
+        ptr += ret;
+        length -= ret;
+    }
+
+    return 0;
+}
+
+static int flushEvdevData(void) {
+    int length = outLength;
 
-    // Copy the full packet into our buffer
-    memcpy(packetBuffer, &dataSize, sizeof(dataSize));
-    memcpy(&packetBuffer[sizeof(dataSize)], data, dataSize);
+    outLength = 0;
+    lastMotionOffset = -1;
 
-    // Lock to prevent other threads from sending at the same time
-    pthread_mutex_lock(&SocketSendLock);
-    send(sock, packetBuffer, dataSize + sizeof(dataSize), 0);
-    pthread_mutex_unlock(&SocketSendLock);
+    return sendAll(outBuffer, length);
 }
 
-void* pollThreadFunc(void* context) {
-    struct DeviceEntry *device = context;
-    struct pollfd pollinfo;
-    int pollres, ret;
-    char data[EVDEV_MAX_EVENT_SIZE];
+static int isMotionEvent(const struct EvdevFrameEvent *event) {
+    return (event->type == EV_REL && (event->code == REL_X || event->code == REL_Y)) ||
+           (event->type == EV_SYN && event->code == SYN_REPORT);
+}
 
-    __android_log_print(ANDROID_LOG_INFO, "EvdevReader", "Polling /dev/input/%s", device->devName);
+static int emitFrame(struct DeviceEntry *device) {
+    struct EvdevFrameHeader header;
+    struct EvdevFrameEvent *events;
+    int frameSize;
+    int i;
 
-    if (grabbing) {
-        // Exclusively grab the input device (required to make the Android cursor disappear)
-        if (ioctl(device->fd, EVIOCGRAB, 1) < 0) {
-            __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
-                                "EVIOCGRAB failed for %s: %d", device->devName, errno);
-            goto cleanup;
-        }
-    }
+    if (mergeMotion && device->frameIsMotion) {
+        int deltaX = 0;
+        int deltaY = 0;
 
-    for (;;) {
-        do {
-            // Unwait every 250 ms to return to caller if the fd is closed
-            pollinfo.fd = device->fd;
-            pollinfo.events = POLLIN;
-            pollinfo.revents = 0;
-            pollres = poll(&pollinfo, 1, 250);
-        }
-        while (pollres == 0);
-
-        if (pollres > 0 && (pollinfo.revents & POLLIN)) {
-            // We'll have data available now
-            ret = read(device->fd, data, EVDEV_MAX_EVENT_SIZE);
-            if (ret < 0) {
-                __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
-                                    "read() failed: %d", errno);
-                goto cleanup;
-            }
-            else if (ret == 0) {
-                __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
-                                    "read() graceful EOF");
-                goto cleanup;
-            }
-            else if (grabbing) {
-                // Write out the data to our client
-                outputEvdevData(data, ret);
+        for (i = 0; i < device->frameCount; i++) {
+            if (device->frame[i].type == EV_REL) {
+                if (device->frame[i].code == REL_X) {
+                    deltaX += device->frame[i].value;
+                }
+                else {
+                    deltaY += device->frame[i].value;
+                }
             }
         }
-        else {
-            if (pollres < 0) {
-                __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
-                                    "poll() failed: %d", errno);
-            }
-            else {
-                __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
-                                    "Unexpected revents: %d", pollinfo.revents);
-            }
 
-            // Terminate this thread
-            goto cleanup;
+        if (lastMotionOffset >= 0 && lastMotionDevice == device) {
+            // Nobody has seen the previous report yet, so just add to it
+            // rather than sending the client another frame
+            header.flags = EVDEV_FRAME_MERGED;
+            memcpy(&outBuffer[lastMotionOffset] + offsetof(struct EvdevFrameHeader, flags),
+                   &header.flags, sizeof(header.flags));
+
+            events = (struct EvdevFrameEvent *)&outBuffer[lastMotionOffset + sizeof(header)];
+            events[0].value += deltaX;
+            events[1].value += deltaY;
+            return 0;
         }
+
+        // Motion frames always have the same layout so they can be merged into
+        device->frame[0].type = EV_REL;
+        device->frame[0].code = REL_X;
+        device->frame[0].value = deltaX;
+        device->frame[1].type = EV_REL;
+        device->frame[1].code = REL_Y;
+        device->frame[1].value = deltaY;
+        device->frame[2].type = EV_SYN;
+        device->frame[2].code = SYN_REPORT;
+        device->frame[2].value = 0;
+        device->frameCount = 3;
     }
 
-cleanup:
-    __android_log_print(ANDROID_LOG_INFO, "EvdevReader", "Closing /dev/input/%s", device->devName);
+    frameSize = sizeof(header) + device->frameCount * sizeof(device->frame[0]);
+    if (outLength + frameSize > OUT_BUFFER_SIZE && flushEvdevData() < 0) {
+        return -1;
+    }
 
-    // Remove the context from the linked list
-    {
-        struct DeviceEntry *lastEntry;
+    if (mergeMotion && device->frameIsMotion) {
+        lastMotionOffset = outLength;
+        lastMotionDevice = device;
+    }
+    else {
+        lastMotionOffset = -1;
+    }
+
+    header.count = device->frameCount;
+    header.flags = 0;
+    memcpy(&outBuffer[outLength], &header, sizeof(header));
+    memcpy(&outBuffer[outLength + sizeof(header)], device->frame,
+           device->frameCount * sizeof(device->frame[0]));
+    outLength += frameSize;
+
+    return 0;
+}
 
-        // Lock the device list
-        pthread_mutex_lock(&DeviceListLock);
+static int queueEvdevData(struct DeviceEntry *device, const struct input_event *events, int count) {
+    struct EvdevFrameEvent *frameEvent;
+    int i;
 
-        if (DeviceListHead == device) {
-            DeviceListHead = device->next;
+    for (i = 0; i < count; i++) {
+        if (device->frameCount == 0) {
+            device->frameIsMotion = 1;
         }
-        else {
-            lastEntry = DeviceListHead;
-            while (lastEntry->next != NULL) {
-                if (lastEntry->next == device) {
-                    lastEntry->next = device->next;
-                    break;
-                }
 
-                lastEntry = lastEntry->next;
+        // The client has no use for the time stamps
+        frameEvent = &device->frame[device->frameCount++];
+        frameEvent->type = events[i].type;
+        frameEvent->code = events[i].code;
+        frameEvent->value = events[i].value;
+
+        if (!isMotionEvent(frameEvent)) {
+            device->frameIsMotion = 0;
+        }
+
+        if ((events[i].type == EV_SYN && events[i].code == SYN_REPORT) ||
+                device->frameCount == MAX_FRAME_EVENTS) {
+            if (emitFrame(device) < 0) {
+                return -1;
+            }
+            device->frameCount = 0;
+        }
+    }
+
+    return 0;
+}
+
+static void closeDevice(struct DeviceEntry *device) {
+    struct DeviceEntry *lastEntry;
+
+    __android_log_print(ANDROID_LOG_INFO, "EvdevReader", "Closing /dev/input/%s", device->devName);
+
+    // Remove the context from the linked list
+    if (DeviceListHead == device) {
+        DeviceListHead = device->next;
+    }
+    else {
+        lastEntry = DeviceListHead;
+        while (lastEntry->next != NULL) {
+            if (lastEntry->next == device) {
+                lastEntry->next = device->next;
+                break;
             }
+
+            lastEntry = lastEntry->next;
         }
+    }
 
-        // Unlock device list
-        pthread_mutex_unlock(&DeviceListLock);
+    if (lastMotionDevice == device) {
+        // Don't merge into the frame of a device that's gone
+        lastMotionOffset = -1;
+        lastMotionDevice = NULL;
     }
 
     // Free the context
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, device->fd, NULL);
     ioctl(device->fd, EVIOCGRAB, 0);
     close(device->fd);
     free(device);
+}
+
+// Returns -1 if the socket failed, 1 if the device was closed, otherwise 0
+static int readDevice(struct DeviceEntry *device) {
+    struct input_event events[EVENTS_PER_READ];
+    int ret;
+
+    for (;;) {
+        ret = read(device->fd, events, sizeof(events));
+        if (ret < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Drained
+                return 0;
+            }
+            else if (errno == EINTR) {
+                continue;
+            }
+
+            __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
+                                "read() failed: %d", errno);
+            closeDevice(device);
+            return 1;
+        }
+        else if (ret == 0) {
+            __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
+                                "read() graceful EOF");
+            closeDevice(device);
+            return 1;
+        }
+        else if (grabbing) {
+            // The kernel only ever returns whole events
+            if (queueEvdevData(device, events, ret / sizeof(events[0])) < 0) {
+                return -1;
+            }
+        }
 
-    return NULL;
+        if (ret < (int)sizeof(events)) {
+            return 0;
+        }
+    }
 }
 
 static int precheckDeviceForPolling(int fd) {
@@ -191,66 +353,85 @@ static int precheckDeviceForPolling(int fd) {
     return (isMouse || isKeyboard) && !isGamepad;
 }
 
-static void startPollForDevice(char* deviceName) {
+static void startPollForDevice(const char* deviceName) {
     struct DeviceEntry *currentEntry;
+    struct epoll_event event;
     char fullPath[256];
     int fd;
 
-    // Lock the device list
-    pthread_mutex_lock(&DeviceListLock);
+    if (strstr(deviceName, "event") == NULL) {
+        // Skip non-event devices
+        return;
+    }
 
     // Check if the device is already being polled
     currentEntry = DeviceListHead;
     while (currentEntry != NULL) {
         if (strcmp(currentEntry->devName, deviceName) == 0) {
             // Already polling this device
-            goto unlock;
+            return;
         }
 
         currentEntry = currentEntry->next;
     }
 
     // Open the device
-    sprintf(fullPath, "/dev/input/%s", deviceName);
-    fd = open(fullPath, O_RDWR);
+    snprintf(fullPath, sizeof(fullPath), "/dev/input/%s", deviceName);
+    fd = open(fullPath, O_RDWR | O_NONBLOCK);
     if (fd < 0) {
         __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "Couldn't open %s: %d", fullPath, errno);
-        goto unlock;
+        return;
+    }
+
+    // Check if we support polling this device
+    if (!precheckDeviceForPolling(fd)) {
+        // Nope, get out
+        close(fd);
+        return;
     }
 
     // Allocate a context
     currentEntry = malloc(sizeof(*currentEntry));
     if (currentEntry == NULL) {
         close(fd);
-        goto unlock;
+        return;
     }
 
     // Populate context
     currentEntry->fd = fd;
-    strcpy(currentEntry->devName, deviceName);
+    currentEntry->frameCount = 0;
+    currentEntry->frameIsMotion = 0;
+    strncpy(currentEntry->devName, deviceName, sizeof(currentEntry->devName) - 1);
+    currentEntry->devName[sizeof(currentEntry->devName) - 1] = 0;
 
-    // Check if we support polling this device
-    if (!precheckDeviceForPolling(fd)) {
-        // Nope, get out
-        free(currentEntry);
-        close(fd);
-        goto unlock;
+    __android_log_print(ANDROID_LOG_INFO, "EvdevReader", "Polling /dev/input/%s", currentEntry->devName);
+
+    if (grabbing) {
+        // Exclusively grab the input device (required to make the Android cursor disappear)
+        if (ioctl(fd, EVIOCGRAB, 1) < 0) {
+            __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
+                                "EVIOCGRAB failed for %s: %d", currentEntry->devName, errno);
+            free(currentEntry);
+            close(fd);
+            return;
+        }
     }
 
-    // Start the polling thread
-    if (pthread_create(&currentEntry->thread, NULL, pollThreadFunc, currentEntry) != 0) {
+    // Add it to the event loop
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = currentEntry;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "epoll_ctl() failed: %d", errno);
+        ioctl(fd, EVIOCGRAB, 0);
         free(currentEntry);
         close(fd);
-        goto unlock;
+        return;
     }
 
     // Queue this onto the device list
     currentEntry->next = DeviceListHead;
     DeviceListHead = currentEntry;
-
-unlock:
-    // Unlock and return
-    pthread_mutex_unlock(&DeviceListLock);
 }
 
 static int enumerateDevices(void) {
@@ -270,11 +451,6 @@ static int enumerateDevices(void) {
             continue;
         }
 
-        if (strstr(dirEnt->d_name, "event") == NULL) {
-            // Skip non-event devices
-            continue;
-        }
-
         startPollForDevice(dirEnt->d_name);
     }
 
@@ -282,35 +458,112 @@ static int enumerateDevices(void) {
     return 0;
 }
 
-static int connectSocket(int port) {
-    struct sockaddr_in saddr;
+static void handleHotplug(void) {
+    char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event *event;
+    ssize_t ret;
+    char *ptr;
+
+    for (;;) {
+        ret = read(inotifyFd, buffer, sizeof(buffer));
+        if (ret <= 0) {
+            // Drained (or EINTR, which will just wake us up again)
+            return;
+        }
+
+        for (ptr = buffer; ptr < buffer + ret; ptr += sizeof(*event) + event->len) {
+            event = (const struct inotify_event *)ptr;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // We missed some, so look at everything again
+                enumerateDevices();
+            }
+            else if (event->len > 0) {
+                // Removal is noticed by the device's own fd hanging up
+                startPollForDevice(event->name);
+            }
+        }
+    }
+}
+
+static int connectSocket(const char *name) {
+    struct sockaddr_un saddr;
+    struct EvdevHello hello;
+    socklen_t saddrLen;
     int ret;
-    int val;
 
-    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (name[0] != '@' || strlen(name) >= sizeof(saddr.sun_path)) {
+        __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "Bad socket name: %s", name);
+        return -1;
+    }
+
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
     if (sock < 0) {
         __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "socket() failed: %d", errno);
         return -1;
     }
 
+    // The app listens in the abstract namespace, which is what the
+    // leading '@' stands for, so there's no socket file to set up
     memset(&saddr, 0, sizeof(saddr));
-    saddr.sin_family = AF_INET;
-    saddr.sin_port = htons(port);
-    saddr.sin_addr.s_addr = inet_addr("127.0.0.1");
-    ret = connect(sock, (struct sockaddr*)&saddr, sizeof(saddr));
+    saddr.sun_family = AF_UNIX;
+    memcpy(&saddr.sun_path[1], &name[1], strlen(name) - 1);
+    saddrLen = offsetof(struct sockaddr_un, sun_path) + strlen(name);
+    ret = connect(sock, (struct sockaddr*)&saddr, saddrLen);
     if (ret < 0) {
         __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "connect() failed: %d", errno);
         return -1;
     }
 
-    val = 1;
-    ret = setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&val, sizeof(val));
+    hello.magic = EVDEV_PROTOCOL_MAGIC;
+    hello.version = EVDEV_PROTOCOL_VERSION;
+    hello.flags = 0;
+    ret = sendAll(&hello, sizeof(hello));
     if (ret < 0) {
-        __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "setsockopt() failed: %d", errno);
-        // We can continue anyways
+        return -1;
+    }
+
+    __android_log_print(ANDROID_LOG_INFO, "EvdevReader", "Connection established to %s", name);
+
+    return 0;
+}
+
+static int startEventLoop(void) {
+    struct epoll_event event;
+
+    epollFd = epoll_create(MAX_EPOLL_EVENTS);
+    if (epollFd < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "epoll_create() failed: %d", errno);
+        return -1;
+    }
+
+    // Requests from the client are tagged with a NULL device
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, sock, &event) < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "epoll_ctl() failed: %d", errno);
+        return -1;
     }
 
-    __android_log_print(ANDROID_LOG_INFO, "EvdevReader", "Connection established to port %d", port);
+    // Hotplug notifications are tagged with the address of the inotify fd
+    inotifyFd = inotify_init();
+    if (inotifyFd >= 0) {
+        fcntl(inotifyFd, F_SETFL, fcntl(inotifyFd, F_GETFL) | O_NONBLOCK);
+        if (inotify_add_watch(inotifyFd, "/dev/input", IN_CREATE | IN_ATTRIB) < 0) {
+            close(inotifyFd);
+            inotifyFd = -1;
+        }
+        else {
+            event.events = EPOLLIN;
+            event.data.ptr = &inotifyFd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, inotifyFd, &event);
+        }
+    }
+    if (inotifyFd < 0) {
+        __android_log_print(ANDROID_LOG_WARN, "EvdevReader",
+                            "inotify unavailable (%d), polling for new devices", errno);
+    }
 
     return 0;
 }
@@ -318,19 +571,64 @@ static int connectSocket(int port) {
 #define UNGRAB_REQ 1
 #define REGRAB_REQ 2
 
+static int handleRequest(void) {
+    unsigned char requestId;
+    struct DeviceEntry *currentEntry;
+    int ret;
+
+    ret = recv(sock, &requestId, sizeof(requestId), 0);
+    if (ret < (int)sizeof(requestId)) {
+        __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "Short read on socket");
+        return -1;
+    }
+
+    if (requestId != UNGRAB_REQ && requestId != REGRAB_REQ) {
+        __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "Unknown request");
+        return -1;
+    }
+
+    // Update state for future devices
+    grabbing = (requestId == REGRAB_REQ);
+
+    // Carry out the requested action on each device, and forget any
+    // half collected reports from before
+    currentEntry = DeviceListHead;
+    while (currentEntry != NULL) {
+        ioctl(currentEntry->fd, EVIOCGRAB, grabbing);
+        currentEntry->frameCount = 0;
+        currentEntry = currentEntry->next;
+    }
+
+    __android_log_print(ANDROID_LOG_INFO, "EvdevReader", "New grab status is: %s",
+        grabbing ? "enabled" : "disabled");
+
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
+    struct epoll_event events[MAX_EPOLL_EVENTS];
     int ret;
-    int pollres;
-    struct pollfd pollinfo;
-    int port;
+    int i;
 
     __android_log_print(ANDROID_LOG_INFO, "EvdevReader", "Entered main()");
 
-    port = atoi(argv[1]);
-    __android_log_print(ANDROID_LOG_INFO, "EvdevReader", "Requested port number: %d", port);
+    if (argc < 2) {
+        __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "Usage: %s @socketname [-m]", argv[0]);
+        return -1;
+    }
+
+    // -m adds up mouse motion that the client hasn't been sent yet
+    mergeMotion = (argc > 2 && strcmp(argv[2], "-m") == 0);
+    __android_log_print(ANDROID_LOG_INFO, "EvdevReader", "Requested socket: %s%s", argv[1],
+                        mergeMotion ? " (merging motion)" : "");
 
     // Connect to the app's socket
-    ret = connectSocket(port);
+    ret = connectSocket(argv[1]);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = startEventLoop();
     if (ret < 0) {
         return ret;
     }
@@ -341,70 +639,60 @@ int main(int argc, char* argv[]) {
         return ret;
     }
 
-    // Wait for requests from the client
     for (;;) {
-        unsigned char requestId;
-
-        do {
-            // Every second we poll again for new devices if
-            // we haven't received any new events
-            pollinfo.fd = sock;
-            pollinfo.events = POLLIN;
-            pollinfo.revents = 0;
-            pollres = poll(&pollinfo, 1, 1000);
-            if (pollres == 0) {
-                // Timeout, re-enumerate devices
-                enumerateDevices();
-            }
-        }
-        while (pollres == 0);
-
-        if (pollres > 0 && (pollinfo.revents & POLLIN)) {
-            // We'll have data available now
-            ret = recv(sock, &requestId, sizeof(requestId), 0);
-            if (ret < sizeof(requestId)) {
-                __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "Short read on socket");
-                return errno;
-            }
-
-            if (requestId != UNGRAB_REQ && requestId != REGRAB_REQ) {
-                __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "Unknown request");
-                return requestId;
+        // Without inotify, look for new devices every second instead
+        ret = epoll_wait(epollFd, events, MAX_EPOLL_EVENTS, inotifyFd >= 0 ? -1 : 1000);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
             }
 
-            {
-                struct DeviceEntry *currentEntry;
-
-                pthread_mutex_lock(&DeviceListLock);
-
-                // Update state for future devices
-                grabbing = (requestId == REGRAB_REQ);
+            __android_log_print(ANDROID_LOG_ERROR, "EvdevReader", "epoll_wait() failed: %d", errno);
+            return -1;
+        }
+        else if (ret == 0) {
+            enumerateDevices();
+            continue;
+        }
 
-                // Carry out the requested action on each device
-                currentEntry = DeviceListHead;
-                while (currentEntry != NULL) {
-                    ioctl(currentEntry->fd, EVIOCGRAB, grabbing);
-                    currentEntry = currentEntry->next;
+        for (i = 0; i < ret; i++) {
+            if (events[i].data.ptr == NULL) {
+                // The client went away or sent us a request
+                if (!(events[i].events & EPOLLIN)) {
+                    __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
+                                        "Socket poll unexpected revents: %d", events[i].events);
+                    return -1;
+                }
+                if (handleRequest() < 0) {
+                    return -1;
                 }
-
-                pthread_mutex_unlock(&DeviceListLock);
-
-                __android_log_print(ANDROID_LOG_INFO, "EvdevReader", "New grab status is: %s",
-                    grabbing ? "enabled" : "disabled");
             }
-        }
-        else {
-            // Terminate this thread
-            if (pollres < 0) {
-                __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
-                                    "Socket recv poll() failed: %d", errno);
+            else if (events[i].data.ptr == &inotifyFd) {
+                handleHotplug();
             }
             else {
-                __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
-                                    "Socket poll unexpected revents: %d", pollinfo.revents);
+                struct DeviceEntry *device = events[i].data.ptr;
+                int readRet = 0;
+
+                if (events[i].events & EPOLLIN) {
+                    // Read whatever is queued first, even if the device hung up
+                    readRet = readDevice(device);
+                    if (readRet < 0) {
+                        return -1;
+                    }
+                }
+
+                if (readRet == 0 && (events[i].events & (EPOLLHUP | EPOLLERR))) {
+                    __android_log_print(ANDROID_LOG_ERROR, "EvdevReader",
+                                        "Unexpected revents: %d", events[i].events);
+                    closeDevice(device);
+                }
             }
+        }
 
+        // Everything that woke us up goes out in one write
+        if (outLength > 0 && flushEvdevData() < 0) {
             return -1;
         }
     }
-}
\ No newline at end of file
+}
@@ -9,6 +9,8 @@ include $(CLEAR_VARS)
 LOCAL_MODULE    := jnienet
 
 LOCAL_SRC_FILES := jnienet.c \
+                   jnienet_client.c \
+                   jnienet_pool.c \
                    enet/callbacks.c \
                    enet/compress.c \
                    enet/host.c \
@@ -21,5 +23,6 @@ LOCAL_SRC_FILES := jnienet.c \
 
 LOCAL_CFLAGS := -DHAS_SOCKLEN_T=1
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/enet/include
+LOCAL_LDLIBS    := -llog
 
 include $(BUILD_SHARED_LIBRARY)
@@ -1,4 +1,7 @@
 #include "enet/enet.h"
+#include "jnienet.h"
+#include "jnienet_client.h"
+#include "jnienet_pool.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -6,14 +9,14 @@
 #include <jni.h>
 
 #define CLIENT_TO_LONG(x) ((intptr_t)(x))
-#define LONG_TO_CLIENT(x) ((ENetHost*)(intptr_t)(x))
+#define LONG_TO_CLIENT(x) ((ENET_CLIENT*)(intptr_t)(x))
 
 #define PEER_TO_LONG(x) ((intptr_t)(x))
 #define LONG_TO_PEER(x) ((ENetPeer*)(intptr_t)(x))
 
 JNIEXPORT jint JNICALL
 Java_com_limelight_nvstream_enet_EnetConnection_initializeEnet(JNIEnv *env, jobject class) {
-    return enet_initialize();
+    return jnienet_pool_initialize_enet();
 }
 
 JNIEXPORT jlong JNICALL
@@ -21,7 +24,7 @@ Java_com_limelight_nvstream_enet_EnetConnection_createClient(JNIEnv *env, jobjec
     ENetAddress enetAddress;
     const char *addrStr;
     int err;
-    
+
     // Perform a lookup on the address to determine the address family
     addrStr = (*env)->GetStringUTFChars(env, address, 0);
     err = enet_address_set_host(&enetAddress, addrStr);
@@ -29,120 +32,316 @@ Java_com_limelight_nvstream_enet_EnetConnection_createClient(JNIEnv *env, jobjec
     if (err < 0) {
         return CLIENT_TO_LONG(NULL);
     }
-    
-    // Create a client that can use 1 outgoing connection and 1 channel
-    return CLIENT_TO_LONG(enet_host_create(enetAddress.address.ss_family, NULL, 1, 1, 0, 0));
+
+    return CLIENT_TO_LONG(jnienet_client_create(enetAddress.address.ss_family));
 }
 
 JNIEXPORT jlong JNICALL
 Java_com_limelight_nvstream_enet_EnetConnection_connectToPeer(JNIEnv *env, jobject class, jlong client, jstring address, jint port, jint timeout) {
-    ENetPeer* peer;
     ENetAddress enetAddress;
-    ENetEvent event;
     const char *addrStr;
     int err;
 
     // Initialize the ENet address
-    addrStr = (*env)->GetStringUTFChars(env, address, 0);    
+    addrStr = (*env)->GetStringUTFChars(env, address, 0);
     err = enet_address_set_host(&enetAddress, addrStr);
     enet_address_set_port(&enetAddress, port);
     (*env)->ReleaseStringUTFChars(env, address, addrStr);
     if (err < 0) {
         return PEER_TO_LONG(NULL);
     }
-    
-    // Start the connection
-    peer = enet_host_connect(LONG_TO_CLIENT(client), &enetAddress, 1, 0);
-    if (peer == NULL) {
-        return PEER_TO_LONG(NULL);
-    }
-    
-    // Wait for the connect to complete
-    if (enet_host_service(LONG_TO_CLIENT(client), &event, timeout) <= 0 || event.type != ENET_EVENT_TYPE_CONNECT) {
-        enet_peer_reset(peer);
-        return PEER_TO_LONG(NULL);
-    }
-    
-    // Ensure the connect verify ACK is sent immediately
-    enet_host_flush(LONG_TO_CLIENT(client));
 
-    // Set the max peer timeout to 10 seconds
-    enet_peer_timeout(peer, ENET_PEER_TIMEOUT_LIMIT, ENET_PEER_TIMEOUT_MINIMUM, 10000);
-    
-    return PEER_TO_LONG(peer);
+    return PEER_TO_LONG(jnienet_client_connect(LONG_TO_CLIENT(client), &enetAddress, timeout));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_limelight_nvstream_enet_EnetConnection_readPacket(JNIEnv *env, jobject class, jlong client, jbyteArray data, jint length, jint timeout) {
-    jint err;
-    jbyte* dataPtr;
     ENetEvent event;
-    
+    jint err;
+
     // Wait for a receive event, timeout, or disconnect
-    err = enet_host_service(LONG_TO_CLIENT(client), &event, timeout);
+    err = jnienet_client_wait_event(LONG_TO_CLIENT(client), &event, timeout);
     if (err <= 0) {
         return err;
     }
     else if (event.type != ENET_EVENT_TYPE_RECEIVE) {
         return -1;
     }
-    
+
     // Check that the packet isn't too large
-    if (event.packet->dataLength > length) {
-        enet_packet_destroy(event.packet);
-        return event.packet->dataLength;
-    }
-    
-    // Copy the packet data into the caller's buffer
-    dataPtr = (*env)->GetByteArrayElements(env, data, 0);
-    memcpy(dataPtr, event.packet->data, event.packet->dataLength);
     err = event.packet->dataLength;
-    (*env)->ReleaseByteArrayElements(env, data, dataPtr, 0);
-    
+    if (err <= length) {
+        // Copy the packet data into the caller's buffer without pinning it
+        (*env)->SetByteArrayRegion(env, data, 0, err, (jbyte*)event.packet->data);
+    }
+
     // Free the packet
     enet_packet_destroy(event.packet);
-    
+
     return err;
 }
 
+// Queues the packet for the service thread, which sends everything
+// that queued up while it was busy in one flush
 JNIEXPORT jboolean JNICALL
 Java_com_limelight_nvstream_enet_EnetConnection_writePacket(JNIEnv *env, jobject class, jlong client, jlong peer, jbyteArray data, jint length, jint packetFlags) {
     ENetPacket* packet;
-    jboolean ret;
-    jbyte* dataPtr;
-    
-    dataPtr = (*env)->GetByteArrayElements(env, data, 0);
-    
-    // Create the reliable packet that describes our outgoing message
-    packet = enet_packet_create(dataPtr, length, packetFlags);
-    if (packet != NULL) {
-        // Send the message to the peer
-        if (enet_peer_send(LONG_TO_PEER(peer), 0, packet) < 0) {
-            // This can fail if the peer has been disconnected
-            enet_packet_destroy(packet);
-            ret = JNI_FALSE;
-        }
-        else {
-            // Force the client to send the packet now
-            enet_host_flush(LONG_TO_CLIENT(client));
-            ret = JNI_TRUE;
-        }
-    }
-    else {
-        ret = JNI_FALSE;
+
+    // Create the packet that describes our outgoing message out of the
+    // pool, and copy the message straight into it
+    packet = jnienet_pool_create_packet(length, packetFlags);
+    if (packet == NULL) {
+        return JNI_FALSE;
     }
-    
-    (*env)->ReleaseByteArrayElements(env, data, dataPtr, JNI_ABORT);
-    
-    return ret;
+    (*env)->GetByteArrayRegion(env, data, 0, length, (jbyte*)packet->data);
+
+    // This can fail if the peer has been disconnected
+    return jnienet_client_send(LONG_TO_CLIENT(client), packet) < 0 ? JNI_FALSE : JNI_TRUE;
 }
 
 JNIEXPORT void JNICALL
 Java_com_limelight_nvstream_enet_EnetConnection_destroyClient(JNIEnv *env, jobject class, jlong client) {
-    enet_host_destroy(LONG_TO_CLIENT(client));
+    jnienet_client_destroy(LONG_TO_CLIENT(client));
 }
 
 JNIEXPORT void JNICALL
 Java_com_limelight_nvstream_enet_EnetConnection_disconnectPeer(JNIEnv *env, jobject class, jlong peer) {
-    enet_peer_disconnect_now(LONG_TO_PEER(peer), 0);
+    jnienet_client_disconnect(LONG_TO_PEER(peer)->data);
+}
+
+#ifndef NDEBUG
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <android/log.h>
+
+#define BENCH_PORT 48100
+#define BENCH_PACKET_SIZE 64 // about the size of a control message
+#define BENCH_WINDOW 32      // packets in flight at once
+#define BENCH_MAX_SAMPLES 65536
+
+static double benchNowNs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+typedef struct {
+    ENetHost* host;
+    pthread_t thread;
+    int stop;
+    ENET_CLIENT* client;
+} BENCH;
+
+static void benchEcho(ENetEvent* event) {
+    if (event->type == ENET_EVENT_TYPE_RECEIVE) {
+        // The received packet goes straight back, so the server doesn't allocate
+        if (enet_peer_send(event->peer, 0, event->packet) < 0) {
+            enet_packet_destroy(event->packet);
+        }
+    }
+}
+
+static void* benchServerThread(void* context) {
+    BENCH* bench = context;
+    ENetEvent event;
+
+    while (!__atomic_load_n(&bench->stop, __ATOMIC_ACQUIRE)) {
+        if (enet_host_service(bench->host, &event, 1) > 0) {
+            benchEcho(&event);
+            while (enet_host_check_events(bench->host, &event) > 0) {
+                benchEcho(&event);
+            }
+            enet_host_flush(bench->host);
+        }
+    }
+
+    return NULL;
+}
+
+static void benchStop(BENCH* bench) {
+    if (bench->client != NULL) {
+        jnienet_client_disconnect(bench->client);
+        jnienet_client_destroy(bench->client);
+    }
+    if (bench->host != NULL) {
+        __atomic_store_n(&bench->stop, 1, __ATOMIC_RELEASE);
+        pthread_join(bench->thread, NULL);
+        enet_host_destroy(bench->host);
+    }
+    enet_deinitialize();
+}
+
+static int benchMallocCount(void) {
+    JNIENET_POOL_STATS stats;
+    jnienet_pool_get_stats(&stats);
+    return stats.mallocAllocations;
+}
+
+// Brings up an echo server on loopback and connects a client to it
+static int benchStart(BENCH* bench) {
+    ENetAddress address;
+
+    memset(bench, 0, sizeof(*bench));
+    if (jnienet_pool_initialize_enet() < 0 ||
+        enet_address_set_host(&address, "127.0.0.1") < 0) {
+        return -1;
+    }
+    enet_address_set_port(&address, BENCH_PORT);
+
+    bench->host = enet_host_create(address.address.ss_family, &address, 1, 1, 0, 0);
+    if (bench->host == NULL) {
+        benchStop(bench);
+        return -1;
+    }
+    if (pthread_create(&bench->thread, NULL, benchServerThread, bench) != 0) {
+        enet_host_destroy(bench->host);
+        bench->host = NULL;
+        benchStop(bench);
+        return -1;
+    }
+
+    bench->client = jnienet_client_create(address.address.ss_family);
+    if (bench->client == NULL || jnienet_client_connect(bench->client, &address, 1000) == NULL) {
+        benchStop(bench);
+        return -1;
+    }
+
+    return 0;
+}
+
+// returns packets per second, or -1 if the echo stopped coming back
+static double benchThroughput(ENET_CLIENT* client, int packetCount, double* allocationsPerPacket) {
+    static unsigned char buffer[16384];
+    unsigned char payload[BENCH_PACKET_SIZE];
+    ENetPacket* packet;
+    int allocations = benchMallocCount();
+    ENetEvent event;
+    int sent = 0;
+    int received = 0;
+    double start;
+    int ret;
+
+    memset(payload, 0x5A, sizeof(payload));
+
+    start = benchNowNs();
+    while (received < packetCount) {
+        while (sent < packetCount && sent - received < BENCH_WINDOW) {
+            packet = jnienet_pool_create_packet(sizeof(payload), ENET_PACKET_FLAG_RELIABLE);
+            memcpy(packet->data, payload, sizeof(payload));
+            jnienet_client_send(client, packet);
+            sent++;
+        }
+
+        // What readPacket does, less the JNI copy
+        ret = jnienet_client_wait_event(client, &event, 1000);
+        if (ret > 0) {
+            memcpy(buffer, event.packet->data, event.packet->dataLength);
+            enet_packet_destroy(event.packet);
+        }
+
+        if (ret <= 0) {
+            return -1;
+        }
+        received += ret;
+    }
+
+    *allocationsPerPacket = (double)(benchMallocCount() - allocations) / packetCount;
+    return packetCount / ((benchNowNs() - start) / 1e9);
+}
+
+typedef struct {
+    ENET_CLIENT* client;
+    int expected;
+    int received;
+    double* rtts;
+} BENCH_READER;
+
+// Sits in a long blocking read the whole time, like the control
+// stream's receive thread
+static void* benchReaderThread(void* context) {
+    BENCH_READER* reader = context;
+    ENetEvent event;
+    double sentNs;
+
+    while (reader->received < reader->expected &&
+           jnienet_client_wait_event(reader->client, &event, 1000) > 0) {
+        memcpy(&sentNs, event.packet->data, sizeof(sentNs));
+        reader->rtts[reader->received++] = benchNowNs() - sentNs;
+        enet_packet_destroy(event.packet);
+    }
+
+    return NULL;
+}
+
+static int benchCompareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Sends a timestamped input-sized packet every millisecond from one
+// thread while another blocks reading the echoes, and logs the round
+// trip times, then the throughput of the same connection flat out
+void jnienet_latency_benchmark(int packetCount) {
+    JNIENET_POOL_STATS stats;
+    ENetPacket* packet;
+    BENCH_READER reader;
+    BENCH bench;
+    pthread_t thread;
+    double sum = 0;
+    double rate, allocations = 0;
+    double sentNs;
+    int i;
+
+    if (packetCount > BENCH_MAX_SAMPLES) {
+        packetCount = BENCH_MAX_SAMPLES;
+    }
+    if (benchStart(&bench) < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, "jnienet", "Benchmark setup failed");
+        return;
+    }
+
+    reader.client = bench.client;
+    reader.expected = packetCount;
+    reader.received = 0;
+    reader.rtts = malloc(packetCount * sizeof(double));
+    if (reader.rtts == NULL || pthread_create(&thread, NULL, benchReaderThread, &reader) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, "jnienet", "Benchmark setup failed");
+        free(reader.rtts);
+        benchStop(&bench);
+        return;
+    }
+
+    for (i = 0; i < packetCount; i++) {
+        packet = jnienet_pool_create_packet(BENCH_PACKET_SIZE, ENET_PACKET_FLAG_RELIABLE);
+        memset(packet->data, 0, BENCH_PACKET_SIZE);
+        sentNs = benchNowNs();
+        memcpy(packet->data, &sentNs, sizeof(sentNs));
+        jnienet_client_send(bench.client, packet);
+        usleep(1000);
+    }
+    pthread_join(thread, NULL);
+
+    if (reader.received > 0) {
+        for (i = 0; i < reader.received; i++) {
+            sum += reader.rtts[i];
+        }
+        qsort(reader.rtts, reader.received, sizeof(double), benchCompareDoubles);
+        __android_log_print(ANDROID_LOG_INFO, "jnienet",
+            "%d of %d echoes at 1 kHz: round trip %.1f us average, %.1f us median, %.1f us 99th percentile, %.1f us max",
+            reader.received, packetCount, sum / reader.received / 1000, reader.rtts[reader.received / 2] / 1000,
+            reader.rtts[reader.received * 99 / 100] / 1000, reader.rtts[reader.received - 1] / 1000);
+    }
+
+    jnienet_pool_get_stats(&stats);
+    __android_log_print(ANDROID_LOG_INFO, "jnienet", "Pool after 1 kHz: %d allocations, %d mallocs, peak %d of %d blocks",
+        stats.poolAllocations, stats.mallocAllocations, stats.peakInUse, stats.blockCount);
+
+    rate = benchThroughput(bench.client, packetCount, &allocations);
+    __android_log_print(ANDROID_LOG_INFO, "jnienet", "Throughput %.0f packets/s (%.2f mallocs/packet)", rate, allocations);
+
+    free(reader.rtts);
+    benchStop(&bench);
 }
+#endif
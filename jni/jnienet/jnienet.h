@@ -0,0 +1,5 @@
+// Debug only entry points for the ENet binding, there's nothing else
+// to call from native code
+#ifndef NDEBUG
+void jnienet_latency_benchmark(int packetCount);
+#endif
@@ -0,0 +1,386 @@
+#include "enet/enet.h"
+#include "jnienet_client.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// Events each queue holds, a power of 2
+#define QUEUE_SIZE 1024
+
+// How long the service thread sleeps when nothing happens, so
+// ENet's retransmit and ping timers still run on time
+#define SERVICE_INTERVAL_MS 5
+
+typedef struct {
+    int sequence;
+    ENetEvent event;
+} QUEUE_CELL;
+
+// Bounded lock-free queue (Vyukov's), which is also safe with several
+// threads on either end. A consumer sets waiting before it sleeps on
+// eventFd, and producers only pay for the wakeup when it has.
+typedef struct {
+    QUEUE_CELL cells[QUEUE_SIZE];
+    int enqueuePos;
+    int dequeuePos;
+    int waiting;
+    int eventFd;
+} EVENT_QUEUE;
+
+struct _ENET_CLIENT {
+    ENetHost* host;
+    ENetPeer* peer;
+
+    pthread_t thread;
+    int running;
+    // Set by the service thread when it ends on its own
+    int stopped;
+
+    // Outgoing events are just their packet
+    EVENT_QUEUE outgoing;
+    EVENT_QUEUE incoming;
+
+    // Receiver only
+    int disconnected;
+};
+
+static int queueInit(EVENT_QUEUE* queue) {
+    int i;
+
+    for (i = 0; i < QUEUE_SIZE; i++) {
+        queue->cells[i].sequence = i;
+    }
+    queue->enqueuePos = 0;
+    queue->dequeuePos = 0;
+    queue->waiting = 0;
+    queue->eventFd = eventfd(0, EFD_NONBLOCK);
+
+    return queue->eventFd < 0 ? -1 : 0;
+}
+
+static void wakeQueue(EVENT_QUEUE* queue) {
+    uint64_t one = 1;
+    write(queue->eventFd, &one, sizeof(one));
+}
+
+// returns -1 if the queue is full
+static int queuePush(EVENT_QUEUE* queue, const ENetEvent* event) {
+    int pos = __atomic_load_n(&queue->enqueuePos, __ATOMIC_RELAXED);
+    QUEUE_CELL* cell;
+    int diff;
+
+    for (;;) {
+        cell = &queue->cells[pos & (QUEUE_SIZE - 1)];
+        diff = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - pos;
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&queue->enqueuePos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return -1;
+        }
+        else {
+            pos = __atomic_load_n(&queue->enqueuePos, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->event = *event;
+    __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+
+    // Pairs with the fence in queueWait: either the consumer sees this
+    // event before it sleeps, or we see that it's sleeping
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&queue->waiting, __ATOMIC_RELAXED)) {
+        wakeQueue(queue);
+    }
+
+    return 0;
+}
+
+// returns 0 if the queue is empty
+static int queuePop(EVENT_QUEUE* queue, ENetEvent* event) {
+    int pos = __atomic_load_n(&queue->dequeuePos, __ATOMIC_RELAXED);
+    QUEUE_CELL* cell;
+    int diff;
+
+    for (;;) {
+        cell = &queue->cells[pos & (QUEUE_SIZE - 1)];
+        diff = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - (pos + 1);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&queue->dequeuePos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return 0;
+        }
+        else {
+            pos = __atomic_load_n(&queue->dequeuePos, __ATOMIC_RELAXED);
+        }
+    }
+
+    *event = cell->event;
+    __atomic_store_n(&cell->sequence, pos + QUEUE_SIZE, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static int queueEmpty(EVENT_QUEUE* queue) {
+    int pos = __atomic_load_n(&queue->dequeuePos, __ATOMIC_RELAXED);
+    return __atomic_load_n(&queue->cells[pos & (QUEUE_SIZE - 1)].sequence, __ATOMIC_ACQUIRE) - (pos + 1) < 0;
+}
+
+// Sleeps until something is pushed, otherFd is readable (if it's not -1)
+// or timeout milliseconds pass
+static void queueWait(EVENT_QUEUE* queue, int otherFd, int timeout) {
+    struct pollfd fds[2];
+    uint64_t count;
+
+    __atomic_store_n(&queue->waiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (queueEmpty(queue)) {
+        fds[0].fd = queue->eventFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = otherFd;
+        fds[1].events = POLLIN;
+        poll(fds, otherFd >= 0 ? 2 : 1, timeout);
+    }
+
+    __atomic_store_n(&queue->waiting, 0, __ATOMIC_RELAXED);
+    read(queue->eventFd, &count, sizeof(count));
+}
+
+static void queueDrain(EVENT_QUEUE* queue) {
+    ENetEvent event;
+
+    while (queuePop(queue, &event)) {
+        if (event.packet != NULL) {
+            enet_packet_destroy(event.packet);
+        }
+    }
+}
+
+static void* serviceThread(void* context) {
+    ENET_CLIENT* client = context;
+    ENetEvent event;
+    ENetEvent stalledEvent;
+    int stalled = 0;
+    int sent;
+    int ret;
+
+    while (__atomic_load_n(&client->running, __ATOMIC_ACQUIRE)) {
+        // Everything queued since last time goes out in one flush
+        sent = 0;
+        while (queuePop(&client->outgoing, &event)) {
+            if (enet_peer_send(client->peer, 0, event.packet) < 0) {
+                // This can fail if the peer has been disconnected
+                enet_packet_destroy(event.packet);
+            }
+            sent++;
+        }
+        if (sent > 0) {
+            enet_host_flush(client->host);
+        }
+
+        // While the receiver is behind, stop servicing rather than drop reliable packets
+        if (stalled) {
+            if (queuePush(&client->incoming, &stalledEvent) < 0) {
+                queueWait(&client->outgoing, -1, SERVICE_INTERVAL_MS);
+                continue;
+            }
+            stalled = 0;
+            if (stalledEvent.type == ENET_EVENT_TYPE_DISCONNECT) {
+                break;
+            }
+        }
+
+        while ((ret = enet_host_service(client->host, &event, 0)) != 0) {
+            if (ret < 0) {
+                event.type = ENET_EVENT_TYPE_DISCONNECT;
+                event.packet = NULL;
+            }
+            else if (event.type != ENET_EVENT_TYPE_RECEIVE && event.type != ENET_EVENT_TYPE_DISCONNECT) {
+                continue;
+            }
+
+            if (queuePush(&client->incoming, &event) < 0) {
+                stalledEvent = event;
+                stalled = 1;
+                break;
+            }
+            else if (event.type == ENET_EVENT_TYPE_DISCONNECT) {
+                goto disconnected;
+            }
+        }
+
+        queueWait(&client->outgoing, stalled ? -1 : (int)client->host->socket, SERVICE_INTERVAL_MS);
+    }
+
+disconnected:
+    __atomic_store_n(&client->stopped, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+ENET_CLIENT* jnienet_client_create(int addressFamily) {
+    ENET_CLIENT* client;
+
+    client = calloc(1, sizeof(*client));
+    if (client == NULL) {
+        return NULL;
+    }
+
+    client->outgoing.eventFd = -1;
+    client->incoming.eventFd = -1;
+    if (queueInit(&client->outgoing) < 0 || queueInit(&client->incoming) < 0) {
+        jnienet_client_destroy(client);
+        return NULL;
+    }
+
+    // Create a client that can use 1 outgoing connection and 1 channel
+    client->host = enet_host_create(addressFamily, NULL, 1, 1, 0, 0);
+    if (client->host == NULL) {
+        jnienet_client_destroy(client);
+        return NULL;
+    }
+
+    return client;
+}
+
+static void stopService(ENET_CLIENT* client) {
+    if (__atomic_load_n(&client->running, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&client->running, 0, __ATOMIC_RELEASE);
+        wakeQueue(&client->outgoing);
+        pthread_join(client->thread, NULL);
+    }
+}
+
+void jnienet_client_destroy(ENET_CLIENT* client) {
+    if (client == NULL) {
+        return;
+    }
+
+    stopService(client);
+
+    queueDrain(&client->outgoing);
+    queueDrain(&client->incoming);
+
+    if (client->host != NULL) {
+        enet_host_destroy(client->host);
+    }
+    if (client->outgoing.eventFd >= 0) {
+        close(client->outgoing.eventFd);
+    }
+    if (client->incoming.eventFd >= 0) {
+        close(client->incoming.eventFd);
+    }
+    free(client);
+}
+
+ENetPeer* jnienet_client_connect(ENET_CLIENT* client, const ENetAddress* address, int timeout) {
+    ENetPeer* peer;
+    ENetEvent event;
+
+    // Start the connection
+    peer = enet_host_connect(client->host, address, 1, 0);
+    if (peer == NULL) {
+        return NULL;
+    }
+
+    // Wait for the connect to complete
+    if (enet_host_service(client->host, &event, timeout) <= 0 || event.type != ENET_EVENT_TYPE_CONNECT) {
+        enet_peer_reset(peer);
+        return NULL;
+    }
+
+    // Ensure the connect verify ACK is sent immediately
+    enet_host_flush(client->host);
+
+    // Set the max peer timeout to 10 seconds
+    enet_peer_timeout(peer, ENET_PEER_TIMEOUT_LIMIT, ENET_PEER_TIMEOUT_MINIMUM, 10000);
+
+    // From here on only the service thread touches the host
+    peer->data = client;
+    client->peer = peer;
+    __atomic_store_n(&client->running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&client->thread, NULL, serviceThread, client) != 0) {
+        __atomic_store_n(&client->running, 0, __ATOMIC_RELEASE);
+        enet_peer_reset(peer);
+        client->peer = NULL;
+        return NULL;
+    }
+
+    return peer;
+}
+
+void jnienet_client_disconnect(ENET_CLIENT* client) {
+    stopService(client);
+
+    if (client->peer != NULL) {
+        enet_peer_disconnect_now(client->peer, 0);
+        client->peer = NULL;
+    }
+}
+
+int jnienet_client_send(ENET_CLIENT* client, ENetPacket* packet) {
+    ENetEvent event;
+
+    if (!__atomic_load_n(&client->running, __ATOMIC_ACQUIRE) ||
+        __atomic_load_n(&client->stopped, __ATOMIC_ACQUIRE)) {
+        enet_packet_destroy(packet);
+        return -1;
+    }
+
+    memset(&event, 0, sizeof(event));
+    event.packet = packet;
+    if (queuePush(&client->outgoing, &event) < 0) {
+        enet_packet_destroy(packet);
+        return -1;
+    }
+
+    return 0;
+}
+
+static long long nowMs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+// Doesn't wait, returns 0 if nothing is queued
+static int pollEvent(ENET_CLIENT* client, ENetEvent* event) {
+    if (!queuePop(&client->incoming, event)) {
+        return 0;
+    }
+
+    if (event->type == ENET_EVENT_TYPE_DISCONNECT) {
+        client->disconnected = 1;
+    }
+    return 1;
+}
+
+int jnienet_client_wait_event(ENET_CLIENT* client, ENetEvent* event, int timeout) {
+    long long deadline = nowMs() + timeout;
+    long long remaining;
+
+    for (;;) {
+        if (pollEvent(client, event)) {
+            return 1;
+        }
+        else if (client->disconnected) {
+            return -1;
+        }
+
+        remaining = deadline - nowMs();
+        if (remaining <= 0) {
+            return 0;
+        }
+        queueWait(&client->incoming, -1, (int)remaining);
+    }
+}
@@ -0,0 +1,23 @@
+typedef struct _ENET_CLIENT ENET_CLIENT;
+
+// An ENet host owned by its own service thread once connected. Sends
+// and received events cross to and from that thread through lock-free
+// queues, so Java threads never touch the host themselves: a read that
+// blocks doesn't hold up input going out, and everything sent while
+// the thread was busy goes out in one flush.
+
+ENET_CLIENT* jnienet_client_create(int addressFamily);
+void jnienet_client_destroy(ENET_CLIENT* client);
+
+// Connects on the calling thread, then starts the service thread.
+// The peer's data points back at the client.
+ENetPeer* jnienet_client_connect(ENET_CLIENT* client, const ENetAddress* address, int timeout);
+// Stops the service thread and disconnects right away
+void jnienet_client_disconnect(ENET_CLIENT* client);
+
+// Takes ownership of packet, returns -1 if it can't be sent
+int jnienet_client_send(ENET_CLIENT* client, ENetPacket* packet);
+
+// Only one thread may receive at a time.
+// returns 1 for an event, 0 on timeout, -1 once disconnected
+int jnienet_client_wait_event(ENET_CLIENT* client, ENetEvent* event, int timeout);
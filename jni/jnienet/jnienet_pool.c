@@ -0,0 +1,221 @@
+#include "enet/enet.h"
+#include "jnienet_pool.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Big enough for ENet's packet, command and acknowledgement structs and
+// for any input message's data
+#define BLOCK_SIZE 256
+
+// 256 KB, a few seconds of 1 kHz input waiting on acknowledgements
+#define BLOCK_COUNT 1024
+
+#define NO_BLOCK 0xFFFFFFFFu
+
+static unsigned char Arena[BLOCK_COUNT][BLOCK_SIZE] __attribute__((aligned(16)));
+
+// Free list threaded through Next. The head carries a tag that changes
+// on every update, so a block being freed and reallocated between a
+// thread's read and its compare-and-swap can't fool it.
+static unsigned int Next[BLOCK_COUNT];
+static uint64_t FreeHead;
+
+static pthread_once_t PoolOnce = PTHREAD_ONCE_INIT;
+
+static JNIENET_POOL_STATS Stats;
+
+static void initializePool(void) {
+    unsigned int i;
+
+    for (i = 0; i < BLOCK_COUNT; i++) {
+        Next[i] = i + 1 < BLOCK_COUNT ? i + 1 : NO_BLOCK;
+    }
+    __atomic_store_n(&FreeHead, 0, __ATOMIC_RELEASE);
+
+    Stats.blockSize = BLOCK_SIZE;
+    Stats.blockCount = BLOCK_COUNT;
+}
+
+static int isPoolBlock(const void* block) {
+    return (const unsigned char*)block >= Arena[0] && (const unsigned char*)block < Arena[BLOCK_COUNT];
+}
+
+static void* popBlock(void) {
+    uint64_t head = __atomic_load_n(&FreeHead, __ATOMIC_ACQUIRE);
+    uint64_t newHead;
+    unsigned int index;
+
+    do {
+        index = (unsigned int)head;
+        if (index == NO_BLOCK) {
+            return NULL;
+        }
+        newHead = ((head >> 32) + 1) << 32 | __atomic_load_n(&Next[index], __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&FreeHead, &head, newHead, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+    return Arena[index];
+}
+
+static void pushBlock(void* block) {
+    unsigned int index = (unsigned int)(((unsigned char*)block - Arena[0]) / BLOCK_SIZE);
+    uint64_t head = __atomic_load_n(&FreeHead, __ATOMIC_RELAXED);
+    uint64_t newHead;
+
+    do {
+        __atomic_store_n(&Next[index], (unsigned int)head, __ATOMIC_RELAXED);
+        newHead = ((head >> 32) + 1) << 32 | index;
+    } while (!__atomic_compare_exchange_n(&FreeHead, &head, newHead, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+void* jnienet_pool_malloc(size_t size) {
+    void* block;
+    int inUse, peak;
+
+    pthread_once(&PoolOnce, initializePool);
+
+    if (size <= BLOCK_SIZE) {
+        block = popBlock();
+        if (block != NULL) {
+            __atomic_add_fetch(&Stats.poolAllocations, 1, __ATOMIC_RELAXED);
+
+            inUse = __atomic_add_fetch(&Stats.inUse, 1, __ATOMIC_RELAXED);
+            peak = __atomic_load_n(&Stats.peakInUse, __ATOMIC_RELAXED);
+            while (inUse > peak &&
+                   !__atomic_compare_exchange_n(&Stats.peakInUse, &peak, inUse, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+            return block;
+        }
+        __atomic_add_fetch(&Stats.exhausted, 1, __ATOMIC_RELAXED);
+    }
+
+    __atomic_add_fetch(&Stats.mallocAllocations, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void jnienet_pool_free(void* block) {
+    if (isPoolBlock(block)) {
+        __atomic_sub_fetch(&Stats.inUse, 1, __ATOMIC_RELAXED);
+        pushBlock(block);
+    }
+    else {
+        free(block);
+    }
+}
+
+int jnienet_pool_initialize_enet(void) {
+    ENetCallbacks callbacks;
+
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.malloc = jnienet_pool_malloc;
+    callbacks.free = jnienet_pool_free;
+    return enet_initialize_with_callbacks(ENET_VERSION, &callbacks);
+}
+
+static void freePacketData(ENetPacket* packet) {
+    jnienet_pool_free(packet->data);
+}
+
+ENetPacket* jnienet_pool_create_packet(size_t length, enet_uint32 flags) {
+    ENetPacket* packet;
+    void* data;
+
+    if (length == 0 || length > BLOCK_SIZE || (data = jnienet_pool_malloc(length)) == NULL) {
+        return enet_packet_create(NULL, length, flags);
+    }
+
+    packet = enet_packet_create(data, length, flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+    if (packet == NULL) {
+        jnienet_pool_free(data);
+        return NULL;
+    }
+
+    // ENet leaves NO_ALLOCATE data alone, so give the block back ourselves
+    packet->freeCallback = freePacketData;
+    return packet;
+}
+
+void jnienet_pool_get_stats(JNIENET_POOL_STATS* stats) {
+    pthread_once(&PoolOnce, initializePool);
+
+    stats->blockSize = Stats.blockSize;
+    stats->blockCount = Stats.blockCount;
+    stats->inUse = __atomic_load_n(&Stats.inUse, __ATOMIC_RELAXED);
+    stats->peakInUse = __atomic_load_n(&Stats.peakInUse, __ATOMIC_RELAXED);
+    stats->poolAllocations = __atomic_load_n(&Stats.poolAllocations, __ATOMIC_RELAXED);
+    stats->mallocAllocations = __atomic_load_n(&Stats.mallocAllocations, __ATOMIC_RELAXED);
+    stats->exhausted = __atomic_load_n(&Stats.exhausted, __ATOMIC_RELAXED);
+}
+
+#ifndef NDEBUG
+#include <time.h>
+#include <android/log.h>
+
+#define BENCH_RATE 1000         // input messages per second
+#define BENCH_IN_FLIGHT 30      // messages waiting on an acknowledgement, 30 ms of round trip
+#define BENCH_MESSAGE_SIZE 14   // a relative mouse move
+#define BENCH_ALLOCATIONS 4     // packet, data, outgoing command, acknowledgement
+
+static double benchNowNs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+// Replays what ENet allocates and frees for each input message, with
+// each message's blocks freed once the acknowledgement a round trip
+// later would have come in. returns ns per message.
+static double benchReplay(int messages, void* (*allocate)(size_t), void (*release)(void*)) {
+    static const size_t sizes[BENCH_ALLOCATIONS] = {
+        sizeof(ENetPacket), BENCH_MESSAGE_SIZE, sizeof(ENetOutgoingCommand), sizeof(ENetAcknowledgement)
+    };
+    void* inFlight[BENCH_IN_FLIGHT][BENCH_ALLOCATIONS];
+    double start;
+    int i, j, slot;
+
+    memset(inFlight, 0, sizeof(inFlight));
+
+    start = benchNowNs();
+    for (i = 0; i < messages; i++) {
+        slot = i % BENCH_IN_FLIGHT;
+        for (j = 0; j < BENCH_ALLOCATIONS; j++) {
+            if (inFlight[slot][j] != NULL) {
+                release(inFlight[slot][j]);
+            }
+            inFlight[slot][j] = allocate(sizes[j]);
+            memset(inFlight[slot][j], i, sizes[j]);
+        }
+    }
+    for (slot = 0; slot < BENCH_IN_FLIGHT; slot++) {
+        for (j = 0; j < BENCH_ALLOCATIONS; j++) {
+            if (inFlight[slot][j] != NULL) {
+                release(inFlight[slot][j]);
+            }
+        }
+    }
+
+    return (benchNowNs() - start) / messages;
+}
+
+// Replays seconds of 1 kHz input against malloc and against the pool,
+// and logs the cost per message and what the pool saw
+void jnienet_pool_benchmark(int seconds) {
+    JNIENET_POOL_STATS before, after;
+    double mallocNs, poolNs;
+
+    jnienet_pool_get_stats(&before);
+    mallocNs = benchReplay(seconds * BENCH_RATE, malloc, free);
+    poolNs = benchReplay(seconds * BENCH_RATE, jnienet_pool_malloc, jnienet_pool_free);
+    jnienet_pool_get_stats(&after);
+
+    __android_log_print(ANDROID_LOG_INFO, "jnienet",
+        "%d s of %d Hz input: malloc %.0f ns/message, pool %.0f ns/message",
+        seconds, BENCH_RATE, mallocNs, poolNs);
+    __android_log_print(ANDROID_LOG_INFO, "jnienet",
+        "Pool: %d allocations, %d fell back to malloc, peak %d of %d blocks in use",
+        after.poolAllocations - before.poolAllocations, after.mallocAllocations - before.mallocAllocations,
+        after.peakInUse, after.blockCount);
+}
+#endif
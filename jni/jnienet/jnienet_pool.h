@@ -0,0 +1,35 @@
+// Fixed-size blocks for ENet's small allocations. Every packet ENet
+// sends or receives allocates its packet struct, a command, its data
+// and an acknowledgement, which at input rates is constant malloc
+// churn. These come out of one preallocated arena instead, through a
+// lock-free free list that any thread can allocate from and free to.
+// Bigger allocations, and small ones when the arena runs dry, go to
+// malloc.
+
+typedef struct {
+    int blockSize;
+    int blockCount;
+    int inUse;
+    int peakInUse;
+    int poolAllocations;
+    // Allocations malloc had to handle, because they were too big or the pool was empty
+    int mallocAllocations;
+    int exhausted;
+} JNIENET_POOL_STATS;
+
+// Installs the pool as ENet's allocator, replaces enet_initialize
+int jnienet_pool_initialize_enet(void);
+
+void* jnienet_pool_malloc(size_t size);
+void jnienet_pool_free(void* block);
+
+// Creates a packet whose data is a pool block, sent with
+// ENET_PACKET_FLAG_NO_ALLOCATE so ENet doesn't copy it.
+// Falls back to a normal packet when it won't fit.
+ENetPacket* jnienet_pool_create_packet(size_t length, enet_uint32 flags);
+
+void jnienet_pool_get_stats(JNIENET_POOL_STATS* stats);
+
+#ifndef NDEBUG
+void jnienet_pool_benchmark(int seconds);
+#endif
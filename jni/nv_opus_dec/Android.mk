@@ -7,10 +7,12 @@ LOCAL_PATH := $(MY_LOCAL_PATH)
 
 include $(CLEAR_VARS)
 LOCAL_MODULE    := nv_opus_dec
-LOCAL_SRC_FILES := nv_opus_dec.c nv_opus_dec_jni.c
+# The spatializer's mixer is built for NEON, every Gear VR phone has it
+LOCAL_SRC_FILES := nv_opus_dec.c nv_audio_output.c nv_audio_spatial.c.neon nv_audio_sles.c nv_opus_dec_jni.c
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/libopus/inc
 
 # Link to libopus library
 LOCAL_STATIC_LIBRARIES := libopus
+LOCAL_LDLIBS    := -llog -lOpenSLES
 
 include $(BUILD_SHARED_LIBRARY)
@@ -0,0 +1,423 @@
+#include <stdlib.h>
+#include <string.h>
+#include "nv_opus_dec.h"
+#include "nv_audio_spatial.h"
+#include "nv_audio_output.h"
+
+// Input frames resampled at a time
+#define CHUNK_FRAMES 960
+
+// The longest frame Opus can decode, 120 ms at 48 KHz
+#define MAX_DECODE_FRAMES 5760
+
+// Frames of input kept from the last chunk for the interpolation
+#define HISTORY_FRAMES 3
+
+struct _NV_AUDIO_OUTPUT {
+	int channelCount;
+	int bufferFrames;
+
+	// Input frames per output frame
+	double step;
+
+	// Output frames, indexes only ever count up and are masked
+	float* ring;
+	int ringFrames;
+	int head; // only written by the writer
+	int tail; // only written by the reader
+	int overruns;
+	int underruns;
+
+	// Writer only
+	float* resampleIn;
+	float* resampleOut;
+	double position;
+	float* convertIn;
+
+	// Reader only
+	int playing;
+	float* convertOut;
+	NV_AUDIO_SPATIAL* spatial;
+	float* spatialIn;
+};
+
+NV_AUDIO_OUTPUT* nv_audio_output_create(int channelCount, int inputRate, int outputRate, int bufferFrames) {
+	NV_AUDIO_OUTPUT* output;
+	int outputChunkFrames;
+
+	output = malloc(sizeof(*output));
+	if (output == NULL) {
+		return NULL;
+	}
+
+	memset(output, 0, sizeof(*output));
+	output->channelCount = channelCount;
+	output->bufferFrames = bufferFrames;
+	output->step = (double)inputRate / outputRate;
+	output->position = 1.0;
+
+	// Room for the latency we want plus plenty of slack for bursts
+	output->ringFrames = 1;
+	while (output->ringFrames < bufferFrames * 4 || output->ringFrames < MAX_DECODE_FRAMES * 2) {
+		output->ringFrames <<= 1;
+	}
+
+	outputChunkFrames = (int)(CHUNK_FRAMES / output->step) + 2;
+	output->ring = malloc(output->ringFrames * channelCount * sizeof(float));
+	output->resampleIn = calloc((CHUNK_FRAMES + HISTORY_FRAMES) * channelCount, sizeof(float));
+	output->resampleOut = malloc(outputChunkFrames * channelCount * sizeof(float));
+	output->convertIn = malloc(CHUNK_FRAMES * channelCount * sizeof(float));
+	output->convertOut = malloc(CHUNK_FRAMES * channelCount * sizeof(float));
+	output->spatialIn = malloc(CHUNK_FRAMES * channelCount * sizeof(float));
+	if (output->ring == NULL || output->resampleIn == NULL || output->resampleOut == NULL ||
+		output->convertIn == NULL || output->convertOut == NULL || output->spatialIn == NULL) {
+		nv_audio_output_free(output);
+		return NULL;
+	}
+
+	return output;
+}
+
+void nv_audio_output_free(NV_AUDIO_OUTPUT* output) {
+	if (output != NULL) {
+		free(output->ring);
+		free(output->resampleIn);
+		free(output->resampleOut);
+		free(output->convertIn);
+		free(output->convertOut);
+		free(output->spatialIn);
+		free(output);
+	}
+}
+
+// returns the number of frames dropped
+static int pushFrames(NV_AUDIO_OUTPUT* output, const float* pcm, int frames) {
+	int head = output->head;
+	int tail = __atomic_load_n(&output->tail, __ATOMIC_ACQUIRE);
+	int space = output->ringFrames - (head - tail);
+	int dropped = 0;
+	int offset, count;
+
+	if (frames > space) {
+		// The reader has stopped, so keep what's already queued
+		dropped = frames - space;
+		frames = space;
+		__atomic_add_fetch(&output->overruns, 1, __ATOMIC_RELAXED);
+	}
+
+	while (frames > 0) {
+		offset = head & (output->ringFrames - 1);
+		count = output->ringFrames - offset;
+		if (count > frames) {
+			count = frames;
+		}
+
+		memcpy(&output->ring[offset * output->channelCount], pcm,
+			   count * output->channelCount * sizeof(float));
+		pcm += count * output->channelCount;
+		head += count;
+		frames -= count;
+	}
+
+	__atomic_store_n(&output->head, head, __ATOMIC_RELEASE);
+	return dropped;
+}
+
+// Cubic Hermite interpolation between y1 and y2
+static float interpolate(float y0, float y1, float y2, float y3, float t) {
+	float c1 = 0.5f * (y2 - y0);
+	float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+	float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+	return ((c3 * t + c2) * t + c1) * t + y1;
+}
+
+// returns the number of output frames
+static int resampleChunk(NV_AUDIO_OUTPUT* output, const float* pcm, int frames) {
+	const int channels = output->channelCount;
+	float* in = output->resampleIn;
+	float* out = output->resampleOut;
+	double position = output->position;
+	int outFrames = 0;
+	int i, c;
+
+	// The chunk goes after the end of the last one
+	memcpy(&in[HISTORY_FRAMES * channels], pcm, frames * channels * sizeof(float));
+
+	// Each output frame needs the input frame before and the two after its position
+	while (position < frames + 1) {
+		const float* y;
+		float t;
+
+		i = (int)position;
+		t = (float)(position - i);
+		y = &in[(i - 1) * channels];
+		for (c = 0; c < channels; c++) {
+			out[outFrames * channels + c] = interpolate(y[c], y[channels + c],
+				y[2 * channels + c], y[3 * channels + c], t);
+		}
+
+		outFrames++;
+		position += output->step;
+	}
+
+	output->position = position - frames;
+	memmove(in, &in[frames * channels], HISTORY_FRAMES * channels * sizeof(float));
+
+	return outFrames;
+}
+
+int nv_audio_output_write_float(NV_AUDIO_OUTPUT* output, const float* pcm, int frames) {
+	int dropped = 0;
+	int count;
+
+	if (output->step == 1.0) {
+		return pushFrames(output, pcm, frames);
+	}
+
+	while (frames > 0) {
+		count = frames < CHUNK_FRAMES ? frames : CHUNK_FRAMES;
+		dropped += pushFrames(output, output->resampleOut, resampleChunk(output, pcm, count));
+		pcm += count * output->channelCount;
+		frames -= count;
+	}
+
+	return dropped;
+}
+
+int nv_audio_output_write_short(NV_AUDIO_OUTPUT* output, const short* pcm, int frames) {
+	int dropped = 0;
+	int count;
+	int i;
+
+	while (frames > 0) {
+		count = frames < CHUNK_FRAMES ? frames : CHUNK_FRAMES;
+		for (i = 0; i < count * output->channelCount; i++) {
+			output->convertIn[i] = pcm[i] * (1.0f / 32768.0f);
+		}
+
+		dropped += nv_audio_output_write_float(output, output->convertIn, count);
+		pcm += count * output->channelCount;
+		frames -= count;
+	}
+
+	return dropped;
+}
+
+void nv_audio_output_set_spatial(NV_AUDIO_OUTPUT* output, NV_AUDIO_SPATIAL* spatial) {
+	output->spatial = spatial;
+}
+
+// Frames as the reader gets them
+static int readChannels(NV_AUDIO_OUTPUT* output) {
+	return output->spatial != NULL ? 2 : output->channelCount;
+}
+
+static int readFrames(NV_AUDIO_OUTPUT* output, float* pcm, int frames) {
+	const int channels = output->channelCount;
+	int head = __atomic_load_n(&output->head, __ATOMIC_ACQUIRE);
+	int tail = output->tail;
+	int available = head - tail;
+	int played = 0;
+	int offset, count;
+
+	if (!output->playing) {
+		// Fill up to the latency we want before starting, and again after running dry
+		if (available < output->bufferFrames) {
+			memset(pcm, 0, frames * channels * sizeof(float));
+			return 0;
+		}
+		output->playing = 1;
+	}
+	else if (available > output->bufferFrames * 2 + frames) {
+		// The writer's clock runs faster than ours, so catch up
+		// rather than letting the latency grow
+		tail = head - output->bufferFrames - frames;
+		available = head - tail;
+	}
+
+	while (played < frames && played < available) {
+		offset = tail & (output->ringFrames - 1);
+		count = output->ringFrames - offset;
+		if (count > frames - played) {
+			count = frames - played;
+		}
+		if (count > available - played) {
+			count = available - played;
+		}
+
+		memcpy(&pcm[played * channels], &output->ring[offset * channels],
+			   count * channels * sizeof(float));
+		tail += count;
+		played += count;
+	}
+
+	if (played < frames) {
+		memset(&pcm[played * channels], 0, (frames - played) * channels * sizeof(float));
+		__atomic_add_fetch(&output->underruns, 1, __ATOMIC_RELAXED);
+		output->playing = 0;
+	}
+
+	__atomic_store_n(&output->tail, tail, __ATOMIC_RELEASE);
+	return played;
+}
+
+int nv_audio_output_read_float(NV_AUDIO_OUTPUT* output, float* pcm, int frames) {
+	int played = 0;
+	int count;
+
+	if (output->spatial == NULL) {
+		return readFrames(output, pcm, frames);
+	}
+
+	// Spatialized as late as possible, so it has the freshest head pose
+	while (frames > 0) {
+		count = frames < CHUNK_FRAMES ? frames : CHUNK_FRAMES;
+		played += readFrames(output, output->spatialIn, count);
+		nv_audio_spatial_process(output->spatial, output->spatialIn, pcm, count);
+		pcm += count * 2;
+		frames -= count;
+	}
+
+	return played;
+}
+
+int nv_audio_output_read_short(NV_AUDIO_OUTPUT* output, short* pcm, int frames) {
+	const int channels = readChannels(output);
+	int played = 0;
+	int count;
+	int i;
+
+	while (frames > 0) {
+		count = frames < CHUNK_FRAMES ? frames : CHUNK_FRAMES;
+		played += nv_audio_output_read_float(output, output->convertOut, count);
+
+		for (i = 0; i < count * channels; i++) {
+			float sample = output->convertOut[i] * 32768.0f;
+			if (sample > 32767.0f) {
+				sample = 32767.0f;
+			}
+			else if (sample < -32768.0f) {
+				sample = -32768.0f;
+			}
+			pcm[i] = (short)sample;
+		}
+
+		pcm += count * channels;
+		frames -= count;
+	}
+
+	return played;
+}
+
+int nv_audio_output_get_buffered(NV_AUDIO_OUTPUT* output) {
+	return __atomic_load_n(&output->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&output->tail, __ATOMIC_ACQUIRE);
+}
+
+int nv_audio_output_get_underruns(NV_AUDIO_OUTPUT* output) {
+	return __atomic_load_n(&output->underruns, __ATOMIC_RELAXED);
+}
+
+int nv_audio_output_get_overruns(NV_AUDIO_OUTPUT* output) {
+	return __atomic_load_n(&output->overruns, __ATOMIC_RELAXED);
+}
+
+#ifndef NDEBUG
+#include <math.h>
+#include <time.h>
+#include <opus_multistream.h>
+#include <android/log.h>
+
+#define BENCH_PACKET_FRAMES 240 // GFE sends 5 ms frames
+
+static double benchNowNs(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+// Decodes a stereo stream on its own, then again written into the ring
+// and resampled, as NativeAudioSink.write does, with a null sink pulling output frames
+// every 5 ms like an OpenSL ES callback would, and logs the cost per
+// packet along with how much latency the ring holds
+void nv_audio_output_benchmark(int outputRate, int seconds) {
+	static const unsigned char mapping[2] = { 0, 1 };
+	const int packetCount = seconds * 48000 / BENCH_PACKET_FRAMES;
+	const int sinkFrames = outputRate * 5 / 1000;
+	unsigned char (*packets)[1000];
+	int* lengths;
+	OpusMSEncoder* encoder;
+	NV_OPUS_DECODER* decoder;
+	NV_AUDIO_OUTPUT* output;
+	short* pcm;
+	double start, decodeNs, writeNs, sinkNs;
+	double bufferedSum = 0;
+	int bufferedMax = 0;
+	int err;
+	int i, j;
+
+	packets = malloc(packetCount * sizeof(*packets));
+	lengths = malloc(packetCount * sizeof(*lengths));
+	pcm = malloc(MAX_DECODE_FRAMES * 2 * sizeof(*pcm));
+	encoder = opus_multistream_encoder_create(48000, 2, 1, 1, mapping, OPUS_APPLICATION_AUDIO, &err);
+	decoder = nv_opus_create(48000, 2, 1, 1, mapping, BENCH_PACKET_FRAMES, &err);
+	output = nv_audio_output_create(2, 48000, outputRate, sinkFrames * 2);
+	if (packets == NULL || lengths == NULL || pcm == NULL || encoder == NULL || decoder == NULL || output == NULL) {
+		__android_log_print(ANDROID_LOG_ERROR, "nv_audio_output", "Benchmark setup failed");
+		goto cleanup;
+	}
+
+	for (i = 0; i < packetCount; i++) {
+		for (j = 0; j < BENCH_PACKET_FRAMES * 2; j++) {
+			pcm[j] = (short)(8000 * sin((i * (double)BENCH_PACKET_FRAMES + j / 2) * (j % 2 ? 440 : 660) * 2 * M_PI / 48000));
+		}
+		lengths[i] = opus_multistream_encode(encoder, pcm, BENCH_PACKET_FRAMES, packets[i], sizeof(packets[i]));
+	}
+
+	start = benchNowNs();
+	for (i = 0; i < packetCount; i++) {
+		nv_opus_decode(decoder, packets[i], lengths[i], pcm);
+	}
+	decodeNs = benchNowNs() - start;
+
+	writeNs = 0;
+	sinkNs = 0;
+	for (i = 0; i < packetCount; i++) {
+		start = benchNowNs();
+		j = nv_opus_decode(decoder, packets[i], lengths[i], pcm);
+		if (j > 0) {
+			nv_audio_output_write_short(output, pcm, j);
+		}
+		writeNs += benchNowNs() - start;
+
+		// Pull exactly 5 ms worth on average, even when that's a fraction of a frame
+		start = benchNowNs();
+		nv_audio_output_read_short(output, pcm,
+			(int)((i + 1) * (long long)outputRate / 200 - i * (long long)outputRate / 200));
+		sinkNs += benchNowNs() - start;
+
+		j = nv_audio_output_get_buffered(output);
+		bufferedSum += j;
+		if (j > bufferedMax) {
+			bufferedMax = j;
+		}
+	}
+
+	__android_log_print(ANDROID_LOG_INFO, "nv_audio_output",
+		"%d packets to %d Hz: decode %.0f ns/packet, decode+write %.0f ns/packet, sink %.0f ns/callback",
+		packetCount, outputRate, decodeNs / packetCount, writeNs / packetCount, sinkNs / packetCount);
+	__android_log_print(ANDROID_LOG_INFO, "nv_audio_output",
+		"Ring latency: %.2f ms average, %.2f ms max, %d underruns, %d overruns",
+		bufferedSum / packetCount * 1000 / outputRate, bufferedMax * 1000.0 / outputRate,
+		nv_audio_output_get_underruns(output), nv_audio_output_get_overruns(output));
+
+cleanup:
+	if (encoder != NULL) {
+		opus_multistream_encoder_destroy(encoder);
+	}
+	nv_audio_output_free(output);
+	nv_opus_free(decoder);
+	free(pcm);
+	free(lengths);
+	free(packets);
+}
+#endif
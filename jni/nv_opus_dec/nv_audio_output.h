@@ -0,0 +1,35 @@
+typedef struct _NV_AUDIO_OUTPUT NV_AUDIO_OUTPUT;
+
+// Floating point PCM ring between the thread that decodes audio and the
+// audio callback that plays it. Audio is resampled to the output rate on
+// the way in, so the platform doesn't add a resampler and its buffering.
+// One thread may write and one other thread may read without locking.
+
+// bufferFrames is the latency to aim for, in output frames
+NV_AUDIO_OUTPUT* nv_audio_output_create(int channelCount, int inputRate, int outputRate, int bufferFrames);
+void nv_audio_output_free(NV_AUDIO_OUTPUT* output);
+
+// Writer side, frames are in the input rate
+// returns the number of frames dropped because the ring was full
+int nv_audio_output_write_float(NV_AUDIO_OUTPUT* output, const float* pcm, int frames);
+int nv_audio_output_write_short(NV_AUDIO_OUTPUT* output, const short* pcm, int frames);
+
+// Spatializes into stereo as the reader reads, with whatever the screen's
+// position is at the time. Set it before reading starts, the output
+// doesn't own it.
+void nv_audio_output_set_spatial(NV_AUDIO_OUTPUT* output, NV_AUDIO_SPATIAL* spatial);
+
+// Reader side, fills all frames with silence where there's nothing to play.
+// Frames have the input's channels, or 2 when spatialized.
+// returns the number of frames that were real audio
+int nv_audio_output_read_float(NV_AUDIO_OUTPUT* output, float* pcm, int frames);
+int nv_audio_output_read_short(NV_AUDIO_OUTPUT* output, short* pcm, int frames);
+
+// Output frames waiting to be read
+int nv_audio_output_get_buffered(NV_AUDIO_OUTPUT* output);
+int nv_audio_output_get_underruns(NV_AUDIO_OUTPUT* output);
+int nv_audio_output_get_overruns(NV_AUDIO_OUTPUT* output);
+
+#ifndef NDEBUG
+void nv_audio_output_benchmark(int outputRate, int seconds);
+#endif
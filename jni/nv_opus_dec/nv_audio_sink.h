@@ -0,0 +1,19 @@
+// What the app's native code sets on NativeAudioSink directly, rather
+// than through Java. libcinema links against this library for it.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The screen's center and the world's up direction in head space, as for
+// nv_audio_spatial_set_screen. Called every rendered frame, does nothing
+// unless the sink is spatializing.
+void nv_audio_sink_set_screen(const float center[3], const float up[3], float width);
+
+// Whether the channels play from around the virtual screen as stereo, for
+// layouts the spatializer knows. Read when the sink starts, off until set.
+void nv_audio_sink_set_spatialize(int spatialize);
+
+#ifdef __cplusplus
+}
+#endif
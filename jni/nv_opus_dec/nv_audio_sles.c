@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <string.h>
+#include <SLES/OpenSLES.h>
+#include <SLES/OpenSLES_Android.h>
+#include <android/log.h>
+#include "nv_opus_dec.h"
+#include "nv_audio_spatial.h"
+#include "nv_audio_output.h"
+#include "nv_audio_sles.h"
+
+#define BUFFER_COUNT 2
+
+struct _NV_AUDIO_SLES {
+	SLObjectItf engineObject;
+	SLEngineItf engine;
+	SLObjectItf outputMixObject;
+	SLObjectItf playerObject;
+	SLPlayItf play;
+	SLAndroidSimpleBufferQueueItf queue;
+
+	NV_AUDIO_OUTPUT* output;
+	int channelCount;
+	int framesPerBuffer;
+	short* buffers[BUFFER_COUNT];
+	int nextBuffer;
+};
+
+static SLuint32 channelMaskFor(int channelCount) {
+	switch (channelCount) {
+	case 1:
+		return SL_SPEAKER_FRONT_CENTER;
+	case 2:
+		return SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT;
+	case 4:
+		return SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT |
+			   SL_SPEAKER_BACK_LEFT | SL_SPEAKER_BACK_RIGHT;
+	case 6:
+		return SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT | SL_SPEAKER_FRONT_CENTER |
+			   SL_SPEAKER_LOW_FREQUENCY | SL_SPEAKER_BACK_LEFT | SL_SPEAKER_BACK_RIGHT;
+	default:
+		return 0;
+	}
+}
+
+// Runs on the OpenSL ES audio thread whenever a buffer has been played
+static void bufferQueueCallback(SLAndroidSimpleBufferQueueItf queue, void* context) {
+	NV_AUDIO_SLES* player = context;
+	short* buffer = player->buffers[player->nextBuffer];
+
+	nv_audio_output_read_short(player->output, buffer, player->framesPerBuffer);
+	(*queue)->Enqueue(queue, buffer, player->framesPerBuffer * player->channelCount * sizeof(short));
+
+	player->nextBuffer = (player->nextBuffer + 1) % BUFFER_COUNT;
+}
+
+NV_AUDIO_SLES* nv_audio_sles_start(NV_AUDIO_OUTPUT* output, int channelCount, int outputRate, int framesPerBuffer) {
+	NV_AUDIO_SLES* player;
+	SLDataLocator_AndroidSimpleBufferQueue queueLocator = { SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, BUFFER_COUNT };
+	SLDataFormat_PCM format;
+	SLDataSource source = { &queueLocator, &format };
+	SLDataLocator_OutputMix outputMixLocator;
+	SLDataSink sink = { &outputMixLocator, NULL };
+	const SLInterfaceID ids[1] = { SL_IID_ANDROIDSIMPLEBUFFERQUEUE };
+	const SLboolean req[1] = { SL_BOOLEAN_TRUE };
+	SLresult res = SL_RESULT_MEMORY_FAILURE;
+	int i;
+
+	if (channelMaskFor(channelCount) == 0) {
+		return NULL;
+	}
+
+	player = malloc(sizeof(*player));
+	if (player == NULL) {
+		return NULL;
+	}
+
+	memset(player, 0, sizeof(*player));
+	player->output = output;
+	player->channelCount = channelCount;
+	player->framesPerBuffer = framesPerBuffer;
+	for (i = 0; i < BUFFER_COUNT; i++) {
+		player->buffers[i] = malloc(framesPerBuffer * channelCount * sizeof(short));
+		if (player->buffers[i] == NULL) {
+			goto fail;
+		}
+	}
+
+	res = slCreateEngine(&player->engineObject, 0, NULL, 0, NULL, NULL);
+	if (res != SL_RESULT_SUCCESS) {
+		goto fail;
+	}
+	res = (*player->engineObject)->Realize(player->engineObject, SL_BOOLEAN_FALSE);
+	if (res != SL_RESULT_SUCCESS) {
+		goto fail;
+	}
+	res = (*player->engineObject)->GetInterface(player->engineObject, SL_IID_ENGINE, &player->engine);
+	if (res != SL_RESULT_SUCCESS) {
+		goto fail;
+	}
+
+	res = (*player->engine)->CreateOutputMix(player->engine, &player->outputMixObject, 0, NULL, NULL);
+	if (res != SL_RESULT_SUCCESS) {
+		goto fail;
+	}
+	res = (*player->outputMixObject)->Realize(player->outputMixObject, SL_BOOLEAN_FALSE);
+	if (res != SL_RESULT_SUCCESS) {
+		goto fail;
+	}
+
+	format.formatType = SL_DATAFORMAT_PCM;
+	format.numChannels = channelCount;
+	format.samplesPerSec = outputRate * 1000; // milliHertz
+	format.bitsPerSample = SL_PCMSAMPLEFORMAT_FIXED_16;
+	format.containerSize = SL_PCMSAMPLEFORMAT_FIXED_16;
+	format.channelMask = channelMaskFor(channelCount);
+	format.endianness = SL_BYTEORDER_LITTLEENDIAN;
+	outputMixLocator.locatorType = SL_DATALOCATOR_OUTPUTMIX;
+	outputMixLocator.outputMix = player->outputMixObject;
+
+	res = (*player->engine)->CreateAudioPlayer(player->engine, &player->playerObject, &source, &sink, 1, ids, req);
+	if (res != SL_RESULT_SUCCESS) {
+		goto fail;
+	}
+	res = (*player->playerObject)->Realize(player->playerObject, SL_BOOLEAN_FALSE);
+	if (res != SL_RESULT_SUCCESS) {
+		goto fail;
+	}
+	res = (*player->playerObject)->GetInterface(player->playerObject, SL_IID_PLAY, &player->play);
+	if (res != SL_RESULT_SUCCESS) {
+		goto fail;
+	}
+	res = (*player->playerObject)->GetInterface(player->playerObject, SL_IID_ANDROIDSIMPLEBUFFERQUEUE, &player->queue);
+	if (res != SL_RESULT_SUCCESS) {
+		goto fail;
+	}
+	res = (*player->queue)->RegisterCallback(player->queue, bufferQueueCallback, player);
+	if (res != SL_RESULT_SUCCESS) {
+		goto fail;
+	}
+
+	// Queue up silence to get the callbacks going
+	for (i = 0; i < BUFFER_COUNT; i++) {
+		bufferQueueCallback(player->queue, player);
+	}
+
+	res = (*player->play)->SetPlayState(player->play, SL_PLAYSTATE_PLAYING);
+	if (res != SL_RESULT_SUCCESS) {
+		goto fail;
+	}
+
+	__android_log_print(ANDROID_LOG_INFO, "nv_audio_sles", "Playing %d channels at %d Hz, %d frames per buffer",
+		channelCount, outputRate, framesPerBuffer);
+	return player;
+
+fail:
+	__android_log_print(ANDROID_LOG_ERROR, "nv_audio_sles", "OpenSL ES setup failed: %d", (int)res);
+	nv_audio_sles_stop(player);
+	return NULL;
+}
+
+void nv_audio_sles_stop(NV_AUDIO_SLES* player) {
+	int i;
+
+	if (player == NULL) {
+		return;
+	}
+
+	// Destroying the player waits for its callback to finish
+	if (player->playerObject != NULL) {
+		(*player->playerObject)->Destroy(player->playerObject);
+	}
+	if (player->outputMixObject != NULL) {
+		(*player->outputMixObject)->Destroy(player->outputMixObject);
+	}
+	if (player->engineObject != NULL) {
+		(*player->engineObject)->Destroy(player->engineObject);
+	}
+
+	for (i = 0; i < BUFFER_COUNT; i++) {
+		free(player->buffers[i]);
+	}
+	free(player);
+}
@@ -0,0 +1,10 @@
+typedef struct _NV_AUDIO_SLES NV_AUDIO_SLES;
+
+// Plays an NV_AUDIO_OUTPUT through an OpenSL ES buffer queue. The buffer
+// queue callback reads straight out of the ring, so there's no Java
+// AudioTrack buffer or platform resampler in the way when outputRate
+// and framesPerBuffer are the device's native ones.
+//
+// Samples go out as 16-bit because float buffer queues need API 21.
+NV_AUDIO_SLES* nv_audio_sles_start(NV_AUDIO_OUTPUT* output, int channelCount, int outputRate, int framesPerBuffer);
+void nv_audio_sles_stop(NV_AUDIO_SLES* player);
@@ -0,0 +1,521 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "nv_audio_spatial.h"
+
+#define MAX_CHANNELS 8
+
+// Frames mixed at a time, a multiple of 4
+#define BLOCK_FRAMES 256
+
+// Head radius and speed of sound for the interaural time difference
+#define HEAD_RADIUS 0.0875f
+#define SPEED_OF_SOUND 343.0f
+
+// Keeps a mono source in front at the level it had in each ear before
+#define MASTER_GAIN 0.7071f
+#define LFE_GAIN 0.5f
+
+// How far a channel's delay may move per processed buffer, in samples.
+// Big jumps (the screen being recentered) glide instead of clicking.
+#define MAX_DELAY_STEP 1.0f
+
+// 4 floats wide, which GCC and clang turn into NEON or SSE registers
+typedef float v4sf __attribute__((vector_size(16)));
+typedef float v4sf_u __attribute__((vector_size(16), aligned(4)));
+
+enum {
+	SPEAKER_SCREEN, // position is across the screen, -1 left edge to 1 right edge
+	SPEAKER_ROOM,   // position is degrees around the seat from the screen, positive to the left
+	SPEAKER_LFE     // no direction
+};
+
+typedef struct {
+	int type;
+	float position;
+} SPEAKER;
+
+static const SPEAKER StereoSpeakers[2] = {
+	{ SPEAKER_SCREEN, -1.0f }, { SPEAKER_SCREEN, 1.0f }
+};
+static const SPEAKER Surround51Speakers[6] = {
+	{ SPEAKER_SCREEN, -1.0f }, { SPEAKER_SCREEN, 1.0f }, { SPEAKER_SCREEN, 0.0f },
+	{ SPEAKER_LFE, 0.0f }, { SPEAKER_ROOM, 110.0f }, { SPEAKER_ROOM, -110.0f }
+};
+static const SPEAKER Surround71Speakers[8] = {
+	{ SPEAKER_SCREEN, -1.0f }, { SPEAKER_SCREEN, 1.0f }, { SPEAKER_SCREEN, 0.0f },
+	{ SPEAKER_LFE, 0.0f }, { SPEAKER_ROOM, 150.0f }, { SPEAKER_ROOM, -150.0f },
+	{ SPEAKER_ROOM, 90.0f }, { SPEAKER_ROOM, -90.0f }
+};
+
+// What one channel sounds like at one ear
+typedef struct {
+	float gain;
+	float shadow; // 0 for none to 0.5 for a 2 tap average
+	float delay;  // in samples
+} EAR_PARAMS;
+
+// Adds one channel to one ear, taps ramping linearly from a by b per frame
+typedef void (*MIX_FUNCTION)(float* mix, const float* x, const float* a, const float* b, int frames);
+
+struct _NV_AUDIO_SPATIAL {
+	int channelCount;
+	const SPEAKER* speakers;
+	float sampleRate;
+	int historyFrames;
+
+	// Written by set_screen, odd while it's being written
+	int screenSeq;
+	float screen[7];
+
+	// Process thread only
+	int primed;
+	EAR_PARAMS current[MAX_CHANNELS][2];
+	float* planes[MAX_CHANNELS];
+	float* mix[2];
+};
+
+NV_AUDIO_SPATIAL* nv_audio_spatial_create(int channelCount, int sampleRate) {
+	static const float center[3] = { 0.0f, 0.0f, -3.0f };
+	static const float up[3] = { 0.0f, 1.0f, 0.0f };
+	NV_AUDIO_SPATIAL* spatial;
+	int maxDelay;
+	int i;
+
+	spatial = malloc(sizeof(*spatial));
+	if (spatial == NULL) {
+		return NULL;
+	}
+
+	memset(spatial, 0, sizeof(*spatial));
+	spatial->channelCount = channelCount;
+	spatial->sampleRate = sampleRate;
+	switch (channelCount) {
+	case 2:
+		spatial->speakers = StereoSpeakers;
+		break;
+	case 6:
+		spatial->speakers = Surround51Speakers;
+		break;
+	case 8:
+		spatial->speakers = Surround71Speakers;
+		break;
+	default:
+		free(spatial);
+		return NULL;
+	}
+
+	// The longest interaural delay plus the taps behind it, rounded up to whole vectors
+	maxDelay = (int)ceilf(HEAD_RADIUS / SPEED_OF_SOUND * (M_PI / 2 + 1) * sampleRate) + 1;
+	spatial->historyFrames = (maxDelay + 3 + 3) & ~3;
+
+	for (i = 0; i < channelCount; i++) {
+		spatial->planes[i] = calloc(spatial->historyFrames + BLOCK_FRAMES, sizeof(float));
+		if (spatial->planes[i] == NULL) {
+			nv_audio_spatial_free(spatial);
+			return NULL;
+		}
+	}
+	for (i = 0; i < 2; i++) {
+		spatial->mix[i] = malloc(BLOCK_FRAMES * sizeof(float));
+		if (spatial->mix[i] == NULL) {
+			nv_audio_spatial_free(spatial);
+			return NULL;
+		}
+	}
+
+	// Until we hear otherwise, the screen is straight ahead
+	nv_audio_spatial_set_screen(spatial, center, up, 4.0f);
+
+	return spatial;
+}
+
+void nv_audio_spatial_free(NV_AUDIO_SPATIAL* spatial) {
+	int i;
+
+	if (spatial != NULL) {
+		for (i = 0; i < MAX_CHANNELS; i++) {
+			free(spatial->planes[i]);
+		}
+		free(spatial->mix[0]);
+		free(spatial->mix[1]);
+		free(spatial);
+	}
+}
+
+int nv_audio_spatial_get_channel_count(NV_AUDIO_SPATIAL* spatial) {
+	return spatial->channelCount;
+}
+
+// Only one thread calls this at a time, so a sequence lock lets the
+// audio thread read a consistent screen without ever blocking
+void nv_audio_spatial_set_screen(NV_AUDIO_SPATIAL* spatial, const float center[3], const float up[3], float width) {
+	int seq = __atomic_load_n(&spatial->screenSeq, __ATOMIC_RELAXED);
+	int i;
+
+	__atomic_store_n(&spatial->screenSeq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	for (i = 0; i < 3; i++) {
+		__atomic_store(&spatial->screen[i], &center[i], __ATOMIC_RELAXED);
+		__atomic_store(&spatial->screen[3 + i], &up[i], __ATOMIC_RELAXED);
+	}
+	__atomic_store(&spatial->screen[6], &width, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&spatial->screenSeq, seq + 2, __ATOMIC_RELEASE);
+}
+
+static void readScreen(NV_AUDIO_SPATIAL* spatial, float screen[7]) {
+	int before, after;
+	int i;
+
+	do {
+		before = __atomic_load_n(&spatial->screenSeq, __ATOMIC_ACQUIRE);
+		for (i = 0; i < 7; i++) {
+			__atomic_load(&spatial->screen[i], &screen[i], __ATOMIC_RELAXED);
+		}
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		after = __atomic_load_n(&spatial->screenSeq, __ATOMIC_RELAXED);
+	} while ((before & 1) || before != after);
+}
+
+static float dot(const float a[3], const float b[3]) {
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void cross(const float a[3], const float b[3], float out[3]) {
+	out[0] = a[1] * b[2] - a[2] * b[1];
+	out[1] = a[2] * b[0] - a[0] * b[2];
+	out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// returns 0 if v is too short to have a direction
+static int normalize(float v[3]) {
+	float length = sqrtf(dot(v, v));
+	if (length < 1e-4f) {
+		return 0;
+	}
+	v[0] /= length;
+	v[1] /= length;
+	v[2] /= length;
+	return 1;
+}
+
+// Spherical head model for a source in direction dir (unit, head space)
+static void earParams(const NV_AUDIO_SPATIAL* spatial, const float dir[3], EAR_PARAMS ears[2]) {
+	// Woodworth's formula, the far ear hears it later by this much
+	float lateral = asinf(fminf(fmaxf(dir[0], -1.0f), 1.0f));
+	float itd = HEAD_RADIUS / SPEED_OF_SOUND * (fabsf(lateral) + fabsf(dir[0])) * spatial->sampleRate;
+	// Sources behind sound duller in both ears
+	float behind = 0.25f * fmaxf(dir[2], 0.0f);
+	int ear;
+
+	for (ear = 0; ear < 2; ear++) {
+		// 1 when the source is on this ear's side, -1 on the far side
+		float facing = (ear == 0) ? -dir[0] : dir[0];
+
+		// About 10 dB quieter in the far ear than the near one
+		ears[ear].gain = MASTER_GAIN * sqrtf(0.5f * (1.0f + 0.8f * facing));
+		ears[ear].shadow = fminf(0.5f * fmaxf(-facing, 0.0f) + behind, 0.5f);
+		ears[ear].delay = (facing < 0.0f) ? itd : 0.0f;
+	}
+}
+
+// Where every channel should end up with the screen where it is now
+static void targetParams(NV_AUDIO_SPATIAL* spatial, EAR_PARAMS targets[][2]) {
+	static const float Forward[3] = { 0.0f, 0.0f, -1.0f };
+	static const float Right[3] = { 1.0f, 0.0f, 0.0f };
+	float screen[7];
+	float* center = &screen[0];
+	float* up = &screen[3];
+	float fwd[3], level[3], right[3], dir[3], axis[3];
+	float along, c, s;
+	int i, j;
+
+	readScreen(spatial, screen);
+	if (!normalize(up)) {
+		up[0] = 0.0f;
+		up[1] = 1.0f;
+		up[2] = 0.0f;
+	}
+
+	memcpy(fwd, center, sizeof(fwd));
+	if (!normalize(fwd)) {
+		memcpy(fwd, Forward, sizeof(fwd));
+	}
+
+	// The screen's horizontal axis, as seen from where we sit
+	cross(fwd, up, right);
+	if (!normalize(right)) {
+		memcpy(right, Right, sizeof(right));
+	}
+
+	// The room speakers stay level with the seat whatever the screen's tilt
+	along = dot(fwd, up);
+	for (j = 0; j < 3; j++) {
+		level[j] = fwd[j] - up[j] * along;
+	}
+	if (!normalize(level)) {
+		cross(up, right, level);
+	}
+
+	for (i = 0; i < spatial->channelCount; i++) {
+		const SPEAKER* speaker = &spatial->speakers[i];
+
+		switch (speaker->type) {
+		case SPEAKER_SCREEN:
+			for (j = 0; j < 3; j++) {
+				dir[j] = center[j] + right[j] * speaker->position * screen[6] * 0.5f;
+			}
+			if (!normalize(dir)) {
+				memcpy(dir, fwd, sizeof(dir));
+			}
+			earParams(spatial, dir, targets[i]);
+			break;
+
+		case SPEAKER_ROOM:
+			// Rotate the level forward direction about up
+			c = cosf(speaker->position * (float)M_PI / 180.0f);
+			s = sinf(speaker->position * (float)M_PI / 180.0f);
+			cross(up, level, axis);
+			for (j = 0; j < 3; j++) {
+				dir[j] = level[j] * c + axis[j] * s;
+			}
+			earParams(spatial, dir, targets[i]);
+			break;
+
+		default:
+			for (j = 0; j < 2; j++) {
+				targets[i][j].gain = MASTER_GAIN * LFE_GAIN;
+				targets[i][j].shadow = 0.0f;
+				targets[i][j].delay = 0.0f;
+			}
+			break;
+		}
+	}
+}
+
+static EAR_PARAMS lerpParams(const EAR_PARAMS* from, const EAR_PARAMS* to, float t) {
+	EAR_PARAMS params;
+	params.gain = from->gain + (to->gain - from->gain) * t;
+	params.shadow = from->shadow + (to->shadow - from->shadow) * t;
+	params.delay = from->delay + (to->delay - from->delay) * t;
+	return params;
+}
+
+// Linear interpolation for the fractional delay, then the shadow's
+// 2 tap low pass, folded into 4 taps behind sample base
+static void paramTaps(const EAR_PARAMS* params, int base, float taps[4]) {
+	float f = params->delay - base;
+	float k = params->shadow;
+	float w0, w1, w2;
+
+	if (f < 1.0f) {
+		w0 = 1.0f - f;
+		w1 = f;
+		w2 = 0.0f;
+	}
+	else {
+		w0 = 0.0f;
+		w1 = 2.0f - f;
+		w2 = f - 1.0f;
+	}
+
+	taps[0] = params->gain * (1.0f - k) * w0;
+	taps[1] = params->gain * ((1.0f - k) * w1 + k * w0);
+	taps[2] = params->gain * ((1.0f - k) * w2 + k * w1);
+	taps[3] = params->gain * k * w2;
+}
+
+static void mixChannel(float* mix, const float* x, const float* a, const float* b, int frames) {
+	v4sf t0 = { a[0], a[0] + b[0], a[0] + 2 * b[0], a[0] + 3 * b[0] };
+	v4sf t1 = { a[1], a[1] + b[1], a[1] + 2 * b[1], a[1] + 3 * b[1] };
+	v4sf t2 = { a[2], a[2] + b[2], a[2] + 2 * b[2], a[2] + 3 * b[2] };
+	v4sf t3 = { a[3], a[3] + b[3], a[3] + 2 * b[3], a[3] + 3 * b[3] };
+	const v4sf d0 = { 4 * b[0], 4 * b[0], 4 * b[0], 4 * b[0] };
+	const v4sf d1 = { 4 * b[1], 4 * b[1], 4 * b[1], 4 * b[1] };
+	const v4sf d2 = { 4 * b[2], 4 * b[2], 4 * b[2], 4 * b[2] };
+	const v4sf d3 = { 4 * b[3], 4 * b[3], 4 * b[3], 4 * b[3] };
+	int n;
+
+	for (n = 0; n + 4 <= frames; n += 4) {
+		v4sf acc = *(v4sf_u*)&mix[n];
+		acc += t0 * *(const v4sf_u*)&x[n];
+		acc += t1 * *(const v4sf_u*)&x[n - 1];
+		acc += t2 * *(const v4sf_u*)&x[n - 2];
+		acc += t3 * *(const v4sf_u*)&x[n - 3];
+		*(v4sf_u*)&mix[n] = acc;
+
+		t0 += d0;
+		t1 += d1;
+		t2 += d2;
+		t3 += d3;
+	}
+
+	for (; n < frames; n++) {
+		mix[n] += (a[0] + b[0] * n) * x[n] + (a[1] + b[1] * n) * x[n - 1] +
+			(a[2] + b[2] * n) * x[n - 2] + (a[3] + b[3] * n) * x[n - 3];
+	}
+}
+
+static void processWith(NV_AUDIO_SPATIAL* spatial, const float* in, float* out, int frames, MIX_FUNCTION mixFunction) {
+	const int channels = spatial->channelCount;
+	const int history = spatial->historyFrames;
+	EAR_PARAMS targets[MAX_CHANNELS][2];
+	float a[4], b[4], end[4];
+	int offset, count, base;
+	int c, ear, i;
+
+	if (frames <= 0) {
+		return;
+	}
+
+	targetParams(spatial, targets);
+	for (c = 0; c < channels; c++) {
+		for (ear = 0; ear < 2; ear++) {
+			EAR_PARAMS* current = &spatial->current[c][ear];
+			EAR_PARAMS* target = &targets[c][ear];
+
+			if (!spatial->primed) {
+				*current = *target;
+			}
+			else if (target->delay > current->delay + MAX_DELAY_STEP) {
+				target->delay = current->delay + MAX_DELAY_STEP;
+			}
+			else if (target->delay < current->delay - MAX_DELAY_STEP) {
+				target->delay = current->delay - MAX_DELAY_STEP;
+			}
+		}
+	}
+	spatial->primed = 1;
+
+	for (offset = 0; offset < frames; offset += count) {
+		count = frames - offset < BLOCK_FRAMES ? frames - offset : BLOCK_FRAMES;
+
+		for (c = 0; c < channels; c++) {
+			float* plane = &spatial->planes[c][history];
+			for (i = 0; i < count; i++) {
+				plane[i] = in[(offset + i) * channels + c];
+			}
+		}
+		memset(spatial->mix[0], 0, count * sizeof(float));
+		memset(spatial->mix[1], 0, count * sizeof(float));
+
+		// Everything glides from where it was to the target over the whole buffer
+		for (c = 0; c < channels; c++) {
+			for (ear = 0; ear < 2; ear++) {
+				EAR_PARAMS from = lerpParams(&spatial->current[c][ear], &targets[c][ear], (float)offset / frames);
+				EAR_PARAMS to = lerpParams(&spatial->current[c][ear], &targets[c][ear], (float)(offset + count) / frames);
+
+				base = (int)fminf(from.delay, to.delay);
+				paramTaps(&from, base, a);
+				paramTaps(&to, base, end);
+				for (i = 0; i < 4; i++) {
+					b[i] = (end[i] - a[i]) / count;
+				}
+
+				mixFunction(spatial->mix[ear], &spatial->planes[c][history - base], a, b, count);
+			}
+		}
+
+		for (i = 0; i < count; i++) {
+			out[(offset + i) * 2] = spatial->mix[0][i];
+			out[(offset + i) * 2 + 1] = spatial->mix[1][i];
+		}
+
+		for (c = 0; c < channels; c++) {
+			memmove(spatial->planes[c], &spatial->planes[c][count], history * sizeof(float));
+		}
+	}
+
+	memcpy(spatial->current, targets, sizeof(targets));
+}
+
+void nv_audio_spatial_process(NV_AUDIO_SPATIAL* spatial, const float* in, float* out, int frames) {
+	processWith(spatial, in, out, frames, mixChannel);
+}
+
+#ifndef NDEBUG
+#include <time.h>
+#include <android/log.h>
+
+#define BENCH_RATE 48000
+#define BENCH_BUFFER_FRAMES 240 // one 5 ms audio callback
+
+static double benchNowNs(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+// What mixChannel does, one sample at a time
+static void mixChannelScalar(float* mix, const float* x, const float* a, const float* b, int frames) {
+	int n, k;
+
+	for (n = 0; n < frames; n++) {
+		for (k = 0; k < 4; k++) {
+			mix[n] += (a[k] + b[k] * n) * x[n - k];
+		}
+	}
+}
+
+// Spatializes noise in 5 ms buffers while the head turns a full circle
+// every 2 seconds, with the vector mixer and with the scalar one. Logs
+// the cost per buffer, how much of one core that is in real time, and
+// how far apart the two outputs are.
+void nv_audio_spatial_benchmark(int channelCount, int seconds) {
+	const int bufferCount = seconds * BENCH_RATE / BENCH_BUFFER_FRAMES;
+	const float up[3] = { 0.0f, 1.0f, 0.0f };
+	NV_AUDIO_SPATIAL* vector = nv_audio_spatial_create(channelCount, BENCH_RATE);
+	NV_AUDIO_SPATIAL* scalar = nv_audio_spatial_create(channelCount, BENCH_RATE);
+	float* in = malloc(BENCH_BUFFER_FRAMES * channelCount * sizeof(float));
+	float* vectorOut = malloc(BENCH_BUFFER_FRAMES * 2 * sizeof(float));
+	float* scalarOut = malloc(BENCH_BUFFER_FRAMES * 2 * sizeof(float));
+	double start, vectorNs = 0, scalarNs = 0;
+	float maxError = 0;
+	unsigned int seed = 1;
+	int i, j;
+
+	if (vector == NULL || scalar == NULL || in == NULL || vectorOut == NULL || scalarOut == NULL) {
+		__android_log_print(ANDROID_LOG_ERROR, "nv_audio_spatial", "Benchmark setup failed");
+		goto cleanup;
+	}
+
+	for (i = 0; i < bufferCount; i++) {
+		float yaw = (float)M_PI * i * BENCH_BUFFER_FRAMES / BENCH_RATE;
+		float center[3] = { -3.0f * sinf(yaw), 0.0f, -3.0f * cosf(yaw) };
+
+		for (j = 0; j < BENCH_BUFFER_FRAMES * channelCount; j++) {
+			seed = seed * 1103515245 + 12345;
+			in[j] = (int)(seed >> 16 & 0x7fff) / 16384.0f - 1.0f;
+		}
+
+		nv_audio_spatial_set_screen(vector, center, up, 4.0f);
+		nv_audio_spatial_set_screen(scalar, center, up, 4.0f);
+
+		start = benchNowNs();
+		nv_audio_spatial_process(vector, in, vectorOut, BENCH_BUFFER_FRAMES);
+		vectorNs += benchNowNs() - start;
+
+		start = benchNowNs();
+		processWith(scalar, in, scalarOut, BENCH_BUFFER_FRAMES, mixChannelScalar);
+		scalarNs += benchNowNs() - start;
+
+		for (j = 0; j < BENCH_BUFFER_FRAMES * 2; j++) {
+			maxError = fmaxf(maxError, fabsf(vectorOut[j] - scalarOut[j]));
+		}
+	}
+
+	__android_log_print(ANDROID_LOG_INFO, "nv_audio_spatial",
+		"%d channels, %d buffers of 5 ms: vector %.0f ns/buffer (%.2f%% of a core), scalar %.0f ns/buffer (%.2f%%), max difference %g",
+		channelCount, bufferCount, vectorNs / bufferCount, vectorNs / bufferCount / 50000.0,
+		scalarNs / bufferCount, scalarNs / bufferCount / 50000.0, maxError);
+
+cleanup:
+	nv_audio_spatial_free(vector);
+	nv_audio_spatial_free(scalar);
+	free(in);
+	free(vectorOut);
+	free(scalarOut);
+}
+#endif
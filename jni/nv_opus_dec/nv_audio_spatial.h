@@ -0,0 +1,29 @@
+typedef struct _NV_AUDIO_SPATIAL NV_AUDIO_SPATIAL;
+
+// Renders the host's stereo, 5.1 or 7.1 channels to headphones as if
+// they came from speakers around the virtual screen. Each channel gets
+// a simple spherical head model (interaural time and level differences
+// plus head shadow) rather than measured HRTFs, which keeps it cheap
+// enough to run in the audio callback with the freshest head pose.
+//
+// Channels are in the order the Opus decoder gives them:
+// FL FR [FC LFE BL BR [SL SR]]
+
+// returns NULL for channel layouts we don't know where to put
+NV_AUDIO_SPATIAL* nv_audio_spatial_create(int channelCount, int sampleRate);
+void nv_audio_spatial_free(NV_AUDIO_SPATIAL* spatial);
+
+// Where the screen is in head space (x right, y up, -z forward), in
+// meters, along with the world's up direction in head space. May be
+// called from any thread, the next processed buffer picks it up.
+void nv_audio_spatial_set_screen(NV_AUDIO_SPATIAL* spatial, const float center[3], const float up[3], float width);
+
+// in has channelCount interleaved channels, out gets interleaved stereo.
+// Only one thread may process.
+void nv_audio_spatial_process(NV_AUDIO_SPATIAL* spatial, const float* in, float* out, int frames);
+
+int nv_audio_spatial_get_channel_count(NV_AUDIO_SPATIAL* spatial);
+
+#ifndef NDEBUG
+void nv_audio_spatial_benchmark(int channelCount, int seconds);
+#endif
@@ -2,41 +2,213 @@
 #include <opus_multistream.h>
 #include "nv_opus_dec.h"
 
-OpusMSDecoder* decoder;
+struct _NV_OPUS_DECODER {
+	OpusMSDecoder* decoder;
+	int channelCount;
+	int samplesPerChannel;
+};
 
 // This function must be called before
 // any other decoding functions
-int nv_opus_init(int sampleRate, int channelCount, int streams,
-				 int coupledStreams, const unsigned char *mapping) {
-	int err;
-	decoder = opus_multistream_decoder_create(
+NV_OPUS_DECODER* nv_opus_create(int sampleRate, int channelCount, int streams,
+								int coupledStreams, const unsigned char *mapping,
+								int samplesPerChannel, int *error) {
+	NV_OPUS_DECODER* ctx;
+
+	ctx = malloc(sizeof(*ctx));
+	if (ctx == NULL) {
+		*error = OPUS_ALLOC_FAIL;
+		return NULL;
+	}
+
+	ctx->channelCount = channelCount;
+	ctx->samplesPerChannel = samplesPerChannel;
+	ctx->decoder = opus_multistream_decoder_create(
 			sampleRate,
 			channelCount,
 			streams,
 			coupledStreams,
 			mapping,
-			&err);
-	return err;
+			error);
+	if (ctx->decoder == NULL) {
+		free(ctx);
+		return NULL;
+	}
+
+	return ctx;
 }
 
 // This function must be called after
 // decoding is finished
-void nv_opus_destroy(void) {
-	if (decoder != NULL) {
-		opus_multistream_decoder_destroy(decoder);
+void nv_opus_free(NV_OPUS_DECODER* ctx) {
+	if (ctx != NULL) {
+		opus_multistream_decoder_destroy(ctx->decoder);
+		free(ctx);
 	}
 }
 
 // packets must be decoded in order
 // a packet loss must call this function with NULL indata and 0 inlen
-// returns the number of decoded samples
-int nv_opus_decode(unsigned char* indata, int inlen, short* outpcmdata, int framesize) {
+// outpcmdata must have room for samplesPerChannel * channelCount samples
+// returns the number of decoded samples per channel
+int nv_opus_decode(NV_OPUS_DECODER* ctx, const unsigned char* indata, int inlen, short* outpcmdata) {
 	int err;
 
 	// Decoding to 16-bit PCM with FEC off
-	// Maximum length assuming 48KHz sample rate
-	err = opus_multistream_decode(decoder, indata, inlen,
-		outpcmdata, framesize, 0);
+	err = opus_multistream_decode(ctx->decoder, indata, inlen,
+		outpcmdata, ctx->samplesPerChannel, 0);
 
 	return err;
 }
+
+int nv_opus_get_channel_count(NV_OPUS_DECODER* ctx) {
+	return ctx->channelCount;
+}
+
+int nv_opus_get_samples_per_channel(NV_OPUS_DECODER* ctx) {
+	return ctx->samplesPerChannel;
+}
+
+#ifndef NDEBUG
+#include <pthread.h>
+#include <math.h>
+#include <android/log.h>
+
+#define STRESS_THREADS 8
+#define STRESS_PACKETS 500
+#define STRESS_SAMPLES 240 // 5 ms at 48 KHz
+#define STRESS_CHANNELS 6
+
+struct StressPackets {
+	int streams;
+	int coupledStreams;
+	unsigned char mapping[STRESS_CHANNELS];
+	unsigned char data[STRESS_PACKETS][1000];
+	int length[STRESS_PACKETS];
+};
+
+struct StressThread {
+	pthread_t thread;
+	int started;
+	const struct StressPackets* packets;
+	int lossPeriod;
+	unsigned int checksum;
+	int failed;
+};
+
+// Decodes every packet, dropping one in lossPeriod to exercise concealment,
+// and sums up the output. A fresh decoder is created for every packet
+// and thrown away, so creation and destruction race with other decoding.
+static void* stressThreadFunc(void* context) {
+	struct StressThread* thread = context;
+	NV_OPUS_DECODER* ctx;
+	NV_OPUS_DECODER* churn;
+	short pcm[STRESS_SAMPLES * STRESS_CHANNELS];
+	int err;
+	int i, j;
+
+	thread->checksum = 0;
+	thread->failed = 0;
+
+	ctx = nv_opus_create(48000, STRESS_CHANNELS, thread->packets->streams,
+		thread->packets->coupledStreams, thread->packets->mapping, STRESS_SAMPLES, &err);
+	if (ctx == NULL) {
+		thread->failed = 1;
+		return NULL;
+	}
+
+	for (i = 0; i < STRESS_PACKETS; i++) {
+		churn = nv_opus_create(48000, STRESS_CHANNELS, thread->packets->streams,
+		thread->packets->coupledStreams, thread->packets->mapping, STRESS_SAMPLES, &err);
+		nv_opus_free(churn);
+
+		if (thread->lossPeriod != 0 && i % thread->lossPeriod == thread->lossPeriod - 1) {
+			err = nv_opus_decode(ctx, NULL, 0, pcm);
+		}
+		else {
+			err = nv_opus_decode(ctx, thread->packets->data[i], thread->packets->length[i], pcm);
+		}
+
+		if (err != STRESS_SAMPLES) {
+			thread->failed = 1;
+			break;
+		}
+
+		for (j = 0; j < STRESS_SAMPLES * STRESS_CHANNELS; j++) {
+			thread->checksum = thread->checksum * 31 + (unsigned short)pcm[j];
+		}
+	}
+
+	nv_opus_free(ctx);
+	return NULL;
+}
+
+// Decodes the same surround stream on several threads at once and checks
+// that each thread gets exactly what it gets when decoding on its own.
+// returns 0 on success
+int nv_opus_stress_test(void) {
+	struct StressPackets* packets;
+	struct StressThread threads[STRESS_THREADS];
+	unsigned int expected[STRESS_THREADS];
+	OpusMSEncoder* encoder;
+	short pcm[STRESS_SAMPLES * STRESS_CHANNELS];
+	int err;
+	int ret = 0;
+	int i, j;
+
+	packets = malloc(sizeof(*packets));
+	if (packets == NULL) {
+		return -1;
+	}
+
+	// Encode a few seconds of tones, one per channel
+	encoder = opus_multistream_surround_encoder_create(48000, STRESS_CHANNELS, 1,
+		&packets->streams, &packets->coupledStreams, packets->mapping, OPUS_APPLICATION_AUDIO, &err);
+	if (encoder == NULL) {
+		__android_log_print(ANDROID_LOG_ERROR, "nv_opus_dec", "Stress test encoder setup failed: %d", err);
+		free(packets);
+		return -1;
+	}
+	for (i = 0; i < STRESS_PACKETS; i++) {
+		for (j = 0; j < STRESS_SAMPLES * STRESS_CHANNELS; j++) {
+			int sample = i * STRESS_SAMPLES + j / STRESS_CHANNELS;
+			int channel = j % STRESS_CHANNELS;
+			pcm[j] = (short)(8000 * sin(sample * (channel + 1) * 440 * 2 * M_PI / 48000));
+		}
+		packets->length[i] = opus_multistream_encode(encoder, pcm, STRESS_SAMPLES,
+			packets->data[i], sizeof(packets->data[i]));
+	}
+	opus_multistream_encoder_destroy(encoder);
+
+	// Each thread drops a different set of packets
+	for (i = 0; i < STRESS_THREADS; i++) {
+		threads[i].packets = packets;
+		threads[i].lossPeriod = i;
+
+		stressThreadFunc(&threads[i]);
+		expected[i] = threads[i].checksum;
+		if (threads[i].failed) {
+			ret = -1;
+		}
+	}
+
+	for (i = 0; i < STRESS_THREADS; i++) {
+		threads[i].started = (pthread_create(&threads[i].thread, NULL, stressThreadFunc, &threads[i]) == 0);
+	}
+	for (i = 0; i < STRESS_THREADS; i++) {
+		if (threads[i].started) {
+			pthread_join(threads[i].thread, NULL);
+		}
+		if (!threads[i].started || threads[i].failed || threads[i].checksum != expected[i]) {
+			__android_log_print(ANDROID_LOG_ERROR, "nv_opus_dec",
+				"Stress test thread %d mismatch: %08x expected %08x", i, threads[i].checksum, expected[i]);
+			ret = -1;
+		}
+	}
+
+	__android_log_print(ANDROID_LOG_INFO, "nv_opus_dec", "Stress test %s", ret == 0 ? "passed" : "failed");
+
+	free(packets);
+	return ret;
+}
+#endif
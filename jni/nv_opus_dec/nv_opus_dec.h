@@ -1,4 +1,18 @@
-int nv_opus_init(int sampleRate, int channelCount, int streams,
-                 int coupledStreams, const unsigned char *mapping);
-void nv_opus_destroy(void);
-int nv_opus_decode(unsigned char* indata, int inlen, short* outpcmdata, int framesize);
+typedef struct _NV_OPUS_DECODER NV_OPUS_DECODER;
+
+// Each decoder is independent, so separate streams can be decoded
+// in parallel on different threads. A single decoder must only be
+// used by one thread at a time.
+
+// returns NULL and sets error on failure
+NV_OPUS_DECODER* nv_opus_create(int sampleRate, int channelCount, int streams,
+                                int coupledStreams, const unsigned char *mapping,
+                                int samplesPerChannel, int *error);
+void nv_opus_free(NV_OPUS_DECODER* ctx);
+int nv_opus_decode(NV_OPUS_DECODER* ctx, const unsigned char* indata, int inlen, short* outpcmdata);
+int nv_opus_get_channel_count(NV_OPUS_DECODER* ctx);
+int nv_opus_get_samples_per_channel(NV_OPUS_DECODER* ctx);
+
+#ifndef NDEBUG
+int nv_opus_stress_test(void);
+#endif
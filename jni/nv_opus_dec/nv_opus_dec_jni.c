@@ -1,10 +1,28 @@
 #include "nv_opus_dec.h"
+#include "nv_audio_spatial.h"
+#include "nv_audio_output.h"
+#include "nv_audio_sles.h"
+#include "nv_audio_sink.h"
 
 #include <stdlib.h>
+#include <pthread.h>
 #include <jni.h>
+#include <opus_defines.h>
 
-static int SamplesPerChannel;
-static int ChannelCount;
+// OpusDecoder's methods are static, so Java only ever has one decoder
+static NV_OPUS_DECODER* Decoder;
+
+// NativeAudioSink is static too, so there's one of it
+static NV_AUDIO_OUTPUT* SinkOutput;
+static NV_AUDIO_SLES* SinkPlayer;
+static NV_AUDIO_SPATIAL* SinkSpatial;
+static int SinkSpatialize;
+static int SinkChannelCount;
+// Audio is written from the decoder thread while stop comes from whichever
+// thread closes the stream, and the screen from the render thread. stop
+// takes each out from under its lock before freeing it.
+static pthread_mutex_t SinkOutputLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t SinkSpatialLock = PTHREAD_MUTEX_INITIALIZER;
 
 // This function must be called before
 // any other decoding functions
@@ -15,11 +33,12 @@ Java_com_limelight_nvstream_av_audio_OpusDecoder_init(JNIEnv *env, jobject this,
 	jbyte* jni_mapping_data;
 	jint ret;
 
-	SamplesPerChannel = samplesPerChannel;
-	ChannelCount = channelCount;
+	// Don't leak the last stream's decoder if it wasn't destroyed
+	nv_opus_free(Decoder);
 
 	jni_mapping_data = (*env)->GetByteArrayElements(env, mapping, 0);
-	ret =  nv_opus_init(sampleRate, channelCount, streams, coupledStreams, jni_mapping_data);
+	Decoder = nv_opus_create(sampleRate, channelCount, streams, coupledStreams,
+							 (unsigned char*)jni_mapping_data, samplesPerChannel, &ret);
 	(*env)->ReleaseByteArrayElements(env, mapping, jni_mapping_data, JNI_ABORT);
 
 	return ret;
@@ -29,7 +48,17 @@ Java_com_limelight_nvstream_av_audio_OpusDecoder_init(JNIEnv *env, jobject this,
 // decoding is finished
 JNIEXPORT void JNICALL
 Java_com_limelight_nvstream_av_audio_OpusDecoder_destroy(JNIEnv *env, jobject this) {
-	nv_opus_destroy();
+	nv_opus_free(Decoder);
+	Decoder = NULL;
+}
+
+// The largest packet we'll decode, which is more than Opus
+// will ever produce for a 20 ms frame of 6 channel audio
+#define MAX_PACKET_SIZE 1500
+
+// Bytes of 16-bit PCM that a single decode can produce
+static int PcmBufferSize(NV_OPUS_DECODER* ctx) {
+	return nv_opus_get_samples_per_channel(ctx) * nv_opus_get_channel_count(ctx) * 2;
 }
 
 // packets must be decoded in order
@@ -42,28 +71,144 @@ Java_com_limelight_nvstream_av_audio_OpusDecoder_decode(
 	jbyteArray outpcmdata) // Output parameter
 {
 	jint ret;
-	jbyte* jni_input_data;
+	jbyte jni_input_data[MAX_PACKET_SIZE];
 	jbyte* jni_pcm_data;
 
-	jni_pcm_data = (*env)->GetByteArrayElements(env, outpcmdata, 0);
+	if (Decoder == NULL || inoff < 0 || inlen < 0 || inlen > MAX_PACKET_SIZE ||
+		(*env)->GetArrayLength(env, outpcmdata) < PcmBufferSize(Decoder)) {
+		return OPUS_BAD_ARG;
+	}
+
+	// Only the packet itself is copied out of the Java heap, rather
+	// than whatever GetByteArrayElements decides to copy
 	if (indata != NULL) {
-		jni_input_data = (*env)->GetByteArrayElements(env, indata, 0);
+		(*env)->GetByteArrayRegion(env, indata, inoff, inlen, jni_input_data);
+	}
 
-		ret = nv_opus_decode(&jni_input_data[inoff], inlen, (jshort*)jni_pcm_data, SamplesPerChannel);
+	// Decoding doesn't call back into the VM, so the output array can be
+	// pinned instead of being copied in and then copied back out again
+	jni_pcm_data = (*env)->GetPrimitiveArrayCritical(env, outpcmdata, NULL);
+	if (jni_pcm_data == NULL) {
+		return OPUS_ALLOC_FAIL;
+	}
 
-		// The input data isn't changed so it can be safely aborted
-		(*env)->ReleaseByteArrayElements(env, indata, jni_input_data, JNI_ABORT);
+	if (indata != NULL) {
+		ret = nv_opus_decode(Decoder, (unsigned char*)jni_input_data, inlen, (jshort*)jni_pcm_data);
 	}
 	else {
-		ret = nv_opus_decode(NULL, 0, (jshort*)jni_pcm_data, SamplesPerChannel);
+		ret = nv_opus_decode(Decoder, NULL, 0, (jshort*)jni_pcm_data);
 	}
 
+	(*env)->ReleasePrimitiveArrayCritical(env, outpcmdata, jni_pcm_data, 0);
+
 	// Convert samples (2 bytes) per channel to total bytes returned
 	if (ret > 0) {
-		ret *= ChannelCount * 2;
+		ret *= nv_opus_get_channel_count(Decoder) * 2;
 	}
 
-	(*env)->ReleaseByteArrayElements(env, outpcmdata, jni_pcm_data, 0);
-
 	return ret;
 }
+
+// outputRate and framesPerBuffer should be the device's native ones from AudioManager.
+// Spatializes if the app's native code last asked for it.
+JNIEXPORT jboolean JNICALL
+Java_com_limelight_binding_audio_NativeAudioSink_start(JNIEnv *env, jclass clazz,
+	jint channelCount, jint sampleRate, jint outputRate, jint framesPerBuffer) {
+	NV_AUDIO_OUTPUT* output;
+	NV_AUDIO_SPATIAL* spatial;
+	int spatialize;
+
+	if (SinkPlayer != NULL) {
+		return JNI_FALSE;
+	}
+
+	pthread_mutex_lock(&SinkSpatialLock);
+	spatialize = SinkSpatialize;
+	pthread_mutex_unlock(&SinkSpatialLock);
+
+	// Enough to ride out one late buffer from the network side
+	output = nv_audio_output_create(channelCount, sampleRate, outputRate, framesPerBuffer * 2);
+	if (output == NULL) {
+		return JNI_FALSE;
+	}
+
+	// It runs after the resampler, at the output rate
+	spatial = spatialize ? nv_audio_spatial_create(channelCount, outputRate) : NULL;
+	nv_audio_output_set_spatial(output, spatial);
+
+	SinkPlayer = nv_audio_sles_start(output, spatial != NULL ? 2 : channelCount, outputRate, framesPerBuffer);
+	if (SinkPlayer == NULL) {
+		nv_audio_output_free(output);
+		nv_audio_spatial_free(spatial);
+		return JNI_FALSE;
+	}
+
+	// Writers only see the output once it's playing
+	pthread_mutex_lock(&SinkOutputLock);
+	SinkOutput = output;
+	SinkChannelCount = channelCount;
+	pthread_mutex_unlock(&SinkOutputLock);
+
+	pthread_mutex_lock(&SinkSpatialLock);
+	SinkSpatial = spatial;
+	pthread_mutex_unlock(&SinkSpatialLock);
+
+	return JNI_TRUE;
+}
+
+void nv_audio_sink_set_screen(const float center[3], const float up[3], float width) {
+	pthread_mutex_lock(&SinkSpatialLock);
+	if (SinkSpatial != NULL) {
+		nv_audio_spatial_set_screen(SinkSpatial, center, up, width);
+	}
+	pthread_mutex_unlock(&SinkSpatialLock);
+}
+
+void nv_audio_sink_set_spatialize(int spatialize) {
+	pthread_mutex_lock(&SinkSpatialLock);
+	SinkSpatialize = spatialize;
+	pthread_mutex_unlock(&SinkSpatialLock);
+}
+
+// Takes already decoded 16-bit PCM, as AudioTrack.write would
+JNIEXPORT void JNICALL
+Java_com_limelight_binding_audio_NativeAudioSink_write(JNIEnv *env, jclass clazz,
+	jbyteArray pcmdata, jint offset, jint length) {
+	jbyte* jni_pcm_data;
+
+	// Held across the write, so stop can't free the output under it.
+	// Once stop has begun there's no output and the write is dropped.
+	pthread_mutex_lock(&SinkOutputLock);
+	if (SinkOutput == NULL) {
+		pthread_mutex_unlock(&SinkOutputLock);
+		return;
+	}
+
+	jni_pcm_data = (*env)->GetPrimitiveArrayCritical(env, pcmdata, NULL);
+	if (jni_pcm_data != NULL) {
+		nv_audio_output_write_short(SinkOutput, (short*)&jni_pcm_data[offset], length / (SinkChannelCount * 2));
+		(*env)->ReleasePrimitiveArrayCritical(env, pcmdata, jni_pcm_data, JNI_ABORT);
+	}
+	pthread_mutex_unlock(&SinkOutputLock);
+}
+
+JNIEXPORT void JNICALL
+Java_com_limelight_binding_audio_NativeAudioSink_stop(JNIEnv *env, jclass clazz) {
+	NV_AUDIO_OUTPUT* output;
+
+	// No writer has the output once it's taken
+	pthread_mutex_lock(&SinkOutputLock);
+	output = SinkOutput;
+	SinkOutput = NULL;
+	pthread_mutex_unlock(&SinkOutputLock);
+
+	// The player has to go next, its callback reads from the output
+	nv_audio_sles_stop(SinkPlayer);
+	SinkPlayer = NULL;
+	nv_audio_output_free(output);
+
+	pthread_mutex_lock(&SinkSpatialLock);
+	nv_audio_spatial_free(SinkSpatial);
+	SinkSpatial = NULL;
+	pthread_mutex_unlock(&SinkSpatialLock);
+}
@@ -0,0 +1,9 @@
+# Android.mk for the native SPS rewriter
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE    := nv_video_sps
+LOCAL_SRC_FILES := nv_video_sps.c nv_video_sps_jni.c
+LOCAL_LDLIBS    := -llog
+
+include $(BUILD_SHARED_LIBRARY)
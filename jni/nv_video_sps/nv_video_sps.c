@@ -0,0 +1,1232 @@
+#include <string.h>
+#include "nv_video_sps.h"
+
+// An SPS is a few dozen bytes, even with scaling matrices it's a few hundred
+#define MAX_RBSP_SIZE 1024
+
+#define NAL_TYPE_SPS 7
+
+typedef struct {
+	const unsigned char* data;
+	int length;     // in bytes
+	int pos;        // in bits
+	int error;
+} BIT_READER;
+
+typedef struct {
+	unsigned char* data;
+	int capacity;   // in bytes
+	int pos;        // in bits
+	int error;
+} BIT_WRITER;
+
+// Where things are in the SPS, as bit offsets into its RBSP, and the
+// fields the fixups touch. Anything left alone is copied over as bits.
+typedef struct {
+	int profileIdc;
+	int constraintFlags;
+	int levelIdc;
+
+	// seq_parameter_set_id
+	int idStart, idEnd;
+	// chroma_format_idc through the scaling matrices, for High profiles
+	int highStart, highEnd;
+	// log2_max_frame_num through the picture order count fields
+	int frameNumStart, frameNumEnd;
+	// gaps_in_frame_num_allowed through the cropping window
+	int geometryStart, geometryEnd;
+
+	int hasVui;
+	// The aspect ratio and overscan info
+	int aspectStart, aspectEnd;
+	// Timing info, HRD parameters and pic_struct_present_flag
+	int timingStart, timingEnd;
+
+	int hasRestrictions;
+	int motionVectorsOverPicBoundaries;
+	int log2MaxMvLengthHorizontal;
+	int log2MaxMvLengthVertical;
+	int maxNumReorderFrames;
+} SPS_LAYOUT;
+
+static int readBit(BIT_READER* br) {
+	int bit;
+
+	if (br->pos >= br->length * 8) {
+		br->error = 1;
+		return 0;
+	}
+	bit = (br->data[br->pos >> 3] >> (7 - (br->pos & 7))) & 1;
+	br->pos++;
+	return bit;
+}
+
+static unsigned int readBits(BIT_READER* br, int count) {
+	unsigned int value = 0;
+
+	while (count-- > 0) {
+		value = (value << 1) | readBit(br);
+	}
+	return value;
+}
+
+// Exp-Golomb ue(v)
+static unsigned int readUe(BIT_READER* br) {
+	int zeros = 0;
+
+	while (!readBit(br)) {
+		if (br->error || ++zeros > 31) {
+			br->error = 1;
+			return 0;
+		}
+	}
+	return ((1u << zeros) - 1) + readBits(br, zeros);
+}
+
+// Exp-Golomb se(v)
+static int readSe(BIT_READER* br) {
+	unsigned int value = readUe(br);
+	return (value & 1) ? (int)((value + 1) / 2) : -(int)(value / 2);
+}
+
+static void writeBit(BIT_WRITER* bw, int bit) {
+	if (bw->pos >= bw->capacity * 8) {
+		bw->error = 1;
+		return;
+	}
+	if (bit) {
+		bw->data[bw->pos >> 3] |= 0x80 >> (bw->pos & 7);
+	}
+	else {
+		bw->data[bw->pos >> 3] &= ~(0x80 >> (bw->pos & 7));
+	}
+	bw->pos++;
+}
+
+static void writeBits(BIT_WRITER* bw, unsigned int value, int count) {
+	while (count-- > 0) {
+		writeBit(bw, (value >> count) & 1);
+	}
+}
+
+static void writeUe(BIT_WRITER* bw, unsigned int value) {
+	unsigned int coded = value + 1;
+	int bits = 0;
+
+	while ((coded >> bits) > 1) {
+		bits++;
+	}
+	writeBits(bw, 0, bits);
+	writeBits(bw, coded, bits + 1);
+}
+
+static void copyBits(BIT_WRITER* bw, const BIT_READER* br, int start, int end) {
+	BIT_READER from = *br;
+
+	from.pos = start;
+	while (from.pos < end) {
+		writeBit(bw, readBit(&from));
+	}
+}
+
+static int isHighProfile(int profileIdc) {
+	switch (profileIdc) {
+	case 100: case 110: case 122: case 244: case 44:
+	case 83: case 86: case 118: case 128: case 138:
+	case 139: case 134: case 135:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static void skipScalingList(BIT_READER* br, int size) {
+	int lastScale = 8, nextScale = 8;
+	int i;
+
+	for (i = 0; i < size && !br->error; i++) {
+		if (nextScale != 0) {
+			nextScale = (lastScale + readSe(br) + 256) % 256;
+		}
+		if (nextScale != 0) {
+			lastScale = nextScale;
+		}
+	}
+}
+
+static void skipHrdParameters(BIT_READER* br) {
+	unsigned int cpbCount = readUe(br) + 1;
+	unsigned int i;
+
+	if (cpbCount > 32) {
+		br->error = 1;
+		return;
+	}
+	readBits(br, 4 + 4);
+	for (i = 0; i < cpbCount && !br->error; i++) {
+		readUe(br);
+		readUe(br);
+		readBit(br);
+	}
+	readBits(br, 5 + 5 + 5 + 5);
+}
+
+static int parseSps(BIT_READER* br, SPS_LAYOUT* sps) {
+	unsigned int pocType, i;
+
+	memset(sps, 0, sizeof(*sps));
+
+	sps->profileIdc = readBits(br, 8);
+	sps->constraintFlags = readBits(br, 8);
+	sps->levelIdc = readBits(br, 8);
+
+	sps->idStart = br->pos;
+	readUe(br);
+	sps->idEnd = br->pos;
+
+	sps->highStart = sps->highEnd = br->pos;
+	if (isHighProfile(sps->profileIdc)) {
+		unsigned int chromaFormatIdc = readUe(br);
+		if (chromaFormatIdc > 3) {
+			return -1;
+		}
+		if (chromaFormatIdc == 3) {
+			readBit(br);
+		}
+		readUe(br);
+		readUe(br);
+		readBit(br);
+		if (readBit(br)) {
+			for (i = 0; i < (chromaFormatIdc != 3 ? 8u : 12u) && !br->error; i++) {
+				if (readBit(br)) {
+					skipScalingList(br, i < 6 ? 16 : 64);
+				}
+			}
+		}
+		sps->highEnd = br->pos;
+	}
+
+	sps->frameNumStart = br->pos;
+	readUe(br);
+	pocType = readUe(br);
+	if (pocType == 0) {
+		readUe(br);
+	}
+	else if (pocType == 1) {
+		unsigned int cycle;
+		readBit(br);
+		readSe(br);
+		readSe(br);
+		cycle = readUe(br);
+		if (cycle > 255) {
+			return -1;
+		}
+		for (i = 0; i < cycle && !br->error; i++) {
+			readSe(br);
+		}
+	}
+	else if (pocType != 2) {
+		return -1;
+	}
+	sps->frameNumEnd = br->pos;
+
+	// max_num_ref_frames, always rewritten
+	readUe(br);
+
+	sps->geometryStart = br->pos;
+	readBit(br);
+	readUe(br);
+	readUe(br);
+	if (!readBit(br)) {
+		readBit(br);
+	}
+	readBit(br);
+	if (readBit(br)) {
+		readUe(br);
+		readUe(br);
+		readUe(br);
+		readUe(br);
+	}
+	sps->geometryEnd = br->pos;
+
+	sps->hasVui = readBit(br);
+	if (sps->hasVui) {
+		int nalHrd, vclHrd;
+
+		sps->aspectStart = br->pos;
+		if (readBit(br)) {
+			if (readBits(br, 8) == 255) {
+				readBits(br, 16);
+				readBits(br, 16);
+			}
+		}
+		if (readBit(br)) {
+			readBit(br);
+		}
+		sps->aspectEnd = br->pos;
+
+		// Video signal type and chroma location are dropped
+		if (readBit(br)) {
+			readBits(br, 3);
+			readBit(br);
+			if (readBit(br)) {
+				readBits(br, 8 + 8 + 8);
+			}
+		}
+		if (readBit(br)) {
+			readUe(br);
+			readUe(br);
+		}
+
+		sps->timingStart = br->pos;
+		if (readBit(br)) {
+			readBits(br, 32);
+			readBits(br, 32);
+			readBit(br);
+		}
+		nalHrd = readBit(br);
+		if (nalHrd) {
+			skipHrdParameters(br);
+		}
+		vclHrd = readBit(br);
+		if (vclHrd) {
+			skipHrdParameters(br);
+		}
+		if (nalHrd || vclHrd) {
+			readBit(br);
+		}
+		readBit(br);
+		sps->timingEnd = br->pos;
+
+		sps->hasRestrictions = readBit(br);
+		if (sps->hasRestrictions) {
+			sps->motionVectorsOverPicBoundaries = readBit(br);
+			readUe(br);
+			readUe(br);
+			sps->log2MaxMvLengthHorizontal = readUe(br);
+			sps->log2MaxMvLengthVertical = readUe(br);
+			sps->maxNumReorderFrames = readUe(br);
+			readUe(br);
+		}
+	}
+
+	return br->error ? -1 : 0;
+}
+
+static void writeSps(BIT_WRITER* bw, const BIT_READER* br, const SPS_LAYOUT* sps,
+					 int profileIdc, int levelIdc, int flags) {
+	// constraint_set0 to 3 stay, 4 and 5 are ours, the reserved bits are 0
+	int constraintFlags = sps->constraintFlags & 0xF0;
+	const int numRefFrames = 1;
+
+	if (profileIdc == 100 && (flags & NV_SPS_FIX_CONSTRAINED_HIGH)) {
+		constraintFlags |= 0x0C;
+	}
+
+	writeBits(bw, profileIdc, 8);
+	writeBits(bw, constraintFlags, 8);
+	writeBits(bw, levelIdc, 8);
+	copyBits(bw, br, sps->idStart, sps->idEnd);
+
+	// High profile fields are only there for High profiles, so changing
+	// profile means dropping them or writing the 4:2:0 8 bit defaults
+	if (isHighProfile(profileIdc)) {
+		if (isHighProfile(sps->profileIdc)) {
+			copyBits(bw, br, sps->highStart, sps->highEnd);
+		}
+		else {
+			writeUe(bw, 1);
+			writeUe(bw, 0);
+			writeUe(bw, 0);
+			writeBit(bw, 0);
+			writeBit(bw, 0);
+		}
+	}
+
+	copyBits(bw, br, sps->frameNumStart, sps->frameNumEnd);
+	writeUe(bw, numRefFrames);
+	copyBits(bw, br, sps->geometryStart, sps->geometryEnd);
+
+	if (!sps->hasVui && !(flags & NV_SPS_FIX_BITSTREAM_RESTRICTIONS)) {
+		writeBit(bw, 0);
+	}
+	else {
+		writeBit(bw, 1);
+		if (sps->hasVui) {
+			copyBits(bw, br, sps->aspectStart, sps->aspectEnd);
+		}
+		else {
+			writeBits(bw, 0, 2);
+		}
+
+		// No video signal type or chroma location
+		writeBits(bw, 0, 2);
+
+		if (sps->hasVui) {
+			copyBits(bw, br, sps->timingStart, sps->timingEnd);
+		}
+		else {
+			// No timing, HRD or pic_struct
+			writeBits(bw, 0, 4);
+		}
+
+		if (flags & NV_SPS_FIX_BITSTREAM_RESTRICTIONS) {
+			writeBit(bw, 1);
+			if (sps->hasRestrictions) {
+				// GFE's motion vector limits and reordering stand
+				writeBit(bw, sps->motionVectorsOverPicBoundaries);
+			}
+			else {
+				writeBit(bw, 1);
+			}
+			// The defaults, more aggressive than what GFE sends
+			writeUe(bw, 2);
+			writeUe(bw, 1);
+			if (sps->hasRestrictions) {
+				writeUe(bw, sps->log2MaxMvLengthHorizontal);
+				writeUe(bw, sps->log2MaxMvLengthVertical);
+				writeUe(bw, sps->maxNumReorderFrames);
+			}
+			else {
+				writeUe(bw, 16);
+				writeUe(bw, 16);
+				writeUe(bw, 0);
+			}
+			// Some decoders throw errors if this is less than num_ref_frames
+			writeUe(bw, numRefFrames);
+		}
+		else {
+			writeBit(bw, 0);
+		}
+	}
+
+	// rbsp_trailing_bits
+	writeBit(bw, 1);
+	while (bw->pos & 7) {
+		writeBit(bw, 0);
+	}
+}
+
+static int startCodeLength(const unsigned char* data, int length) {
+	if (length >= 4 && data[0] == 0 && data[1] == 0 && data[2] == 0 && data[3] == 1) {
+		return 4;
+	}
+	if (length >= 3 && data[0] == 0 && data[1] == 0 && data[2] == 1) {
+		return 3;
+	}
+	return 0;
+}
+
+int nv_sps_rewrite(const unsigned char* in, int inLength, unsigned char* out, int outCapacity,
+				   int profileIdc, int levelIdc, int flags) {
+	unsigned char rbsp[MAX_RBSP_SIZE];
+	unsigned char rewritten[MAX_RBSP_SIZE + 64];
+	BIT_READER br;
+	BIT_WRITER bw;
+	SPS_LAYOUT sps;
+	int headerLength, rbspLength, zeros, pos, i;
+
+	headerLength = startCodeLength(in, inLength);
+	if (headerLength == 0 || inLength <= headerLength || (in[headerLength] & 0x1F) != NAL_TYPE_SPS) {
+		return -1;
+	}
+	// The start code and the NAL header
+	headerLength++;
+
+	// Take out the emulation prevention bytes
+	rbspLength = 0;
+	zeros = 0;
+	for (i = headerLength; i < inLength; i++) {
+		if (zeros >= 2 && in[i] == 3) {
+			zeros = 0;
+			continue;
+		}
+		if (rbspLength == MAX_RBSP_SIZE) {
+			return -1;
+		}
+		rbsp[rbspLength++] = in[i];
+		zeros = in[i] == 0 ? zeros + 1 : 0;
+	}
+
+	br.data = rbsp;
+	br.length = rbspLength;
+	br.pos = 0;
+	br.error = 0;
+	if (parseSps(&br, &sps) != 0) {
+		return -1;
+	}
+
+	bw.data = rewritten;
+	bw.capacity = sizeof(rewritten);
+	bw.pos = 0;
+	bw.error = 0;
+	writeSps(&bw, &br, &sps, profileIdc ? profileIdc : sps.profileIdc, levelIdc ? levelIdc : sps.levelIdc, flags);
+	if (bw.error) {
+		return -1;
+	}
+
+	// The header goes first so out can be in, the escaped SPS after it
+	if (outCapacity < headerLength) {
+		return -1;
+	}
+	memmove(out, in, headerLength);
+	pos = headerLength;
+	zeros = 0;
+	for (i = 0; i < bw.pos / 8; i++) {
+		if (zeros >= 2 && rewritten[i] <= 3) {
+			if (pos == outCapacity) {
+				return -1;
+			}
+			out[pos++] = 3;
+			zeros = 0;
+		}
+		if (pos == outCapacity) {
+			return -1;
+		}
+		out[pos++] = rewritten[i];
+		zeros = rewritten[i] == 0 ? zeros + 1 : 0;
+	}
+
+	return pos;
+}
+
+#ifndef NDEBUG
+#include <stdlib.h>
+#include <android/log.h>
+
+// Every SPS field the self test checks. Fields that aren't in the
+// bitstream stay 0 so two of these compare with memcmp.
+typedef struct {
+	int cpbCount, bitRateScale, cpbSizeScale;
+	unsigned int bitRate[32], cpbSize[32];
+	int cbr[32];
+	int delayLengths[4];
+} TEST_HRD;
+
+typedef struct {
+	int profileIdc, constraintFlags, levelIdc, id;
+	int chromaFormatIdc, separateColourPlanes, bitDepthLuma, bitDepthChroma, transformBypass;
+	int scalingMatrix, scalingListPresent[12], scalingLists[12][64];
+	int log2MaxFrameNum, pocType, log2MaxPocLsb;
+	int deltaPocAlwaysZero, offsetForNonRefPic, offsetForTopToBottom, pocCycle, pocOffsets[255];
+	int numRefFrames, gapsAllowed, widthMbs, heightMapUnits, frameMbsOnly, mbAdaptive, direct8x8;
+	int cropping, crop[4];
+	int vui;
+	int aspectPresent, aspectIdc, sarWidth, sarHeight, overscanPresent, overscanAppropriate;
+	int signalPresent, videoFormat, fullRange, colourPresent, primaries, transfer, matrix;
+	int chromaLocPresent, chromaLocTop, chromaLocBottom;
+	int timingPresent, fixedFrameRate;
+	unsigned int unitsInTick, timeScale;
+	int nalHrd, vclHrd;
+	TEST_HRD hrd[2];
+	int lowDelay, picStruct;
+	int restrictions, mvOverPicBoundaries, maxBytesPerPicDenom, maxBitsPerMbDenom;
+	int log2MvHorizontal, log2MvVertical, numReorderFrames, maxDecFrameBuffering;
+} TEST_SPS;
+
+static void writeSe(BIT_WRITER* bw, int value) {
+	writeUe(bw, value > 0 ? 2 * value - 1 : -2 * value);
+}
+
+static void testWriteHrd(BIT_WRITER* bw, const TEST_HRD* hrd) {
+	int i;
+
+	writeUe(bw, hrd->cpbCount - 1);
+	writeBits(bw, hrd->bitRateScale, 4);
+	writeBits(bw, hrd->cpbSizeScale, 4);
+	for (i = 0; i < hrd->cpbCount; i++) {
+		writeUe(bw, hrd->bitRate[i]);
+		writeUe(bw, hrd->cpbSize[i]);
+		writeBit(bw, hrd->cbr[i]);
+	}
+	for (i = 0; i < 4; i++) {
+		writeBits(bw, hrd->delayLengths[i], 5);
+	}
+}
+
+static void testReadHrd(BIT_READER* br, TEST_HRD* hrd) {
+	int i;
+
+	hrd->cpbCount = readUe(br) + 1;
+	if (hrd->cpbCount > 32) {
+		br->error = 1;
+		return;
+	}
+	hrd->bitRateScale = readBits(br, 4);
+	hrd->cpbSizeScale = readBits(br, 4);
+	for (i = 0; i < hrd->cpbCount; i++) {
+		hrd->bitRate[i] = readUe(br);
+		hrd->cpbSize[i] = readUe(br);
+		hrd->cbr[i] = readBit(br);
+	}
+	for (i = 0; i < 4; i++) {
+		hrd->delayLengths[i] = readBits(br, 5);
+	}
+}
+
+// Writes the whole NAL, start code and emulation prevention included
+static int testWriteSps(const TEST_SPS* sps, unsigned char* out, int capacity) {
+	unsigned char rbsp[MAX_RBSP_SIZE];
+	BIT_WRITER bw = { rbsp, sizeof(rbsp), 0, 0 };
+	int i, j, pos, zeros;
+
+	writeBits(&bw, sps->profileIdc, 8);
+	writeBits(&bw, sps->constraintFlags, 8);
+	writeBits(&bw, sps->levelIdc, 8);
+	writeUe(&bw, sps->id);
+	if (isHighProfile(sps->profileIdc)) {
+		writeUe(&bw, sps->chromaFormatIdc);
+		if (sps->chromaFormatIdc == 3) {
+			writeBit(&bw, sps->separateColourPlanes);
+		}
+		writeUe(&bw, sps->bitDepthLuma);
+		writeUe(&bw, sps->bitDepthChroma);
+		writeBit(&bw, sps->transformBypass);
+		writeBit(&bw, sps->scalingMatrix);
+		if (sps->scalingMatrix) {
+			for (i = 0; i < (sps->chromaFormatIdc != 3 ? 8 : 12); i++) {
+				writeBit(&bw, sps->scalingListPresent[i]);
+				if (sps->scalingListPresent[i]) {
+					int last = 8;
+					for (j = 0; j < (i < 6 ? 16 : 64); j++) {
+						writeSe(&bw, (signed char)(sps->scalingLists[i][j] - last));
+						last = sps->scalingLists[i][j];
+					}
+				}
+			}
+		}
+	}
+	writeUe(&bw, sps->log2MaxFrameNum);
+	writeUe(&bw, sps->pocType);
+	if (sps->pocType == 0) {
+		writeUe(&bw, sps->log2MaxPocLsb);
+	}
+	else if (sps->pocType == 1) {
+		writeBit(&bw, sps->deltaPocAlwaysZero);
+		writeSe(&bw, sps->offsetForNonRefPic);
+		writeSe(&bw, sps->offsetForTopToBottom);
+		writeUe(&bw, sps->pocCycle);
+		for (i = 0; i < sps->pocCycle; i++) {
+			writeSe(&bw, sps->pocOffsets[i]);
+		}
+	}
+	writeUe(&bw, sps->numRefFrames);
+	writeBit(&bw, sps->gapsAllowed);
+	writeUe(&bw, sps->widthMbs);
+	writeUe(&bw, sps->heightMapUnits);
+	writeBit(&bw, sps->frameMbsOnly);
+	if (!sps->frameMbsOnly) {
+		writeBit(&bw, sps->mbAdaptive);
+	}
+	writeBit(&bw, sps->direct8x8);
+	writeBit(&bw, sps->cropping);
+	if (sps->cropping) {
+		for (i = 0; i < 4; i++) {
+			writeUe(&bw, sps->crop[i]);
+		}
+	}
+	writeBit(&bw, sps->vui);
+	if (sps->vui) {
+		writeBit(&bw, sps->aspectPresent);
+		if (sps->aspectPresent) {
+			writeBits(&bw, sps->aspectIdc, 8);
+			if (sps->aspectIdc == 255) {
+				writeBits(&bw, sps->sarWidth, 16);
+				writeBits(&bw, sps->sarHeight, 16);
+			}
+		}
+		writeBit(&bw, sps->overscanPresent);
+		if (sps->overscanPresent) {
+			writeBit(&bw, sps->overscanAppropriate);
+		}
+		writeBit(&bw, sps->signalPresent);
+		if (sps->signalPresent) {
+			writeBits(&bw, sps->videoFormat, 3);
+			writeBit(&bw, sps->fullRange);
+			writeBit(&bw, sps->colourPresent);
+			if (sps->colourPresent) {
+				writeBits(&bw, sps->primaries, 8);
+				writeBits(&bw, sps->transfer, 8);
+				writeBits(&bw, sps->matrix, 8);
+			}
+		}
+		writeBit(&bw, sps->chromaLocPresent);
+		if (sps->chromaLocPresent) {
+			writeUe(&bw, sps->chromaLocTop);
+			writeUe(&bw, sps->chromaLocBottom);
+		}
+		writeBit(&bw, sps->timingPresent);
+		if (sps->timingPresent) {
+			writeBits(&bw, sps->unitsInTick, 32);
+			writeBits(&bw, sps->timeScale, 32);
+			writeBit(&bw, sps->fixedFrameRate);
+		}
+		writeBit(&bw, sps->nalHrd);
+		if (sps->nalHrd) {
+			testWriteHrd(&bw, &sps->hrd[0]);
+		}
+		writeBit(&bw, sps->vclHrd);
+		if (sps->vclHrd) {
+			testWriteHrd(&bw, &sps->hrd[1]);
+		}
+		if (sps->nalHrd || sps->vclHrd) {
+			writeBit(&bw, sps->lowDelay);
+		}
+		writeBit(&bw, sps->picStruct);
+		writeBit(&bw, sps->restrictions);
+		if (sps->restrictions) {
+			writeBit(&bw, sps->mvOverPicBoundaries);
+			writeUe(&bw, sps->maxBytesPerPicDenom);
+			writeUe(&bw, sps->maxBitsPerMbDenom);
+			writeUe(&bw, sps->log2MvHorizontal);
+			writeUe(&bw, sps->log2MvVertical);
+			writeUe(&bw, sps->numReorderFrames);
+			writeUe(&bw, sps->maxDecFrameBuffering);
+		}
+	}
+	writeBit(&bw, 1);
+	while (bw.pos & 7) {
+		writeBit(&bw, 0);
+	}
+
+	out[0] = 0;
+	out[1] = 0;
+	out[2] = 0;
+	out[3] = 1;
+	out[4] = 0x67;
+	pos = 5;
+	zeros = 0;
+	for (i = 0; i < bw.pos / 8 && pos < capacity - 1; i++) {
+		if (zeros >= 2 && rbsp[i] <= 3) {
+			out[pos++] = 3;
+			zeros = 0;
+		}
+		out[pos++] = rbsp[i];
+		zeros = rbsp[i] == 0 ? zeros + 1 : 0;
+	}
+	return pos;
+}
+
+// Parses the SPS independently of parseSps, down to every value
+static int testReadSps(const unsigned char* nal, int length, TEST_SPS* sps) {
+	unsigned char rbsp[MAX_RBSP_SIZE];
+	BIT_READER br;
+	int i, j, rbspLength = 0, zeros = 0;
+
+	memset(sps, 0, sizeof(*sps));
+	if (length < 6 || startCodeLength(nal, length) != 4 || nal[4] != 0x67) {
+		return -1;
+	}
+	for (i = 5; i < length && rbspLength < MAX_RBSP_SIZE; i++) {
+		if (zeros >= 2 && nal[i] == 3) {
+			zeros = 0;
+			continue;
+		}
+		// An unescaped start code in the middle means the escaping is broken
+		if (zeros >= 2 && nal[i] < 3) {
+			return -1;
+		}
+		rbsp[rbspLength++] = nal[i];
+		zeros = nal[i] == 0 ? zeros + 1 : 0;
+	}
+	br.data = rbsp;
+	br.length = rbspLength;
+	br.pos = 0;
+	br.error = 0;
+
+	sps->profileIdc = readBits(&br, 8);
+	sps->constraintFlags = readBits(&br, 8);
+	sps->levelIdc = readBits(&br, 8);
+	sps->id = readUe(&br);
+	if (isHighProfile(sps->profileIdc)) {
+		sps->chromaFormatIdc = readUe(&br);
+		if (sps->chromaFormatIdc == 3) {
+			sps->separateColourPlanes = readBit(&br);
+		}
+		sps->bitDepthLuma = readUe(&br);
+		sps->bitDepthChroma = readUe(&br);
+		sps->transformBypass = readBit(&br);
+		sps->scalingMatrix = readBit(&br);
+		if (sps->scalingMatrix) {
+			for (i = 0; i < (sps->chromaFormatIdc != 3 ? 8 : 12); i++) {
+				sps->scalingListPresent[i] = readBit(&br);
+				if (sps->scalingListPresent[i]) {
+					int last = 8, next = 8;
+					for (j = 0; j < (i < 6 ? 16 : 64); j++) {
+						if (next != 0) {
+							next = (last + readSe(&br) + 256) % 256;
+						}
+						sps->scalingLists[i][j] = next != 0 ? next : last;
+						last = sps->scalingLists[i][j];
+					}
+				}
+			}
+		}
+	}
+	sps->log2MaxFrameNum = readUe(&br);
+	sps->pocType = readUe(&br);
+	if (sps->pocType == 0) {
+		sps->log2MaxPocLsb = readUe(&br);
+	}
+	else if (sps->pocType == 1) {
+		sps->deltaPocAlwaysZero = readBit(&br);
+		sps->offsetForNonRefPic = readSe(&br);
+		sps->offsetForTopToBottom = readSe(&br);
+		sps->pocCycle = readUe(&br);
+		if (sps->pocCycle > 255) {
+			return -1;
+		}
+		for (i = 0; i < sps->pocCycle; i++) {
+			sps->pocOffsets[i] = readSe(&br);
+		}
+	}
+	sps->numRefFrames = readUe(&br);
+	sps->gapsAllowed = readBit(&br);
+	sps->widthMbs = readUe(&br);
+	sps->heightMapUnits = readUe(&br);
+	sps->frameMbsOnly = readBit(&br);
+	if (!sps->frameMbsOnly) {
+		sps->mbAdaptive = readBit(&br);
+	}
+	sps->direct8x8 = readBit(&br);
+	sps->cropping = readBit(&br);
+	if (sps->cropping) {
+		for (i = 0; i < 4; i++) {
+			sps->crop[i] = readUe(&br);
+		}
+	}
+	sps->vui = readBit(&br);
+	if (sps->vui) {
+		sps->aspectPresent = readBit(&br);
+		if (sps->aspectPresent) {
+			sps->aspectIdc = readBits(&br, 8);
+			if (sps->aspectIdc == 255) {
+				sps->sarWidth = readBits(&br, 16);
+				sps->sarHeight = readBits(&br, 16);
+			}
+		}
+		sps->overscanPresent = readBit(&br);
+		if (sps->overscanPresent) {
+			sps->overscanAppropriate = readBit(&br);
+		}
+		sps->signalPresent = readBit(&br);
+		if (sps->signalPresent) {
+			sps->videoFormat = readBits(&br, 3);
+			sps->fullRange = readBit(&br);
+			sps->colourPresent = readBit(&br);
+			if (sps->colourPresent) {
+				sps->primaries = readBits(&br, 8);
+				sps->transfer = readBits(&br, 8);
+				sps->matrix = readBits(&br, 8);
+			}
+		}
+		sps->chromaLocPresent = readBit(&br);
+		if (sps->chromaLocPresent) {
+			sps->chromaLocTop = readUe(&br);
+			sps->chromaLocBottom = readUe(&br);
+		}
+		sps->timingPresent = readBit(&br);
+		if (sps->timingPresent) {
+			sps->unitsInTick = readBits(&br, 32);
+			sps->timeScale = readBits(&br, 32);
+			sps->fixedFrameRate = readBit(&br);
+		}
+		sps->nalHrd = readBit(&br);
+		if (sps->nalHrd) {
+			testReadHrd(&br, &sps->hrd[0]);
+		}
+		sps->vclHrd = readBit(&br);
+		if (sps->vclHrd) {
+			testReadHrd(&br, &sps->hrd[1]);
+		}
+		if (sps->nalHrd || sps->vclHrd) {
+			sps->lowDelay = readBit(&br);
+		}
+		sps->picStruct = readBit(&br);
+		sps->restrictions = readBit(&br);
+		if (sps->restrictions) {
+			sps->mvOverPicBoundaries = readBit(&br);
+			sps->maxBytesPerPicDenom = readUe(&br);
+			sps->maxBitsPerMbDenom = readUe(&br);
+			sps->log2MvHorizontal = readUe(&br);
+			sps->log2MvVertical = readUe(&br);
+			sps->numReorderFrames = readUe(&br);
+			sps->maxDecFrameBuffering = readUe(&br);
+		}
+	}
+
+	// rbsp_trailing_bits, and nothing after them
+	if (!readBit(&br) || br.error) {
+		return -1;
+	}
+	while (br.pos & 7) {
+		if (readBit(&br)) {
+			return -1;
+		}
+	}
+	return br.pos / 8 == rbspLength ? 0 : -1;
+}
+
+// What nv_sps_rewrite should make of sps
+static void testExpectedSps(const TEST_SPS* in, TEST_SPS* out, int profileIdc, int levelIdc, int flags) {
+	*out = *in;
+
+	if (profileIdc != 0) {
+		out->profileIdc = profileIdc;
+	}
+	if (levelIdc != 0) {
+		out->levelIdc = levelIdc;
+	}
+	out->constraintFlags &= 0xF0;
+	if (out->profileIdc == 100 && (flags & NV_SPS_FIX_CONSTRAINED_HIGH)) {
+		out->constraintFlags |= 0x0C;
+	}
+
+	if (!isHighProfile(out->profileIdc) || !isHighProfile(in->profileIdc)) {
+		out->chromaFormatIdc = isHighProfile(out->profileIdc) ? 1 : 0;
+		out->separateColourPlanes = 0;
+		out->bitDepthLuma = 0;
+		out->bitDepthChroma = 0;
+		out->transformBypass = 0;
+		out->scalingMatrix = 0;
+		memset(out->scalingListPresent, 0, sizeof(out->scalingListPresent));
+		memset(out->scalingLists, 0, sizeof(out->scalingLists));
+	}
+
+	out->numRefFrames = 1;
+
+	out->signalPresent = 0;
+	out->videoFormat = 0;
+	out->fullRange = 0;
+	out->colourPresent = 0;
+	out->primaries = 0;
+	out->transfer = 0;
+	out->matrix = 0;
+	out->chromaLocPresent = 0;
+	out->chromaLocTop = 0;
+	out->chromaLocBottom = 0;
+
+	if (flags & NV_SPS_FIX_BITSTREAM_RESTRICTIONS) {
+		out->vui = 1;
+		if (!in->restrictions) {
+			out->restrictions = 1;
+			out->mvOverPicBoundaries = 1;
+			out->log2MvHorizontal = 16;
+			out->log2MvVertical = 16;
+			out->numReorderFrames = 0;
+		}
+		out->maxBytesPerPicDenom = 2;
+		out->maxBitsPerMbDenom = 1;
+		out->maxDecFrameBuffering = 1;
+	}
+	else {
+		out->restrictions = 0;
+		out->mvOverPicBoundaries = 0;
+		out->maxBytesPerPicDenom = 0;
+		out->maxBitsPerMbDenom = 0;
+		out->log2MvHorizontal = 0;
+		out->log2MvVertical = 0;
+		out->numReorderFrames = 0;
+		out->maxDecFrameBuffering = 0;
+	}
+}
+
+// The sort of SPS units GFE sends, and a few it doesn't
+static int testCorpus(TEST_SPS* corpus) {
+	TEST_SPS* sps;
+	int count = 0, i, j;
+
+	// GFE 2.5.11 and later at 1280x720, with the extensions it added
+	sps = &corpus[count++];
+	memset(sps, 0, sizeof(*sps));
+	sps->profileIdc = 100;
+	sps->levelIdc = 51;
+	sps->chromaFormatIdc = 1;
+	sps->log2MaxFrameNum = 4;
+	sps->pocType = 2;
+	sps->numRefFrames = 4;
+	sps->widthMbs = 79;
+	sps->heightMapUnits = 44;
+	sps->frameMbsOnly = 1;
+	sps->direct8x8 = 1;
+	sps->vui = 1;
+	sps->aspectPresent = 1;
+	sps->aspectIdc = 1;
+	sps->signalPresent = 1;
+	sps->videoFormat = 5;
+	sps->colourPresent = 1;
+	sps->primaries = 1;
+	sps->transfer = 1;
+	sps->matrix = 1;
+	sps->chromaLocPresent = 1;
+	sps->timingPresent = 1;
+	sps->unitsInTick = 1;
+	sps->timeScale = 120;
+	sps->fixedFrameRate = 1;
+	sps->restrictions = 1;
+	sps->mvOverPicBoundaries = 1;
+	sps->maxBytesPerPicDenom = 0;
+	sps->maxBitsPerMbDenom = 0;
+	sps->log2MvHorizontal = 13;
+	sps->log2MvVertical = 11;
+	sps->numReorderFrames = 0;
+	sps->maxDecFrameBuffering = 4;
+
+	// Older GFE at 1920x1080, cropped, with no restrictions or extensions
+	sps = &corpus[count++];
+	memset(sps, 0, sizeof(*sps));
+	sps->profileIdc = 100;
+	sps->constraintFlags = 0x0C;
+	sps->levelIdc = 50;
+	sps->chromaFormatIdc = 1;
+	sps->log2MaxFrameNum = 12;
+	sps->pocType = 0;
+	sps->log2MaxPocLsb = 12;
+	sps->numRefFrames = 2;
+	sps->widthMbs = 119;
+	sps->heightMapUnits = 67;
+	sps->frameMbsOnly = 1;
+	sps->direct8x8 = 1;
+	sps->cropping = 1;
+	sps->crop[3] = 4;
+	sps->vui = 1;
+	sps->timingPresent = 1;
+	sps->unitsInTick = 1001;
+	sps->timeScale = 120000;
+	sps->picStruct = 1;
+
+	// Baseline without VUI
+	sps = &corpus[count++];
+	memset(sps, 0, sizeof(*sps));
+	sps->profileIdc = 66;
+	sps->constraintFlags = 0xC0;
+	sps->levelIdc = 31;
+	sps->log2MaxFrameNum = 0;
+	sps->pocType = 2;
+	sps->numRefFrames = 1;
+	sps->widthMbs = 79;
+	sps->heightMapUnits = 44;
+	sps->frameMbsOnly = 1;
+
+	// Main, interlaced, POC type 1 and an odd aspect ratio
+	sps = &corpus[count++];
+	memset(sps, 0, sizeof(*sps));
+	sps->profileIdc = 77;
+	sps->constraintFlags = 0x40;
+	sps->levelIdc = 40;
+	sps->id = 3;
+	sps->log2MaxFrameNum = 5;
+	sps->pocType = 1;
+	sps->offsetForNonRefPic = -2;
+	sps->offsetForTopToBottom = 1;
+	sps->pocCycle = 3;
+	sps->pocOffsets[0] = 2;
+	sps->pocOffsets[1] = -5;
+	sps->pocOffsets[2] = 7;
+	sps->numRefFrames = 3;
+	sps->gapsAllowed = 1;
+	sps->widthMbs = 44;
+	sps->heightMapUnits = 17;
+	sps->mbAdaptive = 1;
+	sps->cropping = 1;
+	sps->crop[0] = 1;
+	sps->crop[1] = 2;
+	sps->crop[2] = 3;
+	sps->crop[3] = 4;
+	sps->vui = 1;
+	sps->aspectPresent = 1;
+	sps->aspectIdc = 255;
+	sps->sarWidth = 40;
+	sps->sarHeight = 33;
+	sps->overscanPresent = 1;
+	sps->overscanAppropriate = 1;
+	sps->signalPresent = 1;
+	sps->videoFormat = 2;
+	sps->fullRange = 1;
+
+	// High with scaling matrices and both HRDs
+	sps = &corpus[count++];
+	memset(sps, 0, sizeof(*sps));
+	sps->profileIdc = 100;
+	sps->levelIdc = 42;
+	sps->chromaFormatIdc = 1;
+	sps->scalingMatrix = 1;
+	for (i = 0; i < 8; i += 3) {
+		sps->scalingListPresent[i] = 1;
+		for (j = 0; j < (i < 6 ? 16 : 64); j++) {
+			sps->scalingLists[i][j] = 4 + ((i * 7 + j * 13) % 200);
+		}
+	}
+	sps->log2MaxFrameNum = 2;
+	sps->pocType = 0;
+	sps->log2MaxPocLsb = 3;
+	sps->numRefFrames = 16;
+	sps->widthMbs = 119;
+	sps->heightMapUnits = 33;
+	sps->mbAdaptive = 0;
+	sps->direct8x8 = 1;
+	sps->vui = 1;
+	sps->timingPresent = 1;
+	sps->unitsInTick = 1;
+	sps->timeScale = 60;
+	sps->nalHrd = 1;
+	sps->hrd[0].cpbCount = 2;
+	sps->hrd[0].bitRateScale = 3;
+	sps->hrd[0].cpbSizeScale = 5;
+	sps->hrd[0].bitRate[0] = 19999;
+	sps->hrd[0].bitRate[1] = 39999;
+	sps->hrd[0].cpbSize[0] = 65535;
+	sps->hrd[0].cpbSize[1] = 131071;
+	sps->hrd[0].cbr[1] = 1;
+	sps->hrd[0].delayLengths[0] = 23;
+	sps->hrd[0].delayLengths[1] = 23;
+	sps->hrd[0].delayLengths[2] = 23;
+	sps->hrd[0].delayLengths[3] = 24;
+	sps->vclHrd = 1;
+	sps->hrd[1] = sps->hrd[0];
+	sps->hrd[1].cpbCount = 1;
+	sps->hrd[1].bitRate[1] = 0;
+	sps->hrd[1].cpbSize[1] = 0;
+	sps->hrd[1].cbr[1] = 0;
+	sps->lowDelay = 1;
+	sps->restrictions = 1;
+	sps->mvOverPicBoundaries = 0;
+	sps->maxBytesPerPicDenom = 4;
+	sps->maxBitsPerMbDenom = 3;
+	sps->log2MvHorizontal = 15;
+	sps->log2MvVertical = 15;
+	sps->numReorderFrames = 2;
+	sps->maxDecFrameBuffering = 16;
+
+	// High 4:4:4 with separate colour planes and all 12 scaling lists
+	sps = &corpus[count++];
+	memset(sps, 0, sizeof(*sps));
+	sps->profileIdc = 244;
+	sps->levelIdc = 52;
+	sps->chromaFormatIdc = 3;
+	sps->separateColourPlanes = 1;
+	sps->bitDepthLuma = 2;
+	sps->bitDepthChroma = 2;
+	sps->transformBypass = 1;
+	sps->scalingMatrix = 1;
+	for (i = 0; i < 12; i++) {
+		sps->scalingListPresent[i] = 1;
+		for (j = 0; j < (i < 6 ? 16 : 64); j++) {
+			sps->scalingLists[i][j] = 1 + ((i * 31 + j * 5) % 255);
+		}
+	}
+	sps->log2MaxFrameNum = 8;
+	sps->pocType = 2;
+	sps->numRefFrames = 1;
+	sps->widthMbs = 159;
+	sps->heightMapUnits = 89;
+	sps->frameMbsOnly = 1;
+
+	return count;
+}
+
+#define TEST_CORPUS_SIZE 8
+#define TEST_NAL_SIZE (MAX_RBSP_SIZE + 64)
+
+int nv_sps_self_test(void) {
+	static const int profiles[] = { 0, 66, 100 };
+	static const int levels[] = { 0, 32, 42 };
+	TEST_SPS corpus[TEST_CORPUS_SIZE];
+	TEST_SPS parsed, expected;
+	unsigned char nal[TEST_NAL_SIZE], out[TEST_NAL_SIZE], again[TEST_NAL_SIZE];
+	int count, failures = 0, rewrites = 0, fuzzed = 0, accepted = 0;
+	int i, p, l, flags, length, outLength, bit;
+
+	count = testCorpus(corpus);
+	for (i = 0; i < count; i++) {
+		length = testWriteSps(&corpus[i], nal, sizeof(nal));
+		if (testReadSps(nal, length, &parsed) != 0 || memcmp(&parsed, &corpus[i], sizeof(parsed)) != 0) {
+			__android_log_print(ANDROID_LOG_ERROR, "nv_video_sps", "SPS %d doesn't round trip", i);
+			failures++;
+			continue;
+		}
+
+		for (p = 0; p < 3; p++) {
+			for (l = 0; l < 3; l++) {
+				for (flags = 0; flags < 4; flags++) {
+					rewrites++;
+					testExpectedSps(&corpus[i], &expected, profiles[p], levels[l], flags);
+					outLength = nv_sps_rewrite(nal, length, out, sizeof(out), profiles[p], levels[l], flags);
+					if (outLength < 0 || testReadSps(out, outLength, &parsed) != 0 ||
+						memcmp(&parsed, &expected, sizeof(parsed)) != 0) {
+						__android_log_print(ANDROID_LOG_ERROR, "nv_video_sps",
+											"SPS %d rewritten wrong for profile %d level %d flags %d",
+											i, profiles[p], levels[l], flags);
+						failures++;
+						continue;
+					}
+
+					// Rewriting it again changes nothing, and in place gives the same
+					memcpy(again, nal, length);
+					if (nv_sps_rewrite(out, outLength, out, sizeof(out), profiles[p], levels[l], flags) != outLength ||
+						nv_sps_rewrite(again, length, again, sizeof(again), profiles[p], levels[l], flags) != outLength ||
+						memcmp(out, again, outLength) != 0) {
+						__android_log_print(ANDROID_LOG_ERROR, "nv_video_sps",
+											"SPS %d isn't stable for profile %d level %d flags %d",
+											i, profiles[p], levels[l], flags);
+						failures++;
+					}
+
+					// Nor does it write past a short buffer
+					memset(again, 0xAA, sizeof(again));
+					if (nv_sps_rewrite(nal, length, again, outLength - 1, profiles[p], levels[l], flags) != -1 ||
+						again[outLength - 1] != 0xAA) {
+						__android_log_print(ANDROID_LOG_ERROR, "nv_video_sps", "SPS %d overran its buffer", i);
+						failures++;
+					}
+				}
+			}
+		}
+
+		// Anything cut short or corrupted either fails or comes out a valid SPS
+		for (bit = -(length - 5); bit < (length - 5) * 8; bit++) {
+			memcpy(again, nal, length);
+			if (bit < 0) {
+				outLength = nv_sps_rewrite(again, length + bit, out, sizeof(out), 0, 0, 3);
+			}
+			else {
+				again[5 + bit / 8] ^= 0x80 >> (bit & 7);
+				outLength = nv_sps_rewrite(again, length, out, sizeof(out), 0, 0, 3);
+			}
+			fuzzed++;
+			if (outLength >= 0) {
+				accepted++;
+				if (outLength > (int)sizeof(out) || testReadSps(out, outLength, &parsed) != 0) {
+					__android_log_print(ANDROID_LOG_ERROR, "nv_video_sps",
+										"SPS %d fuzzed at %d came out broken", i, bit);
+					failures++;
+				}
+			}
+		}
+	}
+
+	// And random bytes after a real header
+	srand(1);
+	for (i = 0; i < 100000; i++) {
+		length = 6 + rand() % 64;
+		memcpy(again, nal, 5);
+		for (p = 5; p < length; p++) {
+			again[p] = rand() % 4 == 0 ? 0 : rand();
+		}
+		outLength = nv_sps_rewrite(again, length, out, sizeof(out), 0, 0, rand() % 4);
+		fuzzed++;
+		if (outLength >= 0) {
+			accepted++;
+			if (testReadSps(out, outLength, &parsed) != 0) {
+				__android_log_print(ANDROID_LOG_ERROR, "nv_video_sps", "Random SPS %d came out broken", i);
+				failures++;
+			}
+		}
+	}
+
+	__android_log_print(ANDROID_LOG_INFO, "nv_video_sps",
+						"SPS self test: %d units, %d rewrites, %d fuzzed (%d accepted), %d failures",
+						count, rewrites, fuzzed, accepted, failures);
+	return failures;
+}
+#endif
@@ -0,0 +1,25 @@
+// Rewrites H.264 SPS units with the fixups some decoders need, straight
+// from one buffer to another with no allocations. Every SPS gets
+// num_ref_frames 1 and loses the video signal type and chroma location
+// GFE 2.5.11 started adding; the rest is up to the flags.
+
+// Adds bitstream restrictions, or patches GFE's, so the decoder knows it
+// needn't buffer frames. Without it the restrictions are removed.
+#define NV_SPS_FIX_BITSTREAM_RESTRICTIONS 0x1
+// Sets constraint_set4 and 5 on High profile, making it Constrained High.
+// Without it they're cleared.
+#define NV_SPS_FIX_CONSTRAINED_HIGH 0x2
+
+// in is the SPS NAL with its Annex B start code; out gets the same start
+// code and the rewritten NAL, and may be the same buffer as in.
+// profileIdc and levelIdc replace the stream's unless they're 0.
+// returns the length written to out, or -1 if the SPS couldn't be parsed
+// or out is too small
+int nv_sps_rewrite(const unsigned char* in, int inLength, unsigned char* out, int outCapacity,
+				   int profileIdc, int levelIdc, int flags);
+
+#ifndef NDEBUG
+// Runs the SPS corpus through the rewriter and checks every field, then
+// throws corrupted SPS units at it. returns the number of failures.
+int nv_sps_self_test(void);
+#endif
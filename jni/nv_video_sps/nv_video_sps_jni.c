@@ -0,0 +1,25 @@
+#include "nv_video_sps.h"
+
+#include <stdlib.h>
+#include <jni.h>
+
+// Far bigger than any SPS GFE sends
+#define MAX_SPS_SIZE 1024
+
+// returns the length written to buf at position, or -1 if the SPS couldn't be parsed
+JNIEXPORT jint JNICALL
+Java_com_limelight_binding_video_NativeSpsRewriter_rewriteSps(JNIEnv *env, jclass clazz, jbyteArray data,
+															  jint offset, jint length, jobject buffer,
+															  jint position, jint capacity, jint profileIdc,
+															  jint levelIdc, jint flags) {
+	jbyte sps[MAX_SPS_SIZE];
+	unsigned char* out = (*env)->GetDirectBufferAddress(env, buffer);
+
+	if (out == NULL || length > MAX_SPS_SIZE) {
+		return -1;
+	}
+
+	(*env)->GetByteArrayRegion(env, data, offset, length, sps);
+	return nv_sps_rewrite((unsigned char*)sps, length, out + position, capacity,
+						  profileIdc, levelIdc, flags);
+}
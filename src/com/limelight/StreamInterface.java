@@ -124,6 +124,14 @@ public class StreamInterface implements SurfaceHolder.Callback,
     	return 0;
     }
 
+    // returns false before there's a decoder to count anything
+    public boolean getStreamStats(int[] stats) {
+    	if(decoderRenderer == null)
+    		return false;
+    	decoderRenderer.getStreamStats(stats);
+    	return true;
+    }
+
 	public StreamInterface(MainActivity creatingActivity, String compUUID, String appName, int appId, String uniqueId, SurfaceHolder sh, int width, int height, int fps, boolean hostAudio, int customBitrate, boolean remote) {
 		activity = creatingActivity;
 		
@@ -876,7 +884,7 @@ public class StreamInterface implements SurfaceHolder.Callback,
 */
             activity.onVideoSizeChanged(prefConfig.width, prefConfig.height);
             conn.start(PlatformBinding.getDeviceName(), holder, drFlags,
-                    PlatformBinding.getAudioRenderer(), decoderRenderer);
+                    PlatformBinding.getAudioRenderer(activity), decoderRenderer);
         }
     }
 
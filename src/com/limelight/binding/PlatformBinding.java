@@ -18,6 +18,10 @@ public class PlatformBinding {
         return new AndroidAudioRenderer();
     }
 
+    public static AudioRenderer getAudioRenderer(Context c) {
+        return new AndroidAudioRenderer(c);
+    }
+
     public static LimelightCryptoProvider getCryptoProvider(Context c) {
         return new AndroidCryptoProvider(c);
     }
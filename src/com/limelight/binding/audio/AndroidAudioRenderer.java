@@ -1,15 +1,55 @@
 package com.limelight.binding.audio;
 
+import android.content.Context;
 import android.media.AudioFormat;
 import android.media.AudioManager;
 import android.media.AudioTrack;
+import android.os.Build;
 
 import com.limelight.LimeLog;
 import com.limelight.nvstream.av.audio.AudioRenderer;
 
 public class AndroidAudioRenderer implements AudioRenderer {
 
+    private final Context context;
     private AudioTrack track;
+    private boolean nativeSink;
+
+    public AndroidAudioRenderer() {
+        this(null);
+    }
+
+    public AndroidAudioRenderer(Context context) {
+        this.context = context;
+    }
+
+    private boolean startNativeSink(int channelCount, int sampleRate) {
+        // The native output rate and buffer size are only published from Jelly Bean MR1 on
+        if (context == null || Build.VERSION.SDK_INT < Build.VERSION_CODES.JELLY_BEAN_MR1) {
+            return false;
+        }
+
+        AudioManager audioManager = (AudioManager) context.getSystemService(Context.AUDIO_SERVICE);
+        String outputRate = audioManager.getProperty(AudioManager.PROPERTY_OUTPUT_SAMPLE_RATE);
+        String framesPerBuffer = audioManager.getProperty(AudioManager.PROPERTY_OUTPUT_FRAMES_PER_BUFFER);
+        if (outputRate == null || framesPerBuffer == null) {
+            return false;
+        }
+
+        try {
+            if (NativeAudioSink.start(channelCount, sampleRate,
+                    Integer.parseInt(outputRate), Integer.parseInt(framesPerBuffer))) {
+                LimeLog.info("Native audio sink at "+outputRate+" Hz, "+framesPerBuffer+" frames per buffer");
+                return true;
+            }
+        } catch (NumberFormatException e) {
+            e.printStackTrace();
+        } catch (UnsatisfiedLinkError e) {
+            e.printStackTrace();
+        }
+
+        return false;
+    }
 
     @Override
     public boolean streamInitialized(int channelCount, int channelMask, int samplesPerFrame, int sampleRate) {
@@ -17,6 +57,11 @@ public class AndroidAudioRenderer implements AudioRenderer {
         int bufferSize;
         int bytesPerFrame = (samplesPerFrame * 2);
 
+        nativeSink = startNativeSink(channelCount, sampleRate);
+        if (nativeSink) {
+            return true;
+        }
+
         switch (channelCount)
         {
         case 1:
@@ -85,11 +130,21 @@ public class AndroidAudioRenderer implements AudioRenderer {
 
     @Override
     public void playDecodedAudio(byte[] audioData, int offset, int length) {
-        track.write(audioData, offset, length);
+        if (nativeSink) {
+            NativeAudioSink.write(audioData, offset, length);
+        }
+        else {
+            track.write(audioData, offset, length);
+        }
     }
 
     @Override
     public void streamClosing() {
+        if (nativeSink) {
+            NativeAudioSink.stop();
+            nativeSink = false;
+        }
+
         if (track != null) {
             track.release();
         }
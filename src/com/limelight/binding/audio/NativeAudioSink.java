@@ -0,0 +1,18 @@
+package com.limelight.binding.audio;
+
+// Plays PCM through OpenSL ES at the device's native rate and buffer size,
+// so neither AudioTrack's buffer nor the platform resampler add latency
+public class NativeAudioSink {
+    static {
+        System.loadLibrary("nv_opus_dec");
+    }
+
+    // The channels play from around the virtual screen as stereo when the
+    // app's native code has turned that on, through nv_audio_sink_set_spatialize
+    public static native boolean start(int channelCount, int sampleRate, int outputRate, int framesPerBuffer);
+    public static native void write(byte[] pcmData, int offset, int length);
+    public static native void stop();
+
+    // Where the screen is in head space is set every rendered frame by the
+    // app's native code, through nv_audio_sink_set_screen
+}
@@ -1,9 +1,6 @@
 package com.limelight.binding.input.evdev;
 
 public class EvdevEvent {
-    public static final int EVDEV_MIN_EVENT_SIZE = 16;
-    public static final int EVDEV_MAX_EVENT_SIZE = 24;
-
     /* Event types */
     public static final short EV_SYN = 0x00;
     public static final short EV_KEY = 0x01;
@@ -25,11 +22,19 @@ public class EvdevEvent {
     public static final short BTN_BACK = 0x116;
     public static final short BTN_TASK = 0x117;
 
-    public final short type;
-    public final short code;
-    public final int value;
+    // Not final so a reader can reuse its events frame after frame
+    public short type;
+    public short code;
+    public int value;
+
+    public EvdevEvent() {
+    }
 
     public EvdevEvent(short type, short code, int value) {
+        set(type, code, value);
+    }
+
+    public void set(short type, short code, int value) {
         this.type = type;
         this.code = code;
         this.value = value;
@@ -1,6 +1,9 @@
 package com.limelight.binding.input.evdev;
 
 import android.content.Context;
+import android.net.LocalServerSocket;
+import android.net.LocalSocket;
+import android.net.LocalSocketAddress;
 
 import com.limelight.LimeLog;
 
@@ -9,8 +12,7 @@ import java.io.File;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
-import java.net.ServerSocket;
-import java.net.Socket;
+import java.util.UUID;
 
 public class EvdevHandler {
 
@@ -21,8 +23,11 @@ public class EvdevHandler {
     private InputStream evdevIn;
     private OutputStream evdevOut;
     private Process su;
-    private ServerSocket servSock;
-    private Socket evdevSock;
+    private LocalServerSocket servSock;
+    private LocalSocket evdevSock;
+
+    // evdev_reader connects to this name in the abstract namespace
+    private final String socketName = "evdev_reader-"+UUID.randomUUID().toString();
 
     private static final byte UNGRAB_REQUEST = 1;
     private static final byte REGRAB_REQUEST = 2;
@@ -36,7 +41,7 @@ public class EvdevHandler {
 
             // Bind a local listening socket for evdevreader to connect to
             try {
-                servSock = new ServerSocket(0, 1);
+                servSock = new LocalServerSocket(socketName);
             } catch (IOException e) {
                 e.printStackTrace();
                 return;
@@ -53,103 +58,117 @@ public class EvdevHandler {
                 return;
             }
 
-            // Start evdevreader
+            // Start evdevreader, asking it to add up mouse motion we haven't read yet
             DataOutputStream suOut = new DataOutputStream(su.getOutputStream());
             try {
-                suOut.writeChars(libraryPath+File.separatorChar+"libevdev_reader.so "+servSock.getLocalPort()+"\n");
+                suOut.writeChars(libraryPath+File.separatorChar+"libevdev_reader.so @"+socketName+" -m\n");
             } catch (IOException e) {
                 e.printStackTrace();
                 return;
             }
 
             // Wait for evdevreader's connection
-            LimeLog.info("Waiting for EvdevReader connection to port "+servSock.getLocalPort());
+            LimeLog.info("Waiting for EvdevReader connection to "+socketName);
+            EvdevReader reader;
             try {
                 evdevSock = servSock.accept();
+                if (shutdown) {
+                    // stop() woke us up
+                    return;
+                }
                 evdevIn = evdevSock.getInputStream();
                 evdevOut = evdevSock.getOutputStream();
+
+                reader = new EvdevReader(evdevIn);
+                if (!reader.readHello()) {
+                    return;
+                }
             } catch (IOException e) {
                 e.printStackTrace();
                 return;
             }
-            LimeLog.info("EvdevReader connected from port "+evdevSock.getPort());
+            LimeLog.info("EvdevReader connected");
 
+            EvdevEvent[] events = reader.getEvents();
             while (!isInterrupted() && !shutdown) {
-                EvdevEvent event;
+                int count;
                 try {
-                    event = EvdevReader.read(evdevIn);
+                    count = reader.readFrame();
                 } catch (IOException e) {
-                    event = null;
+                    count = -1;
                 }
-                if (event == null) {
+                if (count < 0) {
                     break;
                 }
 
-                switch (event.type) {
-                    case EvdevEvent.EV_SYN:
-                        if (deltaX != 0 || deltaY != 0) {
-                            listener.mouseMove(deltaX, deltaY);
-                            deltaX = deltaY = 0;
-                        }
-                        if (deltaScroll != 0) {
-                            listener.mouseScroll(deltaScroll);
-                            deltaScroll = 0;
-                        }
-                        break;
-
-                    case EvdevEvent.EV_REL:
-                        switch (event.code) {
-                            case EvdevEvent.REL_X:
-                                deltaX = event.value;
-                                break;
-                            case EvdevEvent.REL_Y:
-                                deltaY = event.value;
-                                break;
-                            case EvdevEvent.REL_WHEEL:
-                                deltaScroll = (byte) event.value;
-                                break;
-                        }
-                        break;
-
-                    case EvdevEvent.EV_KEY:
-                        switch (event.code) {
-                            case EvdevEvent.BTN_LEFT:
-                                listener.mouseButtonEvent(EvdevListener.BUTTON_LEFT,
-                                        event.value != 0);
-                                break;
-                            case EvdevEvent.BTN_MIDDLE:
-                                listener.mouseButtonEvent(EvdevListener.BUTTON_MIDDLE,
-                                        event.value != 0);
-                                break;
-                            case EvdevEvent.BTN_RIGHT:
-                                listener.mouseButtonEvent(EvdevListener.BUTTON_RIGHT,
-                                        event.value != 0);
-                                break;
-
-                            case EvdevEvent.BTN_SIDE:
-                            case EvdevEvent.BTN_EXTRA:
-                            case EvdevEvent.BTN_FORWARD:
-                            case EvdevEvent.BTN_BACK:
-                            case EvdevEvent.BTN_TASK:
-                                // Other unhandled mouse buttons
-                                break;
-
-                            default:
-                                // We got some unrecognized button. This means
-                                // someone is trying to use the other device in this
-                                // "combination" input device. We'll try to handle
-                                // it via keyboard, but we're not going to disconnect
-                                // if we can't
-                                short keyCode = EvdevTranslator.translateEvdevKeyCode(event.code);
-                                if (keyCode != 0) {
-                                    listener.keyboardEvent(event.value != 0, keyCode);
-                                }
-                                break;
-                        }
-                        break;
-
-                    case EvdevEvent.EV_MSC:
-                        break;
+                for (int i = 0; i < count; i++) {
+                    EvdevEvent event = events[i];
+                    switch (event.type) {
+                        case EvdevEvent.EV_SYN:
+                            if (deltaX != 0 || deltaY != 0) {
+                                listener.mouseMove(deltaX, deltaY);
+                                deltaX = deltaY = 0;
+                            }
+                            if (deltaScroll != 0) {
+                                listener.mouseScroll(deltaScroll);
+                                deltaScroll = 0;
+                            }
+                            break;
+
+                        case EvdevEvent.EV_REL:
+                            switch (event.code) {
+                                case EvdevEvent.REL_X:
+                                    deltaX = event.value;
+                                    break;
+                                case EvdevEvent.REL_Y:
+                                    deltaY = event.value;
+                                    break;
+                                case EvdevEvent.REL_WHEEL:
+                                    deltaScroll = (byte) event.value;
+                                    break;
+                            }
+                            break;
+
+                        case EvdevEvent.EV_KEY:
+                            switch (event.code) {
+                                case EvdevEvent.BTN_LEFT:
+                                    listener.mouseButtonEvent(EvdevListener.BUTTON_LEFT,
+                                            event.value != 0);
+                                    break;
+                                case EvdevEvent.BTN_MIDDLE:
+                                    listener.mouseButtonEvent(EvdevListener.BUTTON_MIDDLE,
+                                            event.value != 0);
+                                    break;
+                                case EvdevEvent.BTN_RIGHT:
+                                    listener.mouseButtonEvent(EvdevListener.BUTTON_RIGHT,
+                                            event.value != 0);
+                                    break;
+
+                                case EvdevEvent.BTN_SIDE:
+                                case EvdevEvent.BTN_EXTRA:
+                                case EvdevEvent.BTN_FORWARD:
+                                case EvdevEvent.BTN_BACK:
+                                case EvdevEvent.BTN_TASK:
+                                    // Other unhandled mouse buttons
+                                    break;
+
+                                default:
+                                    // We got some unrecognized button. This means
+                                    // someone is trying to use the other device in this
+                                    // "combination" input device. We'll try to handle
+                                    // it via keyboard, but we're not going to disconnect
+                                    // if we can't
+                                    short keyCode = EvdevTranslator.translateEvdevKeyCode(event.code);
+                                    if (keyCode != 0) {
+                                        listener.keyboardEvent(event.value != 0, keyCode);
+                                    }
+                                    break;
+                            }
+                            break;
+
+                        case EvdevEvent.EV_MSC:
+                            break;
+                    }
                 }
             }
         }
@@ -193,6 +212,23 @@ public class EvdevHandler {
         handlerThread.interrupt();
 
         if (servSock != null) {
+            // Closing a LocalServerSocket doesn't wake up accept(),
+            // so connect to it ourselves if evdevreader never did
+            if (evdevSock == null) {
+                LocalSocket wakeSock = new LocalSocket();
+                try {
+                    wakeSock.connect(new LocalSocketAddress(socketName));
+                } catch (IOException e) {
+                    e.printStackTrace();
+                } finally {
+                    try {
+                        wakeSock.close();
+                    } catch (IOException e) {
+                        e.printStackTrace();
+                    }
+                }
+            }
+
             try {
                 servSock.close();
             } catch (IOException e) {
@@ -7,52 +7,84 @@ import java.nio.ByteOrder;
 
 import com.limelight.LimeLog;
 
+// Reads the frames that evdev_reader sends. See the protocol
+// description at the top of evdev_reader.c.
 public class EvdevReader {
-    private static void readAll(InputStream in, ByteBuffer bb) throws IOException {
+    public static final int PROTOCOL_MAGIC = 0x46445645; // "EVDF"
+    public static final int PROTOCOL_VERSION = 1;
+
+    private static final int HELLO_SIZE = 8;
+    private static final int FRAME_HEADER_SIZE = 4;
+    private static final int FRAME_EVENT_SIZE = 8;
+    private static final int MAX_FRAME_EVENTS = 64;
+
+    private final InputStream input;
+    private final ByteBuffer header = ByteBuffer.allocate(HELLO_SIZE).order(ByteOrder.nativeOrder());
+    private final ByteBuffer frame = ByteBuffer.allocate(MAX_FRAME_EVENTS * FRAME_EVENT_SIZE).order(ByteOrder.nativeOrder());
+    private final EvdevEvent[] events = new EvdevEvent[MAX_FRAME_EVENTS];
+
+    public EvdevReader(InputStream input) {
+        this.input = input;
+        for (int i = 0; i < events.length; i++) {
+            events[i] = new EvdevEvent();
+        }
+    }
+
+    private void readAll(ByteBuffer bb, int length) throws IOException {
         byte[] buf = bb.array();
         int ret;
         int offset = 0;
 
-        while (offset < buf.length) {
-            ret = in.read(buf, offset, buf.length-offset);
+        while (offset < length) {
+            ret = input.read(buf, offset, length-offset);
             if (ret <= 0) {
                 throw new IOException("Read failed: "+ret);
             }
 
             offset += ret;
         }
+
+        bb.clear();
+        bb.limit(length);
+    }
+
+    // Returns false if the other end doesn't speak our protocol version
+    public boolean readHello() throws IOException {
+        readAll(header, HELLO_SIZE);
+
+        int magic = header.getInt();
+        int version = header.getShort();
+        if (magic != PROTOCOL_MAGIC || version != PROTOCOL_VERSION) {
+            LimeLog.warning("Unsupported evdev protocol: "+Integer.toHexString(magic)+" version "+version);
+            return false;
+        }
+
+        return true;
     }
 
-    // Takes a byte buffer to use to read the output into.
-    // This buffer MUST be in native byte order and at least
-    // EVDEV_MAX_EVENT_SIZE bytes long.
-    public static EvdevEvent read(InputStream input) throws IOException {
-        ByteBuffer bb;
-        int packetLength;
-
-        // Read the packet length
-        bb = ByteBuffer.allocate(4).order(ByteOrder.nativeOrder());
-        readAll(input, bb);
-        packetLength = bb.getInt();
-
-        if (packetLength < EvdevEvent.EVDEV_MIN_EVENT_SIZE) {
-            LimeLog.warning("Short read: "+packetLength);
-            return null;
+    // Reads one report into getEvents(), ending with its EV_SYN if the
+    // report fit in a single frame. Returns how many events it has, or
+    // -1 for a frame we can't read.
+    public int readFrame() throws IOException {
+        readAll(header, FRAME_HEADER_SIZE);
+
+        int count = header.getShort() & 0xFFFF;
+        if (count > MAX_FRAME_EVENTS) {
+            LimeLog.warning("Frame too long: "+count);
+            return -1;
         }
 
-        // Read the rest of the packet
-        bb = ByteBuffer.allocate(packetLength).order(ByteOrder.nativeOrder());
-        readAll(input, bb);
-
-        // Throw away the time stamp
-        if (packetLength == EvdevEvent.EVDEV_MAX_EVENT_SIZE) {
-            bb.getLong();
-            bb.getLong();
-        } else {
-            bb.getInt();
-            bb.getInt();
+        readAll(frame, count * FRAME_EVENT_SIZE);
+
+        for (int i = 0; i < count; i++) {
+            events[i].set(frame.getShort(), frame.getShort(), frame.getInt());
         }
 
-        return new EvdevEvent(bb.getShort(), bb.getShort(), bb.getInt());
+        return count;
+    }
+
+    // The last frame's events, overwritten by the next readFrame()
+    public EvdevEvent[] getEvents() {
+        return events;
     }
 }
@@ -6,4 +6,5 @@ public abstract class EnhancedDecoderRenderer extends VideoDecoderRenderer {
     public abstract boolean isHevcSupported();
     public abstract boolean isAvcSupported();
     public abstract long getLastFrameTimestamp();
+    public abstract void getStreamStats(int[] stats);
 }
@@ -1,13 +1,10 @@
 package com.limelight.binding.video;
 
 import java.nio.ByteBuffer;
+import java.util.Arrays;
 import java.util.Locale;
 import java.util.concurrent.locks.LockSupport;
 
-import org.jcodec.codecs.h264.H264Utils;
-import org.jcodec.codecs.h264.io.model.SeqParameterSet;
-import org.jcodec.codecs.h264.io.model.VUIParameters;
-
 import com.limelight.LimeLog;
 import com.limelight.nvstream.av.ByteBufferDescriptor;
 import com.limelight.nvstream.av.DecodeUnit;
@@ -42,12 +39,18 @@ public class MediaCodecDecoderRenderer extends EnhancedDecoderRenderer {
     private VideoFormat videoFormat;
 
     private boolean needsBaselineSpsHack;
-    private SeqParameterSet savedSps;
+    private byte[] savedSps;
 
     private long lastTimestampUs;
     private long totalTimeMs;
     private long decoderTimeMs;
     private int totalFrames;
+    // For getStreamStats, read from other threads
+    private volatile int submittedFrames;
+    private volatile int decodedFrames;
+    private volatile int completeFrames;
+    private volatile int droppedFrames;
+    private int lastFrameNumber;
 
     private int numSpsIn;
     private int numPpsIn;
@@ -252,6 +255,7 @@ public class MediaCodecDecoderRenderer extends EnhancedDecoderRenderer {
                         int outIndex = videoDecoder.dequeueOutputBuffer(info, 50000);
                         if (outIndex >= 0) {
                             presentationTimeUs = info.presentationTimeUs;
+                            decodedFrames++;
                             int lastIndex = outIndex;
 
                             // Get the last output buffer in the queue
@@ -260,6 +264,7 @@ public class MediaCodecDecoderRenderer extends EnhancedDecoderRenderer {
 
                                 lastIndex = outIndex;
                                 presentationTimeUs = info.presentationTimeUs;
+                                decodedFrames++;
                             }
 
                             // Render the last buffer
@@ -401,6 +406,7 @@ public class MediaCodecDecoderRenderer extends EnhancedDecoderRenderer {
 
                         if (outIndex >= 0) {
                             presentationTimeUs = info.presentationTimeUs;
+                            decodedFrames++;
                             int lastIndex = outIndex;
 
                             // Get the last output buffer in the queue
@@ -408,6 +414,7 @@ public class MediaCodecDecoderRenderer extends EnhancedDecoderRenderer {
                                 videoDecoder.releaseOutputBuffer(lastIndex, false);
                                 lastIndex = outIndex;
                                 presentationTimeUs = info.presentationTimeUs;
+                                decodedFrames++;
                             }
 
                             // Render the last buffer
@@ -531,20 +538,79 @@ public class MediaCodecDecoderRenderer extends EnhancedDecoderRenderer {
         return buf;
     }
 
-    private void doProfileSpecificSpsPatching(SeqParameterSet sps) {
+    private int getSpsLevelIdc() {
+        // Some decoders rely on H264 level to decide how many buffers are needed
+        // Since we only need one frame buffered, we'll set the level as low as we can
+        // for known resolution combinations
+        if (initialWidth == 1280 && initialHeight == 720) {
+            // Max 5 buffered frames at 1280x720x60
+            LimeLog.info("Patching level_idc to 32");
+            return 32;
+        }
+        else if (initialWidth == 1920 && initialHeight == 1080) {
+            // Max 4 buffered frames at 1920x1080x64
+            LimeLog.info("Patching level_idc to 42");
+            return 42;
+        }
+        else {
+            // Leave the profile alone (currently 5.0)
+            return 0;
+        }
+    }
+
+    // The rewriter always patches num_ref_frames to 1, which TI OMAP4 and Exynos 4
+    // need to decode successfully and which hasn't caused issues on any device; at
+    // worst it does nothing and at best it fixes video lag, hangs, and crashes.
+    // It also always removes the video signal type and chroma location that GFE
+    // 2.5.11 started sending, since some devices don't like them.
+    private int getSpsFixups() {
+        int fixups = 0;
+
+        if (needsSpsBitstreamFixup || isExynos4) {
+            // The SPS that comes in the current H264 bytestream doesn't set bitstream_restriction_flag
+            // or max_dec_frame_buffering which increases decoding latency on Tegra. GFE 2.5.11's
+            // restrictions are patched with max_dec_frame_buffering = num_ref_frames and the
+            // default, more aggressive, max_bytes_per_pic_denom and max_bits_per_mb_denom.
+            // Devices that didn't/couldn't get bitstream restrictions before GFE 2.5.11
+            // will continue to not receive them now.
+            LimeLog.info("Patching bitstream restrictions");
+            fixups |= NativeSpsRewriter.SPS_FIX_BITSTREAM_RESTRICTIONS;
+        }
+
         // Some devices benefit from setting constraint flags 4 & 5 to make this Constrained
         // High Profile which allows the decoder to assume there will be no B-frames and
         // reduce delay and buffering accordingly. Some devices (Marvell, Exynos 4) don't
         // like it so we only set them on devices that are confirmed to benefit from it.
-        if (sps.profile_idc == 100 && constrainedHighProfile) {
+        // Otherwise they're forced unset (some may be set by default).
+        if (constrainedHighProfile) {
             LimeLog.info("Setting constraint set flags for constrained high profile");
-            sps.constraint_set_4_flag = true;
-            sps.constraint_set_5_flag = true;
+            fixups |= NativeSpsRewriter.SPS_FIX_CONSTRAINED_HIGH;
         }
-        else {
-            // Force the constraints unset otherwise (some may be set by default)
-            sps.constraint_set_4_flag = false;
-            sps.constraint_set_5_flag = false;
+
+        return fixups;
+    }
+
+    // data holds an Annex B H264 SPS at offset, start code and all.
+    // Writes it to buf with this device's fixups.
+    private void putPatchedSps(byte[] data, int offset, int length, ByteBuffer buf) {
+        int profileIdc = 0;
+
+        // If we need to hack this SPS to say we're baseline, do so now
+        if (needsBaselineSpsHack) {
+            LimeLog.info("Hacking SPS to baseline");
+            profileIdc = 66;
+            savedSps = Arrays.copyOfRange(data, offset, offset+length);
+        }
+
+        putRewrittenSps(data, offset, length, profileIdc, buf);
+    }
+
+    private void putRewrittenSps(byte[] data, int offset, int length, int profileIdc, ByteBuffer buf) {
+        // Rewritten natively, straight into the input buffer
+        if (!NativeSpsRewriter.putRewrittenSps(data, offset, length, buf,
+                profileIdc, getSpsLevelIdc(), getSpsFixups())) {
+            LimeLog.warning("Unable to parse SPS; submitting it unpatched");
+            buf.put(data, offset, length);
         }
     }
 
@@ -579,98 +645,7 @@ public class MediaCodecDecoderRenderer extends EnhancedDecoderRenderer {
             if (header.data[header.offset+4] == 0x67) {
                 numSpsIn++;
 
-                ByteBuffer spsBuf = ByteBuffer.wrap(header.data);
-
-                // Skip to the start of the NALU data
-                spsBuf.position(header.offset+5);
-
-                // The H264Utils.readSPS function safely handles
-                // Annex B NALUs (including NALUs with escape sequences)
-                SeqParameterSet sps = H264Utils.readSPS(spsBuf);
-
-                // Some decoders rely on H264 level to decide how many buffers are needed
-                // Since we only need one frame buffered, we'll set the level as low as we can
-                // for known resolution combinations
-                if (initialWidth == 1280 && initialHeight == 720) {
-                    // Max 5 buffered frames at 1280x720x60
-                    LimeLog.info("Patching level_idc to 32");
-                    sps.level_idc = 32;
-                }
-                else if (initialWidth == 1920 && initialHeight == 1080) {
-                    // Max 4 buffered frames at 1920x1080x64
-                    LimeLog.info("Patching level_idc to 42");
-                    sps.level_idc = 42;
-                }
-                else {
-                    // Leave the profile alone (currently 5.0)
-                }
-
-                // TI OMAP4 requires a reference frame count of 1 to decode successfully. Exynos 4
-                // also requires this fixup.
-                //
-                // I'm doing this fixup for all devices because I haven't seen any devices that
-                // this causes issues for. At worst, it seems to do nothing and at best it fixes
-                // issues with video lag, hangs, and crashes.
-                LimeLog.info("Patching num_ref_frames in SPS");
-                sps.num_ref_frames = 1;
-
-                // GFE 2.5.11 changed the SPS to add additional extensions
-                // Some devices don't like these so we remove them here.
-                sps.vuiParams.video_signal_type_present_flag = false;
-                sps.vuiParams.colour_description_present_flag = false;
-                sps.vuiParams.chroma_loc_info_present_flag = false;
-
-                if (needsSpsBitstreamFixup || isExynos4) {
-                    // The SPS that comes in the current H264 bytestream doesn't set bitstream_restriction_flag
-                    // or max_dec_frame_buffering which increases decoding latency on Tegra.
-
-                    // GFE 2.5.11 started sending bitstream restrictions
-                    if (sps.vuiParams.bitstreamRestriction == null) {
-                        LimeLog.info("Adding bitstream restrictions");
-                        sps.vuiParams.bitstreamRestriction = new VUIParameters.BitstreamRestriction();
-                        sps.vuiParams.bitstreamRestriction.motion_vectors_over_pic_boundaries_flag = true;
-                        sps.vuiParams.bitstreamRestriction.log2_max_mv_length_horizontal = 16;
-                        sps.vuiParams.bitstreamRestriction.log2_max_mv_length_vertical = 16;
-                        sps.vuiParams.bitstreamRestriction.num_reorder_frames = 0;
-                    }
-                    else {
-                        LimeLog.info("Patching bitstream restrictions");
-                    }
-
-                    // Some devices throw errors if max_dec_frame_buffering < num_ref_frames
-                    sps.vuiParams.bitstreamRestriction.max_dec_frame_buffering = sps.num_ref_frames;
-
-                    // These values are the defaults for the fields, but they are more aggressive
-                    // than what GFE sends in 2.5.11, but it doesn't seem to cause picture problems.
-                    sps.vuiParams.bitstreamRestriction.max_bytes_per_pic_denom = 2;
-                    sps.vuiParams.bitstreamRestriction.max_bits_per_mb_denom = 1;
-
-                    // log2_max_mv_length_horizontal and log2_max_mv_length_vertical are set to more
-                    // conservative values by GFE 2.5.11. We'll let those values stand.
-                }
-                else {
-                    // Devices that didn't/couldn't get bitstream restrictions before GFE 2.5.11
-                    // will continue to not receive them now
-                    sps.vuiParams.bitstreamRestriction = null;
-                }
-
-                // If we need to hack this SPS to say we're baseline, do so now
-                if (needsBaselineSpsHack) {
-                    LimeLog.info("Hacking SPS to baseline");
-                    sps.profile_idc = 66;
-                    savedSps = sps;
-                }
-
-                // Patch the SPS constraint flags
-                doProfileSpecificSpsPatching(sps);
-
-                // Write the annex B header
-                buf.put(header.data, header.offset, 5);
-
-                // The H264Utils.writeSPS function safely handles
-                // Annex B NALUs (including NALUs with escape sequences)
-                ByteBuffer escapedNalu = H264Utils.writeSPS(sps, header.length);
-                buf.put(escapedNalu);
+                putPatchedSps(header.data, header.offset, header.length, buf);
 
                 queueInputBuffer(inputBufferIndex,
                         0, buf.position(),
@@ -723,19 +698,8 @@ public class MediaCodecDecoderRenderer extends EnhancedDecoderRenderer {
         int inputIndex = dequeueInputBuffer(true, true);
         ByteBuffer inputBuffer = getEmptyInputBuffer(inputIndex);
 
-        // Write the Annex B header
-        inputBuffer.put(new byte[]{0x00, 0x00, 0x00, 0x01, 0x67});
-
         // Switch the H264 profile back to high
-        savedSps.profile_idc = 100;
-
-        // Patch the SPS constraint flags
-        doProfileSpecificSpsPatching(savedSps);
-
-        // The H264Utils.writeSPS function safely handles
-        // Annex B NALUs (including NALUs with escape sequences)
-        ByteBuffer escapedNalu = H264Utils.writeSPS(savedSps, 128);
-        inputBuffer.put(escapedNalu);
+        putRewrittenSps(savedSps, 0, savedSps.length, 100, inputBuffer);
 
         // No need for the SPS anymore
         savedSps = null;
@@ -783,7 +747,36 @@ public class MediaCodecDecoderRenderer extends EnhancedDecoderRenderer {
         return (int)(totalTimeMs / totalFrames);
     }
 
+    // Fills stats with frames submitted and decoded, decoder time in ms,
+    // then complete frames and dropped frames. All count from the start
+    // of the stream.
+    @Override
+    public void getStreamStats(int[] stats) {
+        stats[0] = submittedFrames;
+        stats[1] = decodedFrames;
+        stats[2] = (int) decoderTimeMs;
+        stats[3] = completeFrames;
+        stats[4] = droppedFrames;
+    }
+
     private void notifyDuReceived(DecodeUnit du) {
+        // Parameter sets come in units of their own, with their frame's number,
+        // and never come out of the decoder, so only pictures are counted.
+        // The depacketizer never hands over a frame it couldn't complete, so
+        // the frame numbers it skips are frames lost to the network.
+        if ((du.getFlags() & DecodeUnit.DU_FLAG_CODEC_CONFIG) == 0) {
+            submittedFrames++;
+
+            int frameNumber = du.getFrameNumber();
+            if (frameNumber > lastFrameNumber) {
+                if (lastFrameNumber != 0) {
+                    droppedFrames += frameNumber - lastFrameNumber - 1;
+                }
+                completeFrames++;
+                lastFrameNumber = frameNumber;
+            }
+        }
+
         long currentTime = MediaCodecHelper.getMonotonicMillis();
         long delta = currentTime-du.getReceiveTimestamp();
         if (delta >= 0 && delta < 1000) {
@@ -0,0 +1,34 @@
+package com.limelight.binding.video;
+
+import java.nio.ByteBuffer;
+
+// Rewrites H264 SPSes natively, straight into a direct buffer
+// such as a MediaCodec input buffer.
+public class NativeSpsRewriter {
+    static {
+        System.loadLibrary("nv_video_sps");
+    }
+
+    // SPS fixups for putRewrittenSps, the same as nv_video_sps.h's
+    public static final int SPS_FIX_BITSTREAM_RESTRICTIONS = 0x1;
+    public static final int SPS_FIX_CONSTRAINED_HIGH = 0x2;
+
+    // Writes the Annex B H264 SPS in data to buf, which must be direct, with
+    // num_ref_frames 1, no video signal type or chroma location, and the fixups
+    // in flags. profileIdc and levelIdc replace the stream's unless they're 0.
+    // returns false, having written nothing, if the SPS couldn't be parsed.
+    public static boolean putRewrittenSps(byte[] data, int offset, int length, ByteBuffer buf,
+                                          int profileIdc, int levelIdc, int flags) {
+        int written = rewriteSps(data, offset, length, buf, buf.position(), buf.remaining(),
+                profileIdc, levelIdc, flags);
+        if (written < 0) {
+            return false;
+        }
+
+        buf.position(buf.position() + written);
+        return true;
+    }
+
+    private static native int rewriteSps(byte[] data, int offset, int length, ByteBuffer buf, int position,
+                                         int capacity, int profileIdc, int levelIdc, int flags);
+}
@@ -51,6 +51,9 @@ public class MainActivity extends VrActivity implements SurfaceHolder.Callback,
 	static 
 	{
 		Log.d( TAG, "LoadLibrary" );
+		// cinema sets the audio screen in nv_opus_dec directly, older linkers
+		// only find it if it's already loaded
+		System.loadLibrary( "nv_opus_dec" );
 		System.loadLibrary( "cinema" );
 	}
 	
@@ -423,6 +426,55 @@ public class MainActivity extends VrActivity implements SurfaceHolder.Callback,
 		Log.v( TAG, "exiting startMovie" );
 	}
 
+	public void reconfigureMovie( final String uuid, final String appName, final int appId, final String binder, final int width, final int height, final int fps, final boolean hostAudio, final int customBitrate, final boolean remote ) 
+	{
+		playbackFinished = false;
+		playbackFailed = false;
+		
+    	runOnUiThread( new Thread()
+    	{
+		 @Override
+    		public void run()
+    		{
+			 	reconfigureMovieLocal( uuid, appName, appId, binder, width, height, fps, hostAudio, customBitrate, remote );
+    		}
+    	} );
+	}
+	
+	// Reconnects on the surface the stream already has, so native keeps the
+	// movie texture and shows the last frame until the new stream's first one.
+	private void reconfigureMovieLocal( final String uuid, final String appName, int appId, final String binder, int width, int height, int fps, boolean hostAudio, int customBitrate, boolean remote ) 
+	{
+		Log.v(TAG, "reconfigureMovie " + appName + " on " + uuid + " to " + width + "x" + height + "@" + fps );
+		
+		synchronized( this ) 
+		{
+			if ( streamInterface == null || movieSurface == null )
+			{
+				startMovieLocal( uuid, appName, appId, binder, width, height, fps, hostAudio, customBitrate, remote );
+				return;
+			}
+			
+			playbackFinished = false;
+			playbackFailed = false;
+	
+			currentAppName = appName;
+			
+			// Set up the new stream while the old one still plays
+			ModifiableSurfaceHolder surfaceHolder = new ModifiableSurfaceHolder();
+			surfaceHolder.setSurface(movieSurface);
+			StreamInterface newStream = new StreamInterface(this, uuid, currentAppName, appId, binder, surfaceHolder, width, height, fps, hostAudio, customBitrate, remote );
+	
+			// The host streams one session and the surface takes one decoder,
+			// so the old stream lets go of both before the new one connects
+			streamInterface.stop();
+			streamInterface = newStream;
+			streamInterface.surfaceCreated(surfaceHolder);
+		}
+		
+		Log.v( TAG, "exiting reconfigureMovie" );
+	}
+
 
 	public void stopMovie()
 	{
@@ -560,6 +612,14 @@ public class MainActivity extends VrActivity implements SurfaceHolder.Callback,
 		return 0;
 	}
 	
+	// The stream's frame counters, see MediaCodecDecoderRenderer.getStreamStats
+	public boolean getStreamStats( int[] stats )
+	{
+		if(streamInterface != null)
+			return streamInterface.getStreamStats(stats);
+		return false;
+	}
+	
 	public long currentTimeStamp()
 	{
 		return System.nanoTime() / 1000;